@@ -0,0 +1,148 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <tuple>
+#include <vector>
+#include "core/dsa/IpLpm.hpp"
+
+namespace detect {
+
+// Address sets referenced by rule src=/dst= options, e.g.
+// "10.0.0.0/8,192.168.0.0/16" or "!10.0.0.0/8".
+//
+// All sets share one LPM table. Each prefix maps to an address class: the
+// bitset of sets containing it (including sets that list a shorter
+// covering prefix), deduplicated. One lookup per address then answers
+// membership for every set, so a packet classifies its src and dst once
+// and each rule check is a bit test.
+class AddressGroups {
+public:
+    static constexpr std::uint32_t kNoClass = 0; // address in no listed prefix
+
+    // Validates a spec without adding it
+    static bool parse_spec(std::string_view spec, bool& negated, std::vector<core::dsa::IpPrefix>& prefixes) {
+        prefixes.clear();
+        negated = !spec.empty() && spec.front() == '!';
+        if (negated) spec.remove_prefix(1);
+        std::size_t pos = 0;
+        while (pos <= spec.size()) {
+            auto comma = spec.find(',', pos);
+            if (comma == std::string_view::npos) comma = spec.size();
+            core::dsa::IpPrefix prefix;
+            if (!core::dsa::IpLpm::parse_prefix(spec.substr(pos, comma - pos), prefix)) return false;
+            prefixes.push_back(prefix);
+            pos = comma + 1;
+        }
+        return !prefixes.empty();
+    }
+
+    // Returns the set id (identical specs share one) or -1 if the spec is invalid
+    int add(const std::string& spec) {
+        for (std::size_t i = 0; i < groups_.size(); ++i) {
+            if (groups_[i].spec == spec) return static_cast<int>(i);
+        }
+        Group group;
+        group.spec = spec;
+        if (!parse_spec(spec, group.negated, group.prefixes)) return -1;
+        groups_.push_back(std::move(group));
+        return static_cast<int>(groups_.size() - 1);
+    }
+
+    void build() {
+        words_ = (groups_.size() + 63) / 64;
+        lpm_ = core::dsa::IpLpm(16);
+        classes_.assign(words_, 0); // class 0: no prefix matched
+        if (groups_.empty()) return;
+
+        // Sets listing each distinct prefix directly
+        std::map<Key, std::vector<std::uint64_t>> direct;
+        for (std::size_t g = 0; g < groups_.size(); ++g) {
+            for (const auto& p : groups_[g].prefixes) {
+                auto& bits = direct[key_of(p)];
+                bits.resize(words_, 0);
+                bits[g / 64] |= std::uint64_t{1} << (g % 64);
+            }
+        }
+
+        // Add sets of every covering shorter prefix, then dedup into classes
+        std::map<std::vector<std::uint64_t>, std::uint32_t> class_ids;
+        class_ids[std::vector<std::uint64_t>(words_, 0)] = kNoClass;
+        for (const auto& [key, bits] : direct) {
+            std::vector<std::uint64_t> all = bits;
+            core::dsa::IpPrefix p = prefix_of(key);
+            for (unsigned len = 0; len < p.length; ++len) {
+                core::dsa::IpPrefix shorter = p;
+                shorter.length = len;
+                truncate(shorter);
+                auto it = direct.find(key_of(shorter));
+                if (it == direct.end()) continue;
+                for (std::size_t w = 0; w < words_; ++w) all[w] |= it->second[w];
+            }
+            auto [it, inserted] = class_ids.try_emplace(all, static_cast<std::uint32_t>(class_ids.size()));
+            if (inserted) classes_.insert(classes_.end(), all.begin(), all.end());
+            lpm_.add(p, it->second);
+        }
+        lpm_.build();
+    }
+
+    std::size_t group_count() const { return groups_.size(); }
+    const std::string& spec(int group) const { return groups_[static_cast<std::size_t>(group)].spec; }
+
+    std::uint32_t classify_v4(std::uint32_t addr) const {
+        std::uint32_t c = lpm_.lookup_v4(addr);
+        return c == core::dsa::IpLpm::kNoMatch ? kNoClass : c;
+    }
+
+    std::uint32_t classify_v6(const std::uint8_t* addr) const {
+        std::uint32_t c = lpm_.lookup_v6(addr);
+        return c == core::dsa::IpLpm::kNoMatch ? kNoClass : c;
+    }
+
+    bool contains(std::uint32_t address_class, int group) const {
+        auto g = static_cast<std::size_t>(group);
+        bool listed = (classes_[address_class * words_ + g / 64] >> (g % 64)) & 1;
+        return listed != groups_[g].negated;
+    }
+
+    std::size_t memory_usage() const {
+        return lpm_.memory_usage() + classes_.capacity() * sizeof(std::uint64_t);
+    }
+
+private:
+    using Key = std::tuple<bool, std::array<std::uint8_t, 16>, unsigned>;
+
+    struct Group {
+        std::string spec;
+        bool negated{false};
+        std::vector<core::dsa::IpPrefix> prefixes;
+    };
+
+    static Key key_of(const core::dsa::IpPrefix& p) { return Key{p.v6, p.addr, p.length}; }
+
+    static core::dsa::IpPrefix prefix_of(const Key& key) {
+        core::dsa::IpPrefix p;
+        p.v6 = std::get<0>(key);
+        p.addr = std::get<1>(key);
+        p.length = std::get<2>(key);
+        return p;
+    }
+
+    static void truncate(core::dsa::IpPrefix& p) {
+        for (unsigned i = 0; i < 16; ++i) {
+            unsigned start = i * 8;
+            if (start + 8 <= p.length) continue;
+            unsigned keep = p.length > start ? p.length - start : 0;
+            p.addr[i] &= static_cast<std::uint8_t>(0xFF00u >> keep);
+        }
+    }
+
+    std::vector<Group> groups_;
+    core::dsa::IpLpm lpm_{16};
+    std::vector<std::uint64_t> classes_; // words_ per class
+    std::size_t words_{0};
+};
+
+} // namespace detect
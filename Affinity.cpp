@@ -0,0 +1,174 @@
+#include "core/Affinity.hpp"
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <filesystem>
+#include <fstream>
+#include <pthread.h>
+#include <sched.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+namespace {
+
+#ifdef _WIN32
+// Flat CPU index <-> (processor group, number within the group)
+bool to_processor_number(int cpu, PROCESSOR_NUMBER& out) {
+    if (cpu < 0) return false;
+    DWORD remaining = static_cast<DWORD>(cpu);
+    WORD groups = GetActiveProcessorGroupCount();
+    for (WORD g = 0; g < groups; ++g) {
+        DWORD count = GetActiveProcessorCount(g);
+        if (remaining < count) {
+            out.Group = g;
+            out.Number = static_cast<BYTE>(remaining);
+            out.Reserved = 0;
+            return true;
+        }
+        remaining -= count;
+    }
+    return false;
+}
+#elif defined(__linux__)
+// Parses a sysfs CPU list such as "0-3,8-11" into node_of_cpu
+void assign_cpulist(const std::string& list, int node, std::vector<int>& node_of_cpu) {
+    std::size_t pos = 0;
+    while (pos < list.size()) {
+        std::size_t end = list.find(',', pos);
+        if (end == std::string::npos) end = list.size();
+        std::string item = list.substr(pos, end - pos);
+        pos = end + 1;
+        if (item.empty() || item[0] < '0' || item[0] > '9') continue;
+        std::size_t dash = item.find('-');
+        unsigned long first = std::stoul(item);
+        unsigned long last = dash == std::string::npos ? first : std::stoul(item.substr(dash + 1));
+        for (unsigned long c = first; c <= last && c < node_of_cpu.size(); ++c) node_of_cpu[c] = node;
+    }
+}
+#endif
+
+} // namespace
+
+std::string CpuTopology::describe() const {
+    std::string out = std::to_string(cpus()) + " CPUs, " + std::to_string(nodes) + " NUMA node" +
+                      (nodes == 1 ? "" : "s") + " (";
+    for (std::size_t n = 0; n < nodes; ++n) {
+        if (n != 0) out += ", ";
+        out += "node " + std::to_string(n) + ": ";
+        // Runs of consecutive CPUs on the node
+        bool first = true;
+        for (std::size_t c = 0; c < node_of_cpu.size(); ++c) {
+            if (node_of_cpu[c] != static_cast<int>(n)) continue;
+            std::size_t last = c;
+            while (last + 1 < node_of_cpu.size() && node_of_cpu[last + 1] == static_cast<int>(n)) ++last;
+            if (!first) out += ",";
+            out += std::to_string(c);
+            if (last != c) out += "-" + std::to_string(last);
+            first = false;
+            c = last;
+        }
+        if (first) out += "none";
+    }
+    return out + ")";
+}
+
+CpuTopology detect_topology() {
+    CpuTopology topology;
+#ifdef _WIN32
+    DWORD count = GetActiveProcessorCount(ALL_PROCESSOR_GROUPS);
+    topology.node_of_cpu.assign(count, 0);
+    int max_node = 0;
+    for (DWORD c = 0; c < count; ++c) {
+        PROCESSOR_NUMBER number{};
+        USHORT node = 0;
+        if (to_processor_number(static_cast<int>(c), number) && GetNumaProcessorNodeEx(&number, &node) &&
+            node != 0xFFFF) {
+            topology.node_of_cpu[c] = node;
+            if (node > max_node) max_node = node;
+        }
+    }
+    topology.nodes = static_cast<std::size_t>(max_node) + 1;
+#elif defined(__linux__)
+    long count = sysconf(_SC_NPROCESSORS_CONF);
+    topology.node_of_cpu.assign(count > 0 ? static_cast<std::size_t>(count) : 1, 0);
+    // One nodeN directory per NUMA node (none on kernels without NUMA)
+    std::size_t nodes = 0;
+    std::error_code ec;
+    for (const auto& dir : std::filesystem::directory_iterator("/sys/devices/system/node", ec)) {
+        std::string name = dir.path().filename().string();
+        if (name.size() < 5 || name.compare(0, 4, "node") != 0 || name[4] < '0' || name[4] > '9') continue;
+        int n = std::stoi(name.substr(4));
+        std::ifstream cpulist(dir.path() / "cpulist");
+        std::string list;
+        if (!std::getline(cpulist, list)) continue;
+        assign_cpulist(list, n, topology.node_of_cpu);
+        if (static_cast<std::size_t>(n) + 1 > nodes) nodes = static_cast<std::size_t>(n) + 1;
+    }
+    topology.nodes = nodes == 0 ? 1 : nodes;
+#else
+    unsigned count = std::thread::hardware_concurrency();
+    topology.node_of_cpu.assign(count ? count : 1, 0);
+#endif
+    return topology;
+}
+
+bool pin_current_thread(int cpu) {
+#ifdef _WIN32
+    PROCESSOR_NUMBER number{};
+    if (!to_processor_number(cpu, number)) {
+        std::cerr << "Cannot pin thread: no CPU " << cpu << std::endl;
+        return false;
+    }
+    GROUP_AFFINITY affinity{};
+    affinity.Group = number.Group;
+    affinity.Mask = KAFFINITY{1} << number.Number;
+    if (!SetThreadGroupAffinity(GetCurrentThread(), &affinity, nullptr)) {
+        std::cerr << "Cannot pin thread to CPU " << cpu << " (error " << GetLastError() << ")" << std::endl;
+        return false;
+    }
+    return true;
+#elif defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        std::cerr << "Cannot pin thread: no CPU " << cpu << std::endl;
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        std::cerr << "Cannot pin thread to CPU " << cpu << " (error " << rc << ")" << std::endl;
+        return false;
+    }
+    return true;
+#else
+    std::cerr << "Thread pinning is not supported on this platform (CPU " << cpu << ")" << std::endl;
+    return false;
+#endif
+}
+
+int current_cpu() {
+#ifdef _WIN32
+    PROCESSOR_NUMBER number{};
+    GetCurrentProcessorNumberEx(&number);
+    int cpu = 0;
+    for (WORD g = 0; g < number.Group; ++g) cpu += static_cast<int>(GetActiveProcessorCount(g));
+    return cpu + number.Number;
+#elif defined(__linux__)
+    return sched_getcpu();
+#else
+    return -1;
+#endif
+}
+
+} // namespace core
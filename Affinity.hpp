@@ -0,0 +1,59 @@
+#pragma once
+#include <cstddef>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+namespace core {
+
+// Logical CPUs and the NUMA node of each. CPU numbers are flat indexes
+// (on Windows counted across processor groups in group order).
+struct CpuTopology {
+    std::vector<int> node_of_cpu; // -1 where unknown
+    std::size_t nodes{1};
+
+    std::size_t cpus() const { return node_of_cpu.size(); }
+    int node(int cpu) const {
+        return cpu >= 0 && static_cast<std::size_t>(cpu) < node_of_cpu.size() ? node_of_cpu[static_cast<std::size_t>(cpu)] : -1;
+    }
+
+    // "16 CPUs, 2 NUMA nodes (node 0: 0-7, node 1: 8-15)"
+    std::string describe() const;
+};
+
+// Reads the topology from the OS; a single node when NUMA isn't reported
+CpuTopology detect_topology();
+
+// Pins the calling thread to one logical CPU. False (with a message) if
+// the CPU doesn't exist or the platform can't pin threads.
+bool pin_current_thread(int cpu);
+
+// CPU the calling thread is running on, -1 if unknown
+int current_cpu();
+
+// Runs fn on a temporary thread pinned to cpu and returns its result, so
+// memory fn allocates and first writes is placed on that CPU's NUMA node
+// (pages go to the node of the first thread touching them, the default
+// policy on Linux and Windows). cpu < 0 runs fn on the calling thread.
+template <typename Fn>
+auto on_cpu(int cpu, Fn&& fn) -> std::invoke_result_t<Fn&> {
+    if (cpu < 0) return fn();
+    using Result = std::invoke_result_t<Fn&>;
+    if constexpr (std::is_void_v<Result>) {
+        std::thread([&] {
+            pin_current_thread(cpu);
+            fn();
+        }).join();
+    } else {
+        Result result{};
+        std::thread([&] {
+            pin_current_thread(cpu);
+            result = fn();
+        }).join();
+        return result;
+    }
+}
+
+} // namespace core
@@ -1,10 +1,14 @@
 #pragma once
-#include <queue>
+#include <cstdint>
+#include <cstring>
 #include <string>
 #include <string_view>
 #include <unordered_map>
 #include <vector>
+#include <array>
+#include <atomic>
 #include <memory>
+#include "core/ThreadPool.hpp"
 
 namespace core { namespace dsa {
 
@@ -20,9 +24,37 @@ class AhoCorasick {
         Node* failure{nullptr};
         std::vector<std::size_t> output; // pattern IDs that end at this node
         bool is_root{false};
+        std::uint32_t id{0};             // state number in the flattened DFA
     };
 
+    // Flattened DFA entries carry this bit when the target state has output
+    static constexpr std::uint32_t kOutputFlag = 0x80000000u;
+
 public:
+    // Read-only view of the flattened DFA. Normally points at this object's
+    // own arrays; attach() can point it at externally owned memory such as
+    // a mapped compiled-ruleset file.
+    struct Tables {
+        const std::uint16_t* byte_class{nullptr};   // 256 entries
+        std::uint32_t class_count{0};
+        std::uint32_t state_count{0};
+        std::uint32_t output_count{0};
+        std::uint32_t pattern_count{0};
+        const std::uint32_t* delta{nullptr};        // state_count * class_count
+        const std::uint32_t* out_begin{nullptr};    // state_count + 1
+        const std::uint32_t* out_ids{nullptr};      // output_count
+        const std::uint32_t* pattern_length{nullptr}; // pattern_count
+    };
+
+    // Copies a transition table large enough to thrash the TLB somewhere
+    // cheaper to walk (huge pages) and returns the copy, owned by the
+    // returned pointer, or null to leave it where it is. None by default, so
+    // the matcher needs no platform code; the IDS installs
+    // core::place_on_huge_pages (Arena.cpp) at startup.
+    using TablePlacer = std::shared_ptr<void> (*)(const void* table, std::size_t bytes);
+
+    static void set_table_placer(TablePlacer placer) { table_placer().store(placer, std::memory_order_relaxed); }
+
     AhoCorasick() : root_(std::make_unique<Node>()) {
         root_->is_root = true;
         root_->failure = root_.get();
@@ -32,59 +64,68 @@ public:
     std::size_t add_pattern(std::string_view pattern) {
         std::size_t pattern_id = patterns_.size();
         patterns_.emplace_back(pattern);
-        
-        Node* current = root_.get();
-        for (char c : pattern) {
-            if (current->children.find(c) == current->children.end()) {
-                current->children[c] = std::make_unique<Node>();
-            }
-            current = current->children[c].get();
-        }
-        current->output.push_back(pattern_id);
-        
+        insert(root_.get(), pattern, pattern_id);
         built_ = false; // Need to rebuild failure links
         return pattern_id;
     }
 
-    // Build failure links (call after adding all patterns)
-    void build() {
-        if (built_) return;
-        
-        // BFS to build failure links
-        std::queue<Node*> queue;
-        
-        // Initialize first level
-        for (auto& [c, child] : root_->children) {
-            child->failure = root_.get();
-            queue.push(child.get());
+    // Adds patterns in order (IDs as add_pattern would give them). With a
+    // pool, patterns are split by first byte and each root subtree is built
+    // by one task, since subtrees share no nodes.
+    void add_patterns(const std::vector<std::string>& patterns, ThreadPool* pool = nullptr) {
+        if (!pool || patterns.size() < kParallelPatterns) {
+            for (const auto& p : patterns) add_pattern(p);
+            return;
         }
-        
-        while (!queue.empty()) {
-            Node* current = queue.front();
-            queue.pop();
-            
-            for (auto& [c, child] : current->children) {
-                queue.push(child.get());
-                
-                // Find failure link
-                Node* failure = current->failure;
-                while (failure != root_.get() && failure->children.find(c) == failure->children.end()) {
-                    failure = failure->failure;
-                }
-                
-                if (failure->children.find(c) != failure->children.end() && failure->children[c].get() != child.get()) {
-                    child->failure = failure->children[c].get();
-                } else {
-                    child->failure = root_.get();
-                }
-                
-                // Merge output from failure link
-                for (std::size_t pattern_id : child->failure->output) {
-                    child->output.push_back(pattern_id);
-                }
+        std::size_t first_id = patterns_.size();
+        std::array<std::vector<std::size_t>, 256> by_first;
+        for (std::size_t i = 0; i < patterns.size(); ++i) {
+            patterns_.push_back(patterns[i]);
+            if (patterns[i].empty()) {
+                root_->output.push_back(first_id + i);
+            } else {
+                by_first[static_cast<unsigned char>(patterns[i][0])].push_back(i);
             }
         }
-        
+        std::vector<std::pair<Node*, const std::vector<std::size_t>*>> subtrees;
+        for (unsigned b = 0; b < 256; ++b) {
+            if (by_first[b].empty()) continue;
+            auto& child = root_->children[static_cast<char>(b)];
+            if (!child) child = std::make_unique<Node>();
+            subtrees.emplace_back(child.get(), &by_first[b]);
+        }
+        pool->parallel_for(subtrees.size(), [&](std::size_t k) {
+            for (std::size_t i : *subtrees[k].second) {
+                insert(subtrees[k].first, std::string_view(patterns[i]).substr(1), first_id + i);
+            }
+        });
+        built_ = false;
+    }
+
+    // Build failure links and the DFA (call after adding all patterns). A
+    // node's failure link, inherited outputs and DFA row only read
+    // shallower nodes, so with a pool each depth level is filled in
+    // parallel ranges.
+    void build(ThreadPool* pool = nullptr) {
+        if (built_) return;
+
+        // Breadth-first order; nodes of depth d are order[level[d], level[d + 1])
+        std::vector<Node*> order{root_.get()};
+        std::vector<std::size_t> level{0, 1};
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            order[i]->id = static_cast<std::uint32_t>(i);
+            for (auto& [c, child] : order[i]->children) order.push_back(child.get());
+            if (i + 1 == level.back() && order.size() > level.back()) level.push_back(order.size());
+        }
+
+        // Links of depth d + 1 are set from the parents at depth d
+        for (std::size_t d = 0; d + 1 < level.size(); ++d) {
+            for_each_range(pool, level[d], level[d + 1], [&](std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) link_children(order[i]);
+            });
+        }
+
+        build_dfa(order, level, pool);
         built_ = true;
     }
 
@@ -93,43 +134,190 @@ public:
         if (!built_) build();
         
         std::vector<AhoCorasickMatch> matches;
-        Node* current = root_.get();
-        
+        scan(text, [&](std::size_t position, std::size_t pattern_id) {
+            matches.push_back({position, pattern_id, tables_.pattern_length[pattern_id]});
+        });
+        return matches;
+    }
+
+    // Allocation-free search over the flattened DFA; calls
+    // on_match(start_position, pattern_id) for every occurrence. Requires build().
+    template <typename F>
+    void scan(std::string_view text, F&& on_match) const {
+        const Tables& t = tables_;
+        const std::size_t classes = t.class_count;
+        std::uint32_t state = 0;
         for (std::size_t i = 0; i < text.size(); ++i) {
-            char c = text[i];
-            
-            // Follow failure links until we find a match or reach root
-            while (current != root_.get() && current->children.find(c) == current->children.end()) {
-                current = current->failure;
-            }
-            
-            if (current->children.find(c) != current->children.end()) {
-                current = current->children[c].get();
-            }
-            
-            // Report all patterns that end at this position
-            for (std::size_t pattern_id : current->output) {
-                matches.push_back({
-                    i + 1 - patterns_[pattern_id].size(), // start position
-                    pattern_id,
-                    patterns_[pattern_id].size()
-                });
+            std::uint32_t next = t.delta[state * classes + t.byte_class[static_cast<unsigned char>(text[i])]];
+            state = next & ~kOutputFlag;
+            if (next & kOutputFlag) {
+                for (std::uint32_t o = t.out_begin[state]; o < t.out_begin[state + 1]; ++o) {
+                    std::size_t pattern_id = t.out_ids[o];
+                    on_match(i + 1 - t.pattern_length[pattern_id], pattern_id);
+                }
             }
         }
-        
-        return matches;
     }
 
+    // Search-only mode over externally owned tables, used in place (never
+    // handed to the TablePlacer, which would keep a second copy); the caller
+    // keeps the memory alive. add_pattern()/get_pattern() are unavailable
+    // afterwards.
+    void attach(const Tables& tables) {
+        tables_ = tables;
+        built_ = true;
+    }
+
+    const Tables& tables() const { return tables_; }
+
     const std::string& get_pattern(std::size_t pattern_id) const {
         return patterns_[pattern_id];
     }
 
-    std::size_t pattern_count() const { return patterns_.size(); }
+    std::size_t pattern_count() const { return tables_.pattern_count ? tables_.pattern_count : patterns_.size(); }
+    std::size_t state_count() const { return tables_.state_count; }
+
+    // Approximate heap bytes owned by this object (attached tables are not owned)
+    std::size_t memory_usage() const {
+        std::size_t bytes = byte_class_.capacity() * sizeof(std::uint16_t);
+        bytes += (delta_.capacity() + out_begin_.capacity() + out_ids_.capacity() + pattern_length_.capacity()) *
+                 sizeof(std::uint32_t);
+        if (placed_delta_) bytes += std::size_t{tables_.state_count} * tables_.class_count * sizeof(std::uint32_t);
+        for (const auto& p : patterns_) bytes += sizeof(std::string) + p.capacity();
+        if (!patterns_.empty()) bytes += tables_.state_count * (sizeof(Node) + 48); // trie nodes incl. child map entries
+        return bytes;
+    }
 
 private:
+    void insert(Node* current, std::string_view suffix, std::size_t pattern_id) {
+        for (char c : suffix) {
+            auto& child = current->children[c];
+            if (!child) child = std::make_unique<Node>();
+            current = child.get();
+        }
+        current->output.push_back(pattern_id);
+    }
+
+    void link_children(Node* node) const {
+        for (auto& [c, child] : node->children) {
+            child->failure = root_.get();
+            if (node->is_root) continue;
+            Node* failure = node->failure;
+            while (failure != root_.get() && failure->children.find(c) == failure->children.end()) {
+                failure = failure->failure;
+            }
+            auto it = failure->children.find(c);
+            if (it != failure->children.end()) child->failure = it->second.get();
+
+            // Merge output from failure link
+            const auto& inherited = child->failure->output;
+            child->output.insert(child->output.end(), inherited.begin(), inherited.end());
+        }
+    }
+
+    // Runs f(begin, end) over [begin, end), split across the pool when the
+    // range is large enough to pay for it
+    template <typename F>
+    static void for_each_range(ThreadPool* pool, std::size_t begin, std::size_t end, F&& f) {
+        if (!pool || end - begin < 2 * kParallelNodes) {
+            f(begin, end);
+            return;
+        }
+        pool->parallel_ranges(end - begin, kParallelNodes,
+                              [&](std::size_t b, std::size_t e) { f(begin + b, begin + e); });
+    }
+
+    // Flattens the trie plus failure links into a dense transition table over
+    // byte equivalence classes (one class per byte used by any pattern, plus
+    // one for all other bytes), so search is one table load per byte.
+    void build_dfa(const std::vector<Node*>& order, const std::vector<std::size_t>& level, ThreadPool* pool) {
+        byte_class_.assign(256, 0);
+        class_count_ = 1;
+        for (const auto& p : patterns_) {
+            for (unsigned char c : p) {
+                if (byte_class_[c] == 0) byte_class_[c] = static_cast<std::uint16_t>(class_count_++);
+            }
+        }
+
+        delta_.assign(order.size() * class_count_, 0);
+        out_begin_.assign(order.size() + 1, 0);
+        out_ids_.clear();
+        for (Node* node : order) {
+            out_begin_[node->id] = static_cast<std::uint32_t>(out_ids_.size());
+            for (std::size_t pattern_id : node->output) out_ids_.push_back(static_cast<std::uint32_t>(pattern_id));
+        }
+        out_begin_[order.size()] = static_cast<std::uint32_t>(out_ids_.size());
+
+        // A node's failure state is shallower, so its row is filled in first
+        std::vector<std::uint32_t> class_rep(class_count_, 0);
+        for (unsigned b = 256; b-- > 0;) class_rep[byte_class_[b]] = b;
+        auto fill_rows = [&](std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const Node* node = order[i];
+                for (std::size_t cls = 0; cls < class_count_; ++cls) {
+                    char c = static_cast<char>(class_rep[cls]);
+                    auto it = node->children.find(c);
+                    std::uint32_t next = 0;
+                    if (cls != 0 && it != node->children.end()) {
+                        Node* child = it->second.get();
+                        next = child->id | (child->output.empty() ? 0 : kOutputFlag);
+                    } else if (!node->is_root) {
+                        next = delta_[node->failure->id * class_count_ + cls];
+                    }
+                    delta_[node->id * class_count_ + cls] = next;
+                }
+            }
+        };
+        for (std::size_t d = 0; d + 1 < level.size(); ++d) for_each_range(pool, level[d], level[d + 1], fill_rows);
+
+        pattern_length_.clear();
+        for (const auto& p : patterns_) pattern_length_.push_back(static_cast<std::uint32_t>(p.size()));
+
+        tables_.byte_class = byte_class_.data();
+        tables_.class_count = static_cast<std::uint32_t>(class_count_);
+        tables_.state_count = static_cast<std::uint32_t>(order.size());
+        tables_.output_count = static_cast<std::uint32_t>(out_ids_.size());
+        tables_.pattern_count = static_cast<std::uint32_t>(patterns_.size());
+        tables_.delta = delta_.data();
+        tables_.out_begin = out_begin_.data();
+        tables_.out_ids = out_ids_.data();
+        tables_.pattern_length = pattern_length_.data();
+        place_delta();
+    }
+
+    // Hands a large built transition table to the installed TablePlacer
+    void place_delta() {
+        std::size_t bytes = std::size_t{tables_.state_count} * tables_.class_count * sizeof(std::uint32_t);
+        TablePlacer placer = table_placer().load(std::memory_order_relaxed);
+        if (!placer || bytes < kHugeTableBytes) return;
+        std::shared_ptr<void> placed = placer(tables_.delta, bytes);
+        if (!placed) return;
+        placed_delta_ = std::move(placed);
+        tables_.delta = static_cast<const std::uint32_t*>(placed_delta_.get());
+        delta_ = std::vector<std::uint32_t>();
+    }
+
+    static std::atomic<TablePlacer>& table_placer() {
+        static std::atomic<TablePlacer> placer{nullptr};
+        return placer;
+    }
+
+    static constexpr std::size_t kHugeTableBytes = std::size_t{2} << 20;
+    static constexpr std::size_t kParallelPatterns = 4096; // below this a serial trie build is cheaper
+    static constexpr std::size_t kParallelNodes = 2048;    // nodes per range in a parallel level
+
     std::unique_ptr<Node> root_;
     std::vector<std::string> patterns_;
     bool built_{false};
+
+    std::vector<std::uint16_t> byte_class_ = std::vector<std::uint16_t>(256, 0); // heap-backed so moves keep tables_ valid
+    std::size_t class_count_{1};
+    std::vector<std::uint32_t> delta_;
+    std::shared_ptr<void> placed_delta_;             // delta_ moved by the TablePlacer, when large
+    std::vector<std::uint32_t> out_begin_;
+    std::vector<std::uint32_t> out_ids_;
+    std::vector<std::uint32_t> pattern_length_;
+    Tables tables_{};
 };
 
 }} // namespace core::dsa
@@ -0,0 +1,175 @@
+#include "core/Arena.hpp"
+#include <atomic>
+#include <cstring>
+#include <utility>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+namespace core {
+
+namespace {
+
+std::atomic<HugePages> g_default_huge_pages{HugePages::Off};
+
+constexpr std::size_t kPage2M = std::size_t{2} << 20;
+constexpr std::size_t kPage1G = std::size_t{1} << 30;
+
+std::size_t round_up(std::size_t bytes, std::size_t page) { return (bytes + page - 1) / page * page; }
+
+} // namespace
+
+bool parse_huge_pages(std::string_view text, HugePages& out) {
+    if (text == "off" || text == "false" || text.empty()) out = HugePages::Off;
+    else if (text == "thp" || text == "transparent") out = HugePages::Transparent;
+    else if (text == "2m" || text == "2M") out = HugePages::Huge2M;
+    else if (text == "1g" || text == "1G") out = HugePages::Huge1G;
+    else return false;
+    return true;
+}
+
+const char* huge_pages_name(HugePages pages) {
+    switch (pages) {
+    case HugePages::Transparent: return "transparent huge pages";
+    case HugePages::Huge2M: return "2 MB pages";
+    case HugePages::Huge1G: return "1 GB pages";
+    default: return "normal pages";
+    }
+}
+
+HugePages default_huge_pages() { return g_default_huge_pages.load(std::memory_order_relaxed); }
+void set_default_huge_pages(HugePages pages) { g_default_huge_pages.store(pages, std::memory_order_relaxed); }
+
+std::shared_ptr<void> place_on_huge_pages(const void* table, std::size_t bytes) {
+    HugePages pages = default_huge_pages();
+    if (pages == HugePages::Off) return nullptr;
+    auto region = std::make_shared<PageRegion>();
+    if (!region->map(bytes, pages) || region->backing() == HugePages::Off) return nullptr;
+    std::memcpy(region->data(), table, bytes);
+    return std::shared_ptr<void>(region, region->data());
+}
+
+PageRegion::PageRegion(PageRegion&& other) noexcept
+    : data_(std::exchange(other.data_, nullptr)), size_(std::exchange(other.size_, 0)),
+      mapped_(std::exchange(other.mapped_, 0)), base_(std::exchange(other.base_, nullptr)),
+      backing_(std::exchange(other.backing_, HugePages::Off)) {}
+
+PageRegion& PageRegion::operator=(PageRegion&& other) noexcept {
+    if (this != &other) {
+        unmap();
+        data_ = std::exchange(other.data_, nullptr);
+        size_ = std::exchange(other.size_, 0);
+        mapped_ = std::exchange(other.mapped_, 0);
+        base_ = std::exchange(other.base_, nullptr);
+        backing_ = std::exchange(other.backing_, HugePages::Off);
+    }
+    return *this;
+}
+
+bool PageRegion::map(std::size_t bytes, HugePages wanted) {
+    unmap();
+    if (bytes == 0) return false;
+#ifdef _WIN32
+    if (wanted == HugePages::Huge2M || wanted == HugePages::Huge1G) {
+        std::size_t large = GetLargePageMinimum();
+        if (large != 0) {
+            std::size_t size = round_up(bytes, large);
+            void* p = VirtualAlloc(nullptr, size, MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES, PAGE_READWRITE);
+            if (p) {
+                base_ = p;
+                data_ = static_cast<std::uint8_t*>(p);
+                size_ = mapped_ = size;
+                backing_ = large >= kPage1G ? HugePages::Huge1G : HugePages::Huge2M;
+                return true;
+            }
+        }
+    }
+    void* p = VirtualAlloc(nullptr, bytes, MEM_RESERVE | MEM_COMMIT, PAGE_READWRITE);
+    if (!p) return false;
+    base_ = p;
+    data_ = static_cast<std::uint8_t*>(p);
+    size_ = mapped_ = bytes;
+    backing_ = HugePages::Off;
+    return true;
+#else
+    auto try_map = [&](std::size_t size, int extra_flags) -> void* {
+        void* p = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | extra_flags, -1, 0);
+        return p == MAP_FAILED ? nullptr : p;
+    };
+#if defined(MAP_HUGETLB)
+    // MAP_HUGE_* select the page size in bits 26..31 of the flags
+    constexpr int kHuge2M = 21 << 26;
+    constexpr int kHuge1G = 30 << 26;
+    if (wanted == HugePages::Huge1G) {
+        std::size_t size = round_up(bytes, kPage1G);
+        if (void* p = try_map(size, MAP_HUGETLB | kHuge1G)) {
+            base_ = p;
+            data_ = static_cast<std::uint8_t*>(p);
+            size_ = mapped_ = size;
+            backing_ = HugePages::Huge1G;
+            return true;
+        }
+    }
+    if (wanted == HugePages::Huge1G || wanted == HugePages::Huge2M) {
+        std::size_t size = round_up(bytes, kPage2M);
+        if (void* p = try_map(size, MAP_HUGETLB | kHuge2M)) {
+            base_ = p;
+            data_ = static_cast<std::uint8_t*>(p);
+            size_ = mapped_ = size;
+            backing_ = HugePages::Huge2M;
+            return true;
+        }
+    }
+#endif
+    if (wanted != HugePages::Off) {
+        // Map 2 MB extra so the usable part starts on a 2 MB boundary, which
+        // lets the kernel back it with huge pages from the first byte
+        std::size_t size = round_up(bytes, kPage2M);
+        if (void* p = try_map(size + kPage2M, 0)) {
+            auto addr = reinterpret_cast<std::uintptr_t>(p);
+            auto aligned = (addr + kPage2M - 1) & ~(std::uintptr_t{kPage2M} - 1);
+            base_ = p;
+            data_ = reinterpret_cast<std::uint8_t*>(aligned);
+            size_ = size;
+            mapped_ = size + kPage2M;
+            backing_ = HugePages::Off;
+#if defined(MADV_HUGEPAGE)
+            if (madvise(data_, size_, MADV_HUGEPAGE) == 0) backing_ = HugePages::Transparent;
+#endif
+            return true;
+        }
+    }
+    void* p = try_map(bytes, 0);
+    if (!p) return false;
+    base_ = p;
+    data_ = static_cast<std::uint8_t*>(p);
+    size_ = mapped_ = bytes;
+    backing_ = HugePages::Off;
+    return true;
+#endif
+}
+
+void PageRegion::unmap() {
+    if (!base_) return;
+#ifdef _WIN32
+    VirtualFree(base_, 0, MEM_RELEASE);
+#else
+    munmap(base_, mapped_);
+#endif
+    base_ = nullptr;
+    data_ = nullptr;
+    size_ = mapped_ = 0;
+    backing_ = HugePages::Off;
+}
+
+} // namespace core
@@ -0,0 +1,167 @@
+#pragma once
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <new>
+#include <string_view>
+
+namespace core {
+
+// Page size backing a region, in order of preference when falling back
+enum class HugePages { Off, Transparent, Huge2M, Huge1G };
+
+// "off", "thp" (transparent, madvise), "2m", "1g"
+bool parse_huge_pages(std::string_view text, HugePages& out);
+const char* huge_pages_name(HugePages pages);
+
+// Process-wide choice for structures that size themselves (DFA tables);
+// set once at startup from the config
+HugePages default_huge_pages();
+void set_default_huge_pages(HugePages pages);
+
+// Copy of table in a region on default_huge_pages(), owned by the returned
+// pointer; null when huge pages are off or none could be mapped. Installed
+// as the AhoCorasick::TablePlacer by the IDS.
+std::shared_ptr<void> place_on_huge_pages(const void* table, std::size_t bytes);
+
+// One anonymous memory mapping, zero-filled. map() tries the requested
+// huge page size and falls back to smaller ones (1 GB -> 2 MB ->
+// transparent -> normal pages), so it only fails when no memory can be
+// mapped at all; backing() tells what was obtained.
+//   Linux    MAP_HUGETLB (needs pages reserved in /proc/sys/vm/nr_hugepages
+//            or hugetlbfs), MADV_HUGEPAGE for transparent huge pages
+//   Windows  MEM_LARGE_PAGES (needs SeLockMemoryPrivilege; no 1 GB or
+//            transparent pages)
+class PageRegion {
+public:
+    PageRegion() = default;
+    ~PageRegion() { unmap(); }
+
+    PageRegion(const PageRegion&) = delete;
+    PageRegion& operator=(const PageRegion&) = delete;
+    PageRegion(PageRegion&& other) noexcept;
+    PageRegion& operator=(PageRegion&& other) noexcept;
+
+    bool map(std::size_t bytes, HugePages wanted);
+    void unmap();
+
+    std::uint8_t* data() const { return data_; }
+    std::size_t size() const { return size_; }
+    HugePages backing() const { return backing_; }
+
+private:
+    std::uint8_t* data_{nullptr};
+    std::size_t size_{0};        // usable bytes, at least the requested size
+    std::size_t mapped_{0};      // bytes to unmap
+    void* base_{nullptr};        // start of the mapping (before alignment trimming)
+    HugePages backing_{HugePages::Off};
+};
+
+// Bump allocator over a PageRegion for one owning thread. Freed blocks go
+// to per-size-class free lists (16-byte steps up to 1 KB, powers of two
+// above), so containers that allocate and free nodes of a few sizes, such
+// as the flow table under eviction churn, reuse arena memory instead of
+// growing it. Blocks are 16-byte aligned, and those of 2 KB and more
+// start on a cache line; allocate() returns nullptr when the region is
+// exhausted or more alignment is requested, and ArenaAllocator then falls
+// back to the heap.
+class Arena {
+public:
+    Arena(std::size_t capacity, HugePages wanted) { region_.map(capacity, wanted); }
+
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+
+    void* allocate(std::size_t bytes, std::size_t align = alignof(std::max_align_t)) {
+        if (bytes == 0) return nullptr;
+        std::size_t cls = size_class(bytes);
+        if (cls >= kClasses || align > (cls < kSmallClasses ? kAlign : kLargeAlign)) return nullptr;
+        if (FreeBlock* block = free_[cls]) {
+            free_[cls] = block->next;
+            return block;
+        }
+        std::size_t start = cls < kSmallClasses ? used_ : (used_ + kLargeAlign - 1) & ~(kLargeAlign - 1);
+        std::size_t size = block_size(cls);
+        if (start > region_.size() || size > region_.size() - start) return nullptr;
+        void* p = region_.data() + start;
+        used_ = start + size;
+        return p;
+    }
+
+    void deallocate(void* p, std::size_t bytes) {
+        std::size_t cls = size_class(bytes);
+        auto* block = static_cast<FreeBlock*>(p);
+        block->next = free_[cls];
+        free_[cls] = block;
+    }
+
+    bool owns(const void* p) const {
+        auto* byte = static_cast<const std::uint8_t*>(p);
+        return region_.data() != nullptr && byte >= region_.data() && byte < region_.data() + region_.size();
+    }
+
+    std::size_t capacity() const { return region_.size(); }
+    std::size_t used() const { return used_; }
+    HugePages backing() const { return region_.backing(); }
+
+    static constexpr std::size_t kAlign = 16;
+    static constexpr std::size_t kLargeAlign = 64;
+    static constexpr std::size_t kSmallClasses = 64; // 16, 32, ... 1024
+    static constexpr std::size_t kClasses = kSmallClasses + 30;
+
+    // Size class of a request and the block size it is served with
+    static std::size_t size_class(std::size_t bytes) {
+        if (bytes <= kSmallClasses * kAlign) return (bytes + kAlign - 1) / kAlign - (bytes != 0);
+        return kSmallClasses + static_cast<std::size_t>(std::bit_width(bytes - 1)) - 11;
+    }
+    static std::size_t block_size(std::size_t cls) {
+        return cls < kSmallClasses ? (cls + 1) * kAlign : std::size_t{2048} << (cls - kSmallClasses);
+    }
+
+private:
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+
+    PageRegion region_;
+    std::size_t used_{0};
+    FreeBlock* free_[kClasses]{};
+};
+
+// Standard allocator drawing from an Arena, or from the heap without one or
+// once the arena is exhausted; blocks go back to where they came from
+template <typename T>
+class ArenaAllocator {
+public:
+    using value_type = T;
+
+    ArenaAllocator() noexcept = default;
+    explicit ArenaAllocator(Arena* arena) noexcept : arena_(arena) {}
+    template <typename U>
+    ArenaAllocator(const ArenaAllocator<U>& other) noexcept : arena_(other.arena()) {}
+
+    T* allocate(std::size_t n) {
+        void* p = arena_ ? arena_->allocate(n * sizeof(T), alignof(T)) : nullptr;
+        if (!p) p = ::operator new(n * sizeof(T), std::align_val_t{alignof(T)});
+        return static_cast<T*>(p);
+    }
+
+    void deallocate(T* p, std::size_t n) noexcept {
+        if (arena_ && arena_->owns(p)) {
+            arena_->deallocate(p, n * sizeof(T));
+        } else {
+            ::operator delete(p, n * sizeof(T), std::align_val_t{alignof(T)});
+        }
+    }
+
+    Arena* arena() const noexcept { return arena_; }
+
+    template <typename U>
+    bool operator==(const ArenaAllocator<U>& other) const noexcept { return arena_ == other.arena(); }
+
+private:
+    Arena* arena_{nullptr};
+};
+
+} // namespace core
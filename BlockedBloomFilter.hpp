@@ -0,0 +1,248 @@
+#pragma once
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/CpuFeatures.hpp"
+#include "core/Hash.hpp"
+#include "core/MappedFile.hpp"
+
+#if defined(__GNUC__) || defined(__clang__)
+#define IDS_BLOOM_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define IDS_BLOOM_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define IDS_BLOOM_PREFETCH(p) ((void)0)
+#endif
+
+namespace core { namespace dsa {
+
+// Split-block Bloom filter for large IOC sets (IPs, domains, file hashes).
+//
+// Each key touches a single 256-bit block, i.e. one cache line at most,
+// instead of k lines spread over the array. The high 32 bits of the key's
+// 64-bit hash pick the block; the low 32 bits, multiplied by eight odd
+// salts, pick one bit in each of the block's eight 32-bit words. With AVX2
+// a whole block is tested with one multiply, shift and vptest. At ~10 bits
+// per key the false positive rate is about 1%.
+//
+// contains_batch() prefetches blocks ahead of the probe loop so misses
+// overlap, and takes the AVX2 kernel when the CPU has it (chosen at run
+// time, see core/CpuFeatures.hpp); single queries use AVX2 only in builds
+// that target it. A filter can be saved and mapped back (or attached to memory
+// embedded in another image) without rehashing any key.
+class BlockedBloomFilter {
+public:
+    struct alignas(32) Block {
+        std::uint32_t words[8];
+    };
+
+    BlockedBloomFilter() = default;
+
+    explicit BlockedBloomFilter(std::size_t expected_items, double bits_per_item = 10.0) {
+        reset(expected_items, bits_per_item);
+    }
+
+    BlockedBloomFilter(BlockedBloomFilter&&) = default;
+    BlockedBloomFilter& operator=(BlockedBloomFilter&&) = default;
+
+    void reset(std::size_t expected_items, double bits_per_item = 10.0) {
+        auto bits = static_cast<double>(expected_items) * bits_per_item;
+        auto blocks = static_cast<std::size_t>(std::ceil(bits / 256.0));
+        image_.close();
+        owned_.assign(blocks ? blocks : 1, Block{});
+        blocks_ = owned_.data();
+        block_count_ = owned_.size();
+    }
+
+    // Only a filter built in memory (reset()) takes inserts; a loaded or
+    // attached one is read-only and rejects them
+    bool insert_hash(std::uint64_t hash) {
+        if (!writable()) return false;
+        Block& block = owned_[block_index(hash)];
+        std::uint32_t masks[8];
+        make_masks(static_cast<std::uint32_t>(hash), masks);
+        for (int i = 0; i < 8; ++i) block.words[i] |= masks[i];
+        return true;
+    }
+
+    bool contains_hash(std::uint64_t hash) const {
+        if (!blocks_) return false;
+        const Block& block = blocks_[block_index(hash)];
+#if defined(__AVX2__)
+        return test_block_avx2(block, static_cast<std::uint32_t>(hash));
+#else
+        return test_block(block, static_cast<std::uint32_t>(hash));
+#endif
+    }
+
+    bool insert(std::string_view key) { return insert_hash(core::hash64(key)); }
+    bool possibly_contains(std::string_view key) const { return contains_hash(core::hash64(key)); }
+
+    // Bulk build: inserts with the next blocks prefetched
+    bool insert_batch(const std::uint64_t* hashes, std::size_t n) {
+        if (!writable()) return false;
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i + kPrefetchDistance < n) IDS_BLOOM_PREFETCH(&owned_[block_index(hashes[i + kPrefetchDistance])]);
+            insert_hash(hashes[i]);
+        }
+        return true;
+    }
+
+    // out[i] = 1 if hashes[i] may be in the set. Blocks are prefetched
+    // kPrefetchDistance keys ahead so independent misses overlap.
+    void contains_batch(const std::uint64_t* hashes, std::size_t n, std::uint8_t* out) const {
+        if (!blocks_) {
+            std::memset(out, 0, n);
+            return;
+        }
+#if defined(IDS_X86_SIMD)
+        if (simd_ == SimdLevel::Avx2) {
+            contains_batch_avx2(hashes, n, out);
+            return;
+        }
+#endif
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i + kPrefetchDistance < n) IDS_BLOOM_PREFETCH(&blocks_[block_index(hashes[i + kPrefetchDistance])]);
+            out[i] = test_block(blocks_[block_index(hashes[i])], static_cast<std::uint32_t>(hashes[i])) ? 1 : 0;
+        }
+    }
+
+    // Kernel contains_batch() uses; limit_simd() lowers it (benchmarks)
+    SimdLevel simd_level() const { return simd_; }
+    void limit_simd(SimdLevel level) { simd_ = std::min(simd_, level); }
+
+    bool writable() const { return !owned_.empty(); }
+    std::size_t block_count() const { return block_count_; }
+    std::size_t byte_size() const { return block_count_ * sizeof(Block); }
+    const Block* data() const { return blocks_; }
+    std::size_t memory_usage() const { return owned_.capacity() * sizeof(Block); }
+
+    // Uses externally owned blocks (e.g. a section of a mapped image) in
+    // place; data must stay valid and 32-byte aligned.
+    void attach(const Block* blocks, std::size_t count) {
+        image_.close();
+        owned_.clear();
+        blocks_ = blocks;
+        block_count_ = count;
+    }
+
+    bool save(const std::string& path) const {
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.version = kFormatVersion;
+        header.byte_order = kByteOrder;
+        header.block_count = block_count_;
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "[BlockedBloomFilter] Cannot write " << tmp << std::endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(blocks_), static_cast<std::streamsize>(byte_size()));
+            if (!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    // Maps a filter written by save(); the blocks are used in place
+    bool load(const std::string& path) {
+        core::MappedFile image;
+        if (!image.open(path) || image.size() < sizeof(Header)) return false;
+        Header header{};
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0 || header.version != kFormatVersion ||
+            header.byte_order != kByteOrder || header.block_count == 0 ||
+            header.block_count != (image.size() - sizeof(Header)) / sizeof(Block) ||
+            sizeof(Header) + header.block_count * sizeof(Block) != image.size()) {
+            return false;
+        }
+        owned_.clear();
+        image_ = std::move(image);
+        blocks_ = reinterpret_cast<const Block*>(image_.data() + sizeof(Header));
+        block_count_ = header.block_count;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kPrefetchDistance = 8;
+    static constexpr char kMagic[8] = {'I', 'D', 'S', 'B', 'L', 'O', 'O', 'M'};
+    static constexpr std::uint32_t kFormatVersion = 2; // 2: hash64 mixing changed
+    static constexpr std::uint32_t kByteOrder = 0x01020304u;
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t block_count;
+        std::uint64_t reserved[5];
+    };
+    static_assert(sizeof(Header) % sizeof(Block) == 0, "blocks after the header must stay 32-byte aligned");
+
+    static constexpr std::uint32_t kSalt[8] = {0x47b6137bu, 0x44974d91u, 0x8824ad5bu, 0xa2b7289du,
+                                               0x705495c7u, 0x2df1424bu, 0x9efc4947u, 0x5c6bfb31u};
+
+    // Multiply-shift of the high half onto [0, block_count): no power-of-two size needed
+    std::size_t block_index(std::uint64_t hash) const {
+        return static_cast<std::size_t>(((hash >> 32) * block_count_) >> 32);
+    }
+
+    static void make_masks(std::uint32_t key, std::uint32_t* masks) {
+        for (int i = 0; i < 8; ++i) masks[i] = 1u << ((key * kSalt[i]) >> 27);
+    }
+
+    static bool test_block(const Block& block, std::uint32_t key) {
+        std::uint32_t masks[8];
+        make_masks(key, masks);
+        for (int i = 0; i < 8; ++i) {
+            if ((block.words[i] & masks[i]) != masks[i]) return false;
+        }
+        return true;
+    }
+
+#if defined(IDS_X86_SIMD)
+    IDS_TARGET_AVX2 static __m256i make_mask(std::uint32_t key) {
+        const __m256i salt = _mm256_setr_epi32(static_cast<int>(kSalt[0]), static_cast<int>(kSalt[1]),
+                                               static_cast<int>(kSalt[2]), static_cast<int>(kSalt[3]),
+                                               static_cast<int>(kSalt[4]), static_cast<int>(kSalt[5]),
+                                               static_cast<int>(kSalt[6]), static_cast<int>(kSalt[7]));
+        __m256i bit = _mm256_srli_epi32(_mm256_mullo_epi32(_mm256_set1_epi32(static_cast<int>(key)), salt), 27);
+        return _mm256_sllv_epi32(_mm256_set1_epi32(1), bit);
+    }
+
+    IDS_TARGET_AVX2 static bool test_block_avx2(const Block& block, std::uint32_t key) {
+        __m256i bits = _mm256_load_si256(reinterpret_cast<const __m256i*>(block.words));
+        return _mm256_testc_si256(bits, make_mask(key)) != 0;
+    }
+
+    IDS_TARGET_AVX2 void contains_batch_avx2(const std::uint64_t* hashes, std::size_t n, std::uint8_t* out) const {
+        for (std::size_t i = 0; i < n; ++i) {
+            if (i + kPrefetchDistance < n) IDS_BLOOM_PREFETCH(&blocks_[block_index(hashes[i + kPrefetchDistance])]);
+            out[i] = test_block_avx2(blocks_[block_index(hashes[i])], static_cast<std::uint32_t>(hashes[i])) ? 1 : 0;
+        }
+    }
+#endif
+
+    std::vector<Block> owned_;
+    core::MappedFile image_;
+    const Block* blocks_{nullptr};
+    std::size_t block_count_{0};
+    SimdLevel simd_{cpu_simd_level()};
+};
+
+}} // namespace core::dsa
@@ -0,0 +1,82 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+
+namespace core { namespace dsa {
+
+// Bounded multi-producer / single-consumer queue (Vyukov's sequence-numbered
+// ring). Producers claim a slot with one CAS and fill it in place; a full
+// queue fails the push instead of blocking or allocating. Slots are
+// allocated once, so T should be cheap to overwrite (fixed-size records).
+template <typename T>
+class BoundedQueueMPSC {
+public:
+    // capacity is rounded up to a power of two
+    explicit BoundedQueueMPSC(std::size_t capacity)
+        : mask_(std::bit_ceil(capacity < 2 ? std::size_t{2} : capacity) - 1),
+          slots_(std::make_unique<Slot[]>(mask_ + 1)) {
+        for (std::size_t i = 0; i <= mask_; ++i) slots_[i].sequence.store(i, std::memory_order_relaxed);
+    }
+
+    BoundedQueueMPSC(const BoundedQueueMPSC&) = delete;
+    BoundedQueueMPSC& operator=(const BoundedQueueMPSC&) = delete;
+
+    // fill(T&) writes the element in place. Returns false if the queue is full.
+    template <typename Fill>
+    bool try_emplace(Fill&& fill) {
+        std::size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots_[pos & mask_];
+            std::size_t seq = slot->sequence.load(std::memory_order_acquire);
+            auto diff = static_cast<std::intptr_t>(seq) - static_cast<std::intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) break;
+            } else if (diff < 0) {
+                return false; // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+        fill(slot->value);
+        slot->sequence.store(pos + 1, std::memory_order_release);
+        return true;
+    }
+
+    bool try_push(const T& v) {
+        return try_emplace([&](T& slot) { slot = v; });
+    }
+
+    // Consumer only. visit(const T&) reads the element in place.
+    template <typename Visit>
+    bool try_consume(Visit&& visit) {
+        Slot& slot = slots_[dequeue_pos_ & mask_];
+        if (slot.sequence.load(std::memory_order_acquire) != dequeue_pos_ + 1) return false;
+        visit(static_cast<const T&>(slot.value));
+        slot.sequence.store(dequeue_pos_ + mask_ + 1, std::memory_order_release);
+        ++dequeue_pos_;
+        return true;
+    }
+
+    bool try_pop(T& out) {
+        return try_consume([&](const T& v) { out = v; });
+    }
+
+    std::size_t capacity() const { return mask_ + 1; }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence{0};
+        T value{};
+    };
+
+    std::size_t mask_;
+    std::unique_ptr<Slot[]> slots_;
+    alignas(64) std::atomic<std::size_t> enqueue_pos_{0};
+    alignas(64) std::size_t dequeue_pos_{0}; // consumer only
+};
+
+}} // namespace core::dsa
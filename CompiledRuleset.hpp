@@ -0,0 +1,516 @@
+#pragma once
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/MappedFile.hpp"
+#include "config/ConfigLoader.hpp"
+#include "detect/Engine.hpp"
+
+namespace detect {
+
+// Versioned binary image of a compiled Engine: rule metadata, the global
+// literal table, per-group tables and the flattened Aho-Corasick DFAs.
+//
+// Integers are host-endian (checked via byte_order) and every section is
+// 8-byte aligned, so a mapped image is used in place: automaton groups
+// point straight into the mapping. Teddy and memchr groups are rebuilt from
+// the literal table (linear in at most 64 literals) and regexes are
+// recompiled from their source, which is cheap next to the automaton BFS.
+class CompiledRuleset {
+public:
+    static constexpr std::uint32_t kFormatVersion = 5;
+
+    // Hash of the rule files' contents plus the format version
+    static bool hash_files(const std::vector<std::string>& paths, std::uint64_t& hash) {
+        if (!config::hash_files(paths, hash)) return false;
+        for (int shift = 0; shift < 32; shift += 8) {
+            hash ^= static_cast<std::uint8_t>(kFormatVersion >> shift);
+            hash *= 1099511628211ull;
+        }
+        return true;
+    }
+
+    static bool save(const Engine& engine, const std::string& path, std::uint64_t source_hash) {
+        Writer w;
+        w.reserve(sizeof(Header));
+
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.version = kFormatVersion;
+        header.byte_order = kByteOrder;
+        header.source_hash = source_hash;
+        header.rule_count = static_cast<std::uint32_t>(engine.rules_.size());
+        header.pattern_count = static_cast<std::uint32_t>(engine.patterns_.size());
+        header.group_count = static_cast<std::uint32_t>(engine.groups_.size());
+
+        std::string strings;
+        auto intern = [&](const std::string& s) {
+            StrRef ref{static_cast<std::uint32_t>(strings.size()), static_cast<std::uint32_t>(s.size())};
+            strings += s;
+            return ref;
+        };
+
+        header.rules_offset = w.align();
+        for (const auto& rule : engine.rules_) {
+            RuleRecord r{};
+            r.id = rule.id;
+            r.proto = rule.proto;
+            r.message = intern(rule.message);
+            r.payload_pattern = intern(rule.payload_pattern);
+            r.pcre = intern(rule.pcre);
+            r.pcre_flags = intern(rule.pcre_flags);
+            r.src = intern(rule.src);
+            r.dst = intern(rule.dst);
+            r.threshold_type = static_cast<std::uint8_t>(rule.threshold.type);
+            r.threshold_track = static_cast<std::uint8_t>(rule.threshold.track);
+            r.threshold_count = rule.threshold.count;
+            r.threshold_seconds = rule.threshold.seconds;
+            w.put(r);
+        }
+
+        header.patterns_offset = w.align();
+        std::uint32_t rule_refs = 0;
+        for (std::size_t p = 0; p < engine.patterns_.size(); ++p) {
+            PatternRecord r{};
+            r.text = intern(engine.patterns_[p]);
+            r.rule_begin = rule_refs;
+            r.rule_count = static_cast<std::uint32_t>(engine.pattern_rules_[p].size());
+            rule_refs += r.rule_count;
+            w.put(r);
+        }
+
+        header.pattern_rules_offset = w.align();
+        header.pattern_rule_count = rule_refs;
+        for (const auto& list : engine.pattern_rules_) {
+            for (std::size_t rule : list) w.put(static_cast<std::uint32_t>(rule));
+        }
+
+        header.groups_offset = w.align();
+        std::size_t groups_at = w.reserve(sizeof(GroupRecord) * engine.groups_.size());
+        for (std::size_t g = 0; g < engine.groups_.size(); ++g) {
+            const SignatureGroup& group = engine.groups_[g];
+            GroupRecord r{};
+            r.kind = static_cast<std::uint32_t>(group.matcher.kind());
+            r.pattern_count = static_cast<std::uint32_t>(group.pattern_ids.size());
+            r.pattern_ids_offset = w.put_u32s(group.pattern_ids);
+            r.unfiltered_count = static_cast<std::uint32_t>(group.unfiltered_regex_rules.size());
+            r.unfiltered_offset = w.put_u32s(group.unfiltered_regex_rules);
+            if (group.matcher.kind() == core::dsa::LiteralMatcher::Kind::AhoCorasick) {
+                r.automaton_offset = put_automaton(w, group.matcher.automaton().tables());
+            }
+            w.patch(groups_at + g * sizeof(GroupRecord), r);
+        }
+
+        header.strings_offset = w.align();
+        header.strings_size = strings.size();
+        w.append(strings.data(), strings.size());
+        w.align();
+
+        header.file_size = w.size();
+        w.patch(0, header);
+
+        // Write to a temporary file and rename so readers never see a partial image
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "[CompiledRuleset] Cannot write " << tmp << std::endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(w.data()), static_cast<std::streamsize>(w.size()));
+            if (!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::cerr << "[CompiledRuleset] Cannot replace " << path << ": " << ec.message() << std::endl;
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    // Maps the image and installs it into engine. Fails (leaving engine
+    // untouched) if the file is missing, malformed, from another format
+    // version or was compiled from different rule files.
+    static bool load(Engine& engine, const std::string& path, std::uint64_t source_hash) {
+        auto image = std::make_shared<core::MappedFile>();
+        if (!image->open(path)) return false;
+
+        const std::uint8_t* base = image->data();
+        const std::size_t size = image->size();
+        if (size < sizeof(Header)) return false;
+
+        Header header{};
+        std::memcpy(&header, base, sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0) return false;
+        if (header.version != kFormatVersion || header.byte_order != kByteOrder) return false;
+        if (header.source_hash != source_hash || header.file_size != size) return false;
+        if (header.group_count != static_cast<std::uint32_t>(GroupId::Count)) return false;
+
+        Reader r{base, size};
+        if (!r.fits(header.rules_offset, header.rule_count, sizeof(RuleRecord)) ||
+            !r.fits(header.patterns_offset, header.pattern_count, sizeof(PatternRecord)) ||
+            !r.fits(header.pattern_rules_offset, header.pattern_rule_count, 4) ||
+            !r.fits(header.groups_offset, header.group_count, sizeof(GroupRecord)) ||
+            !r.fits(header.strings_offset, header.strings_size, 1)) {
+            return false;
+        }
+        std::string_view strings(reinterpret_cast<const char*>(base + header.strings_offset), header.strings_size);
+        auto text = [&](StrRef ref, std::string& out) {
+            if (std::uint64_t{ref.offset} + ref.length > strings.size()) return false;
+            out.assign(strings.substr(ref.offset, ref.length));
+            return true;
+        };
+
+        Engine loaded;
+        const auto* rules = reinterpret_cast<const RuleRecord*>(base + header.rules_offset);
+        for (std::uint32_t i = 0; i < header.rule_count; ++i) {
+            Rule rule;
+            rule.id = rules[i].id;
+            rule.proto = static_cast<std::uint8_t>(rules[i].proto);
+            if (rules[i].threshold_type > static_cast<std::uint8_t>(RuleThreshold::Type::Both) ||
+                rules[i].threshold_track > static_cast<std::uint8_t>(RuleThreshold::Track::ByRule) ||
+                (rules[i].threshold_type != 0 && (rules[i].threshold_count == 0 || rules[i].threshold_seconds == 0))) {
+                return false;
+            }
+            rule.threshold.type = static_cast<RuleThreshold::Type>(rules[i].threshold_type);
+            rule.threshold.track = static_cast<RuleThreshold::Track>(rules[i].threshold_track);
+            rule.threshold.count = rules[i].threshold_count;
+            rule.threshold.seconds = rules[i].threshold_seconds;
+            if (!text(rules[i].message, rule.message) || !text(rules[i].payload_pattern, rule.payload_pattern) ||
+                !text(rules[i].pcre, rule.pcre) || !text(rules[i].pcre_flags, rule.pcre_flags) ||
+                !text(rules[i].src, rule.src) || !text(rules[i].dst, rule.dst)) {
+                return false;
+            }
+            bool negated = false;
+            std::vector<core::dsa::IpPrefix> prefixes;
+            if ((!rule.src.empty() && !AddressGroups::parse_spec(rule.src, negated, prefixes)) ||
+                (!rule.dst.empty() && !AddressGroups::parse_spec(rule.dst, negated, prefixes))) {
+                return false;
+            }
+            loaded.add_address_filters(rule);
+
+            std::int32_t regex_index = -1;
+            if (!rule.pcre.empty()) {
+                core::dsa::Regex re;
+                if (!re.compile(rule.pcre, rule.pcre_flags)) return false;
+                regex_index = static_cast<std::int32_t>(loaded.regexes_.size());
+                loaded.regexes_.push_back(std::move(re));
+            }
+            loaded.rule_regex_.push_back(regex_index);
+            loaded.rules_.push_back(std::move(rule));
+        }
+
+        const auto* patterns = reinterpret_cast<const PatternRecord*>(base + header.patterns_offset);
+        const auto* pattern_rules = reinterpret_cast<const std::uint32_t*>(base + header.pattern_rules_offset);
+        for (std::uint32_t i = 0; i < header.pattern_count; ++i) {
+            std::string literal;
+            const PatternRecord& rec = patterns[i];
+            if (!text(rec.text, literal) || rec.rule_begin > header.pattern_rule_count ||
+                rec.rule_count > header.pattern_rule_count - rec.rule_begin) {
+                return false;
+            }
+            std::vector<std::size_t> rule_list;
+            for (std::uint32_t k = 0; k < rec.rule_count; ++k) {
+                if (pattern_rules[rec.rule_begin + k] >= header.rule_count) return false;
+                rule_list.push_back(pattern_rules[rec.rule_begin + k]);
+            }
+            if (loaded.intern_pattern(std::move(literal)) != i) return false; // duplicate literal
+            loaded.pattern_rules_[i] = std::move(rule_list);
+        }
+
+        const auto* groups = reinterpret_cast<const GroupRecord*>(base + header.groups_offset);
+        for (std::uint32_t g = 0; g < header.group_count; ++g) {
+            const GroupRecord& rec = groups[g];
+            SignatureGroup& group = loaded.groups_[g];
+            if (!r.fits(rec.pattern_ids_offset, rec.pattern_count, 4) ||
+                !r.fits(rec.unfiltered_offset, rec.unfiltered_count, 4)) {
+                return false;
+            }
+            const auto* ids = reinterpret_cast<const std::uint32_t*>(base + rec.pattern_ids_offset);
+            std::vector<std::string> literals;
+            for (std::uint32_t i = 0; i < rec.pattern_count; ++i) {
+                if (ids[i] >= header.pattern_count) return false;
+                group.pattern_ids.push_back(ids[i]);
+                literals.push_back(loaded.patterns_[ids[i]]);
+            }
+            const auto* unfiltered = reinterpret_cast<const std::uint32_t*>(base + rec.unfiltered_offset);
+            for (std::uint32_t i = 0; i < rec.unfiltered_count; ++i) {
+                // Must name a regex rule: the verifier indexes regexes_ by it
+                if (unfiltered[i] >= header.rule_count || loaded.rule_regex_[unfiltered[i]] < 0) return false;
+                group.unfiltered_regex_rules.push_back(unfiltered[i]);
+            }
+
+            auto kind = static_cast<core::dsa::LiteralMatcher::Kind>(rec.kind);
+            if (kind == core::dsa::LiteralMatcher::Kind::AhoCorasick) {
+                core::dsa::AhoCorasick::Tables tables{};
+                if (!map_automaton(r, rec.automaton_offset, literals, tables)) return false;
+                group.matcher.attach(tables);
+            } else if (kind == core::dsa::LiteralMatcher::Kind::Empty ||
+                       kind == core::dsa::LiteralMatcher::Kind::Memchr ||
+                       kind == core::dsa::LiteralMatcher::Kind::Teddy) {
+                group.matcher.build(literals, kind);
+            } else {
+                return false;
+            }
+        }
+
+        loaded.address_groups_.build();
+        loaded.image_ = std::move(image);
+        loaded.generation_ = Engine::next_generation();
+        loaded.built_ = true;
+        engine = std::move(loaded);
+        return true;
+    }
+
+private:
+    static constexpr char kMagic[8] = {'I', 'D', 'S', 'R', 'U', 'L', 'E', 'S'};
+    static constexpr std::uint32_t kByteOrder = 0x01020304u;
+
+    struct StrRef {
+        std::uint32_t offset;
+        std::uint32_t length;
+    };
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t source_hash;
+        std::uint64_t file_size;
+        std::uint32_t rule_count;
+        std::uint32_t pattern_count;
+        std::uint32_t group_count;
+        std::uint32_t reserved;
+        std::uint64_t rules_offset;
+        std::uint64_t patterns_offset;
+        std::uint64_t pattern_rules_offset;  // u32 rule indices, sliced by PatternRecord
+        std::uint64_t pattern_rule_count;
+        std::uint64_t groups_offset;
+        std::uint64_t strings_offset;
+        std::uint64_t strings_size;
+    };
+
+    struct RuleRecord {
+        std::int32_t id;
+        std::uint32_t proto;
+        StrRef message;
+        StrRef payload_pattern;
+        StrRef pcre;
+        StrRef pcre_flags;
+        StrRef src;
+        StrRef dst;
+        std::uint8_t threshold_type;
+        std::uint8_t threshold_track;
+        std::uint16_t reserved;
+        std::uint32_t threshold_count;
+        std::uint32_t threshold_seconds;
+    };
+
+    struct PatternRecord {
+        std::uint32_t rule_begin; // first entry in the pattern_rules section
+        std::uint32_t rule_count;
+        StrRef text;
+    };
+
+    struct GroupRecord {
+        std::uint32_t kind;
+        std::uint32_t pattern_count;
+        std::uint64_t pattern_ids_offset;
+        std::uint32_t unfiltered_count;
+        std::uint32_t reserved;
+        std::uint64_t unfiltered_offset;
+        std::uint64_t automaton_offset; // 0 unless kind is AhoCorasick
+    };
+
+    struct AutomatonRecord {
+        std::uint32_t class_count;
+        std::uint32_t state_count;
+        std::uint32_t output_count;
+        std::uint32_t pattern_count;
+        std::uint64_t byte_class_offset;
+        std::uint64_t delta_offset;
+        std::uint64_t out_begin_offset;
+        std::uint64_t out_ids_offset;
+        std::uint64_t pattern_length_offset;
+    };
+
+    class Writer {
+    public:
+        std::size_t size() const { return buf_.size(); }
+        const std::uint8_t* data() const { return buf_.data(); }
+
+        std::size_t align() {
+            buf_.resize((buf_.size() + 7) & ~std::size_t{7}, 0);
+            return buf_.size();
+        }
+
+        std::size_t reserve(std::size_t n) {
+            std::size_t at = align();
+            buf_.resize(at + n, 0);
+            return at;
+        }
+
+        std::size_t append(const void* p, std::size_t n) {
+            std::size_t at = buf_.size();
+            buf_.resize(at + n);
+            if (n) std::memcpy(buf_.data() + at, p, n);
+            return at;
+        }
+
+        template <typename T>
+        void put(const T& v) { append(&v, sizeof(T)); }
+
+        template <typename T>
+        void patch(std::size_t at, const T& v) { std::memcpy(buf_.data() + at, &v, sizeof(T)); }
+
+        template <typename T>
+        std::uint64_t put_array(const T* p, std::size_t n) {
+            std::size_t at = align();
+            append(p, n * sizeof(T));
+            return at;
+        }
+
+        std::uint64_t put_u32s(const std::vector<std::size_t>& v) {
+            std::size_t at = align();
+            for (std::size_t x : v) put(static_cast<std::uint32_t>(x));
+            return at;
+        }
+
+    private:
+        std::vector<std::uint8_t> buf_;
+    };
+
+    struct Reader {
+        const std::uint8_t* base;
+        std::size_t size;
+
+        bool fits(std::uint64_t offset, std::uint64_t count, std::uint64_t elem) const {
+            if (offset % 4 != 0 || offset > size) return false;
+            if (count == 0) return true;
+            return elem != 0 && count <= (size - offset) / elem;
+        }
+    };
+
+    static std::uint64_t put_automaton(Writer& w, const core::dsa::AhoCorasick::Tables& t) {
+        AutomatonRecord rec{};
+        rec.class_count = t.class_count;
+        rec.state_count = t.state_count;
+        rec.output_count = t.output_count;
+        rec.pattern_count = t.pattern_count;
+        rec.byte_class_offset = w.put_array(t.byte_class, 256);
+        rec.delta_offset = w.put_array(t.delta, std::size_t{t.state_count} * t.class_count);
+        rec.out_begin_offset = w.put_array(t.out_begin, std::size_t{t.state_count} + 1);
+        rec.out_ids_offset = w.put_array(t.out_ids, t.output_count);
+        rec.pattern_length_offset = w.put_array(t.pattern_length, t.pattern_count);
+        std::uint64_t at = w.align();
+        w.put(rec);
+        return at;
+    }
+
+    // Points tables into the mapping after checking every index the scan
+    // loop will follow, so a damaged image can't send it out of bounds:
+    // pattern lengths must be those of the group's literals, and no state
+    // may report a pattern longer than the shortest input that reaches it
+    // (the scan computes the match start as end - length).
+    static bool map_automaton(const Reader& r, std::uint64_t offset, const std::vector<std::string>& literals,
+                              core::dsa::AhoCorasick::Tables& t) {
+        if (offset == 0 || !r.fits(offset, 1, sizeof(AutomatonRecord))) return false;
+        AutomatonRecord rec{};
+        std::memcpy(&rec, r.base + offset, sizeof(rec));
+        const std::uint64_t cells = std::uint64_t{rec.state_count} * rec.class_count;
+        if (rec.state_count == 0 || rec.class_count == 0 || rec.class_count > 257 ||
+            rec.pattern_count != literals.size() ||
+            !r.fits(rec.byte_class_offset, 256, 2) || !r.fits(rec.delta_offset, cells, 4) ||
+            !r.fits(rec.out_begin_offset, std::uint64_t{rec.state_count} + 1, 4) ||
+            !r.fits(rec.out_ids_offset, rec.output_count, 4) ||
+            !r.fits(rec.pattern_length_offset, rec.pattern_count, 4)) {
+            return false;
+        }
+
+        t.byte_class = reinterpret_cast<const std::uint16_t*>(r.base + rec.byte_class_offset);
+        t.class_count = rec.class_count;
+        t.state_count = rec.state_count;
+        t.output_count = rec.output_count;
+        t.pattern_count = rec.pattern_count;
+        t.delta = reinterpret_cast<const std::uint32_t*>(r.base + rec.delta_offset);
+        t.out_begin = reinterpret_cast<const std::uint32_t*>(r.base + rec.out_begin_offset);
+        t.out_ids = reinterpret_cast<const std::uint32_t*>(r.base + rec.out_ids_offset);
+        t.pattern_length = reinterpret_cast<const std::uint32_t*>(r.base + rec.pattern_length_offset);
+
+        for (unsigned b = 0; b < 256; ++b) if (t.byte_class[b] >= t.class_count) return false;
+        for (std::uint64_t i = 0; i < cells; ++i) if ((t.delta[i] & 0x7FFFFFFFu) >= t.state_count) return false;
+        for (std::uint32_t s = 0; s < t.state_count; ++s) {
+            if (t.out_begin[s] > t.out_begin[s + 1]) return false;
+        }
+        if (t.out_begin[t.state_count] > t.output_count) return false;
+        for (std::uint32_t o = 0; o < t.output_count; ++o) if (t.out_ids[o] >= t.pattern_count) return false;
+        for (std::uint32_t p = 0; p < t.pattern_count; ++p) {
+            if (t.pattern_length[p] != literals[p].size()) return false;
+        }
+
+        // Shortest input reaching each state, breadth-first from the start
+        std::vector<std::uint32_t> depth(t.state_count, UINT32_MAX);
+        std::vector<std::uint32_t> queue{0};
+        depth[0] = 0;
+        for (std::size_t head = 0; head < queue.size(); ++head) {
+            std::uint32_t s = queue[head];
+            for (std::uint32_t c = 0; c < t.class_count; ++c) {
+                std::uint32_t next = t.delta[std::uint64_t{s} * t.class_count + c] & 0x7FFFFFFFu;
+                if (depth[next] != UINT32_MAX) continue;
+                depth[next] = depth[s] + 1;
+                queue.push_back(next);
+            }
+        }
+        for (std::uint32_t s = 0; s < t.state_count; ++s) {
+            if (depth[s] == UINT32_MAX) continue;
+            for (std::uint32_t o = t.out_begin[s]; o < t.out_begin[s + 1]; ++o) {
+                if (t.pattern_length[t.out_ids[o]] > depth[s]) return false;
+            }
+        }
+        return true;
+    }
+};
+
+// Startup path: use the compiled image when it matches the rule files,
+// otherwise compile the rules (on pool, if given) and rewrite the image
+// for next time.
+inline bool load_or_compile_ruleset(Engine& engine, const std::vector<std::string>& rule_files,
+                                    const std::string& image_path, core::ThreadPool* pool = nullptr) {
+    auto start = std::chrono::steady_clock::now();
+    auto elapsed_ms = [&]() {
+        return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    };
+
+    std::uint64_t source_hash = 0;
+    if (!CompiledRuleset::hash_files(rule_files, source_hash)) {
+        std::cerr << "[CompiledRuleset] Cannot read rule files" << std::endl;
+        return false;
+    }
+
+    if (!image_path.empty() && CompiledRuleset::load(engine, image_path, source_hash)) {
+        std::cout << "Loaded compiled ruleset " << image_path << " in " << elapsed_ms() << " ms" << std::endl;
+        return true;
+    }
+
+    Engine compiled;
+    for (const auto& file : rule_files) compiled.add_rules(config::load_rules(file, pool), pool);
+    compiled.build(pool);
+    std::cout << "Compiled " << compiled.rule_count() << " rules in " << elapsed_ms() << " ms" << std::endl;
+
+    if (!image_path.empty() && CompiledRuleset::save(compiled, image_path, source_hash)) {
+        std::cout << "Wrote compiled ruleset " << image_path << std::endl;
+    }
+    engine = std::move(compiled);
+    return true;
+}
+
+} // namespace detect
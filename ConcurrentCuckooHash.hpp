@@ -0,0 +1,385 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <vector>
+#include "core/Hash.hpp"
+
+namespace core { namespace dsa {
+
+// Bucketized cuckoo hash table for lookup tables shared by many reader
+// threads and updated by one writer (block lists, flow verdicts, passive
+// DNS).
+//
+// Each key has two candidate buckets of four slots. A slot's 8-bit tag
+// (a hash fingerprint, 0 = empty) is enough to derive the entry's other
+// bucket, so when both buckets are full the writer searches breadth-first
+// for the shortest chain of entries that can each move to their alternate
+// bucket, which keeps inserts succeeding past 90% load. The chain is
+// shifted from its free end backwards, so a moved entry is always present
+// in at least one of its buckets.
+//
+// Readers take no locks. Every bucket has a version counter that the
+// writer makes odd while it changes the bucket (a seqlock): a reader
+// snapshots both buckets' versions, reads, and retries if either changed.
+// Slot contents are kept in relaxed atomic words, so Key and Value must be
+// trivially copyable.
+//
+// When no chain is found the writer builds a table twice the size and
+// publishes it; Reader handles switch on their next lookup and the old
+// table is freed once the last reader has moved on, so resizing never
+// blocks readers.
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>>
+class ConcurrentCuckooHash {
+    static_assert(std::is_trivially_copyable_v<Key> && std::is_trivially_copyable_v<Value>,
+                  "readers copy slots optimistically; keys and values must be trivially copyable");
+
+    static constexpr std::size_t kSlots = 4;
+    static constexpr std::size_t kMaxPathDepth = 5;
+    static constexpr std::size_t kMaxSearchNodes = 2048;
+
+    struct Entry {
+        Key key;
+        Value value;
+    };
+    static constexpr std::size_t kWords = (sizeof(Entry) + 7) / 8;
+
+    struct alignas(64) Bucket {
+        std::atomic<std::uint32_t> version{0}; // odd while the writer is changing the bucket
+        std::atomic<std::uint32_t> tags{0};    // one byte per slot, 0 = empty
+        std::atomic<std::uint64_t> words[kSlots * kWords]{};
+    };
+
+    struct Table {
+        explicit Table(std::size_t bucket_count)
+            : buckets(std::make_unique<Bucket[]>(bucket_count)), mask(bucket_count - 1) {}
+        std::unique_ptr<Bucket[]> buckets;
+        std::size_t mask;
+    };
+
+    struct SearchNode {
+        std::size_t bucket;
+        std::int32_t parent; // index into the search queue, -1 for a root
+        std::uint8_t slot;   // slot of the parent whose entry moves here
+        std::uint8_t depth;
+    };
+
+public:
+    // Per-thread lookup handle. Not shared between threads.
+    class Reader {
+    public:
+        explicit Reader(const ConcurrentCuckooHash& table) : owner_(table) { refresh(); }
+
+        bool find(const Key& key, Value& out) {
+            refresh();
+            return owner_.find_in(*table_, key, out);
+        }
+
+        bool contains(const Key& key) {
+            Value ignored;
+            return find(key, ignored);
+        }
+
+    private:
+        void refresh() {
+            std::uint64_t generation = owner_.generation_.load(std::memory_order_acquire);
+            if (table_ && generation == seen_generation_) return;
+            std::lock_guard<std::mutex> lock(owner_.publish_mutex_);
+            table_ = owner_.current_;
+            seen_generation_ = owner_.generation_.load(std::memory_order_relaxed);
+        }
+
+        const ConcurrentCuckooHash& owner_;
+        std::shared_ptr<const Table> table_;
+        std::uint64_t seen_generation_{0};
+    };
+
+    explicit ConcurrentCuckooHash(std::size_t capacity = 1024) {
+        std::size_t buckets = 1;
+        while (buckets * kSlots < capacity) buckets <<= 1;
+        table_ = std::make_shared<Table>(buckets);
+        current_ = table_;
+    }
+
+    ConcurrentCuckooHash(const ConcurrentCuckooHash&) = delete;
+    ConcurrentCuckooHash& operator=(const ConcurrentCuckooHash&) = delete;
+
+    // Writer thread only. Returns false only if the table cannot grow.
+    bool insert_or_assign(const Key& key, const Value& value) {
+        std::uint64_t hash = hash_of(key);
+        for (;;) {
+            Table& t = *table_;
+            std::size_t b1 = hash & t.mask;
+            std::uint8_t tag = tag_of(hash);
+            std::size_t b2 = alt_bucket(t, b1, tag);
+            std::size_t slot;
+            for (std::size_t b : {b1, b2}) {
+                if (locate(t, b, tag, key, slot)) {
+                    write_slot(t.buckets[b], slot, tag, Entry{key, value});
+                    return true;
+                }
+            }
+            if (place(t, b1, b2, tag, Entry{key, value})) {
+                ++size_;
+                return true;
+            }
+            if (!grow()) return false;
+        }
+    }
+
+    // Writer thread only
+    bool erase(const Key& key) {
+        std::uint64_t hash = hash_of(key);
+        Table& t = *table_;
+        std::size_t b1 = hash & t.mask;
+        std::uint8_t tag = tag_of(hash);
+        std::size_t slot;
+        for (std::size_t b : {b1, alt_bucket(t, b1, tag)}) {
+            if (locate(t, b, tag, key, slot)) {
+                Bucket& bucket = t.buckets[b];
+                begin_write(bucket);
+                set_tag(bucket, slot, 0);
+                end_write(bucket);
+                --size_;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Writer thread only; other threads use a Reader
+    bool find(const Key& key, Value& out) const { return find_in(*table_, key, out); }
+
+    std::size_t size() const { return size_; }
+    std::size_t capacity() const { return (table_->mask + 1) * kSlots; }
+    double load_factor() const { return static_cast<double>(size_) / static_cast<double>(capacity()); }
+    std::size_t memory_usage() const { return (table_->mask + 1) * sizeof(Bucket); }
+
+    // Number of tables published so far (resizes)
+    std::uint64_t generation() const { return generation_.load(std::memory_order_acquire); }
+
+private:
+    template <typename K>
+    std::uint64_t hash_of(const K& key) const {
+        return core::hash64(static_cast<std::uint64_t>(hasher_(key)));
+    }
+
+    static std::uint8_t tag_of(std::uint64_t hash) {
+        auto tag = static_cast<std::uint8_t>(hash >> 56);
+        return tag ? tag : 1;
+    }
+
+    // Partial-key cuckoo: the alternate bucket depends only on the bucket and
+    // tag, and alt_bucket(alt_bucket(b)) == b
+    static std::size_t alt_bucket(const Table& t, std::size_t bucket, std::uint8_t tag) {
+        return (bucket ^ (static_cast<std::size_t>(tag) * 0xc6a4a7935bd1e995ull)) & t.mask;
+    }
+
+    static std::uint8_t slot_tag(std::uint32_t tags, std::size_t slot) {
+        return static_cast<std::uint8_t>(tags >> (8 * slot));
+    }
+
+    static Entry read_slot(const Bucket& bucket, std::size_t slot) {
+        std::uint64_t words[kWords];
+        for (std::size_t w = 0; w < kWords; ++w) words[w] = bucket.words[slot * kWords + w].load(std::memory_order_relaxed);
+        Entry entry;
+        std::memcpy(&entry, words, sizeof(Entry));
+        return entry;
+    }
+
+    // Optimistic read of both candidate buckets, retried while the writer
+    // is changing either of them
+    bool find_in(const Table& t, const Key& key, Value& out) const {
+        std::uint64_t hash = hash_of(key);
+        std::size_t b1 = hash & t.mask;
+        std::uint8_t tag = tag_of(hash);
+        const Bucket& first = t.buckets[b1];
+        const Bucket& second = t.buckets[alt_bucket(t, b1, tag)];
+        for (;;) {
+            std::uint32_t v1 = first.version.load(std::memory_order_acquire);
+            std::uint32_t v2 = second.version.load(std::memory_order_acquire);
+            if ((v1 | v2) & 1) continue;
+            bool found = false;
+            for (const Bucket* bucket : {&first, &second}) {
+                std::uint32_t tags = bucket->tags.load(std::memory_order_relaxed);
+                for (std::size_t s = 0; s < kSlots && !found; ++s) {
+                    if (slot_tag(tags, s) != tag) continue;
+                    Entry entry = read_slot(*bucket, s);
+                    if (eq_(entry.key, key)) {
+                        out = entry.value;
+                        found = true;
+                    }
+                }
+                if (found) break;
+            }
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (first.version.load(std::memory_order_relaxed) == v1 &&
+                second.version.load(std::memory_order_relaxed) == v2) {
+                return found;
+            }
+        }
+    }
+
+    // Writer-side helpers: the writer is the only thread changing buckets,
+    // so its own reads need no validation
+    static void begin_write(Bucket& bucket) {
+        bucket.version.store(bucket.version.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+    }
+
+    static void end_write(Bucket& bucket) {
+        bucket.version.store(bucket.version.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    static void set_tag(Bucket& bucket, std::size_t slot, std::uint8_t tag) {
+        std::uint32_t tags = bucket.tags.load(std::memory_order_relaxed);
+        tags = (tags & ~(0xFFu << (8 * slot))) | (static_cast<std::uint32_t>(tag) << (8 * slot));
+        bucket.tags.store(tags, std::memory_order_relaxed);
+    }
+
+    static void store_entry(Bucket& bucket, std::size_t slot, const Entry& entry) {
+        std::uint64_t words[kWords] = {};
+        std::memcpy(words, &entry, sizeof(Entry));
+        for (std::size_t w = 0; w < kWords; ++w) bucket.words[slot * kWords + w].store(words[w], std::memory_order_relaxed);
+    }
+
+    static void write_slot(Bucket& bucket, std::size_t slot, std::uint8_t tag, const Entry& entry) {
+        begin_write(bucket);
+        store_entry(bucket, slot, entry);
+        set_tag(bucket, slot, tag);
+        end_write(bucket);
+    }
+
+    bool locate(const Table& t, std::size_t b, std::uint8_t tag, const Key& key, std::size_t& slot) const {
+        const Bucket& bucket = t.buckets[b];
+        std::uint32_t tags = bucket.tags.load(std::memory_order_relaxed);
+        for (std::size_t s = 0; s < kSlots; ++s) {
+            if (slot_tag(tags, s) == tag && eq_(read_slot(bucket, s).key, key)) {
+                slot = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool free_slot(const Bucket& bucket, std::size_t& slot) {
+        std::uint32_t tags = bucket.tags.load(std::memory_order_relaxed);
+        for (std::size_t s = 0; s < kSlots; ++s) {
+            if (slot_tag(tags, s) == 0) {
+                slot = s;
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Puts a new entry in b1 or b2, displacing along a BFS cuckoo path if
+    // both are full. Returns false if no path was found.
+    bool place(Table& t, std::size_t b1, std::size_t b2, std::uint8_t tag, const Entry& entry) {
+        std::size_t slot;
+        for (std::size_t b : {b1, b2}) {
+            if (free_slot(t.buckets[b], slot)) {
+                write_slot(t.buckets[b], slot, tag, entry);
+                return true;
+            }
+        }
+
+        std::vector<SearchNode>& nodes = search_nodes_;
+        nodes.clear();
+        nodes.push_back(SearchNode{b1, -1, 0, 0});
+        nodes.push_back(SearchNode{b2, -1, 0, 0});
+        for (std::size_t head = 0; head < nodes.size(); ++head) {
+            SearchNode node = nodes[head];
+            if (node.depth >= kMaxPathDepth) continue;
+            std::uint32_t tags = t.buckets[node.bucket].tags.load(std::memory_order_relaxed);
+            for (std::size_t s = 0; s < kSlots; ++s) {
+                std::size_t next = alt_bucket(t, node.bucket, slot_tag(tags, s));
+                std::size_t free;
+                if (free_slot(t.buckets[next], free)) {
+                    // Shift entries along the path, starting at the free end
+                    std::size_t to_bucket = next, to_slot = free;
+                    std::size_t from_bucket = node.bucket, from_slot = s;
+                    std::int32_t at = static_cast<std::int32_t>(head);
+                    for (;;) {
+                        move_slot(t, from_bucket, from_slot, to_bucket, to_slot);
+                        const SearchNode& n = nodes[static_cast<std::size_t>(at)];
+                        if (n.parent < 0) break;
+                        to_bucket = from_bucket;
+                        to_slot = from_slot;
+                        from_bucket = nodes[static_cast<std::size_t>(n.parent)].bucket;
+                        from_slot = n.slot;
+                        at = n.parent;
+                    }
+                    write_slot(t.buckets[from_bucket], from_slot, tag, entry);
+                    return true;
+                }
+                if (nodes.size() < kMaxSearchNodes) {
+                    nodes.push_back(SearchNode{next, static_cast<std::int32_t>(head), static_cast<std::uint8_t>(s),
+                                         static_cast<std::uint8_t>(node.depth + 1)});
+                }
+            }
+        }
+        return false;
+    }
+
+    // The destination is written before the source is cleared, both inside
+    // one version bump, so readers of either bucket never miss the entry
+    static void move_slot(Table& t, std::size_t from_bucket, std::size_t from_slot, std::size_t to_bucket,
+                          std::size_t to_slot) {
+        Bucket& from = t.buckets[from_bucket];
+        Bucket& to = t.buckets[to_bucket];
+        std::uint8_t tag = slot_tag(from.tags.load(std::memory_order_relaxed), from_slot);
+        begin_write(to);
+        if (&from != &to) begin_write(from);
+        store_entry(to, to_slot, read_slot(from, from_slot));
+        set_tag(to, to_slot, tag);
+        set_tag(from, from_slot, 0);
+        if (&from != &to) end_write(from);
+        end_write(to);
+    }
+
+    // Rebuilds into a table twice the size and publishes it to readers
+    bool grow() {
+        const Table& old = *table_;
+        std::size_t buckets = (old.mask + 1) * 2;
+        for (;;) {
+            if (buckets > (std::size_t{1} << 40)) return false;
+            auto next = std::make_shared<Table>(buckets);
+            bool ok = true;
+            for (std::size_t b = 0; b <= old.mask && ok; ++b) {
+                std::uint32_t tags = old.buckets[b].tags.load(std::memory_order_relaxed);
+                for (std::size_t s = 0; s < kSlots && ok; ++s) {
+                    if (slot_tag(tags, s) == 0) continue;
+                    Entry entry = read_slot(old.buckets[b], s);
+                    std::uint64_t hash = hash_of(entry.key);
+                    std::size_t b1 = hash & next->mask;
+                    std::uint8_t tag = tag_of(hash);
+                    ok = place(*next, b1, alt_bucket(*next, b1, tag), tag, entry);
+                }
+            }
+            if (ok) {
+                table_ = next;
+                std::lock_guard<std::mutex> lock(publish_mutex_);
+                current_ = std::move(next);
+                generation_.fetch_add(1, std::memory_order_release);
+                return true;
+            }
+            buckets *= 2;
+        }
+    }
+
+    std::shared_ptr<Table> table_;          // writer's view
+    mutable std::mutex publish_mutex_;      // guards current_ for Reader::refresh
+    std::shared_ptr<const Table> current_;  // published to readers
+    std::atomic<std::uint64_t> generation_{0};
+    std::vector<SearchNode> search_nodes_;  // BFS queue, reused across inserts
+    std::size_t size_{0};
+    Hash hasher_;
+    Eq eq_;
+};
+
+}} // namespace core::dsa
@@ -1,9 +1,18 @@
 #pragma once
+#include <algorithm>
+#include <iterator>
 #include <string>
+#include <string_view>
 #include <vector>
 #include <fstream>
 #include <iostream>
+#include <sstream>
+#include "core/ThreadPool.hpp"
+#include "core/dsa/DomainSet.hpp"
+#include "core/dsa/IpLpm.hpp"
+#include "detect/AddressGroups.hpp"
 #include "detect/Rule.hpp"
+#include "detect/Threshold.hpp"
 
 namespace config {
 
@@ -13,12 +22,61 @@ struct IdsConfig {
     std::string windivert_filter{"true"};
     std::size_t ring_buffer_size{1024};
     std::size_t flow_table_size{8192};
+    int flow_timeout_seconds{60};            // idle flows (and their IPS verdicts) expire after this
+    std::uint64_t ips_inspect_depth{1048576}; // payload bytes inspected per flow before IPS passes it unchecked; 0 = all
+    std::uint64_t stream_depth{1048576};     // payload bytes per flow handed to detection; 0 = unlimited
+    bool tls_bypass{true};                   // skip detection once a TLS flow carries application data
+    double entropy_threshold{7.2};           // bits/byte marking a flow direction compressed/encrypted; 0 = off
+    std::uint64_t entropy_window{2048};      // payload bytes inspected in a high-entropy flow
+    std::size_t result_cache_size{4096};     // per-worker cached match outcomes of repeated payloads; 0 = off
+    std::size_t threshold_table_size{65536}; // per-worker alert threshold counters (rule x tracked address)
+    bool rule_profiling{false};              // per-rule candidate/verification/match counters and regex time
+    std::size_t rule_profile_top{20};        // rules listed in the profile report
     std::size_t worker_threads{1};
+    std::string pipeline_mode{"fused"};     // "fused" (run to completion) or "staged" (prepare + detect lanes)
+    std::size_t detect_threads{2};           // staged: detection lanes, one thread each
+    std::size_t pipeline_batch{64};          // packets per batch handed to a lane, and per engine refresh
+    std::size_t pipeline_burst{16};          // packets pulled at once; their flow lookups are batched
+    int capture_cpu{-1};                     // CPU pinning per thread; -1 = let the scheduler place it
+    int worker_cpu{-1};
+    std::vector<int> detect_cpus{};          // staged: CPU per detection lane, in lane order
+    int stats_cpu{-1};
+    std::string huge_pages{"off"};          // off, thp, 2m, 1g: flow table arena and large DFA tables
+    std::string pcap_file{};                 // capture mode 4: classic pcap file replayed as capture
+    std::size_t pcap_loops{1};               // times the pcap file is replayed; 0 = until stopped
     std::vector<std::string> rule_files{};
+    std::string compiled_ruleset{};          // cached compiled image of rule_files, empty to disable
+    std::string blocklist_file{};            // CIDR per line; flows to/from a listed address are blocked
+    std::vector<std::string> domain_blocklist{}; // domain list files, matched against DNS/HTTP Host/TLS SNI
+    std::string domain_blocklist_image{};    // cached built domain set, empty to disable
+    std::string eve_log{};                   // EVE JSON alert log; empty writes alerts to stdout
+    std::size_t eve_queue_size{8192};        // alerts buffered for the output thread; overflow is dropped
+    std::uint64_t eve_rotate_mb{64};         // rotate the EVE log past this size; 0 = never
+    unsigned eve_rotate_keep{5};             // rotated EVE logs kept
+    std::string eve_output{"json"};          // "json" (eve_log) or "ring" (binary records in event_ring_path)
+    std::string event_ring_path{"events.ring"}; // memory-mapped event ring for local consumers
+    std::size_t event_ring_records{65536};   // ring capacity in 256-byte records
     bool enable_stats{true};
     int stats_interval_seconds{5};
+    std::uint16_t metrics_port{0};           // Prometheus endpoint on 127.0.0.1; 0 = off
 };
 
+// Comma-separated list value: rule_files: "a.rules, b.rules"
+inline std::vector<std::string> split_list(const std::string& value) {
+    std::vector<std::string> items;
+    std::size_t pos = 0;
+    while (pos <= value.size()) {
+        auto comma = value.find(',', pos);
+        if (comma == std::string::npos) comma = value.size();
+        std::string item = value.substr(pos, comma - pos);
+        item.erase(0, item.find_first_not_of(" \t"));
+        item.erase(item.find_last_not_of(" \t") + 1);
+        if (!item.empty()) items.push_back(item);
+        pos = comma + 1;
+    }
+    return items;
+}
+
 // Simple JSON-like config parser (basic implementation)
 inline bool load_config(const std::string& filename, IdsConfig& config) {
     std::ifstream file(filename);
@@ -50,43 +108,261 @@ inline bool load_config(const std::string& filename, IdsConfig& config) {
         else if (key == "windivert_filter") config.windivert_filter = value;
         else if (key == "ring_buffer_size") config.ring_buffer_size = std::stoull(value);
         else if (key == "flow_table_size") config.flow_table_size = std::stoull(value);
+        else if (key == "flow_timeout_seconds") config.flow_timeout_seconds = std::stoi(value);
+        else if (key == "ips_inspect_depth") config.ips_inspect_depth = std::stoull(value);
+        else if (key == "stream_depth") config.stream_depth = std::stoull(value);
+        else if (key == "tls_bypass") config.tls_bypass = (value == "true");
+        else if (key == "entropy_threshold") config.entropy_threshold = std::stod(value);
+        else if (key == "entropy_window") config.entropy_window = std::stoull(value);
+        else if (key == "result_cache_size") config.result_cache_size = std::stoull(value);
+        else if (key == "threshold_table_size") config.threshold_table_size = std::stoull(value);
+        else if (key == "rule_profiling") config.rule_profiling = (value == "true");
+        else if (key == "rule_profile_top") config.rule_profile_top = std::stoull(value);
         else if (key == "worker_threads") config.worker_threads = std::stoull(value);
+        else if (key == "pipeline_mode") config.pipeline_mode = value;
+        else if (key == "detect_threads") config.detect_threads = std::stoull(value);
+        else if (key == "pipeline_batch") config.pipeline_batch = std::stoull(value);
+        else if (key == "pipeline_burst") config.pipeline_burst = std::stoull(value);
+        else if (key == "capture_cpu") config.capture_cpu = std::stoi(value);
+        else if (key == "worker_cpu") config.worker_cpu = std::stoi(value);
+        else if (key == "stats_cpu") config.stats_cpu = std::stoi(value);
+        else if (key == "huge_pages") config.huge_pages = value;
+        else if (key == "detect_cpus") {
+            config.detect_cpus.clear();
+            for (const auto& cpu : split_list(value)) config.detect_cpus.push_back(std::stoi(cpu));
+        }
+        else if (key == "pcap_file") config.pcap_file = value;
+        else if (key == "pcap_loops") config.pcap_loops = std::stoull(value);
+        else if (key == "rule_files") config.rule_files = split_list(value);
+        else if (key == "compiled_ruleset") config.compiled_ruleset = value;
+        else if (key == "blocklist_file") config.blocklist_file = value;
+        else if (key == "domain_blocklist") config.domain_blocklist = split_list(value);
+        else if (key == "domain_blocklist_image") config.domain_blocklist_image = value;
+        else if (key == "eve_log") config.eve_log = value;
+        else if (key == "eve_queue_size") config.eve_queue_size = std::stoull(value);
+        else if (key == "eve_rotate_mb") config.eve_rotate_mb = std::stoull(value);
+        else if (key == "eve_rotate_keep") config.eve_rotate_keep = static_cast<unsigned>(std::stoul(value));
+        else if (key == "eve_output") config.eve_output = value;
+        else if (key == "event_ring_path") config.event_ring_path = value;
+        else if (key == "event_ring_records") config.event_ring_records = std::stoull(value);
         else if (key == "enable_stats") config.enable_stats = (value == "true");
         else if (key == "stats_interval_seconds") config.stats_interval_seconds = std::stoi(value);
+        else if (key == "metrics_port") config.metrics_port = static_cast<std::uint16_t>(std::stoul(value));
     }
     
     return true;
 }
 
-inline std::vector<detect::Rule> load_rules(const std::string& filename) {
-    std::vector<detect::Rule> rules;
+// Parses a trailing rule options field: key=value pairs separated by ';'.
+// Returns false if the text isn't an options field (then it belongs to the pattern).
+inline bool parse_rule_options(const std::string& text, detect::Rule& rule) {
+    detect::Rule parsed = rule;
+    std::size_t pos = 0;
+    while (pos <= text.size()) {
+        auto end = text.find(';', pos);
+        if (end == std::string::npos) end = text.size();
+        std::string option = text.substr(pos, end - pos);
+        pos = end + 1;
+
+        option.erase(0, option.find_first_not_of(" \t"));
+        option.erase(option.find_last_not_of(" \t") + 1);
+        if (option.empty()) continue;
+
+        auto eq = option.find('=');
+        if (eq == std::string::npos) return false;
+        std::string key = option.substr(0, eq);
+        std::string value = option.substr(eq + 1);
+
+        if (key == "proto") {
+            if (value == "tcp") parsed.proto = 6;
+            else if (value == "udp") parsed.proto = 17;
+            else if (value == "icmp") parsed.proto = 1;
+            else if (value == "any") parsed.proto = 0;
+            else return false;
+        } else if (key == "src" || key == "dst") {
+            bool negated = false;
+            std::vector<core::dsa::IpPrefix> prefixes;
+            if (!detect::AddressGroups::parse_spec(value, negated, prefixes)) return false;
+            (key == "src" ? parsed.src : parsed.dst) = value;
+        } else if (key == "threshold") {
+            if (!detect::parse_threshold(value, parsed.threshold)) return false;
+        } else {
+            return false;
+        }
+    }
+    rule = std::move(parsed);
+    return true;
+}
+
+// FNV-1a over the contents of the given files, used to tag cached images
+// (compiled rulesets, domain sets) with the sources they were built from
+inline bool hash_files(const std::vector<std::string>& paths, std::uint64_t& hash) {
+    hash = 1469598103934665603ull;
+    auto mix = [&](std::uint8_t b) { hash ^= b; hash *= 1099511628211ull; };
+    for (const auto& path : paths) {
+        std::ifstream file(path, std::ios::binary);
+        if (!file.is_open()) return false;
+        std::vector<char> buffer(1 << 16);
+        while (file.read(buffer.data(), static_cast<std::streamsize>(buffer.size())) || file.gcount() > 0) {
+            auto n = static_cast<std::size_t>(file.gcount());
+            for (std::size_t i = 0; i < n; ++i) mix(static_cast<std::uint8_t>(buffer[i]));
+        }
+        mix(0xFF); // file separator
+    }
+    return true;
+}
+
+// Domain block list files: one entry per line ("example.com", "*.example.com"
+// or ".example.com"), '#' comments, hosts-file lines ("0.0.0.0 example.com")
+// accepted. Entries get the index of their file as category. Uses the
+// cached image when it was built from the same files, else builds and
+// rewrites it.
+inline bool load_domain_set(const std::vector<std::string>& files, const std::string& image_path,
+                            core::dsa::DomainSet& set) {
+    std::uint64_t source_hash = 0;
+    if (!hash_files(files, source_hash)) {
+        std::cerr << "Cannot read domain block list files" << std::endl;
+        return false;
+    }
+    if (!image_path.empty() && set.load(image_path, source_hash)) {
+        std::cout << "Mapped " << set.size() << " blocked domains from " << image_path << std::endl;
+        return true;
+    }
+
+    for (std::size_t f = 0; f < files.size(); ++f) {
+        std::ifstream file(files[f]);
+        std::string line;
+        std::size_t invalid = 0;
+        while (std::getline(file, line)) {
+            line.erase(std::min(line.find('#'), line.size()));
+            std::istringstream tokens(line);
+            std::string first, second;
+            tokens >> first >> second;
+            if (first.empty()) continue;
+            core::dsa::IpPrefix ip;
+            const std::string& entry = (!second.empty() && core::dsa::IpLpm::parse_prefix(first, ip)) ? second : first;
+            if (!set.add(entry, static_cast<std::uint16_t>(f))) ++invalid;
+        }
+        if (invalid) std::cerr << "Skipped " << invalid << " invalid domains in " << files[f] << std::endl;
+    }
+    set.build();
+    std::cout << "Loaded " << set.size() << " blocked domains" << std::endl;
+    if (!image_path.empty()) set.save(image_path, source_hash);
+    return true;
+}
+
+// Loads an IP block list (one address or CIDR per line, '#' comments) into
+// table; each prefix's value is its line number. Returns the prefix count.
+inline std::size_t load_blocklist(const std::string& filename, core::dsa::IpLpm& table) {
     std::ifstream file(filename);
-    
     if (!file.is_open()) {
-        std::cerr << "Cannot open rules file: " << filename << std::endl;
-        return rules;
+        std::cerr << "Cannot open blocklist file: " << filename << std::endl;
+        return 0;
     }
-    
     std::string line;
-    int rule_id = 1;
-    
+    std::size_t line_no = 0;
+    std::size_t count = 0;
     while (std::getline(file, line)) {
+        ++line_no;
+        line.erase(std::min(line.find('#'), line.size()));
         line.erase(0, line.find_first_not_of(" \t"));
-        line.erase(line.find_last_not_of(" \t") + 1);
-        
-        if (line.empty() || line[0] == '#') continue;
-        
-        // Simple rule format: message|pattern
-        auto pipe_pos = line.find('|');
-        if (pipe_pos != std::string::npos) {
-            std::string message = line.substr(0, pipe_pos);
-            std::string pattern = line.substr(pipe_pos + 1);
-            
+        line.erase(line.find_last_not_of(" \t\r") + 1);
+        if (line.empty()) continue;
+        if (table.add(line, static_cast<std::uint32_t>(line_no))) {
+            ++count;
+        } else {
+            std::cerr << "Invalid blocklist entry at " << filename << ":" << line_no << std::endl;
+        }
+    }
+    table.build();
+    std::cout << "Loaded " << count << " blocklist prefixes from " << filename << std::endl;
+    return count;
+}
+
+// Parses one rule line; returns false for blank lines, comments and lines
+// without a '|' separator. The rule id is assigned by the caller.
+inline bool parse_rule_line(std::string_view text, detect::Rule& rule) {
+    std::string line(text);
+    line.erase(0, line.find_first_not_of(" \t\r"));
+    line.erase(line.find_last_not_of(" \t\r") + 1);
+
+    if (line.empty() || line[0] == '#') return false;
+
+    // Simple rule format: message|pattern or message|/regex/flags, optionally |options
+    auto pipe_pos = line.find('|');
+    if (pipe_pos == std::string::npos) return false;
+
+    std::string message = line.substr(0, pipe_pos);
+    std::string pattern = line.substr(pipe_pos + 1);
+
+    rule = detect::Rule{};
+    rule.message = message;
+
+    // Optional trailing options field: message|pattern|proto=tcp
+    auto options_pos = pattern.rfind('|');
+    if (options_pos != std::string::npos &&
+        parse_rule_options(pattern.substr(options_pos + 1), rule)) {
+        pattern.erase(options_pos);
+    }
+
+    // Patterns written as /regex/flags are PCRE, anything else is a literal
+    auto last_slash = pattern.rfind('/');
+    if (pattern.size() >= 2 && pattern[0] == '/' && last_slash > 0) {
+        rule.pcre = pattern.substr(1, last_slash - 1);
+        rule.pcre_flags = pattern.substr(last_slash + 1);
+    } else {
+        rule.payload_pattern = pattern;
+    }
+    return true;
+}
+
+// Reads the whole file and parses it in line-aligned chunks, in parallel
+// when a pool is given. Rule ids follow file order either way.
+inline std::vector<detect::Rule> load_rules(const std::string& filename, core::ThreadPool* pool = nullptr) {
+    std::vector<detect::Rule> rules;
+    std::ifstream file(filename, std::ios::binary);
+    
+    if (!file.is_open()) {
+        std::cerr << "Cannot open rules file: " << filename << std::endl;
+        return rules;
+    }
+
+    std::string content((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    // Chunk boundaries snapped forward to the next line start
+    constexpr std::size_t kMinChunkBytes = 64 * 1024;
+    std::size_t chunk_count = 1;
+    if (pool) chunk_count = std::max<std::size_t>(1, std::min(pool->size() * 4, content.size() / kMinChunkBytes));
+    std::vector<std::size_t> bounds{0};
+    for (std::size_t c = 1; c < chunk_count; ++c) {
+        std::size_t pos = content.find('\n', std::max(bounds.back(), content.size() * c / chunk_count));
+        if (pos == std::string::npos) break;
+        bounds.push_back(pos + 1);
+    }
+    bounds.push_back(content.size());
+
+    std::vector<std::vector<detect::Rule>> parsed(bounds.size() - 1);
+    auto parse_chunk = [&](std::size_t c) {
+        std::string_view chunk(content.data() + bounds[c], bounds[c + 1] - bounds[c]);
+        std::size_t pos = 0;
+        while (pos < chunk.size()) {
+            auto eol = chunk.find('\n', pos);
+            if (eol == std::string_view::npos) eol = chunk.size();
             detect::Rule rule;
+            if (parse_rule_line(chunk.substr(pos, eol - pos), rule)) parsed[c].push_back(std::move(rule));
+            pos = eol + 1;
+        }
+    };
+    if (pool) {
+        pool->parallel_for(parsed.size(), parse_chunk);
+    } else {
+        for (std::size_t c = 0; c < parsed.size(); ++c) parse_chunk(c);
+    }
+
+    int rule_id = 1;
+    for (auto& chunk : parsed) {
+        for (auto& rule : chunk) {
             rule.id = rule_id++;
-            rule.message = message;
-            rule.payload_pattern = pattern;
-            
             rules.push_back(std::move(rule));
         }
     }
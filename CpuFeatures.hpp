@@ -0,0 +1,75 @@
+#pragma once
+
+// x86 SIMD levels detected at run time, so default builds (MSVC x64 only
+// guarantees SSE2, GCC/Clang default to it) can still take SSSE3/AVX2
+// paths on CPUs that have them. Kernels for those levels are marked with
+// IDS_TARGET_SSSE3 / IDS_TARGET_AVX2: GCC and Clang compile a marked
+// function for that instruction set regardless of -m flags, MSVC accepts
+// the intrinsics anywhere. Building with -mavx2 or /arch:AVX2 makes the
+// AVX2 level a compile-time fact and skips detection.
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+#define IDS_X86_SIMD 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(IDS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+#define IDS_TARGET_SSSE3 __attribute__((target("ssse3")))
+#define IDS_TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define IDS_TARGET_SSSE3
+#define IDS_TARGET_AVX2
+#endif
+
+namespace core {
+
+enum class SimdLevel { None, Ssse3, Avx2 };
+
+namespace detail {
+
+inline SimdLevel detect_simd_level() {
+#if defined(__AVX2__)
+    return SimdLevel::Avx2;
+#elif defined(IDS_X86_SIMD) && (defined(__GNUC__) || defined(__clang__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::Avx2;
+    if (__builtin_cpu_supports("ssse3")) return SimdLevel::Ssse3;
+    return SimdLevel::None;
+#elif defined(IDS_X86_SIMD) && defined(_MSC_VER)
+    int regs[4];
+    __cpuid(regs, 0);
+    int max_leaf = regs[0];
+    __cpuid(regs, 1);
+    bool ssse3 = (regs[2] & (1 << 9)) != 0;
+    bool osxsave = (regs[2] & (1 << 27)) != 0;
+    bool avx = (regs[2] & (1 << 28)) != 0;
+    // AVX2 also needs the OS to save the YMM registers (XCR0 bits 1 and 2)
+    if (max_leaf >= 7 && osxsave && avx && (_xgetbv(0) & 0x6) == 0x6) {
+        __cpuidex(regs, 7, 0);
+        if (regs[1] & (1 << 5)) return SimdLevel::Avx2;
+    }
+    return ssse3 ? SimdLevel::Ssse3 : SimdLevel::None;
+#else
+    return SimdLevel::None;
+#endif
+}
+
+} // namespace detail
+
+// Highest level usable on this CPU; detected once per process
+inline SimdLevel cpu_simd_level() {
+    static const SimdLevel level = detail::detect_simd_level();
+    return level;
+}
+
+inline const char* simd_level_name(SimdLevel level) {
+    switch (level) {
+        case SimdLevel::Avx2: return "AVX2";
+        case SimdLevel::Ssse3: return "SSSE3";
+        default: return "scalar";
+    }
+}
+
+} // namespace core
@@ -1,5 +1,6 @@
 #pragma once
 #include <cstdint>
+#include <memory_resource>
 #include <string>
 #include <vector>
 #include "core/Packet.hpp"
@@ -16,12 +17,14 @@ struct DNSHeader {
 };
 
 struct DNSQuestion {
-    std::string name{};
+    std::pmr::string name{};
     std::uint16_t type{0};
     std::uint16_t class_{0};
 };
 
-inline bool parse_dns(core::ByteSpan bytes, DNSHeader &header, std::vector<DNSQuestion> &questions) {
+// Question names are allocated from the vector's memory resource (e.g. a
+// worker's core::ScratchArena)
+inline bool parse_dns(core::ByteSpan bytes, DNSHeader &header, std::pmr::vector<DNSQuestion> &questions) {
     if (bytes.size() < 12) return false;
     
     header.id = (bytes[0] << 8) | bytes[1];
@@ -34,7 +37,7 @@ inline bool parse_dns(core::ByteSpan bytes, DNSHeader &header, std::vector<DNSQu
     // Parse questions (simplified)
     std::size_t offset = 12;
     for (std::uint16_t i = 0; i < header.questions && offset < bytes.size(); ++i) {
-        DNSQuestion q;
+        DNSQuestion q{std::pmr::string(questions.get_allocator())};
         
         // Parse name (simplified - doesn't handle compression)
         while (offset < bytes.size() && bytes[offset] != 0) {
@@ -0,0 +1,315 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "core/MappedFile.hpp"
+#include "core/dsa/BlockedBloomFilter.hpp"
+
+namespace core { namespace dsa {
+
+// Read-only domain set for exact and suffix (subdomain) matching, sized for
+// block lists of millions of names.
+//
+// Every entry lives in one open-addressing table keyed by a hash computed
+// over the name's bytes from right to left. A lookup walks the queried name
+// once from its end; at each label boundary the running hash is the hash of
+// that suffix ("com", "example.com", "www.example.com"), so every candidate
+// suffix costs one probe and no string building. Slots hold the full hash
+// and an offset into a string pool for verification.
+//
+// A blocked Bloom filter over the same suffix hashes sits in front of the
+// table. At ~10 bits per entry it stays cache-resident where the slots do
+// not, so the common case (no suffix listed) costs no table misses.
+//
+// Entry syntax: "example.com" matches only that name, "*.example.com" only
+// its subdomains, ".example.com" both. The built table can be saved as an
+// image and later memory-mapped and used in place.
+class DomainSet {
+public:
+    enum Flags : std::uint8_t { kExact = 1, kSubdomains = 2 };
+
+    struct Match {
+        std::string_view entry;     // matched suffix as stored (lowercase)
+        std::uint16_t category{0};  // caller-defined, e.g. feed id
+        bool exact{false};          // whole name matched (vs. a parent domain)
+    };
+
+    DomainSet() = default;
+    DomainSet(DomainSet&&) = default;
+    DomainSet& operator=(DomainSet&&) = default;
+
+    // Returns false for malformed entries
+    bool add(std::string_view entry, std::uint16_t category = 0) {
+        std::uint8_t flags = kExact;
+        if (entry.size() >= 2 && entry[0] == '*' && entry[1] == '.') {
+            flags = kSubdomains;
+            entry.remove_prefix(2);
+        } else if (!entry.empty() && entry[0] == '.') {
+            flags = kExact | kSubdomains;
+            entry.remove_prefix(1);
+        }
+        if (!entry.empty() && entry.back() == '.') entry.remove_suffix(1);
+        if (entry.empty() || entry.size() > kMaxNameLength) return false;
+
+        std::string name(entry);
+        for (char& c : name) {
+            c = lower(c);
+            bool ok = (c >= 'a' && c <= 'z') || (c >= '0' && c <= '9') || c == '-' || c == '.' || c == '_';
+            if (!ok) return false;
+        }
+        if (name.front() == '.' || name.find("..") != std::string::npos) return false;
+
+        auto [it, inserted] = pending_index_.try_emplace(name, pending_.size());
+        if (inserted) {
+            pending_.push_back(Pending{std::move(name), flags, category});
+        } else {
+            pending_[it->second].flags |= flags;
+        }
+        return true;
+    }
+
+    void build() {
+        std::size_t slots = 16;
+        while (slots < pending_.size() * 2) slots <<= 1;
+        owned_slots_.assign(slots, Slot{});
+        owned_strings_.clear();
+        bloom_.reset(pending_.size(), kBloomBitsPerEntry);
+        for (const auto& p : pending_) {
+            Slot slot{};
+            slot.hash = suffix_hash(p.name);
+            slot.offset = static_cast<std::uint32_t>(owned_strings_.size());
+            slot.length = static_cast<std::uint8_t>(p.name.size());
+            slot.flags = p.flags;
+            slot.category = p.category;
+            owned_strings_.insert(owned_strings_.end(), p.name.begin(), p.name.end());
+            bloom_.insert_hash(slot.hash);
+            std::size_t i = slot.hash & (slots - 1);
+            while (owned_slots_[i].length != 0) i = (i + 1) & (slots - 1);
+            owned_slots_[i] = slot;
+        }
+        count_ = pending_.size();
+        pending_.clear();
+        pending_.shrink_to_fit();
+        pending_index_.clear();
+        image_.close();
+        slots_ = owned_slots_.data();
+        slot_mask_ = slots - 1;
+        strings_ = owned_strings_.data();
+    }
+
+    // Checks name and each parent domain; name may use any case and a trailing dot
+    bool lookup(std::string_view name, Match* match = nullptr) const {
+        if (!slots_) return false;
+        if (!name.empty() && name.back() == '.') name.remove_suffix(1);
+        if (name.empty() || name.size() > kMaxNameLength) return false;
+
+        std::uint64_t h = kFnvOffset;
+        for (std::size_t i = name.size(); i-- > 0;) {
+            h = (h ^ static_cast<std::uint8_t>(lower(name[i]))) * kFnvPrime;
+            bool whole = i == 0;
+            if (!whole && name[i - 1] != '.') continue;
+            std::uint8_t need = whole ? kExact : kSubdomains;
+            std::uint64_t hash = finalize(h);
+            if (!bloom_.contains_hash(hash)) continue;
+            if (const Slot* slot = find(hash, name.substr(i))) {
+                if (!(slot->flags & need)) continue;
+                if (match) {
+                    match->entry = std::string_view(strings_ + slot->offset, slot->length);
+                    match->category = slot->category;
+                    match->exact = whole;
+                }
+                return true;
+            }
+        }
+        return false;
+    }
+
+    std::size_t size() const { return count_; }
+    bool mapped() const { return image_.is_open(); }
+
+    std::size_t memory_usage() const {
+        return owned_slots_.capacity() * sizeof(Slot) + owned_strings_.capacity() + bloom_.memory_usage();
+    }
+
+    // Writes the built table as an image tagged with source_hash (e.g. a
+    // hash of the list files it was built from)
+    bool save(const std::string& path, std::uint64_t source_hash) const {
+        Header header{};
+        std::memcpy(header.magic, kMagic, sizeof(header.magic));
+        header.version = kFormatVersion;
+        header.byte_order = kByteOrder;
+        header.source_hash = source_hash;
+        header.entry_count = count_;
+        header.slot_count = slots_ ? slot_mask_ + 1 : 0;
+        header.slots_offset = sizeof(Header);
+        header.bloom_offset = header.slots_offset + header.slot_count * sizeof(Slot);
+        header.bloom_blocks = bloom_.block_count();
+        header.strings_offset = header.bloom_offset + bloom_.byte_size();
+        header.strings_size = strings_size();
+        header.file_size = header.strings_offset + header.strings_size;
+
+        std::string tmp = path + ".tmp";
+        {
+            std::ofstream out(tmp, std::ios::binary | std::ios::trunc);
+            if (!out.is_open()) {
+                std::cerr << "[DomainSet] Cannot write " << tmp << std::endl;
+                return false;
+            }
+            out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+            out.write(reinterpret_cast<const char*>(slots_), static_cast<std::streamsize>(header.slot_count * sizeof(Slot)));
+            out.write(reinterpret_cast<const char*>(bloom_.data()), static_cast<std::streamsize>(bloom_.byte_size()));
+            out.write(strings_, static_cast<std::streamsize>(header.strings_size));
+            if (!out) return false;
+        }
+        std::error_code ec;
+        std::filesystem::rename(tmp, path, ec);
+        if (ec) {
+            std::cerr << "[DomainSet] Cannot replace " << path << ": " << ec.message() << std::endl;
+            std::filesystem::remove(tmp, ec);
+            return false;
+        }
+        return true;
+    }
+
+    // Maps an image written by save(). Fails if it is malformed or was
+    // built from a different source.
+    bool load(const std::string& path, std::uint64_t source_hash) {
+        core::MappedFile image;
+        if (!image.open(path) || image.size() < sizeof(Header)) return false;
+        Header header{};
+        std::memcpy(&header, image.data(), sizeof(header));
+        if (std::memcmp(header.magic, kMagic, sizeof(header.magic)) != 0 || header.version != kFormatVersion ||
+            header.byte_order != kByteOrder || header.source_hash != source_hash ||
+            header.file_size != image.size() || header.slot_count < 16 ||
+            (header.slot_count & (header.slot_count - 1)) != 0 || header.slots_offset != sizeof(Header) ||
+            header.slot_count > (image.size() - sizeof(Header)) / sizeof(Slot) ||
+            header.bloom_offset != header.slots_offset + header.slot_count * sizeof(Slot) ||
+            header.bloom_blocks == 0 || header.bloom_blocks > (image.size() - header.bloom_offset) / kBloomBlockSize ||
+            header.strings_offset != header.bloom_offset + header.bloom_blocks * kBloomBlockSize ||
+            header.strings_offset + header.strings_size != image.size()) {
+            return false;
+        }
+        const auto* slots = reinterpret_cast<const Slot*>(image.data() + header.slots_offset);
+        std::size_t used = 0;
+        for (std::size_t i = 0; i < header.slot_count; ++i) {
+            if (slots[i].length == 0) continue;
+            if (std::uint64_t{slots[i].offset} + slots[i].length > header.strings_size) return false;
+            ++used;
+        }
+        if (used != header.entry_count || used == header.slot_count) return false;
+
+        image_ = std::move(image);
+        owned_slots_.clear();
+        owned_strings_.clear();
+        slots_ = slots;
+        slot_mask_ = header.slot_count - 1;
+        bloom_.attach(reinterpret_cast<const BlockedBloomFilter::Block*>(image_.data() + header.bloom_offset),
+                      header.bloom_blocks);
+        strings_ = reinterpret_cast<const char*>(image_.data() + header.strings_offset);
+        count_ = header.entry_count;
+        return true;
+    }
+
+private:
+    static constexpr std::size_t kMaxNameLength = 253;
+    static constexpr std::uint64_t kFnvOffset = 1469598103934665603ull;
+    static constexpr std::uint64_t kFnvPrime = 1099511628211ull;
+    static constexpr char kMagic[8] = {'I', 'D', 'S', 'D', 'O', 'M', 'S', '\0'};
+    static constexpr std::uint32_t kFormatVersion = 2;
+    static constexpr double kBloomBitsPerEntry = 10.0;
+    static constexpr std::size_t kBloomBlockSize = sizeof(BlockedBloomFilter::Block);
+    static constexpr std::uint32_t kByteOrder = 0x01020304u;
+
+    struct Slot {
+        std::uint64_t hash{0};
+        std::uint32_t offset{0};   // into the string pool
+        std::uint8_t length{0};    // 0 = empty slot
+        std::uint8_t flags{0};
+        std::uint16_t category{0};
+    };
+    static_assert(sizeof(Slot) == 16, "Slot layout is part of the image format");
+
+    struct Header {
+        char magic[8];
+        std::uint32_t version;
+        std::uint32_t byte_order;
+        std::uint64_t source_hash;
+        std::uint64_t file_size;
+        std::uint64_t entry_count;
+        std::uint64_t slot_count;
+        std::uint64_t slots_offset;
+        std::uint64_t bloom_offset;
+        std::uint64_t bloom_blocks;
+        std::uint64_t strings_offset;
+        std::uint64_t strings_size;
+        std::uint64_t reserved;
+    };
+    // Slots start 32-byte aligned and the slot array is a power of two of at
+    // least 16 slots, so the Bloom blocks that follow are aligned as well
+    static_assert(sizeof(Header) % 32 == 0, "image sections must stay 32-byte aligned");
+
+    struct Pending {
+        std::string name;
+        std::uint8_t flags;
+        std::uint16_t category;
+    };
+
+    static char lower(char c) { return (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c; }
+
+    // FNV-1a over the bytes in reverse, then a 64-bit finalizer so the low
+    // bits used for the slot index are well mixed
+    static std::uint64_t finalize(std::uint64_t h) {
+        h ^= h >> 33;
+        h *= 0xff51afd7ed558ccdull;
+        h ^= h >> 33;
+        h *= 0xc4ceb9fe1a85ec53ull;
+        h ^= h >> 33;
+        return h;
+    }
+
+    static std::uint64_t suffix_hash(std::string_view s) {
+        std::uint64_t h = kFnvOffset;
+        for (std::size_t i = s.size(); i-- > 0;) h = (h ^ static_cast<std::uint8_t>(s[i])) * kFnvPrime;
+        return finalize(h);
+    }
+
+    const Slot* find(std::uint64_t hash, std::string_view suffix) const {
+        for (std::size_t i = hash & slot_mask_;; i = (i + 1) & slot_mask_) {
+            const Slot& slot = slots_[i];
+            if (slot.length == 0) return nullptr;
+            if (slot.hash != hash || slot.length != suffix.size()) continue;
+            const char* stored = strings_ + slot.offset;
+            bool equal = true;
+            for (std::size_t k = 0; k < suffix.size() && equal; ++k) equal = stored[k] == lower(suffix[k]);
+            if (equal) return &slot;
+        }
+    }
+
+    std::size_t strings_size() const {
+        if (!owned_strings_.empty() || !image_.is_open()) return owned_strings_.size();
+        return image_.size() - sizeof(Header) - (slot_mask_ + 1) * sizeof(Slot) - bloom_.byte_size();
+    }
+
+    // Build input
+    std::vector<Pending> pending_;
+    std::unordered_map<std::string, std::size_t> pending_index_;
+
+    // Built table: owned vectors, or views into image_
+    std::vector<Slot> owned_slots_;
+    std::vector<char> owned_strings_; // vector, not string: moves must keep strings_ valid
+    core::MappedFile image_;
+    BlockedBloomFilter bloom_;
+    const Slot* slots_{nullptr};
+    std::size_t slot_mask_{0};
+    const char* strings_{nullptr};
+    std::size_t count_{0};
+};
+
+}} // namespace core::dsa
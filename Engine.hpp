@@ -1,106 +1,549 @@
 #pragma once
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <string_view>
 #include <vector>
 #include <cstring>
+#include <iostream>
+#include <memory>
+#include <memory_resource>
 #include <unordered_map>
+#include "core/Hash.hpp"
+#include "core/MappedFile.hpp"
 #include "core/Packet.hpp"
-#include "core/dsa/AhoCorasick.hpp"
-#include "core/dsa/BloomFilter.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/dsa/LiteralMatcher.hpp"
+#include "core/dsa/Regex.hpp"
+#include "detect/AddressGroups.hpp"
+#include "detect/ResultCache.hpp"
 #include "detect/Rule.hpp"
+#include "detect/RuleProfiler.hpp"
 #include "flow/FlowTable.hpp"
 
 namespace detect {
 
+// One alert candidate. rule points into the engine and context into the
+// matched payload, so a result is valid while both are: consume results
+// before the payload is released or the reader moves to a newer engine.
 struct MatchResult {
-    Rule rule;
+    const Rule* rule;
+    std::size_t rule_index; // Engine::rule(rule_index) == *rule; unique across rule files, unlike rule->id
     std::size_t position;
-    std::string context;
+    std::string_view context;
+};
+
+// Results are allocated from the caller's memory resource (e.g. a per-batch
+// core::ScratchArena), the default heap resource unless given
+using MatchResults = std::pmr::vector<MatchResult>;
+
+// Per-packet bounds on regex verification work
+struct RegexLimits {
+    std::size_t max_verifications{32};
+    std::size_t max_scan_bytes{256 * 1024};
+};
+
+// Rules are split by transport protocol so each packet only scans the
+// literals that can apply to it. Proto-agnostic rules sit once in Any,
+// which every packet scans; Tcp, Udp and Other (every other protocol) hold
+// only the rules for them. A packet scans Any plus its protocol's group, or
+// every group when no flow key is known.
+enum class GroupId : std::size_t { Any = 0, Tcp, Udp, Other, Count };
+
+struct SignatureGroup {
+    std::vector<std::size_t> pattern_ids;            // unique literal ids scanned by this group
+    std::vector<std::size_t> unfiltered_regex_rules; // regex rules without a usable literal
+    core::dsa::LiteralMatcher matcher;
+};
+
+// Per-worker mutable state for Engine::match: lazy regex DFA caches,
+// candidate dedup marks and counters. Giving each worker its own scratch
+// lets one immutable Engine be shared by all of them; the scratch resets
+// itself when it meets a different engine (e.g. after a reload).
+struct MatchScratch {
+    std::uint64_t engine_generation{0};
+    std::vector<core::dsa::RegexCache> regex_caches;
+    std::vector<std::size_t> regex_candidates;
+    std::vector<MatchHit> hits;
+    std::vector<std::uint32_t> candidate_mark;
+    std::uint32_t candidate_gen{0};
+    std::uint64_t regex_verifications{0};
+    std::uint64_t regex_budget_skips{0};
+    RuleProfile* profile{nullptr}; // per-rule profiling, off when null
 };
 
 class Engine {
 public:
-    Engine() : bloom_(16384, 4), built_(false) {}
+    Engine() : built_(false) {}
 
     void addRule(Rule r) {
-        if (!r.payload_pattern.empty()) {
-            std::size_t pattern_id = aho_corasick_.add_pattern(r.payload_pattern);
-            pattern_to_rule_[pattern_id] = rules_.size();
-            bloom_.add(r.payload_pattern);
+        std::vector<Rule> one;
+        one.push_back(std::move(r));
+        add_rules(std::move(one));
+    }
+
+    // Adds a batch of rules. With a pool, regexes are compiled and literals
+    // deduplicated per chunk in parallel; the chunk tables are then merged
+    // into the shared literal table in rule order.
+    void add_rules(std::vector<Rule> rules, core::ThreadPool* pool = nullptr) {
+        struct Chunk {
+            std::vector<core::dsa::Regex> regexes;           // per rule in the chunk
+            std::vector<std::string> errors;                 // per rule, empty if accepted
+            std::vector<std::string> literals;               // unique within the chunk
+            std::unordered_map<std::string, std::size_t> index;
+            std::vector<std::vector<std::size_t>> literal_rules; // indices into rules
+        };
+
+        auto compile_chunk = [&rules](Chunk& chunk, std::size_t begin, std::size_t end) {
+            auto add_literal = [&chunk](const std::string& literal, std::size_t rule) {
+                auto [it, inserted] = chunk.index.try_emplace(literal, chunk.literals.size());
+                if (inserted) {
+                    chunk.literals.push_back(literal);
+                    chunk.literal_rules.emplace_back();
+                }
+                auto& list = chunk.literal_rules[it->second];
+                if (list.empty() || list.back() != rule) list.push_back(rule);
+            };
+            for (std::size_t i = begin; i < end; ++i) {
+                const Rule& r = rules[i];
+                chunk.regexes.emplace_back();
+                chunk.errors.emplace_back();
+                bool negated = false;
+                std::vector<core::dsa::IpPrefix> prefixes;
+                if ((!r.src.empty() && !AddressGroups::parse_spec(r.src, negated, prefixes)) ||
+                    (!r.dst.empty() && !AddressGroups::parse_spec(r.dst, negated, prefixes))) {
+                    chunk.errors.back() = "invalid address filter";
+                    continue;
+                }
+                if (!r.pcre.empty()) {
+                    if (!chunk.regexes.back().compile(r.pcre, r.pcre_flags)) {
+                        chunk.errors.back() = chunk.regexes.back().error();
+                        continue;
+                    }
+                    // The regex's required literals join the multi-pattern prefilter;
+                    // the regex itself only runs once one of them hits.
+                    for (const auto& literal : chunk.regexes.back().required_literals()) add_literal(literal, i);
+                }
+                if (!r.payload_pattern.empty()) add_literal(r.payload_pattern, i);
+            }
+        };
+
+        std::vector<Chunk> chunks;
+        std::vector<std::size_t> bounds{0};
+        if (pool && rules.size() >= 2 * kRulesPerChunk) {
+            std::size_t count = std::min(pool->size() * 4, rules.size() / kRulesPerChunk);
+            for (std::size_t c = 1; c <= count; ++c) bounds.push_back(rules.size() * c / count);
+            chunks.resize(count);
+            pool->parallel_for(count, [&](std::size_t c) { compile_chunk(chunks[c], bounds[c], bounds[c + 1]); });
+        } else {
+            bounds.push_back(rules.size());
+            chunks.resize(1);
+            compile_chunk(chunks[0], 0, rules.size());
+        }
+
+        // Final rule index of every accepted rule (rejected ones are skipped)
+        std::vector<std::size_t> final_index(rules.size(), SIZE_MAX);
+        std::size_t next = rules_.size();
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            for (std::size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+                if (chunks[c].errors[i - bounds[c]].empty()) final_index[i] = next++;
+            }
+        }
+
+        for (std::size_t c = 0; c < chunks.size(); ++c) {
+            Chunk& chunk = chunks[c];
+            for (std::size_t l = 0; l < chunk.literals.size(); ++l) {
+                std::size_t id = intern_pattern(std::move(chunk.literals[l]));
+                for (std::size_t i : chunk.literal_rules[l]) pattern_rules_[id].push_back(final_index[i]);
+            }
+            for (std::size_t i = bounds[c]; i < bounds[c + 1]; ++i) {
+                Rule& r = rules[i];
+                core::dsa::Regex& re = chunk.regexes[i - bounds[c]];
+                if (!chunk.errors[i - bounds[c]].empty()) {
+                    std::cerr << "[Engine] Skipping rule " << r.id << ": " << chunk.errors[i - bounds[c]] << std::endl;
+                    continue;
+                }
+                std::int32_t regex_index = -1;
+                if (!r.pcre.empty()) {
+                    if (re.required_literals().empty()) {
+                        std::cerr << "[Engine] Rule " << r.id << ": no literal in /" << r.pcre
+                                  << "/, regex runs on every payload" << std::endl;
+                    }
+                    regex_index = static_cast<std::int32_t>(regexes_.size());
+                    regexes_.push_back(std::move(re));
+                }
+                rule_regex_.push_back(regex_index);
+                add_address_filters(r);
+                rules_.push_back(std::move(r));
+            }
         }
-        rules_.emplace_back(std::move(r));
         built_ = false;
     }
 
-    void build() {
-        if (!built_) {
-            aho_corasick_.build();
-            built_ = true;
+    // Builds one literal matcher per signature group; the matcher kind is
+    // chosen from the group's pattern count and lengths. With a pool the
+    // groups' literal lists are gathered concurrently, then the matchers are
+    // built one group at a time, each large automaton build splitting itself
+    // across the pool (one task per group would leave most cores idle while
+    // the largest group builds).
+    void build(core::ThreadPool* pool = nullptr) {
+        if (built_) return;
+        address_groups_.build();
+        std::array<std::vector<std::string>, static_cast<std::size_t>(GroupId::Count)> group_literals;
+        auto collect_group = [this, &group_literals](std::size_t g) {
+            auto id = static_cast<GroupId>(g);
+            SignatureGroup& group = groups_[g];
+            group.pattern_ids.clear();
+            group.unfiltered_regex_rules.clear();
+
+            std::vector<std::string>& literals = group_literals[g];
+            for (std::size_t p = 0; p < patterns_.size(); ++p) {
+                bool used = false;
+                for (std::size_t r : pattern_rules_[p]) {
+                    if (rule_in_group(rules_[r], id)) {
+                        used = true;
+                        break;
+                    }
+                }
+                if (!used) continue;
+                group.pattern_ids.push_back(p);
+                literals.push_back(patterns_[p]);
+            }
+            for (std::size_t r = 0; r < rules_.size(); ++r) {
+                if (rule_regex_[r] >= 0 && rule_in_group(rules_[r], id) &&
+                    regexes_[static_cast<std::size_t>(rule_regex_[r])].required_literals().empty()) {
+                    group.unfiltered_regex_rules.push_back(r);
+                }
+            }
+        };
+        if (pool) {
+            pool->parallel_for(groups_.size(), collect_group);
+        } else {
+            for (std::size_t g = 0; g < groups_.size(); ++g) collect_group(g);
         }
+        for (std::size_t g = 0; g < groups_.size(); ++g) groups_[g].matcher.build(group_literals[g], pool);
+        generation_ = next_generation();
+        built_ = true;
     }
 
-    std::vector<MatchResult> match(core::ByteSpan payload, const flow::FlowKey* flow_key = nullptr) {
+    // Single-threaded convenience: builds on first use and matches with the
+    // engine's own scratch.
+    MatchResults match(core::ByteSpan payload, const flow::FlowKey* flow_key = nullptr) {
         if (!built_) build();
-        
-        std::vector<MatchResult> results;
-        
-        // Convert to string_view for processing
+        return match(payload, flow_key, scratch_);
+    }
+
+    // Thread-safe for a built engine as long as each thread passes its own scratch
+    MatchResults match(core::ByteSpan payload, const flow::FlowKey* flow_key, MatchScratch& scratch,
+                       std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const {
+        if (!built_) return MatchResults(memory);
+        std::string_view payload_str(reinterpret_cast<const char*>(payload.data()), payload.size());
+        const FlowContext flow = flow_context(flow_key);
+        collect_hits(payload_str, group_for(flow_key), flow, scratch);
+        return materialize(payload_str, scratch.hits.data(), scratch.hits.size(), memory);
+    }
+
+    // As above, through the worker's result cache: a payload already seen
+    // with the same signature group and flow filter inputs reuses the
+    // recorded outcome without scanning
+    MatchResults match(core::ByteSpan payload, const flow::FlowKey* flow_key, MatchScratch& scratch, ResultCache& cache,
+                       std::pmr::memory_resource* memory = std::pmr::get_default_resource()) const {
+        if (!built_ || !cache.enabled()) return match(payload, flow_key, scratch, memory);
         std::string_view payload_str(reinterpret_cast<const char*>(payload.data()), payload.size());
-        
-        // Bloom filter prefilter
-        bool bloom_match = false;
+        GroupId group = group_for(flow_key);
+        const FlowContext flow = flow_context(flow_key);
+
+        cache.sync(generation_);
+        const ResultScope scope{flow.src_class, flow.dst_class, static_cast<std::uint8_t>(group),
+                                static_cast<std::uint8_t>(flow_key ? flow_key->proto : 0u)};
+        std::uint64_t key = core::hash64(payload.data(), payload.size(), scope.seed());
+        if (const auto* entry = cache.find(key, scope, payload)) {
+            return materialize(payload_str, entry->hits, entry->count, memory);
+        }
+        collect_hits(payload_str, group, flow, scratch);
+        cache.store(key, scope, payload, scratch.hits.data(), scratch.hits.size());
+        return materialize(payload_str, scratch.hits.data(), scratch.hits.size(), memory);
+    }
+
+    std::size_t rule_count() const { return rules_.size(); }
+    const Rule& rule(std::size_t index) const { return rules_[index]; }
+    std::size_t regex_rule_count() const { return regexes_.size(); }
+    std::size_t pattern_count() const { return patterns_.size(); }
+    const SignatureGroup& group(GroupId id) const { return groups_[static_cast<std::size_t>(id)]; }
+
+    static const char* group_name(GroupId id) {
+        switch (id) {
+            case GroupId::Any: return "any";
+            case GroupId::Tcp: return "tcp";
+            case GroupId::Udp: return "udp";
+            case GroupId::Other: return "other";
+            case GroupId::Count: break;
+        }
+        return "?";
+    }
+
+    void set_regex_limits(RegexLimits limits) { regex_limits_ = limits; }
+    std::uint64_t regex_verifications() const { return scratch_.regex_verifications; }
+    std::uint64_t regex_budget_skips() const { return scratch_.regex_budget_skips; }
+
+    // Identifies one build of this engine; changes whenever the rules are rebuilt
+    std::uint64_t generation() const { return generation_; }
+
+    // Approximate heap footprint of the compiled rules (excludes scratch)
+    std::size_t memory_usage() const {
+        std::size_t bytes = sizeof(*this);
         for (const auto& rule : rules_) {
-            if (!rule.payload_pattern.empty() && bloom_.possibly_contains(rule.payload_pattern)) {
-                bloom_match = true;
-                break;
-            }
+            bytes += sizeof(Rule) + rule.message.capacity() + rule.payload_pattern.capacity() +
+                     rule.pcre.capacity() + rule.pcre_flags.capacity();
+        }
+        for (std::size_t p = 0; p < patterns_.size(); ++p) {
+            // literal, its index entry (a second copy of the string) and its rule list
+            bytes += 2 * (sizeof(std::string) + patterns_[p].capacity()) + 32;
+            bytes += sizeof(std::vector<std::size_t>) + pattern_rules_[p].capacity() * sizeof(std::size_t);
+        }
+        for (const auto& group : groups_) {
+            bytes += (group.pattern_ids.capacity() + group.unfiltered_regex_rules.capacity()) * sizeof(std::size_t);
+            bytes += group.matcher.memory_usage();
+        }
+        for (const auto& re : regexes_) bytes += re.memory_usage();
+        bytes += (rule_src_group_.capacity() + rule_dst_group_.capacity()) * sizeof(std::int32_t);
+        bytes += address_groups_.memory_usage();
+        return bytes;
+    }
+    
+private:
+    friend class CompiledRuleset;
+
+    static constexpr std::size_t kRulesPerChunk = 512;
+
+    std::size_t intern_pattern(std::string literal) {
+        auto it = pattern_index_.find(literal);
+        if (it != pattern_index_.end()) return it->second;
+        std::size_t id = patterns_.size();
+        pattern_index_.emplace(literal, id);
+        patterns_.push_back(std::move(literal));
+        pattern_rules_.emplace_back();
+        return id;
+    }
+
+    // Per-packet flow facts shared by every rule filter check
+    struct FlowContext {
+        const flow::FlowKey* key{nullptr};
+        std::uint32_t src_class{AddressGroups::kNoClass};
+        std::uint32_t dst_class{AddressGroups::kNoClass};
+    };
+
+    static std::uint64_t next_generation() {
+        static std::atomic<std::uint64_t> counter{0};
+        return ++counter;
+    }
+
+    void prepare_scratch(MatchScratch& scratch) const {
+#if IDS_RULE_PROFILING
+        if (scratch.profile && scratch.profile->generation() != generation_) {
+            scratch.profile->reset(generation_, rules_.size());
+        }
+#endif
+        if (scratch.engine_generation == generation_) return;
+        scratch.engine_generation = generation_;
+        scratch.regex_caches.clear();
+        scratch.regex_caches.resize(regexes_.size());
+        scratch.candidate_mark.assign(rules_.size(), 0);
+        scratch.candidate_gen = 0;
+    }
+
+    // Protocol group scanned alongside Any; Count (every group) without a flow key
+    static GroupId group_for(const flow::FlowKey* flow_key) {
+        if (!flow_key) return GroupId::Count;
+        if (flow_key->proto == 6) return GroupId::Tcp;
+        if (flow_key->proto == 17) return GroupId::Udp;
+        return GroupId::Other;
+    }
+
+    // Every rule is in exactly one group
+    static GroupId rule_group(const Rule& rule) {
+        if (rule.proto == 0) return GroupId::Any;
+        if (rule.proto == 6) return GroupId::Tcp;
+        if (rule.proto == 17) return GroupId::Udp;
+        return GroupId::Other;
+    }
+
+    static bool rule_in_group(const Rule& rule, GroupId id) { return rule_group(rule) == id; }
+
+    // Literal scan of Any and the protocol group plus regex verification;
+    // the outcome is left in scratch.hits
+    void collect_hits(std::string_view payload, GroupId proto_group, const FlowContext& flow,
+                      MatchScratch& scratch) const {
+        prepare_scratch(scratch);
+        if (++scratch.candidate_gen == 0) {
+            std::fill(scratch.candidate_mark.begin(), scratch.candidate_mark.end(), 0);
+            scratch.candidate_gen = 1;
+        }
+        scratch.regex_candidates.clear();
+        scratch.hits.clear();
+        if (proto_group == GroupId::Count) {
+            for (std::size_t g = 0; g < groups_.size(); ++g) scan_group(payload, static_cast<GroupId>(g), flow, scratch);
+        } else {
+            scan_group(payload, GroupId::Any, flow, scratch);
+            scan_group(payload, proto_group, flow, scratch);
         }
-        
-        if (!bloom_match) return results;
-        
-        // Aho-Corasick multi-pattern matching
-        auto matches = aho_corasick_.search(payload_str);
-        
-        for (const auto& match : matches) {
-            auto it = pattern_to_rule_.find(match.pattern_id);
-            if (it != pattern_to_rule_.end()) {
-                const Rule& rule = rules_[it->second];
-                
+        verify_regex_candidates(payload, flow, scratch);
+    }
+
+    // A literal can be shared by rules in several groups; each group's scan
+    // only reports the rules it holds
+    void scan_group(std::string_view payload, GroupId group_id, const FlowContext& flow, MatchScratch& scratch) const {
+        const SignatureGroup& group = groups_[static_cast<std::size_t>(group_id)];
+#if IDS_RULE_PROFILING
+        RuleProfile* profile = scratch.profile;
+#endif
+
+        group.matcher.scan(payload, [&](std::size_t position, std::size_t local_id) {
+            std::size_t pattern_id = group.pattern_ids[local_id];
+            for (std::size_t rule_index : pattern_rules_[pattern_id]) {
+                if (!rule_in_group(rules_[rule_index], group_id)) continue;
+#if IDS_RULE_PROFILING
+                if (profile) RuleCounters::bump(profile->rule(rule_index).candidates);
+#endif
+                // Literal hit for a regex rule: queue it once for verification
+                if (rule_regex_[rule_index] >= 0) {
+                    if (scratch.candidate_mark[rule_index] != scratch.candidate_gen) {
+                        scratch.candidate_mark[rule_index] = scratch.candidate_gen;
+                        scratch.regex_candidates.push_back(rule_index);
+                    }
+                    continue;
+                }
+
                 // Apply additional filters
-                if (flow_key && !check_flow_filters(rule, *flow_key)) {
+                if (!check_flow_filters(rule_index, flow)) {
                     continue;
                 }
-                
-                MatchResult result;
-                result.rule = rule;
-                result.position = match.position;
-                result.context = extract_context(payload_str, match.position, match.length);
-                results.push_back(std::move(result));
+
+                scratch.hits.push_back({static_cast<std::uint32_t>(rule_index), static_cast<std::uint32_t>(position),
+                                        static_cast<std::uint32_t>(patterns_[pattern_id].size())});
+#if IDS_RULE_PROFILING
+                if (profile) RuleCounters::bump(profile->rule(rule_index).matches);
+#endif
+            }
+        });
+
+        scratch.regex_candidates.insert(scratch.regex_candidates.end(),
+                                        group.unfiltered_regex_rules.begin(), group.unfiltered_regex_rules.end());
+#if IDS_RULE_PROFILING
+        if (profile) {
+            for (std::size_t rule_index : group.unfiltered_regex_rules) {
+                RuleCounters::bump(profile->rule(rule_index).candidates);
             }
         }
-        
+#endif
+    }
+
+    MatchResults materialize(std::string_view payload, const MatchHit* hits, std::size_t count,
+                             std::pmr::memory_resource* memory) const {
+        MatchResults results(memory);
+        results.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) {
+            results.push_back(MatchResult{&rules_[hits[i].rule], hits[i].rule, hits[i].position,
+                                          extract_context(payload, hits[i].position, hits[i].context_length)});
+        }
         return results;
     }
 
-    std::size_t rule_count() const { return rules_.size(); }
-    
-private:
-    bool check_flow_filters(const Rule& rule, const flow::FlowKey& flow_key) {
-        // Add IP/port filtering logic here
-        (void)rule; (void)flow_key;
+    // Runs the queued regexes, bounded by the per-packet verification budget
+    void verify_regex_candidates(std::string_view payload, const FlowContext& flow, MatchScratch& scratch) const {
+        std::size_t verified = 0;
+        std::size_t scanned = 0;
+        for (std::size_t rule_index : scratch.regex_candidates) {
+            if (!check_flow_filters(rule_index, flow)) continue;
+
+            if (verified >= regex_limits_.max_verifications ||
+                scanned + payload.size() > regex_limits_.max_scan_bytes) {
+                ++scratch.regex_budget_skips;
+                continue;
+            }
+            ++verified;
+            ++scratch.regex_verifications;
+            scanned += payload.size();
+
+            auto regex_index = static_cast<std::size_t>(rule_regex_[rule_index]);
+            std::size_t end = 0;
+#if IDS_RULE_PROFILING
+            std::uint64_t start = scratch.profile ? profile_ticks() : 0;
+#endif
+            bool found = regexes_[regex_index].search(payload, scratch.regex_caches[regex_index], &end);
+#if IDS_RULE_PROFILING
+            if (scratch.profile) {
+                RuleCounters& c = scratch.profile->rule(rule_index);
+                RuleCounters::bump(c.ticks, profile_ticks() - start);
+                RuleCounters::bump(c.verifications);
+                if (found) RuleCounters::bump(c.matches);
+            }
+#endif
+            if (!found) continue;
+
+            // end offset of the earliest match
+            scratch.hits.push_back({static_cast<std::uint32_t>(rule_index), static_cast<std::uint32_t>(end), 0});
+        }
+    }
+
+    FlowContext flow_context(const flow::FlowKey* flow_key) const {
+        FlowContext flow;
+        flow.key = flow_key;
+        if (flow_key && address_groups_.group_count() > 0) {
+            flow.src_class = address_groups_.classify_v4(flow_key->src);
+            flow.dst_class = address_groups_.classify_v4(flow_key->dst);
+        }
+        return flow;
+    }
+
+    // Protocol and address filters; everything passes when no flow is known
+    bool check_flow_filters(std::size_t rule_index, const FlowContext& flow) const {
+        if (!flow.key) return true;
+        const Rule& rule = rules_[rule_index];
+        if (rule.proto != 0 && rule.proto != flow.key->proto) return false;
+        if (rule_src_group_[rule_index] >= 0 && !address_groups_.contains(flow.src_class, rule_src_group_[rule_index])) {
+            return false;
+        }
+        if (rule_dst_group_[rule_index] >= 0 && !address_groups_.contains(flow.dst_class, rule_dst_group_[rule_index])) {
+            return false;
+        }
         return true;
     }
+
+    // Registers the rule's src/dst specs (already validated) as address groups
+    void add_address_filters(const Rule& rule) {
+        rule_src_group_.push_back(rule.src.empty() ? -1 : address_groups_.add(rule.src));
+        rule_dst_group_.push_back(rule.dst.empty() ? -1 : address_groups_.add(rule.dst));
+    }
     
-    std::string extract_context(std::string_view payload, std::size_t pos, std::size_t len) {
+    static std::string_view extract_context(std::string_view payload, std::size_t pos, std::size_t len) {
         std::size_t start = pos > 10 ? pos - 10 : 0;
         std::size_t end = std::min(pos + len + 10, payload.size());
-        return std::string(payload.substr(start, end - start));
+        return payload.substr(start, end - start);
     }
 
     std::vector<Rule> rules_;
-    core::dsa::AhoCorasick aho_corasick_;
-    core::dsa::BloomFilter bloom_;
-    std::unordered_map<std::size_t, std::size_t> pattern_to_rule_;
+    // Unique literals, indexed by pattern id, and the rules each one feeds
+    std::vector<std::string> patterns_;
+    std::vector<std::vector<std::size_t>> pattern_rules_;
+    std::unordered_map<std::string, std::size_t> pattern_index_;
+    std::array<SignatureGroup, static_cast<std::size_t>(GroupId::Count)> groups_{};
+
+    // Regex rules: compiled programs (lazy DFA caches live in MatchScratch)
+    std::vector<std::int32_t> rule_regex_;
+    std::vector<core::dsa::Regex> regexes_;
+    RegexLimits regex_limits_{};
+
+    // Rule src/dst filters: address group ids, -1 = any
+    std::vector<std::int32_t> rule_src_group_;
+    std::vector<std::int32_t> rule_dst_group_;
+    AddressGroups address_groups_;
+
+    MatchScratch scratch_; // used by the single-threaded match() overload
+    std::uint64_t generation_{0};
+    std::shared_ptr<const core::MappedFile> image_; // backs attached automata when loaded from a compiled ruleset
     bool built_;
 };
 
@@ -0,0 +1,166 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "core/ProcessMemory.hpp"
+#include "core/ThreadPool.hpp"
+#include "detect/CompiledRuleset.hpp"
+#include "detect/Engine.hpp"
+
+namespace detect {
+
+// Publishes immutable Engine snapshots to worker threads, RCU style.
+//
+// publish() swaps the current snapshot under a mutex and then bumps an
+// atomic version. Workers hold their own shared_ptr to the snapshot they
+// are using and only compare the version at batch boundaries, so matching
+// never takes the lock. The old engine is freed when the last worker
+// holding it picks up the new one (its grace period ends).
+class EngineHandle {
+public:
+    explicit EngineHandle(std::shared_ptr<const Engine> engine = nullptr) : current_(std::move(engine)) {}
+
+    void publish(std::shared_ptr<const Engine> engine) {
+        std::shared_ptr<const Engine> old;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            old = std::move(current_);
+            current_ = std::move(engine);
+            version_.fetch_add(1, std::memory_order_release);
+        }
+        // old (if this was the last reference) is destroyed outside the lock
+    }
+
+    std::shared_ptr<const Engine> snapshot() const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return current_;
+    }
+
+    std::uint64_t version() const { return version_.load(std::memory_order_acquire); }
+
+private:
+    mutable std::mutex mutex_;
+    std::shared_ptr<const Engine> current_;
+    std::atomic<std::uint64_t> version_{0};
+};
+
+// Worker-side view of an EngineHandle: the snapshot in use plus this
+// worker's match scratch and result cache (result_cache_entries = 0
+// disables it). Not shared between threads.
+class EngineReader {
+public:
+    explicit EngineReader(const EngineHandle& handle, std::size_t result_cache_entries = 0,
+                          ResultCacheStats* cache_stats = nullptr)
+        : handle_(handle), cache_(result_cache_entries, cache_stats) {
+        refresh();
+    }
+
+    // Call at batch boundaries. Returns true if a newer engine was picked up.
+    bool refresh() {
+        std::uint64_t version = handle_.version();
+        if (engine_ && version == seen_version_) return false;
+        engine_ = handle_.snapshot();
+        seen_version_ = version;
+        return true;
+    }
+
+    // Results live in memory (see MatchResults) and point into the current
+    // engine, so they must be consumed before the next refresh()
+    MatchResults match(core::ByteSpan payload, const flow::FlowKey* flow_key = nullptr,
+                       std::pmr::memory_resource* memory = std::pmr::get_default_resource()) {
+        if (!engine_) return MatchResults(memory);
+        return engine_->match(payload, flow_key, scratch_, cache_, memory);
+    }
+
+    // Per-rule profiling for this worker's matches; nullptr turns it off
+    void set_profile(RuleProfile* profile) { scratch_.profile = profile; }
+
+    const Engine* engine() const { return engine_.get(); }
+    const MatchScratch& scratch() const { return scratch_; }
+    const ResultCache& result_cache() const { return cache_; }
+
+private:
+    const EngineHandle& handle_;
+    std::shared_ptr<const Engine> engine_;
+    std::uint64_t seen_version_{0};
+    MatchScratch scratch_;
+    ResultCache cache_;
+};
+
+struct ReloadStats {
+    bool ok{false};
+    std::size_t rule_count{0};
+    double duration_ms{0};
+    std::size_t old_engine_bytes{0};     // estimated footprint of the replaced engine
+    std::size_t new_engine_bytes{0};     // estimated footprint of the new engine
+    core::ProcessMemory before{};        // process memory when the reload started
+    core::ProcessMemory overlap{};       // process memory with both engines alive
+};
+
+// Compiles rule files on a background thread and publishes the result
+// through an EngineHandle. Capture and matching keep running on the old
+// engine until workers reach their next batch boundary.
+class RulesetReloader {
+public:
+    using Callback = std::function<void(const ReloadStats&)>;
+
+    explicit RulesetReloader(EngineHandle& handle, core::ThreadPool* pool = nullptr)
+        : handle_(handle), pool_(pool) {}
+    ~RulesetReloader() { join(); }
+
+    RulesetReloader(const RulesetReloader&) = delete;
+    RulesetReloader& operator=(const RulesetReloader&) = delete;
+
+    // Returns false if a reload is already in progress
+    bool start(std::vector<std::string> rule_files, std::string image_path, Callback on_done) {
+        if (busy_.exchange(true)) return false;
+        join();
+        thread_ = std::thread([this, files = std::move(rule_files), path = std::move(image_path),
+                               done = std::move(on_done)]() {
+            ReloadStats stats = run(files, path);
+            busy_ = false;
+            if (done) done(stats);
+        });
+        return true;
+    }
+
+    bool busy() const { return busy_.load(); }
+
+    void join() {
+        if (thread_.joinable()) thread_.join();
+    }
+
+private:
+    ReloadStats run(const std::vector<std::string>& rule_files, const std::string& image_path) {
+        ReloadStats stats;
+        core::query_process_memory(stats.before);
+        auto start = std::chrono::steady_clock::now();
+
+        auto engine = std::make_shared<Engine>();
+        if (rule_files.empty() || !load_or_compile_ruleset(*engine, rule_files, image_path, pool_)) return stats;
+        engine->build(pool_);
+
+        stats.duration_ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        stats.rule_count = engine->rule_count();
+        stats.new_engine_bytes = engine->memory_usage();
+        if (auto old = handle_.snapshot()) stats.old_engine_bytes = old->memory_usage();
+        core::query_process_memory(stats.overlap);
+
+        handle_.publish(std::move(engine));
+        stats.ok = true;
+        return stats;
+    }
+
+    EngineHandle& handle_;
+    core::ThreadPool* pool_;
+    std::thread thread_;
+    std::atomic<bool> busy_{false};
+};
+
+} // namespace detect
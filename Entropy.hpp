@@ -0,0 +1,92 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IDS_ENTROPY_SSE2 1
+#endif
+
+namespace core {
+
+// Byte-entropy estimation for spotting compressed or encrypted payloads.
+// Samples are short (the first payload bytes of a flow direction), so the
+// histogram counters are 16-bit and c*log2(c) comes from a table.
+namespace entropy_detail {
+
+constexpr std::size_t kMaxSample = 4096;
+
+inline const std::array<float, kMaxSample + 1>& clog2_table() {
+    static const auto table = [] {
+        std::array<float, kMaxSample + 1> t{};
+        for (std::size_t c = 1; c <= kMaxSample; ++c) {
+            t[c] = static_cast<float>(static_cast<double>(c) * std::log2(static_cast<double>(c)));
+        }
+        return t;
+    }();
+    return table;
+}
+
+} // namespace entropy_detail
+
+// Bytes with the high bit set (SSE2: 16 per compare)
+inline std::size_t count_high_bytes(const std::uint8_t* data, std::size_t size) {
+    std::size_t count = 0;
+    std::size_t i = 0;
+#if defined(IDS_ENTROPY_SSE2)
+    for (; i + 16 <= size; i += 16) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i));
+        count += static_cast<std::size_t>(std::popcount(static_cast<unsigned>(_mm_movemask_epi8(v))));
+    }
+#endif
+    for (; i < size; ++i) count += data[i] >> 7;
+    return count;
+}
+
+// Shannon entropy of the sample in bits per byte (0..8). At most
+// kMaxSample bytes are looked at.
+inline double byte_entropy(const std::uint8_t* data, std::size_t size) {
+    size = std::min(size, entropy_detail::kMaxSample);
+    if (size == 0) return 0.0;
+
+    // Four interleaved histograms so runs of equal bytes don't serialize on
+    // one counter's load/store
+    std::uint16_t hist[4][256] = {};
+    std::size_t i = 0;
+    for (; i + 4 <= size; i += 4) {
+        ++hist[0][data[i]];
+        ++hist[1][data[i + 1]];
+        ++hist[2][data[i + 2]];
+        ++hist[3][data[i + 3]];
+    }
+    for (; i < size; ++i) ++hist[0][data[i]];
+
+    // H = log2(n) - sum(c * log2(c)) / n
+    const auto& clog2 = entropy_detail::clog2_table();
+    float sum = 0.0f;
+    for (std::size_t b = 0; b < 256; ++b) {
+        sum += clog2[hist[0][b] + hist[1][b] + hist[2][b] + hist[3][b]];
+    }
+    return std::log2(static_cast<double>(size)) - static_cast<double>(sum) / static_cast<double>(size);
+}
+
+// True if the sample's entropy reaches threshold (bits per byte). Bytes
+// split into high-bit and 7-bit classes bound the entropy by 7 + h(f), with
+// f the high-bit fraction: text, which has almost no high bytes, is
+// rejected by the SIMD count alone, without building the histogram.
+inline bool entropy_at_least(const std::uint8_t* data, std::size_t size, double threshold) {
+    size = std::min(size, entropy_detail::kMaxSample);
+    if (size == 0) return threshold <= 0.0;
+    if (threshold > 7.0) {
+        double f = static_cast<double>(count_high_bytes(data, size)) / static_cast<double>(size);
+        double h = (f <= 0.0 || f >= 1.0) ? 0.0 : -(f * std::log2(f) + (1.0 - f) * std::log2(1.0 - f));
+        if (7.0 + h < threshold) return false;
+    }
+    return byte_entropy(data, size) >= threshold;
+}
+
+} // namespace core
@@ -1,31 +1,266 @@
 #pragma once
+#include <chrono>
 #include <cstdint>
+#include <cstring>
 #include <string>
-#include <sstream>
+#include <string_view>
 #include "flow/FlowTable.hpp"
 #include "detect/Rule.hpp"
 
 namespace output {
 
+// Hand-rolled EVE JSON serialization. Everything appends to a caller-owned
+// std::string so a writer can reuse one buffer for a whole batch of events.
+
+namespace eve_detail {
+
+// "00".."99": two digits per table lookup
+inline const char* digit_pairs() {
+    static const char table[] =
+        "00010203040506070809101112131415161718192021222324252627282930313233343536373839"
+        "40414243444546474849505152535455565758596061626364656667686970717273747576777879"
+        "8081828384858687888990919293949596979899";
+    return table;
+}
+
+inline char* write_2digits(char* out, unsigned v) {
+    std::memcpy(out, digit_pairs() + 2 * v, 2);
+    return out + 2;
+}
+
+// Writes v backwards ending at end; returns the first character
+inline char* write_uint_backwards(char* end, std::uint64_t v) {
+    while (v >= 100) {
+        end -= 2;
+        std::memcpy(end, digit_pairs() + 2 * (v % 100), 2);
+        v /= 100;
+    }
+    if (v >= 10) {
+        end -= 2;
+        std::memcpy(end, digit_pairs() + 2 * v, 2);
+    } else {
+        *--end = static_cast<char>('0' + v);
+    }
+    return end;
+}
+
+// Proleptic Gregorian date from days since 1970-01-01 (H. Hinnant's algorithm)
+inline void civil_from_days(std::int64_t days, int& year, unsigned& month, unsigned& day) {
+    days += 719468;
+    std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    auto doe = static_cast<unsigned>(days - era * 146097);
+    unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    unsigned mp = (5 * doy + 2) / 153;
+    day = doy - (153 * mp + 2) / 5 + 1;
+    month = mp < 10 ? mp + 3 : mp - 9;
+    year = static_cast<int>(static_cast<std::int64_t>(yoe) + era * 400 + (month <= 2));
+}
+
+} // namespace eve_detail
+
+inline void append_uint(std::string& out, std::uint64_t v) {
+    char buf[20];
+    char* begin = eve_detail::write_uint_backwards(buf + sizeof(buf), v);
+    out.append(begin, static_cast<std::size_t>(buf + sizeof(buf) - begin));
+}
+
+// Dotted quad into out (at least 15 bytes); returns the end
+inline char* format_ipv4(char* out, std::uint32_t ip) {
+    for (int shift = 24; shift >= 0; shift -= 8) {
+        unsigned octet = (ip >> shift) & 0xFF;
+        if (octet >= 100) {
+            *out++ = static_cast<char>('0' + octet / 100);
+            out = eve_detail::write_2digits(out, octet % 100);
+        } else if (octet >= 10) {
+            out = eve_detail::write_2digits(out, octet);
+        } else {
+            *out++ = static_cast<char>('0' + octet);
+        }
+        if (shift != 0) *out++ = '.';
+    }
+    return out;
+}
+
+inline void append_ipv4(std::string& out, std::uint32_t ip) {
+    char buf[16];
+    out.append(buf, static_cast<std::size_t>(format_ipv4(buf, ip) - buf));
+}
+
 inline std::string ipv4_to_string(std::uint32_t ip) {
-    std::ostringstream oss;
-    oss << ((ip >> 24) & 0xFF) << '.'
-        << ((ip >> 16) & 0xFF) << '.'
-        << ((ip >> 8) & 0xFF) << '.'
-        << (ip & 0xFF);
-    return oss.str();
+    char buf[16];
+    return std::string(buf, static_cast<std::size_t>(format_ipv4(buf, ip) - buf));
+}
+
+// RFC 3339 UTC timestamp with microseconds: 2024-05-01T12:34:56.123456Z
+inline void append_rfc3339_us(std::string& out, std::int64_t micros_since_epoch) {
+    std::int64_t seconds = micros_since_epoch / 1000000;
+    std::int64_t micros = micros_since_epoch % 1000000;
+    if (micros < 0) {
+        micros += 1000000;
+        --seconds;
+    }
+    std::int64_t days = seconds / 86400;
+    std::int64_t rem = seconds % 86400;
+    if (rem < 0) {
+        rem += 86400;
+        --days;
+    }
+    int year;
+    unsigned month, day;
+    eve_detail::civil_from_days(days, year, month, day);
+
+    char buf[27];
+    char* p = buf;
+    unsigned y = static_cast<unsigned>(year) % 10000;
+    p = eve_detail::write_2digits(p, y / 100);
+    p = eve_detail::write_2digits(p, y % 100);
+    *p++ = '-';
+    p = eve_detail::write_2digits(p, month);
+    *p++ = '-';
+    p = eve_detail::write_2digits(p, day);
+    *p++ = 'T';
+    p = eve_detail::write_2digits(p, static_cast<unsigned>(rem / 3600));
+    *p++ = ':';
+    p = eve_detail::write_2digits(p, static_cast<unsigned>(rem / 60 % 60));
+    *p++ = ':';
+    p = eve_detail::write_2digits(p, static_cast<unsigned>(rem % 60));
+    *p++ = '.';
+    auto us = static_cast<unsigned>(micros);
+    p = eve_detail::write_2digits(p, us / 10000);
+    p = eve_detail::write_2digits(p, us / 100 % 100);
+    p = eve_detail::write_2digits(p, us % 100);
+    *p++ = 'Z';
+    out.append(buf, static_cast<std::size_t>(p - buf));
+}
+
+inline std::int64_t micros_since_epoch(std::chrono::system_clock::time_point t) {
+    return std::chrono::duration_cast<std::chrono::microseconds>(t.time_since_epoch()).count();
+}
+
+// Quoted JSON string. Quotes, backslashes and control characters are
+// escaped; other bytes pass through (rule messages are UTF-8).
+inline void append_json_string(std::string& out, std::string_view s) {
+    static const char hex[] = "0123456789abcdef";
+    out.push_back('"');
+    std::size_t run = 0; // start of the pending unescaped run
+    for (std::size_t i = 0; i < s.size(); ++i) {
+        auto c = static_cast<unsigned char>(s[i]);
+        if (c >= 0x20 && c != '"' && c != '\\') continue;
+        out.append(s.data() + run, i - run);
+        run = i + 1;
+        out.push_back('\\');
+        switch (c) {
+        case '"': out.push_back('"'); break;
+        case '\\': out.push_back('\\'); break;
+        case '\n': out.push_back('n'); break;
+        case '\r': out.push_back('r'); break;
+        case '\t': out.push_back('t'); break;
+        default:
+            out.append("u00", 3);
+            out.push_back(hex[c >> 4]);
+            out.push_back(hex[c & 15]);
+            break;
+        }
+    }
+    out.append(s.data() + run, s.size() - run);
+    out.push_back('"');
+}
+
+// Payload bytes for display: printable ASCII kept, everything else '.'
+inline void append_json_printable(std::string& out, std::string_view s) {
+    out.push_back('"');
+    for (char ch : s) {
+        auto c = static_cast<unsigned char>(ch);
+        if (c < 0x20 || c >= 0x7f) {
+            out.push_back('.');
+        } else {
+            if (c == '"' || c == '\\') out.push_back('\\');
+            out.push_back(ch);
+        }
+    }
+    out.push_back('"');
+}
+
+// Opening of an EVE record: timestamp, event type and the flow's endpoints
+inline void append_eve_common(std::string& out, std::int64_t timestamp_us, std::string_view event_type,
+                              const flow::FlowKey& k) {
+    out.append("{\"timestamp\":\"");
+    append_rfc3339_us(out, timestamp_us);
+    out.append("\",\"event_type\":\"");
+    out.append(event_type);
+    out.append("\",\"src_ip\":\"");
+    append_ipv4(out, k.src);
+    out.append("\",\"src_port\":");
+    append_uint(out, k.sport);
+    out.append(",\"dest_ip\":\"");
+    append_ipv4(out, k.dst);
+    out.append("\",\"dest_port\":");
+    append_uint(out, k.dport);
+    out.append(",\"proto\":");
+    append_uint(out, k.proto);
+}
+
+// One EVE alert record (no trailing newline)
+inline void append_eve_alert(std::string& out, std::int64_t timestamp_us, std::uint32_t signature_id,
+                             std::string_view signature, const flow::FlowKey& k, std::string_view payload_printable) {
+    append_eve_common(out, timestamp_us, "alert", k);
+    out.append(",\"alert\":{\"signature_id\":");
+    append_uint(out, signature_id);
+    out.append(",\"signature\":");
+    append_json_string(out, signature);
+    out.push_back('}');
+    if (!payload_printable.empty()) {
+        out.append(",\"payload_printable\":");
+        append_json_printable(out, payload_printable);
+    }
+    out.push_back('}');
+}
+
+// One EVE flow record for a finished flow direction (no trailing newline)
+inline void append_eve_flow(std::string& out, std::int64_t timestamp_us, const flow::FlowKey& k,
+                            std::uint64_t packets, std::uint64_t bytes, std::int64_t start_us) {
+    append_eve_common(out, timestamp_us, "flow", k);
+    out.append(",\"flow\":{\"pkts\":");
+    append_uint(out, packets);
+    out.append(",\"bytes\":");
+    append_uint(out, bytes);
+    out.append(",\"start\":\"");
+    append_rfc3339_us(out, start_us);
+    out.append("\",\"end\":\"");
+    append_rfc3339_us(out, timestamp_us);
+    out.append("\"}}");
+}
+
+// One EVE tls record for a parsed ClientHello or ServerHello (no trailing
+// newline); the fingerprint is JA3 for a client and JA3S for a server
+inline void append_eve_tls(std::string& out, std::int64_t timestamp_us, const flow::FlowKey& k, bool client,
+                           std::uint16_t version, std::string_view sni, std::string_view alpn,
+                           std::string_view fingerprint_hex) {
+    static const char hex[] = "0123456789abcdef";
+    append_eve_common(out, timestamp_us, "tls", k);
+    char v[6] = {'0', 'x', hex[version >> 12], hex[(version >> 8) & 15], hex[(version >> 4) & 15], hex[version & 15]};
+    out.append(",\"tls\":{\"version\":\"");
+    out.append(v, sizeof(v));
+    out.push_back('"');
+    if (!sni.empty()) {
+        out.append(",\"sni\":");
+        append_json_string(out, sni);
+    }
+    if (!alpn.empty()) {
+        out.append(",\"alpn\":");
+        append_json_string(out, alpn);
+    }
+    out.append(client ? ",\"ja3\":{\"hash\":" : ",\"ja3s\":{\"hash\":");
+    append_json_string(out, fingerprint_hex);
+    out.append("}}}");
 }
 
 inline std::string make_eve_alert_line(const detect::Rule& rule, const flow::FlowKey& k) {
-    std::ostringstream oss;
-    oss << "{\"timestamp\":\"now\",";
-    oss << "\"event_type\":\"alert\",";
-    oss << "\"alert\":{\"signature_id\":" << rule.id << ",\"signature\":\"" << rule.message << "\"},";
-    oss << "\"src_ip\":\"" << ipv4_to_string(k.src) << "\",";
-    oss << "\"src_port\":" << k.sport << ",";
-    oss << "\"dest_ip\":\"" << ipv4_to_string(k.dst) << "\",";
-    oss << "\"dest_port\":" << k.dport << "}";
-    return oss.str();
+    std::string line;
+    line.reserve(256);
+    append_eve_alert(line, micros_since_epoch(std::chrono::system_clock::now()), rule.id, rule.message, k, {});
+    return line;
 }
 
 } // namespace output
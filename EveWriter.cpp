@@ -0,0 +1,312 @@
+#include "output/EveWriter.hpp"
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <iostream>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace output {
+
+// Append-only log file, or stdout for an empty path. size() counts bytes in
+// the file including those present when it was opened.
+class EveFile {
+public:
+    ~EveFile() { close(); }
+
+    bool open(const std::string& path) {
+        close();
+        size_ = 0;
+#ifdef _WIN32
+        if (path.empty()) {
+            handle_ = GetStdHandle(STD_OUTPUT_HANDLE);
+            owned_ = false;
+            return handle_ != INVALID_HANDLE_VALUE && handle_ != nullptr;
+        }
+        handle_ = CreateFileA(path.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+                              OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (handle_ == INVALID_HANDLE_VALUE) return false;
+        owned_ = true;
+        LARGE_INTEGER size{};
+        if (GetFileSizeEx(handle_, &size)) size_ = static_cast<std::uint64_t>(size.QuadPart);
+        return true;
+#else
+        if (path.empty()) {
+            fd_ = STDOUT_FILENO;
+            owned_ = false;
+            return true;
+        }
+        fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0644);
+        if (fd_ < 0) return false;
+        owned_ = true;
+        struct stat st{};
+        if (::fstat(fd_, &st) == 0) size_ = static_cast<std::uint64_t>(st.st_size);
+        return true;
+#endif
+    }
+
+    bool write(const char* data, std::size_t size) {
+        while (size != 0) {
+#ifdef _WIN32
+            DWORD chunk = static_cast<DWORD>(std::min<std::size_t>(size, 1u << 30));
+            DWORD done = 0;
+            if (!WriteFile(handle_, data, chunk, &done, nullptr)) return false;
+#else
+            ssize_t done = ::write(fd_, data, size);
+            if (done < 0) {
+                if (errno == EINTR) continue;
+                return false;
+            }
+#endif
+            data += done;
+            size -= static_cast<std::size_t>(done);
+            size_ += static_cast<std::uint64_t>(done);
+        }
+        return true;
+    }
+
+    void close() {
+#ifdef _WIN32
+        if (owned_ && handle_ != INVALID_HANDLE_VALUE) CloseHandle(handle_);
+        handle_ = INVALID_HANDLE_VALUE;
+#else
+        if (owned_ && fd_ >= 0) ::close(fd_);
+        fd_ = -1;
+#endif
+        owned_ = false;
+    }
+
+    std::uint64_t size() const { return size_; }
+
+private:
+#ifdef _WIN32
+    HANDLE handle_{INVALID_HANDLE_VALUE};
+#else
+    int fd_{-1};
+#endif
+    bool owned_{false};
+    std::uint64_t size_{0};
+};
+
+EveWriter::EveWriter(EveWriterConfig config)
+    : config_(std::move(config)), queue_(config_.queue_size), file_(std::make_unique<EveFile>()) {}
+
+EveWriter::~EveWriter() {
+    stop();
+}
+
+bool EveWriter::start() {
+    if (thread_.joinable()) return true;
+    if (config_.format == EveWriterConfig::Format::Ring) {
+        if (config_.path.empty() || !ring_.open(config_.path, config_.ring_capacity)) return false;
+    } else if (!file_->open(config_.path)) {
+        std::cerr << "Cannot open EVE log: " << config_.path << std::endl;
+        return false;
+    }
+    buffer_.reserve(kBatchBytes + 4096);
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void EveWriter::stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    thread_.join();
+    file_->close();
+}
+
+bool EveWriter::submit(std::uint32_t signature_id, std::string_view signature, const flow::FlowKey& flow,
+                       std::string_view payload, std::chrono::system_clock::time_point ts) {
+    signature = utf8_prefix(signature, EveEvent::kMaxSignature);
+    payload = payload.substr(0, EveEvent::kMaxPayload);
+
+    bool queued = queue_.try_emplace([&](EveEvent& a) {
+        a.kind = EveEvent::Kind::Alert;
+        a.timestamp_us = micros_since_epoch(ts);
+        a.signature_id = signature_id;
+        a.flow = flow;
+        a.signature_length = static_cast<std::uint16_t>(signature.size());
+        a.payload_length = static_cast<std::uint16_t>(payload.size());
+        std::memcpy(a.signature, signature.data(), signature.size());
+        std::memcpy(a.payload, payload.data(), payload.size());
+    });
+    if (!queued) stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+    return queued;
+}
+
+bool EveWriter::submit_flow(const flow::FlowKey& flow, std::uint64_t packets, std::uint64_t bytes,
+                            std::chrono::system_clock::time_point start, std::chrono::system_clock::time_point ts) {
+    bool queued = queue_.try_emplace([&](EveEvent& e) {
+        e.kind = EveEvent::Kind::Flow;
+        e.timestamp_us = micros_since_epoch(ts);
+        e.flow = flow;
+        e.packets = packets;
+        e.bytes = bytes;
+        e.start_us = micros_since_epoch(start);
+        e.signature_length = 0;
+        e.payload_length = 0;
+    });
+    if (!queued) stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+    return queued;
+}
+
+bool EveWriter::submit_tls(const flow::FlowKey& flow, bool client, std::uint16_t version, std::string_view sni,
+                           std::string_view alpn, std::string_view fingerprint_hex,
+                           std::chrono::system_clock::time_point ts) {
+    sni = utf8_prefix(sni, EveEvent::kMaxSignature);
+    alpn = utf8_prefix(alpn, EveEvent::kMaxPayload);
+    fingerprint_hex = fingerprint_hex.substr(0, sizeof(EveEvent::fingerprint));
+
+    bool queued = queue_.try_emplace([&](EveEvent& e) {
+        e.kind = EveEvent::Kind::Tls;
+        e.timestamp_us = micros_since_epoch(ts);
+        e.flow = flow;
+        e.tls_version = version;
+        e.tls_client = client;
+        e.signature_length = static_cast<std::uint16_t>(sni.size());
+        e.payload_length = static_cast<std::uint16_t>(alpn.size());
+        std::memcpy(e.signature, sni.data(), sni.size());
+        std::memcpy(e.payload, alpn.data(), alpn.size());
+        std::memset(e.fingerprint, '0', sizeof(e.fingerprint));
+        std::memcpy(e.fingerprint, fingerprint_hex.data(), fingerprint_hex.size());
+    });
+    if (!queued) stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+    return queued;
+}
+
+void EveWriter::run() {
+    bool ring = config_.format == EveWriterConfig::Format::Ring;
+    for (;;) {
+        // Checked before draining, so events submitted before stop() are written
+        bool stopping = stopping_.load(std::memory_order_acquire);
+        std::uint64_t consumed = 0;
+        std::uint64_t records = 0;
+        while (buffer_.size() < kBatchBytes && queue_.try_consume([&](const EveEvent& e) {
+                   if (ring) {
+                       records += store_record(e);
+                   } else {
+                       serialize(e);
+                       ++records;
+                   }
+               })) {
+            ++consumed;
+        }
+        if (consumed != 0) {
+            stats_.written.store(stats_.written.load(std::memory_order_relaxed) + records, std::memory_order_relaxed);
+            if (!ring) flush();
+            continue;
+        }
+        if (stopping) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+void EveWriter::serialize(const EveEvent& e) {
+    if (config_.path.empty()) buffer_.append(config_.console_prefix);
+    if (e.kind == EveEvent::Kind::Alert) {
+        append_eve_alert(buffer_, e.timestamp_us, e.signature_id, std::string_view(e.signature, e.signature_length),
+                         e.flow, std::string_view(e.payload, e.payload_length));
+    } else if (e.kind == EveEvent::Kind::Tls) {
+        append_eve_tls(buffer_, e.timestamp_us, e.flow, e.tls_client, e.tls_version,
+                       std::string_view(e.signature, e.signature_length), std::string_view(e.payload, e.payload_length),
+                       std::string_view(e.fingerprint, sizeof(e.fingerprint)));
+    } else {
+        append_eve_flow(buffer_, e.timestamp_us, e.flow, e.packets, e.bytes, e.start_us);
+    }
+    buffer_.push_back('\n');
+}
+
+// Fills the ring slot in place; a full ring drops the record
+bool EveWriter::store_record(const EveEvent& e) {
+    RingRecord* r = ring_.claim();
+    if (!r) {
+        stats_.dropped.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+    switch (e.kind) {
+    case EveEvent::Kind::Alert: r->type = static_cast<std::uint16_t>(RingRecordType::Alert); break;
+    case EveEvent::Kind::Flow: r->type = static_cast<std::uint16_t>(RingRecordType::Flow); break;
+    case EveEvent::Kind::Tls: r->type = static_cast<std::uint16_t>(RingRecordType::Tls); break;
+    }
+    r->proto = e.flow.proto;
+    r->timestamp_us = e.timestamp_us;
+    r->src = e.flow.src;
+    r->dst = e.flow.dst;
+    r->sport = e.flow.sport;
+    r->dport = e.flow.dport;
+    r->signature_id = e.signature_id;
+    r->packets = e.packets;
+    r->bytes = e.bytes;
+    r->start_us = e.start_us;
+    // The record's signature field is shorter than the event's; cut it on a
+    // character boundary too
+    std::string_view signature = utf8_prefix(std::string_view(e.signature, e.signature_length), sizeof(r->signature));
+    r->signature_length = static_cast<std::uint16_t>(signature.size());
+    std::memcpy(r->signature, signature.data(), r->signature_length);
+    if (e.kind == EveEvent::Kind::Tls) {
+        // Fingerprint, then as much of the ALPN protocol as fits
+        r->tls_client = e.tls_client ? 1 : 0;
+        r->signature_id = e.tls_version;
+        std::memcpy(r->payload, e.fingerprint, sizeof(e.fingerprint));
+        std::string_view alpn = utf8_prefix(std::string_view(e.payload, e.payload_length),
+                                            sizeof(r->payload) - sizeof(e.fingerprint));
+        std::memcpy(r->payload + sizeof(e.fingerprint), alpn.data(), alpn.size());
+        r->payload_length = static_cast<std::uint16_t>(sizeof(e.fingerprint) + alpn.size());
+    } else {
+        r->payload_length = static_cast<std::uint16_t>(std::min<std::size_t>(e.payload_length, sizeof(r->payload)));
+        std::memcpy(r->payload, e.payload, r->payload_length);
+    }
+    ring_.publish();
+    return true;
+}
+
+void EveWriter::flush() {
+    if (buffer_.empty()) return;
+    if (file_->write(buffer_.data(), buffer_.size())) {
+        stats_.bytes.store(stats_.bytes.load(std::memory_order_relaxed) + buffer_.size(), std::memory_order_relaxed);
+    } else {
+        stats_.write_errors.store(stats_.write_errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    stats_.writes.store(stats_.writes.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    buffer_.clear();
+    if (!config_.path.empty() && config_.rotate_bytes != 0 && file_->size() >= config_.rotate_bytes) rotate();
+}
+
+// path -> path.1 -> ... -> path.N; the oldest is removed
+void EveWriter::rotate() {
+    namespace fs = std::filesystem;
+    file_->close();
+    std::error_code ec;
+    const std::string& base = config_.path;
+    if (config_.rotate_keep == 0) {
+        fs::remove(base, ec);
+    } else {
+        fs::remove(base + "." + std::to_string(config_.rotate_keep), ec);
+        for (unsigned i = config_.rotate_keep; i > 1; --i) {
+            fs::rename(base + "." + std::to_string(i - 1), base + "." + std::to_string(i), ec);
+        }
+        fs::rename(base, base + ".1", ec);
+    }
+    if (!file_->open(base)) {
+        std::cerr << "Cannot reopen EVE log after rotation: " << base << std::endl;
+        stats_.write_errors.store(stats_.write_errors.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        return;
+    }
+    stats_.rotations.store(stats_.rotations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+}
+
+} // namespace output
@@ -0,0 +1,131 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <thread>
+#include "core/dsa/BoundedQueueMPSC.hpp"
+#include "flow/FlowTable.hpp"
+#include "output/EventRing.hpp"
+#include "output/EveJson.hpp"
+
+namespace output {
+
+struct EveWriterConfig {
+    enum class Format { Json, Ring };
+
+    Format format{Format::Json};             // EVE JSON lines, or binary records in an event ring
+    std::string path{};                      // EVE log file (empty writes to stdout) or ring file
+    std::size_t queue_size{8192};            // alerts buffered for the output thread
+    std::uint64_t rotate_bytes{64ull << 20}; // start a new file past this size; 0 = never
+    unsigned rotate_keep{5};                 // rotated files kept: path.1 (newest) .. path.N
+    std::string console_prefix{"[ALERT] "}; // line prefix when writing to stdout
+    std::size_t ring_capacity{65536};        // ring format: records in the ring
+};
+
+// dropped is bumped by producers, the rest by the output thread only
+struct EveWriterStats {
+    std::atomic<std::uint64_t> written{0};      // records written
+    std::atomic<std::uint64_t> dropped{0};      // records lost to a full queue (or full ring)
+    std::atomic<std::uint64_t> bytes{0};
+    std::atomic<std::uint64_t> writes{0};       // write calls (one per batch)
+    std::atomic<std::uint64_t> rotations{0};
+    std::atomic<std::uint64_t> write_errors{0};
+};
+
+// Longest prefix of text of at most max bytes that doesn't split a UTF-8
+// character
+inline std::string_view utf8_prefix(std::string_view text, std::size_t max) {
+    if (text.size() <= max) return text;
+    std::size_t cut = max;
+    while (cut > 0 && (static_cast<unsigned char>(text[cut]) & 0xC0) == 0x80) --cut;
+    return text.substr(0, cut);
+}
+
+// Fixed-size event copied into a queue slot, so submitting never
+// allocates. Long signatures and payload excerpts are truncated. TLS
+// events carry the SNI in signature and the ALPN protocol in payload.
+struct EveEvent {
+    enum class Kind : std::uint8_t { Alert, Flow, Tls };
+
+    static constexpr std::size_t kMaxSignature = 192;
+    static constexpr std::size_t kMaxPayload = 96;
+
+    Kind kind{Kind::Alert};
+    std::int64_t timestamp_us{0};
+    flow::FlowKey flow{};
+    std::uint32_t signature_id{0}; // alerts
+    std::uint64_t packets{0};      // flows
+    std::uint64_t bytes{0};        // flows
+    std::int64_t start_us{0};      // flows
+    std::uint16_t tls_version{0};  // tls
+    bool tls_client{false};        // tls: ClientHello (JA3) or ServerHello (JA3S)
+    char fingerprint[32];          // tls: JA3/JA3S hex
+    std::uint16_t signature_length{0};
+    std::uint16_t payload_length{0};
+    char signature[kMaxSignature];
+    char payload[kMaxPayload];
+};
+
+class EveFile; // platform file handle, EveWriter.cpp
+
+// Asynchronous event writer. Workers submit alerts, flow and TLS records into a
+// bounded queue and never wait for I/O: when the queue is full the event is
+// dropped and counted. One output thread either serializes queued events as
+// EVE JSON into a reused buffer, writing each batch with a single write
+// call and rotating the file by size, or stores them as binary records in
+// an EventRing.
+class EveWriter {
+public:
+    explicit EveWriter(EveWriterConfig config);
+    ~EveWriter();
+
+    EveWriter(const EveWriter&) = delete;
+    EveWriter& operator=(const EveWriter&) = delete;
+
+    // Opens the log (or maps the ring) and starts the output thread
+    bool start();
+
+    // Drains the queue, writes what is left and joins the output thread
+    void stop();
+
+    // Thread-safe; returns false if the alert was dropped
+    bool submit(std::uint32_t signature_id, std::string_view signature, const flow::FlowKey& flow,
+                std::string_view payload,
+                std::chrono::system_clock::time_point ts = std::chrono::system_clock::now());
+
+    // Thread-safe; a finished flow direction, end time ts
+    bool submit_flow(const flow::FlowKey& flow, std::uint64_t packets, std::uint64_t bytes,
+                     std::chrono::system_clock::time_point start,
+                     std::chrono::system_clock::time_point ts = std::chrono::system_clock::now());
+
+    // Thread-safe; a parsed TLS hello, fingerprint_hex being its 32-digit JA3 (client) or JA3S
+    bool submit_tls(const flow::FlowKey& flow, bool client, std::uint16_t version, std::string_view sni,
+                    std::string_view alpn, std::string_view fingerprint_hex,
+                    std::chrono::system_clock::time_point ts = std::chrono::system_clock::now());
+
+    const EveWriterStats& stats() const { return stats_; }
+    const std::string& path() const { return config_.path; }
+
+private:
+    static constexpr std::size_t kBatchBytes = 256 * 1024;
+
+    void run();
+    void serialize(const EveEvent& event);
+    bool store_record(const EveEvent& event);
+    void flush();
+    void rotate();
+
+    EveWriterConfig config_;
+    core::dsa::BoundedQueueMPSC<EveEvent> queue_;
+    std::unique_ptr<EveFile> file_;
+    EventRingWriter ring_;
+    std::string buffer_; // serialized batch, reused
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+    EveWriterStats stats_;
+};
+
+} // namespace output
@@ -0,0 +1,197 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include "core/MappedFile.hpp"
+
+namespace output {
+
+// Binary event ring: fixed-layout alert, flow and TLS records in a memory-mapped
+// file shared with local consumers (SIEM shippers), which read records in
+// place instead of re-parsing EVE JSON.
+//
+// File layout: a 256-byte header, then `capacity` records of 256 bytes.
+// The IDS is the single producer and a single consumer process reads.
+// Indices are free-running 64-bit record counts; record i lives in slot
+// i & (capacity - 1). The producer never overwrites unread records: when
+// the ring is full the record is dropped and counted in the header.
+
+enum class RingRecordType : std::uint16_t { Alert = 1, Flow = 2, Tls = 3 };
+
+struct RingRecord {
+    std::uint16_t type;           // RingRecordType
+    std::uint16_t layout_version; // kRecordVersion of the writer
+    std::uint8_t proto;
+    std::uint8_t tls_client;      // tls: 1 for a ClientHello (JA3), 0 for a ServerHello (JA3S)
+    std::uint8_t reserved0[2];
+    std::int64_t timestamp_us;    // event time, UTC microseconds since the epoch
+    std::uint32_t src;            // IPv4, host byte order
+    std::uint32_t dst;
+    std::uint16_t sport;
+    std::uint16_t dport;
+    std::uint32_t signature_id;   // alerts; tls: hello version
+    std::uint64_t packets;        // flows
+    std::uint64_t bytes;          // flows
+    std::int64_t start_us;        // flows: first packet
+    std::uint16_t signature_length;
+    std::uint16_t payload_length;
+    std::uint32_t reserved1;
+    char signature[128];          // alerts, UTF-8 cut on a character boundary, not NUL terminated; tls: SNI
+    char payload[64];             // alerts: payload excerpt around the match; tls: JA3 hex (32) then ALPN
+};
+static_assert(sizeof(RingRecord) == 256, "ring record layout is part of the file format");
+
+struct RingHeader {
+    char magic[8];
+    std::uint32_t version;        // file format version
+    std::uint32_t byte_order;
+    std::uint32_t record_size;
+    std::uint32_t record_version; // RingRecord layout version
+    std::uint64_t capacity;       // records, power of two
+    std::uint64_t records_offset;
+    std::uint64_t file_size;
+    alignas(64) std::uint64_t write_index; // records published (producer)
+    std::uint64_t dropped;                 // records lost to a full ring (producer)
+    alignas(64) std::uint64_t read_index;  // records consumed (consumer)
+};
+
+constexpr char kRingMagic[8] = {'I', 'D', 'S', 'R', 'I', 'N', 'G', '\0'};
+constexpr std::uint32_t kRingFormatVersion = 1;
+constexpr std::uint32_t kRingRecordVersion = 2;
+constexpr std::uint32_t kRingByteOrder = 0x01020304;
+constexpr std::uint64_t kRingRecordsOffset = 256;
+static_assert(sizeof(RingHeader) <= kRingRecordsOffset, "header must fit before the records");
+
+namespace ring_detail {
+
+// Indices are shared with another process through the mapping, so they are
+// accessed with (address-free, lock-free) atomic_ref operations
+inline std::uint64_t load(std::uint64_t& v) {
+    return std::atomic_ref<std::uint64_t>(v).load(std::memory_order_acquire);
+}
+inline void store(std::uint64_t& v, std::uint64_t value) {
+    std::atomic_ref<std::uint64_t>(v).store(value, std::memory_order_release);
+}
+static_assert(std::atomic_ref<std::uint64_t>::is_always_lock_free, "ring indices need lock-free 64-bit atomics");
+
+inline bool valid_header(const RingHeader& h, std::size_t file_size) {
+    return std::memcmp(h.magic, kRingMagic, sizeof(h.magic)) == 0 && h.version == kRingFormatVersion &&
+           h.byte_order == kRingByteOrder && h.record_size == sizeof(RingRecord) &&
+           h.record_version == kRingRecordVersion && h.capacity != 0 && (h.capacity & (h.capacity - 1)) == 0 &&
+           h.records_offset == kRingRecordsOffset && h.file_size == file_size &&
+           h.capacity <= (file_size - kRingRecordsOffset) / sizeof(RingRecord);
+}
+
+} // namespace ring_detail
+
+class EventRingWriter {
+public:
+    // Maps the ring file, creating or re-initializing it unless it is a
+    // valid ring with the same capacity (then publishing resumes where the
+    // previous producer stopped). capacity is rounded up to a power of two.
+    bool open(const std::string& path, std::size_t capacity) {
+        std::uint64_t records = 2;
+        while (records < capacity) records <<= 1;
+        std::size_t size = static_cast<std::size_t>(kRingRecordsOffset + records * sizeof(RingRecord));
+        if (!file_.open_writable(path, size)) {
+            std::cerr << "Cannot map event ring: " << path << std::endl;
+            return false;
+        }
+        header_ = reinterpret_cast<RingHeader*>(file_.writable_data());
+        records_ = reinterpret_cast<RingRecord*>(file_.writable_data() + kRingRecordsOffset);
+
+        if (!ring_detail::valid_header(*header_, file_.size()) || header_->capacity != records) {
+            // Fields first, magic last, so a consumer never sees a half-written header as valid
+            std::memset(header_->magic, 0, sizeof(header_->magic));
+            header_->version = kRingFormatVersion;
+            header_->byte_order = kRingByteOrder;
+            header_->record_size = sizeof(RingRecord);
+            header_->record_version = kRingRecordVersion;
+            header_->capacity = records;
+            header_->records_offset = kRingRecordsOffset;
+            header_->file_size = file_.size();
+            ring_detail::store(header_->dropped, 0);
+            ring_detail::store(header_->read_index, 0);
+            ring_detail::store(header_->write_index, 0);
+            std::atomic_thread_fence(std::memory_order_release);
+            std::memcpy(header_->magic, kRingMagic, sizeof(kRingMagic));
+        }
+        mask_ = records - 1;
+        write_index_ = ring_detail::load(header_->write_index);
+        return true;
+    }
+
+    bool is_open() const { return header_ != nullptr; }
+
+    // Slot for the next record, or nullptr (counted as dropped) if the
+    // consumer is a full ring behind. Fill it, then publish().
+    RingRecord* claim() {
+        if (write_index_ - ring_detail::load(header_->read_index) > mask_) {
+            ring_detail::store(header_->dropped, header_->dropped + 1);
+            return nullptr;
+        }
+        RingRecord* record = &records_[write_index_ & mask_];
+        std::memset(record, 0, sizeof(*record));
+        record->layout_version = kRingRecordVersion;
+        return record;
+    }
+
+    void publish() { ring_detail::store(header_->write_index, ++write_index_); }
+
+    std::uint64_t dropped() const { return ring_detail::load(header_->dropped); }
+
+private:
+    core::MappedFile file_;
+    RingHeader* header_{nullptr};
+    RingRecord* records_{nullptr};
+    std::uint64_t mask_{0};
+    std::uint64_t write_index_{0};
+};
+
+// Consumer side. Records are read in place (zero copy) and released once
+// processed, which lets the producer reuse their slots.
+class EventRingReader {
+public:
+    bool open(const std::string& path) {
+        if (!file_.open_writable(path) || file_.size() < kRingRecordsOffset) return false;
+        header_ = reinterpret_cast<RingHeader*>(file_.writable_data());
+        if (!ring_detail::valid_header(*header_, file_.size())) {
+            header_ = nullptr;
+            return false;
+        }
+        records_ = reinterpret_cast<const RingRecord*>(file_.data() + kRingRecordsOffset);
+        mask_ = header_->capacity - 1;
+        return true;
+    }
+
+    // Next unread record, or nullptr if the consumer has caught up
+    const RingRecord* peek() const {
+        std::uint64_t read = ring_detail::load(header_->read_index);
+        if (read == ring_detail::load(header_->write_index)) return nullptr;
+        return &records_[read & mask_];
+    }
+
+    void release() { ring_detail::store(header_->read_index, ring_detail::load(header_->read_index) + 1); }
+
+    // Unconsumed records, for reading without releasing: record(i) is stable
+    // for read_index() <= i < write_index() until released
+    std::uint64_t read_index() const { return ring_detail::load(header_->read_index); }
+    std::uint64_t write_index() const { return ring_detail::load(header_->write_index); }
+    const RingRecord& record(std::uint64_t index) const { return records_[index & mask_]; }
+
+    std::uint64_t pending() const {
+        return ring_detail::load(header_->write_index) - ring_detail::load(header_->read_index);
+    }
+    std::uint64_t dropped() const { return ring_detail::load(header_->dropped); }
+    std::uint64_t capacity() const { return header_->capacity; }
+
+private:
+    core::MappedFile file_;
+    RingHeader* header_{nullptr};
+    const RingRecord* records_{nullptr};
+    std::uint64_t mask_{0};
+};
+
+} // namespace output
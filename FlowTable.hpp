@@ -1,9 +1,17 @@
 #pragma once
+#include <algorithm>
 #include <cstdint>
 #include <chrono>
 #include <functional>
 #include <string>
-#include "core/dsa/LRUCache.hpp"
+#include <vector>
+#include "core/Arena.hpp"
+#include "core/Entropy.hpp"
+#include "core/Packet.hpp"
+#include "core/dsa/SwissTable.hpp"
+#include "decode/IPv4.hpp"
+#include "decode/TCP.hpp"
+#include "decode/TLS.hpp"
 
 namespace flow {
 
@@ -17,6 +25,9 @@ struct FlowKey {
     bool operator==(const FlowKey& o) const {
         return src==o.src && dst==o.dst && sport==o.sport && dport==o.dport && proto==o.proto;
     }
+
+    // Key of the opposite direction of the same connection
+    FlowKey reversed() const { return FlowKey{dst, src, dport, sport, proto}; }
 };
 
 struct FlowKeyHash {
@@ -28,26 +39,296 @@ struct FlowKeyHash {
     }
 };
 
+// An IPv4 packet decoded down to its flow key, shared by the worker and the
+// inline IPS decision path
+struct DecodedFlow {
+    FlowKey key{};
+    core::ByteSpan l4{};
+    core::ByteSpan payload{};  // TCP/UDP payload, or the whole L4 data for other protocols
+    std::uint8_t tcp_flags{0};
+    std::uint32_t tcp_seq{0};
+
+    static constexpr std::uint8_t kFin = 0x01;
+    static constexpr std::uint8_t kRst = 0x04;
+
+    bool tcp_closing() const { return key.proto == 6 && (tcp_flags & (kFin | kRst)); }
+};
+
+enum class DecodeError : std::uint8_t { None, Ipv4, Tcp, Udp };
+
+// l3 starts at the IP header. Returns false for non-IPv4 or truncated
+// TCP/UDP, with the failing layer in *error when given.
+inline bool decode_flow(core::ByteSpan l3, DecodedFlow& out, DecodeError* error = nullptr) {
+    auto fail = [&](DecodeError e) {
+        if (error) *error = e;
+        return false;
+    };
+    decode::IPv4Header ip{};
+    if (!decode::parse_ipv4(l3, ip, out.l4)) return fail(DecodeError::Ipv4);
+    out.key = FlowKey{ip.src, ip.dst, 0, 0, ip.protocol};
+    out.tcp_flags = 0;
+    if (ip.protocol == 6) {
+        decode::TCPHeader tcp{};
+        if (!decode::parse_tcp(out.l4, tcp, out.payload)) return fail(DecodeError::Tcp);
+        out.key.sport = tcp.srcPort;
+        out.key.dport = tcp.dstPort;
+        out.tcp_flags = tcp.flags;
+        out.tcp_seq = tcp.seq;
+    } else if (ip.protocol == 17) {
+        if (out.l4.size() < 8) return fail(DecodeError::Udp);
+        out.key.sport = static_cast<std::uint16_t>((out.l4[0] << 8) | out.l4[1]);
+        out.key.dport = static_cast<std::uint16_t>((out.l4[2] << 8) | out.l4[3]);
+        out.payload = out.l4.subspan(8);
+    } else {
+        out.payload = out.l4;
+    }
+    return true;
+}
+
+enum class Bypass : std::uint8_t { None, StreamDepth, Encrypted, HighEntropy };
+
 struct FlowEntry {
     std::chrono::steady_clock::time_point lastSeen{};
+    std::chrono::system_clock::time_point firstSeen{}; // wall clock, for flow records
     std::uint64_t packets{0};
     std::uint64_t bytes{0};
+    std::uint64_t inspected_bytes{0}; // payload bytes handed to detection
+    bool blocked{false};              // endpoint on the IP block list; detection is skipped
+    bool flow_logged{false};          // flow record emitted (FIN/RST seen)
+    bool tls_handshake{false};        // a TLS ClientHello or ServerHello was parsed in this direction
+    bool tls_server_hello{false};     // ...and it was a ServerHello
+    bool tls_hello_done{false};       // TLS hello parsed, or the flow turned out not to start with one
+    bool entropy_checked{false};      // first payload sampled for entropy
+    bool high_entropy{false};         // looks compressed/encrypted: inspection limited to entropy_window
+    Bypass bypass{Bypass::None};      // detection skipped for the rest of the flow
+};
+
+struct InspectionPolicy {
+    std::uint64_t stream_depth{0}; // payload bytes inspected per flow, 0 = unlimited
+    bool tls_bypass{true};         // stop inspecting once TLS application data starts
+    double entropy_threshold{0.0}; // bits per byte marking a flow high-entropy, 0 = off
+    std::uint64_t entropy_window{0}; // payload bytes inspected in a high-entropy flow (0 = none)
+
+    // Smallest payload worth sampling; below this the estimate is too biased
+    // for the usual 7-8 bits/byte thresholds
+    static constexpr std::size_t kEntropyMinSample = 512;
+    static constexpr std::size_t kEntropySample = 1024;
 };
 
+// True once a real TLS handshake has been parsed on the connection: a
+// ClientHello one way and a ServerHello the other. Record headers alone
+// are five bytes anyone can send on any port.
+inline bool tls_hellos_parsed(const FlowEntry& e, const FlowEntry* reverse) {
+    return e.tls_handshake && reverse && reverse->tls_handshake && reverse->tls_server_hello != e.tls_server_hello;
+}
+
+// Trims payload to what detection should still scan under the flow's
+// inspection budget (empty once the flow is bypassed). Returns true when
+// this packet moved the flow into bypass. reverse is the entry of the
+// opposite direction, if tracked; TLS bypass needs both directions' hellos.
+inline bool apply_inspection_budget(FlowEntry& e, const FlowKey& key, core::ByteSpan& payload,
+                                    const InspectionPolicy& policy, const FlowEntry* reverse = nullptr) {
+    if (e.bypass != Bypass::None) {
+        payload = {};
+        return false;
+    }
+    Bypass reason = Bypass::None;
+    if (policy.tls_bypass && key.proto == 6 && tls_hellos_parsed(e, reverse) &&
+        decode::tls_record_type(payload) == decode::TlsContentType::ApplicationData) {
+        reason = Bypass::Encrypted;
+        payload = {};
+    }
+    // The first large enough payload of a non-TLS flow direction decides
+    // whether it gets the (small) high-entropy window
+    if (policy.entropy_threshold > 0.0 && !e.entropy_checked && !e.tls_handshake &&
+        payload.size() >= InspectionPolicy::kEntropyMinSample) {
+        e.entropy_checked = true;
+        e.high_entropy = core::entropy_at_least(payload.data(), std::min(payload.size(), InspectionPolicy::kEntropySample),
+                                                policy.entropy_threshold);
+    }
+    bool limited = policy.stream_depth != 0;
+    std::uint64_t depth = policy.stream_depth;
+    if (e.high_entropy && (!limited || policy.entropy_window < depth)) {
+        limited = true;
+        depth = policy.entropy_window;
+    }
+    if (reason == Bypass::None && limited) {
+        std::uint64_t remaining = depth > e.inspected_bytes ? depth - e.inspected_bytes : 0;
+        if (payload.size() >= remaining) {
+            payload = payload.first(static_cast<std::size_t>(remaining));
+            reason = e.high_entropy ? Bypass::HighEntropy : Bypass::StreamDepth;
+        }
+    }
+    e.inspected_bytes += payload.size();
+    e.bypass = reason;
+    return reason != Bypass::None;
+}
+
+// Per-worker flow state with least-recently-used eviction once capacity
+// flows are tracked.
+//
+// Entries live in a slab of cache-line nodes {key, entry} allocated up to
+// capacity and then reused, found through a SwissTable index of slab
+// positions; recency is a doubly linked list of slab positions kept beside
+// the slab. Nodes never move, so an entry stays put until its flow is
+// evicted.
+//
+// touch() resolves one packet at a time, and each lookup in a table much
+// larger than the cache waits out a miss in the index and another in the
+// slab. lookup_batch() takes a burst of keys instead: it hashes them all
+// and prefetches their index windows, then finds their slab nodes and
+// prefetches those, and only then resolves each key in order, so the
+// misses of the burst overlap.
 class FlowTable {
 public:
-    explicit FlowTable(std::size_t capacity)
-        : cache_(capacity) {}
+    // With an arena, the slab, recency links and index come from it (e.g.
+    // huge pages; see arena_bytes), and from the heap once it is full
+    explicit FlowTable(std::size_t capacity, core::Arena* arena = nullptr)
+        : capacity_(std::clamp<std::size_t>(capacity, 1, kNil)), nodes_(core::ArenaAllocator<Node>(arena)),
+          links_(core::ArenaAllocator<Link>(arena)), index_(capacity_, core::ArenaAllocator<FlowKey>(arena)) {
+        nodes_.reserve(capacity_);
+        links_.reserve(capacity_);
+    }
+
+    FlowTable(const FlowTable&) = delete;
+    FlowTable& operator=(const FlowTable&) = delete;
+
+    // Arena size holding a table of capacity flows: the slab, the recency
+    // links and the index slots and control bytes, each one block
+    static std::size_t arena_bytes(std::size_t capacity) {
+        auto block = [](std::size_t bytes) { return core::Arena::block_size(core::Arena::size_class(bytes)); };
+        std::size_t slots = Index::capacity_for(capacity);
+        return block(capacity * sizeof(Node)) + block(capacity * sizeof(Link)) +
+               block(slots * sizeof(Index::Slot)) + block(slots + 16) + (std::size_t{1} << 20);
+    }
 
     FlowEntry& touch(const FlowKey& k, std::chrono::steady_clock::time_point now) {
-        auto& e = cache_.get_or_create(k, [](){ return FlowEntry{}; });
-        e.lastSeen = now;
-        ++e.packets;
+        FlowEntry& e = resolve(k, index_.hash(k), kNil);
+        touch_entry(e, now);
         return e;
     }
 
+    // Counts a packet on an entry from lookup_batch()
+    static void touch_entry(FlowEntry& e, std::chrono::steady_clock::time_point now) {
+        e.lastSeen = now;
+        if (++e.packets == 1) e.firstSeen = std::chrono::system_clock::now();
+    }
+
+    // out[i] = entry of keys[i], created (with packets == 0) when new. The
+    // recency order and evictions are those of looking the keys up one by
+    // one; packets are counted by touch_entry() as each is processed. An
+    // entry stays valid until capacity() newer flows have been looked up,
+    // so n should not exceed capacity().
+    void lookup_batch(const FlowKey* keys, std::size_t n, FlowEntry** out) {
+        std::uint64_t hashes[kBurst];
+        std::uint32_t hints[kBurst];
+        for (std::size_t base = 0; base < n; base += kBurst) {
+            std::size_t count = std::min(kBurst, n - base);
+            const FlowKey* burst = keys + base;
+            for (std::size_t i = 0; i < count; ++i) {
+                hashes[i] = index_.hash(burst[i]);
+                index_.prefetch(hashes[i]);
+            }
+            for (std::size_t i = 0; i < count; ++i) {
+                const std::uint32_t* at = index_.find(burst[i], hashes[i]);
+                hints[i] = at ? *at : kNil;
+                if (at) {
+                    IDS_SWISS_PREFETCH(&nodes_[*at]);
+                    IDS_SWISS_PREFETCH(&links_[*at]);
+                }
+            }
+            for (std::size_t i = 0; i < count; ++i) out[base + i] = &resolve(burst[i], hashes[i], hints[i]);
+        }
+    }
+
+    // Entry of k if tracked, without counting a packet or changing recency
+    const FlowEntry* find(const FlowKey& k) const {
+        const std::uint32_t* at = index_.find(k);
+        return at ? &nodes_[*at].entry : nullptr;
+    }
+
+    std::size_t size() const { return nodes_.size(); }
+    std::size_t capacity() const { return capacity_; }
+
 private:
-    core::dsa::LRUCache<FlowKey, FlowEntry, FlowKeyHash> cache_;
+    static constexpr std::uint32_t kNil = ~std::uint32_t{0};
+    static constexpr std::size_t kBurst = 32;
+
+    struct alignas(64) Node {
+        FlowKey key;
+        FlowEntry entry;
+    };
+
+    struct Link {
+        std::uint32_t prev{kNil}; // more recent
+        std::uint32_t next{kNil}; // less recent
+    };
+
+    using Index = core::dsa::SwissTable<FlowKey, std::uint32_t, FlowKeyHash, std::equal_to<FlowKey>,
+                                        core::ArenaAllocator<FlowKey>>;
+
+    // Entry of key, most recent from now on. hint is the key's slab position
+    // found before earlier keys of the batch were resolved; it is only
+    // trusted if the node still holds the key.
+    FlowEntry& resolve(const FlowKey& key, std::uint64_t hash, std::uint32_t hint) {
+        std::uint32_t id = hint;
+        if (id == kNil || !(nodes_[id].key == key)) {
+            const std::uint32_t* at = index_.find(key, hash);
+            id = at ? *at : kNil;
+        }
+        if (id != kNil) {
+            if (id != head_) {
+                unlink(id);
+                push_front(id);
+            }
+            return nodes_[id].entry;
+        }
+
+        if (nodes_.size() < capacity_) {
+            id = static_cast<std::uint32_t>(nodes_.size());
+            nodes_.push_back(Node{key, FlowEntry{}});
+            links_.emplace_back();
+        } else {
+            id = tail_;
+            unlink(id);
+            index_.erase(nodes_[id].key);
+            nodes_[id] = Node{key, FlowEntry{}};
+        }
+        index_.try_emplace_hashed(key, hash, id);
+        push_front(id);
+        return nodes_[id].entry;
+    }
+
+    void unlink(std::uint32_t id) {
+        Link& l = links_[id];
+        if (l.prev != kNil) {
+            links_[l.prev].next = l.next;
+        } else {
+            head_ = l.next;
+        }
+        if (l.next != kNil) {
+            links_[l.next].prev = l.prev;
+        } else {
+            tail_ = l.prev;
+        }
+    }
+
+    void push_front(std::uint32_t id) {
+        links_[id] = Link{kNil, head_};
+        if (head_ != kNil) {
+            links_[head_].prev = id;
+        } else {
+            tail_ = id;
+        }
+        head_ = id;
+    }
+
+    std::size_t capacity_;
+    std::vector<Node, core::ArenaAllocator<Node>> nodes_;
+    std::vector<Link, core::ArenaAllocator<Link>> links_;
+    Index index_;
+    std::uint32_t head_{kNil}; // most recently used
+    std::uint32_t tail_{kNil};
 };
 
 } // namespace flow
@@ -1,4 +1,5 @@
 #pragma once
+#include <memory_resource>
 #include <string>
 #include <unordered_map>
 #include <string_view>
@@ -6,20 +7,28 @@
 
 namespace decode {
 
+// Fields are allocated from one memory resource (e.g. a worker's
+// core::ScratchArena), the default heap resource unless given
 struct HTTPRequest {
-    std::string method{};
-    std::string uri{};
-    std::string version{};
-    std::unordered_map<std::string, std::string> headers{};
-    std::string body{};
+    explicit HTTPRequest(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : method(memory), uri(memory), version(memory), headers(memory), body(memory) {}
+
+    std::pmr::string method;
+    std::pmr::string uri;
+    std::pmr::string version;
+    std::pmr::unordered_map<std::pmr::string, std::pmr::string> headers;
+    std::pmr::string body;
 };
 
 struct HTTPResponse {
-    std::string version{};
+    explicit HTTPResponse(std::pmr::memory_resource* memory = std::pmr::get_default_resource())
+        : version(memory), reason(memory), headers(memory), body(memory) {}
+
+    std::pmr::string version;
     int status_code{0};
-    std::string reason{};
-    std::unordered_map<std::string, std::string> headers{};
-    std::string body{};
+    std::pmr::string reason;
+    std::pmr::unordered_map<std::pmr::string, std::pmr::string> headers;
+    std::pmr::string body;
 };
 
 inline bool parse_http_request(core::ByteSpan data, HTTPRequest& req) {
@@ -62,14 +71,14 @@ inline bool parse_http_request(core::ByteSpan data, HTTPRequest& req) {
         auto colon_pos = header_line.find(':');
         
         if (colon_pos != std::string_view::npos) {
-            std::string key(header_line.substr(0, colon_pos));
-            std::string value(header_line.substr(colon_pos + 1));
+            std::string_view value = header_line.substr(colon_pos + 1);
             
             // Trim whitespace
-            while (!value.empty() && value[0] == ' ') value.erase(0, 1);
-            while (!value.empty() && value.back() == ' ') value.pop_back();
+            while (!value.empty() && value.front() == ' ') value.remove_prefix(1);
+            while (!value.empty() && value.back() == ' ') value.remove_suffix(1);
             
-            req.headers[key] = value;
+            std::pmr::string key(header_line.substr(0, colon_pos), req.headers.get_allocator());
+            req.headers.insert_or_assign(std::move(key), value);
         }
         
         pos = line_end + 2;
@@ -91,4 +100,31 @@ inline bool is_http_traffic(core::ByteSpan payload) {
            text.starts_with("HTTP/");
 }
 
+// Host header of a request without building an HTTPRequest: scans the
+// header lines in place and returns the host with any ":port" removed.
+// Empty if payload doesn't start with a request line or has no Host.
+inline std::string_view find_http_host(core::ByteSpan payload) {
+    if (!is_http_traffic(payload)) return {};
+    std::string_view text(reinterpret_cast<const char*>(payload.data()), payload.size());
+
+    auto pos = text.find("\r\n");
+    while (pos != std::string_view::npos) {
+        pos += 2;
+        auto line_end = text.find("\r\n", pos);
+        std::string_view line = text.substr(pos, line_end == std::string_view::npos ? text.size() - pos : line_end - pos);
+        if (line.empty()) break; // end of headers
+
+        if (line.size() > 5 && (line[0] | 0x20) == 'h' && (line[1] | 0x20) == 'o' && (line[2] | 0x20) == 's' &&
+            (line[3] | 0x20) == 't' && line[4] == ':') {
+            std::string_view host = line.substr(5);
+            while (!host.empty() && (host.front() == ' ' || host.front() == '\t')) host.remove_prefix(1);
+            while (!host.empty() && (host.back() == ' ' || host.back() == '\t')) host.remove_suffix(1);
+            if (!host.empty() && host.front() != '[') host = host.substr(0, host.find(':'));
+            return host;
+        }
+        pos = line_end;
+    }
+    return {};
+}
+
 } // namespace decode
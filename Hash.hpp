@@ -0,0 +1,107 @@
+#pragma once
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace core {
+
+// Fast non-cryptographic 64-bit hashing (wyhash-style multiply-fold).
+// Reads 16 bytes per step, so short keys such as IPs and domains hash in a
+// handful of instructions. Not stable across versions; don't persist raw
+// hashes without versioning the format that stores them.
+
+namespace hash_detail {
+
+constexpr std::uint64_t kSecret0 = 0xa0761d6478bd642full;
+constexpr std::uint64_t kSecret1 = 0xe7037ed1a0b428dbull;
+constexpr std::uint64_t kSecret2 = 0x8ebc6af09c88c6e3ull;
+constexpr std::uint64_t kSecret3 = 0x589965cc75374cc3ull;
+
+// 64x64 -> 128 multiply, folded to 64 bits
+inline std::uint64_t mum(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    __uint128_t r = static_cast<__uint128_t>(a) * b;
+    return static_cast<std::uint64_t>(r) ^ static_cast<std::uint64_t>(r >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    std::uint64_t hi;
+    std::uint64_t lo = _umul128(a, b, &hi);
+    return lo ^ hi;
+#else
+    std::uint64_t ha = a >> 32, la = a & 0xFFFFFFFFull, hb = b >> 32, lb = b & 0xFFFFFFFFull;
+    std::uint64_t rh = ha * hb, rm0 = ha * lb, rm1 = hb * la, rl = la * lb;
+    std::uint64_t t = rl + (rm0 << 32);
+    std::uint64_t carry = t < rl;
+    std::uint64_t lo = t + (rm1 << 32);
+    carry += lo < t;
+    std::uint64_t hi = rh + (rm0 >> 32) + (rm1 >> 32) + carry;
+    return lo ^ hi;
+#endif
+}
+
+// mum() with both inputs folded back in. A factor of zero (an input equal
+// to the secret it is xored with) makes the product zero; plain mum() would
+// then drop the running state, so any 16-byte block starting with kSecret1
+// gave the same hash whatever came before it and whatever the seed.
+inline std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+    return mum(a, b) ^ a ^ b;
+}
+
+inline std::uint64_t read64(const std::uint8_t* p) {
+    std::uint64_t v;
+    std::memcpy(&v, p, 8);
+    return v;
+}
+
+inline std::uint64_t read32(const std::uint8_t* p) {
+    std::uint32_t v;
+    std::memcpy(&v, p, 4);
+    return v;
+}
+
+} // namespace hash_detail
+
+inline std::uint64_t hash64(const void* data, std::size_t len, std::uint64_t seed = 0) {
+    using namespace hash_detail;
+    const auto* p = static_cast<const std::uint8_t*>(data);
+    std::uint64_t h = seed ^ kSecret0;
+    std::size_t n = len;
+    while (n > 16) {
+        h = mix(read64(p) ^ kSecret1, read64(p + 8) ^ h);
+        p += 16;
+        n -= 16;
+    }
+    std::uint64_t a = 0, b = 0;
+    if (n >= 8) {
+        a = read64(p);
+        b = read64(p + n - 8);
+    } else if (n >= 4) {
+        a = read32(p);
+        b = read32(p + n - 4);
+    } else if (n > 0) {
+        a = (static_cast<std::uint64_t>(p[0]) << 16) | (static_cast<std::uint64_t>(p[n >> 1]) << 8) | p[n - 1];
+    }
+    return mix(mix(a ^ kSecret1, b ^ h) ^ kSecret2, len ^ kSecret3);
+}
+
+inline std::uint64_t hash64(std::string_view s, std::uint64_t seed = 0) {
+    return hash64(s.data(), s.size(), seed);
+}
+
+// Integer keys (IPv4 addresses, ids)
+inline std::uint64_t hash64(std::uint64_t v, std::uint64_t seed = 0) {
+    using namespace hash_detail;
+    return mix(mix(v ^ kSecret1, seed ^ kSecret0) ^ kSecret2, 8 ^ kSecret3);
+}
+
+// Transparent string hasher: tables keyed by std::string can be probed with
+// a string_view or literal without building a temporary string
+struct StringHash {
+    using is_transparent = void;
+    std::size_t operator()(std::string_view s) const { return static_cast<std::size_t>(hash64(s)); }
+};
+
+} // namespace core
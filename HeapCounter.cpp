@@ -0,0 +1,102 @@
+#include "core/HeapCounter.hpp"
+#include <cstddef>
+#include <cstdlib>
+#include <new>
+
+#if IDS_COUNT_HEAP_ALLOCATIONS
+
+namespace {
+
+thread_local std::uint64_t t_allocations = 0;
+
+// operator new semantics: retry through the new handler, throw when there is none
+void* allocate(std::size_t size, std::size_t align) {
+    ++t_allocations;
+    if (size == 0) size = 1;
+    for (;;) {
+        void* p = nullptr;
+        if (align <= alignof(std::max_align_t)) {
+            p = std::malloc(size);
+        } else {
+#ifdef _WIN32
+            p = _aligned_malloc(size, align);
+#else
+            if (posix_memalign(&p, align, size) != 0) p = nullptr;
+#endif
+        }
+        if (p) return p;
+        std::new_handler handler = std::get_new_handler();
+        if (!handler) throw std::bad_alloc();
+        handler();
+    }
+}
+
+void* allocate_nothrow(std::size_t size, std::size_t align) noexcept {
+    try {
+        return allocate(size, align);
+    } catch (...) {
+        return nullptr;
+    }
+}
+
+void release(void* p, std::size_t align) noexcept {
+#ifdef _WIN32
+    if (align > alignof(std::max_align_t)) {
+        _aligned_free(p);
+        return;
+    }
+#else
+    (void)align;
+#endif
+    std::free(p);
+}
+
+constexpr std::size_t kDefault = alignof(std::max_align_t);
+
+} // namespace
+
+void* operator new(std::size_t size) { return allocate(size, kDefault); }
+void* operator new[](std::size_t size) { return allocate(size, kDefault); }
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, kDefault); }
+void* operator new[](std::size_t size, const std::nothrow_t&) noexcept { return allocate_nothrow(size, kDefault); }
+void* operator new(std::size_t size, std::align_val_t align) { return allocate(size, static_cast<std::size_t>(align)); }
+void* operator new[](std::size_t size, std::align_val_t align) { return allocate(size, static_cast<std::size_t>(align)); }
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<std::size_t>(align));
+}
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    return allocate_nothrow(size, static_cast<std::size_t>(align));
+}
+
+void operator delete(void* p) noexcept { release(p, kDefault); }
+void operator delete[](void* p) noexcept { release(p, kDefault); }
+void operator delete(void* p, std::size_t) noexcept { release(p, kDefault); }
+void operator delete[](void* p, std::size_t) noexcept { release(p, kDefault); }
+void operator delete(void* p, const std::nothrow_t&) noexcept { release(p, kDefault); }
+void operator delete[](void* p, const std::nothrow_t&) noexcept { release(p, kDefault); }
+void operator delete(void* p, std::align_val_t align) noexcept { release(p, static_cast<std::size_t>(align)); }
+void operator delete[](void* p, std::align_val_t align) noexcept { release(p, static_cast<std::size_t>(align)); }
+void operator delete(void* p, std::size_t, std::align_val_t align) noexcept {
+    release(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::size_t, std::align_val_t align) noexcept {
+    release(p, static_cast<std::size_t>(align));
+}
+void operator delete(void* p, std::align_val_t align, const std::nothrow_t&) noexcept {
+    release(p, static_cast<std::size_t>(align));
+}
+void operator delete[](void* p, std::align_val_t align, const std::nothrow_t&) noexcept {
+    release(p, static_cast<std::size_t>(align));
+}
+
+namespace core {
+std::uint64_t heap_allocations() { return t_allocations; }
+} // namespace core
+
+#else
+
+namespace core {
+std::uint64_t heap_allocations() { return 0; }
+} // namespace core
+
+#endif
@@ -0,0 +1,21 @@
+#pragma once
+#include <cstdint>
+
+// Global operator new/delete are replaced (HeapCounter.cpp) to count heap
+// allocations per thread, so the packet path can show it allocates nothing
+// at steady state. The replacement forwards to malloc/free; build with
+// IDS_COUNT_HEAP_ALLOCATIONS=0 to keep the runtime's own operators (e.g.
+// when linking another allocator).
+#ifndef IDS_COUNT_HEAP_ALLOCATIONS
+#define IDS_COUNT_HEAP_ALLOCATIONS 1
+#endif
+
+namespace core {
+
+// Calls of operator new (any form) made by the calling thread so far; 0
+// when counting is compiled out
+std::uint64_t heap_allocations();
+
+constexpr bool heap_counting_enabled() { return IDS_COUNT_HEAP_ALLOCATIONS != 0; }
+
+} // namespace core
@@ -0,0 +1,268 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core { namespace dsa {
+
+struct IpPrefix {
+    bool v6{false};
+    std::array<std::uint8_t, 16> addr{}; // network byte order; IPv4 uses the first 4 bytes
+    unsigned length{0};
+
+    std::uint32_t v4() const {
+        return (static_cast<std::uint32_t>(addr[0]) << 24) | (static_cast<std::uint32_t>(addr[1]) << 16) |
+               (static_cast<std::uint32_t>(addr[2]) << 8) | addr[3];
+    }
+};
+
+// Longest-prefix-match table mapping IPv4/IPv6 prefixes to 31-bit values.
+//
+// IPv4 uses DIR-24-8 by default: a 2^24-entry table indexed by the top 24
+// bits whose entries either hold a value or point at a 256-entry table for
+// the last octet, so every lookup is one or two memory accesses. The 64 MB
+// root suits large reputation lists; small tables (rule address groups) can
+// use a 16-bit root instead (DIR-16-8-8, up to three accesses, 256 KB).
+// IPv6 uses the same scheme as a multibit trie: a 2^16-entry root, then
+// 256-entry nodes per further octet.
+//
+// Tables are built in one pass: add() every prefix, then build(). Prefixes
+// are written shortest first, so longer prefixes overwrite the ranges they
+// refine and a new second-level table inherits the entry it replaces.
+class IpLpm {
+public:
+    static constexpr std::uint32_t kNoMatch = 0x7FFFFFFFu;
+
+    // v4_root_bits is 24 (DIR-24-8) or 16 (DIR-16-8-8)
+    explicit IpLpm(unsigned v4_root_bits = 24) : v4_root_bits_(v4_root_bits == 16 ? 16u : 24u) {}
+
+    // value must be below kNoMatch. Later duplicates of a prefix win.
+    bool add(const IpPrefix& prefix, std::uint32_t value) {
+        if (value >= kNoMatch || prefix.length > (prefix.v6 ? 128u : 32u)) return false;
+        pending_.push_back(Pending{prefix, value});
+        return true;
+    }
+
+    // Accepts "a.b.c.d", "a.b.c.d/len", IPv6 text forms with optional "/len"
+    bool add(std::string_view cidr, std::uint32_t value) {
+        IpPrefix prefix;
+        return parse_prefix(cidr, prefix) && add(prefix, value);
+    }
+
+    void build() {
+        root4_.clear();
+        nodes4_.clear();
+        root6_.clear();
+        nodes6_.clear();
+        v4_count_ = v6_count_ = 0;
+
+        std::stable_sort(pending_.begin(), pending_.end(),
+                         [](const Pending& a, const Pending& b) { return a.prefix.length < b.prefix.length; });
+        for (const auto& p : pending_) {
+            if (p.prefix.v6) {
+                insert(root6_, 16, nodes6_, p.prefix, p.value);
+                ++v6_count_;
+            } else {
+                insert(root4_, v4_root_bits_, nodes4_, p.prefix, p.value);
+                ++v4_count_;
+            }
+        }
+        pending_.clear();
+        pending_.shrink_to_fit();
+    }
+
+    // addr in host order, as produced by decode::parse_ipv4
+    std::uint32_t lookup_v4(std::uint32_t addr) const {
+        if (root4_.empty()) return kNoMatch;
+        std::uint32_t e = root4_[addr >> (32 - v4_root_bits_)];
+        for (unsigned shift = 24 - v4_root_bits_; e & kChild; shift -= 8) {
+            e = nodes4_[((e & ~kChild) << 8) | ((addr >> shift) & 0xFF)];
+        }
+        return e;
+    }
+
+    std::uint32_t lookup_v6(const std::uint8_t* addr) const {
+        if (root6_.empty()) return kNoMatch;
+        std::uint32_t e = root6_[(static_cast<std::uint32_t>(addr[0]) << 8) | addr[1]];
+        for (std::size_t b = 2; e & kChild; ++b) e = nodes6_[((e & ~kChild) << 8) | addr[b]];
+        return e;
+    }
+
+    std::size_t v4_prefix_count() const { return v4_count_; }
+    std::size_t v6_prefix_count() const { return v6_count_; }
+
+    std::size_t memory_usage() const {
+        return (root4_.capacity() + nodes4_.capacity() + root6_.capacity() + nodes6_.capacity()) *
+               sizeof(std::uint32_t);
+    }
+
+    static bool parse_prefix(std::string_view text, IpPrefix& out) {
+        while (!text.empty() && (text.front() == ' ' || text.front() == '\t')) text.remove_prefix(1);
+        while (!text.empty() && (text.back() == ' ' || text.back() == '\t' || text.back() == '\r')) text.remove_suffix(1);
+
+        out = IpPrefix{};
+        std::string_view addr = text;
+        int length = -1;
+        auto slash = text.find('/');
+        if (slash != std::string_view::npos) {
+            addr = text.substr(0, slash);
+            if (!parse_uint(text.substr(slash + 1), 128, length)) return false;
+        }
+
+        if (addr.find(':') != std::string_view::npos) {
+            out.v6 = true;
+            if (!parse_v6(addr, out.addr.data())) return false;
+            out.length = length < 0 ? 128u : static_cast<unsigned>(length);
+        } else {
+            if (!parse_v4(addr, out.addr.data())) return false;
+            if (length > 32) return false;
+            out.length = length < 0 ? 32u : static_cast<unsigned>(length);
+        }
+        mask(out);
+        return true;
+    }
+
+private:
+    static constexpr std::uint32_t kChild = 0x80000000u; // entry indexes a child table
+
+    struct Pending {
+        IpPrefix prefix;
+        std::uint32_t value;
+    };
+
+    // Root indexed by the top root_bits (16 or 24), then one 256-entry node
+    // per further octet
+    static void insert(std::vector<std::uint32_t>& root, unsigned root_bits, std::vector<std::uint32_t>& nodes,
+                       const IpPrefix& p, std::uint32_t value) {
+        if (root.empty()) root.assign(std::size_t{1} << root_bits, kNoMatch);
+        const std::uint8_t* a = p.addr.data();
+        std::size_t index = 0;
+        for (unsigned b = 0; b < root_bits / 8; ++b) index = (index << 8) | a[b];
+        if (p.length <= root_bits) {
+            std::size_t span = std::size_t{1} << (root_bits - p.length);
+            std::fill_n(root.begin() + static_cast<std::ptrdiff_t>(index & ~(span - 1)), span, value);
+            return;
+        }
+        // Slots are tracked by index: new_table() may reallocate nodes
+        std::vector<std::uint32_t>* table = &root;
+        std::size_t slot = index;
+        for (unsigned b = root_bits / 8;; ++b) {
+            std::uint32_t e = (*table)[slot];
+            if (!(e & kChild)) {
+                e = kChild | new_table(nodes, e);
+                (*table)[slot] = e;
+            }
+            std::size_t base = static_cast<std::size_t>(e & ~kChild) << 8;
+            if (p.length <= 8 * (b + 1)) {
+                std::size_t span = std::size_t{1} << (8 * (b + 1) - p.length);
+                std::fill_n(nodes.begin() + static_cast<std::ptrdiff_t>(base + (a[b] & ~(span - 1))), span, value);
+                return;
+            }
+            table = &nodes;
+            slot = base + a[b];
+        }
+    }
+
+    static std::uint32_t new_table(std::vector<std::uint32_t>& pool, std::uint32_t inherit) {
+        auto index = static_cast<std::uint32_t>(pool.size() >> 8);
+        pool.resize(pool.size() + 256, inherit);
+        return index;
+    }
+
+    static void mask(IpPrefix& p) {
+        unsigned bits = p.v6 ? 128 : 32;
+        for (unsigned i = 0; i < 16; ++i) {
+            unsigned start = i * 8;
+            if (start >= bits) {
+                p.addr[i] = 0;
+            } else if (start + 8 > p.length) {
+                unsigned keep = p.length > start ? p.length - start : 0;
+                p.addr[i] &= static_cast<std::uint8_t>(0xFF00u >> keep);
+            }
+        }
+    }
+
+    static bool parse_uint(std::string_view s, int max, int& out) {
+        if (s.empty() || s.size() > 3) return false;
+        out = 0;
+        for (char c : s) {
+            if (c < '0' || c > '9') return false;
+            out = out * 10 + (c - '0');
+        }
+        return out <= max;
+    }
+
+    static bool parse_v4(std::string_view s, std::uint8_t* out) {
+        for (int i = 0; i < 4; ++i) {
+            auto dot = s.find('.');
+            if ((dot == std::string_view::npos) != (i == 3)) return false;
+            int octet = 0;
+            if (!parse_uint(s.substr(0, dot), 255, octet)) return false;
+            out[i] = static_cast<std::uint8_t>(octet);
+            if (i < 3) s.remove_prefix(dot + 1);
+        }
+        return true;
+    }
+
+    // RFC 4291 text form with at most one "::"; embedded IPv4 is not accepted
+    static bool parse_v6(std::string_view s, std::uint8_t* out) {
+        std::uint16_t head[8], tail[8];
+        int nhead = 0, ntail = 0;
+        bool compressed = false;
+        auto gap = s.find("::");
+        std::string_view parts[2] = {s, {}};
+        if (gap != std::string_view::npos) {
+            compressed = true;
+            parts[0] = s.substr(0, gap);
+            parts[1] = s.substr(gap + 2);
+            if (parts[1].find("::") != std::string_view::npos) return false;
+        }
+        for (int side = 0; side < 2; ++side) {
+            std::string_view part = parts[side];
+            if (part.empty()) continue;
+            std::uint16_t* groups = side == 0 ? head : tail;
+            int& n = side == 0 ? nhead : ntail;
+            std::size_t pos = 0;
+            while (true) {
+                auto colon = part.find(':', pos);
+                std::string_view group = part.substr(pos, colon == std::string_view::npos ? colon : colon - pos);
+                if (group.empty() || group.size() > 4 || n == 8) return false;
+                std::uint16_t v = 0;
+                for (char c : group) {
+                    int d = (c >= '0' && c <= '9') ? c - '0'
+                          : (c >= 'a' && c <= 'f') ? c - 'a' + 10
+                          : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : -1;
+                    if (d < 0) return false;
+                    v = static_cast<std::uint16_t>((v << 4) | d);
+                }
+                groups[n++] = v;
+                if (colon == std::string_view::npos) break;
+                pos = colon + 1;
+            }
+        }
+        if (compressed ? nhead + ntail > 7 : nhead != 8) return false;
+        std::uint16_t all[8] = {};
+        for (int i = 0; i < nhead; ++i) all[i] = head[i];
+        for (int i = 0; i < ntail; ++i) all[8 - ntail + i] = tail[i];
+        for (int i = 0; i < 8; ++i) {
+            out[2 * i] = static_cast<std::uint8_t>(all[i] >> 8);
+            out[2 * i + 1] = static_cast<std::uint8_t>(all[i]);
+        }
+        return true;
+    }
+
+    std::vector<Pending> pending_;
+    unsigned v4_root_bits_;
+    std::vector<std::uint32_t> root4_;  // IPv4 top level, allocated on first IPv4 prefix
+    std::vector<std::uint32_t> nodes4_; // IPv4 per-octet tables, 256 entries each
+    std::vector<std::uint32_t> root6_;  // IPv6 top 16 bits
+    std::vector<std::uint32_t> nodes6_; // IPv6 per-octet tables, 256 entries each
+    std::size_t v4_count_{0};
+    std::size_t v6_count_{0};
+};
+
+}} // namespace core::dsa
@@ -1,14 +1,26 @@
 #pragma once
 #include <list>
+#include <memory>
 #include <unordered_map>
 #include <utility>
 
 namespace core { namespace dsa {
 
-template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEq = std::equal_to<Key>>
+// Allocator is rebound for the recency list and the map nodes, so both can
+// come from one arena (see core::ArenaAllocator)
+template <typename Key, typename T, typename Hash = std::hash<Key>, typename KeyEq = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>>
 class LRUCache {
+    struct Entry;
+    template <typename U>
+    using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+    using List = std::list<Key, Rebind<Key>>;
+    using Map = std::unordered_map<Key, Entry, Hash, KeyEq, Rebind<std::pair<const Key, Entry>>>;
+
 public:
-    explicit LRUCache(std::size_t capacity) : capacity_(capacity) {}
+    explicit LRUCache(std::size_t capacity, const Allocator& alloc = Allocator())
+        : capacity_(capacity), order_(Rebind<Key>(alloc)),
+          map_(0, Hash(), KeyEq(), Rebind<std::pair<const Key, Entry>>(alloc)) {}
 
     template <typename Factory>
     T& get_or_create(const Key& key, Factory factory) {
@@ -26,13 +38,16 @@ public:
 
     bool contains(const Key& key) const { return map_.find(key) != map_.end(); }
 
+    // Sizes the bucket array for capacity entries up front, so the map never rehashes
+    void reserve() { map_.reserve(capacity_); }
+
 private:
     struct Entry {
         T value;
-        typename std::list<Key>::iterator it;
+        typename List::iterator it;
     };
 
-    void touch(typename std::unordered_map<Key, Entry, Hash, KeyEq>::iterator it) {
+    void touch(typename Map::iterator it) {
         order_.splice(order_.begin(), order_, it->second.it);
         it->second.it = order_.begin();
     }
@@ -44,8 +59,8 @@ private:
     }
 
     std::size_t capacity_;
-    std::list<Key> order_{};
-    std::unordered_map<Key, Entry, Hash, KeyEq> map_{};
+    List order_;
+    Map map_;
 };
 
 }} // namespace core::dsa
@@ -0,0 +1,159 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "core/dsa/AhoCorasick.hpp"
+#include "core/dsa/Teddy.hpp"
+
+namespace core { namespace dsa {
+
+// Multi-literal matcher that picks its algorithm from the pattern set:
+//   one literal                       -> memchr on its rarest byte + memcmp
+//   up to 64 literals (see choose())  -> Teddy SIMD fingerprints
+//   anything larger                   -> flattened Aho-Corasick DFA
+// All kinds report on_match(start_position, pattern_index) where
+// pattern_index is the position in the vector given to build().
+class LiteralMatcher {
+public:
+    enum class Kind { Empty, Memchr, Teddy, AhoCorasick };
+
+    static Kind choose(const std::vector<std::string>& patterns) {
+        if (patterns.empty()) return Kind::Empty;
+        if (patterns.size() == 1) return Kind::Memchr;
+        std::size_t shortest = SIZE_MAX;
+        for (const auto& p : patterns) shortest = std::min(shortest, p.size());
+        // One-byte fingerprints saturate the 8 buckets quickly; keep Teddy
+        // for sets where candidates stay rare.
+        if (patterns.size() <= Teddy::kMaxPatterns && (shortest >= 2 || patterns.size() <= 8)) {
+            return Kind::Teddy;
+        }
+        return Kind::AhoCorasick;
+    }
+
+    // A pool speeds up large automaton builds (see AhoCorasick::build)
+    void build(const std::vector<std::string>& patterns, ThreadPool* pool = nullptr) {
+        build(patterns, choose(patterns), pool);
+    }
+
+    void build(const std::vector<std::string>& patterns, Kind kind, ThreadPool* pool = nullptr) {
+        kind_ = kind;
+        single_.clear();
+        teddy_ = Teddy{};
+        aho_corasick_ = AhoCorasick{};
+        for (const auto& p : patterns) {
+            if (p.empty()) kind_ = Kind::AhoCorasick; // only the automaton handles empty literals
+        }
+        if (kind_ == Kind::Memchr && patterns.size() != 1) kind_ = Kind::AhoCorasick;
+        if (kind_ == Kind::Teddy && !teddy_.build(patterns)) kind_ = Kind::AhoCorasick;
+
+        switch (kind_) {
+            case Kind::Empty:
+            case Kind::Teddy:
+                break;
+            case Kind::Memchr:
+                single_ = patterns[0];
+                rare_offset_ = rarest_byte_offset(single_);
+                break;
+            case Kind::AhoCorasick:
+                aho_corasick_.add_patterns(patterns, pool);
+                aho_corasick_.build(pool);
+                break;
+        }
+    }
+
+    // Uses a prebuilt automaton in place, e.g. one mapped from a compiled ruleset
+    void attach(const AhoCorasick::Tables& tables) {
+        kind_ = Kind::AhoCorasick;
+        single_.clear();
+        teddy_ = Teddy{};
+        aho_corasick_ = AhoCorasick{};
+        aho_corasick_.attach(tables);
+    }
+
+    Kind kind() const { return kind_; }
+    const AhoCorasick& automaton() const { return aho_corasick_; }
+
+    std::size_t memory_usage() const {
+        return single_.capacity() + teddy_.memory_usage() + aho_corasick_.memory_usage();
+    }
+
+    static const char* kind_name(Kind kind) {
+        switch (kind) {
+            case Kind::Empty: return "empty";
+            case Kind::Memchr: return "memchr";
+            case Kind::Teddy: return "teddy";
+            case Kind::AhoCorasick: return "aho-corasick";
+        }
+        return "?";
+    }
+
+    template <typename F>
+    void scan(std::string_view text, F&& on_match) const {
+        switch (kind_) {
+            case Kind::Empty:
+                return;
+            case Kind::Memchr:
+                scan_single(text, on_match);
+                return;
+            case Kind::Teddy:
+                teddy_.scan(text, on_match);
+                return;
+            case Kind::AhoCorasick:
+                aho_corasick_.scan(text, on_match);
+                return;
+        }
+    }
+
+private:
+    // Rough commonness of a byte in protocol text: lowercase letters and
+    // space are frequent, digits and uppercase less so, the rest rare.
+    static int byte_frequency(unsigned char c) {
+        static constexpr std::string_view kByFrequency = " etaoinsrhldcumfpgwybvkxjqz";
+        auto pos = kByFrequency.find(static_cast<char>(c));
+        if (pos != std::string_view::npos) return 100 - static_cast<int>(pos);
+        if (c >= '0' && c <= '9') return 50;
+        if (c >= 'A' && c <= 'Z') return 40;
+        if (c == '/' || c == '.' || c == '=' || c == '-' || c == '\r' || c == '\n') return 45;
+        return 10;
+    }
+
+    static std::size_t rarest_byte_offset(const std::string& literal) {
+        std::size_t best = 0;
+        for (std::size_t i = 1; i < literal.size(); ++i) {
+            if (byte_frequency(static_cast<unsigned char>(literal[i])) <
+                byte_frequency(static_cast<unsigned char>(literal[best]))) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // memchr for the literal's rarest byte, then confirm the whole literal
+    template <typename F>
+    void scan_single(std::string_view text, F& on_match) const {
+        const std::size_t len = single_.size();
+        if (text.size() < len) return;
+        const char* base = text.data();
+        const char rare = single_[rare_offset_];
+        const char* p = base + rare_offset_;
+        const char* end = base + (text.size() - len) + rare_offset_ + 1; // one past the last candidate
+        while (p < end) {
+            p = static_cast<const char*>(std::memchr(p, rare, static_cast<std::size_t>(end - p)));
+            if (!p) return;
+            const char* start = p - rare_offset_;
+            if (std::memcmp(start, single_.data(), len) == 0) on_match(static_cast<std::size_t>(start - base), 0);
+            ++p;
+        }
+    }
+
+    Kind kind_{Kind::Empty};
+    std::string single_;
+    std::size_t rare_offset_{0};
+    Teddy teddy_;
+    AhoCorasick aho_corasick_;
+};
+
+}} // namespace core::dsa
@@ -0,0 +1,41 @@
+#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+namespace core {
+
+// Memory mapping of a whole file (MapViewOfFile on Windows, mmap
+// elsewhere), read-only or shared read-write. The mapping stays valid
+// until close() or destruction.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    bool open(const std::string& path);
+
+    // Shared read-write mapping, visible to other processes mapping the same
+    // file. Creates the file if needed and grows it to at least min_size
+    // (0 maps an existing file at its current size).
+    bool open_writable(const std::string& path, std::size_t min_size = 0);
+    void close();
+
+    bool is_open() const { return data_ != nullptr; }
+    const std::uint8_t* data() const { return data_; }
+    std::uint8_t* writable_data() const { return writable_ ? data_ : nullptr; }
+    std::size_t size() const { return size_; }
+
+private:
+    std::uint8_t* data_{nullptr};
+    std::size_t size_{0};
+    bool writable_{false};
+    void* mapping_{nullptr}; // file mapping handle (Windows only)
+};
+
+} // namespace core
@@ -0,0 +1,243 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace core {
+
+// Pipeline counters. Each thread owns a MetricShard and bumps its own
+// cache-line-aligned copy with plain (relaxed load + store) writes; readers
+// sum the shards, so the packet path never writes a shared cache line.
+enum class Counter : std::size_t {
+    PacketsCaptured,
+    CapturedBytes,
+    RingFullWaits,       // capture found the packet ring full and waited
+    PacketsProcessed,
+    DecodeEthernet,      // decode failures by reason
+    DecodeNotIpv4,
+    DecodeIpv4,
+    DecodeTcp,
+    DecodeUdp,
+    FlowsCreated,
+    ReassemblyBuffered,  // segments buffered by TLS hello reassembly
+    TlsHellos,
+    PayloadBytes,
+    BypassedBytes,       // payload bytes skipped by the inspection budget
+    MatcherPackets,
+    MatcherBytes,
+    Alerts,
+    AlertsSuppressed,
+    HeapAllocations,     // global operator new calls by the worker and detection lanes
+    Count
+};
+
+struct CounterInfo {
+    std::string_view name; // Prometheus metric name, counters sharing it differ by label
+    std::string_view label; // "key=\"value\"" or empty
+    std::string_view help;
+};
+
+inline const CounterInfo& counter_info(Counter c) {
+    static const CounterInfo table[] = {
+        {"ids_packets_captured_total", "", "Packets delivered by the capture source"},
+        {"ids_captured_bytes_total", "", "Bytes delivered by the capture source"},
+        {"ids_ring_full_waits_total", "", "Times capture waited on a full packet ring"},
+        {"ids_packets_processed_total", "", "Packets taken off the ring by workers"},
+        {"ids_decode_errors_total", "reason=\"ethernet\"", "Packets that failed to decode, by reason"},
+        {"ids_decode_errors_total", "reason=\"not_ipv4\"", ""},
+        {"ids_decode_errors_total", "reason=\"ipv4\"", ""},
+        {"ids_decode_errors_total", "reason=\"tcp\"", ""},
+        {"ids_decode_errors_total", "reason=\"udp\"", ""},
+        {"ids_flows_created_total", "", "Flow directions added to the flow table"},
+        {"ids_reassembly_buffered_segments_total", "", "TCP segments buffered by TLS hello reassembly"},
+        {"ids_tls_hellos_total", "", "TLS client and server hellos parsed"},
+        {"ids_payload_bytes_total", "", "Transport payload bytes of inspected flows"},
+        {"ids_bypassed_bytes_total", "", "Payload bytes skipped by stream depth, TLS and entropy bypass"},
+        {"ids_matcher_packets_total", "", "Payloads scanned by the detection engine"},
+        {"ids_matcher_bytes_total", "", "Payload bytes scanned by the detection engine"},
+        {"ids_alerts_total", "", "Alerts raised"},
+        {"ids_alerts_suppressed_total", "", "Alerts withheld by rule thresholds"},
+        {"ids_heap_allocations_total", "", "Global heap allocations made by the worker and detection lane threads"},
+    };
+    static_assert(sizeof(table) / sizeof(table[0]) == static_cast<std::size_t>(Counter::Count));
+    return table[static_cast<std::size_t>(c)];
+}
+
+// HDR-style log-linear histogram of nanosecond latencies: 8 linear
+// sub-buckets per power of two (at most 12.5% relative error) up to 2^40 ns.
+// Recording is an index computation and one increment by the owning
+// thread; snapshots are merged by readers.
+class LatencyHistogram {
+public:
+    static constexpr unsigned kSubBits = 3;
+    static constexpr std::size_t kSub = std::size_t{1} << kSubBits;
+    static constexpr unsigned kMaxBits = 40;
+    static constexpr std::size_t kBuckets = (kMaxBits - kSubBits + 1) * kSub;
+
+    static std::size_t bucket(std::uint64_t ns) {
+        if (ns >= (std::uint64_t{1} << kMaxBits)) ns = (std::uint64_t{1} << kMaxBits) - 1;
+        if (ns < 2 * kSub) return static_cast<std::size_t>(ns);
+        unsigned shift = static_cast<unsigned>(std::bit_width(ns)) - kSubBits - 1;
+        return (shift + 1) * kSub + static_cast<std::size_t>((ns >> shift) - kSub);
+    }
+
+    // Smallest value of a bucket; bucket b covers [lower(b), lower(b + 1))
+    static std::uint64_t lower(std::size_t b) {
+        if (b < 2 * kSub) return b;
+        unsigned shift = static_cast<unsigned>(b / kSub) - 1;
+        return static_cast<std::uint64_t>(kSub + b % kSub) << shift;
+    }
+
+    void record(std::uint64_t ns) {
+        bump(counts_[bucket(ns)], 1);
+        bump(sum_, ns);
+    }
+
+    struct Snapshot {
+        std::uint64_t counts[kBuckets]{};
+        std::uint64_t sum{0};
+        std::uint64_t count{0};
+
+        // Upper bound of the bucket holding quantile q (0..1); 0 when empty
+        std::uint64_t quantile(double q) const {
+            if (count == 0) return 0;
+            auto rank = static_cast<std::uint64_t>(q * static_cast<double>(count - 1)) + 1;
+            std::uint64_t seen = 0;
+            for (std::size_t b = 0; b < kBuckets; ++b) {
+                seen += counts[b];
+                if (seen >= rank) return b + 1 < kBuckets ? lower(b + 1) - 1 : lower(b);
+            }
+            return lower(kBuckets - 1);
+        }
+
+        // Observations below limit; limit is a power of two, so it falls on a bucket boundary
+        std::uint64_t count_below(std::uint64_t limit) const {
+            std::uint64_t n = 0;
+            for (std::size_t b = 0; b < kBuckets && lower(b) < limit; ++b) n += counts[b];
+            return n;
+        }
+    };
+
+    void add_to(Snapshot& s) const {
+        for (std::size_t b = 0; b < kBuckets; ++b) {
+            std::uint64_t n = counts_[b].load(std::memory_order_relaxed);
+            s.counts[b] += n;
+            s.count += n;
+        }
+        s.sum += sum_.load(std::memory_order_relaxed);
+    }
+
+private:
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+
+    std::atomic<std::uint64_t> counts_[kBuckets]{};
+    std::atomic<std::uint64_t> sum_{0};
+};
+
+// One thread's counters and capture-to-verdict latencies. Written by that
+// thread only.
+struct alignas(64) MetricShard {
+    std::atomic<std::uint64_t> counters[static_cast<std::size_t>(Counter::Count)]{};
+    LatencyHistogram latency;
+
+    void add(Counter c, std::uint64_t n = 1) {
+        auto& counter = counters[static_cast<std::size_t>(c)];
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Records the time since a packet's capture timestamp
+inline void record_latency(MetricShard& shard, std::chrono::steady_clock::time_point captured) {
+    auto elapsed = std::chrono::steady_clock::now() - captured;
+    shard.latency.record(static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count()));
+}
+
+// record_latency when it goes out of scope, however processing of the
+// packet ends
+class ScopedLatency {
+public:
+    ScopedLatency(MetricShard& shard, std::chrono::steady_clock::time_point captured)
+        : shard_(shard), captured_(captured) {}
+    ~ScopedLatency() { record_latency(shard_, captured_); }
+
+    ScopedLatency(const ScopedLatency&) = delete;
+    ScopedLatency& operator=(const ScopedLatency&) = delete;
+
+private:
+    MetricShard& shard_;
+    std::chrono::steady_clock::time_point captured_;
+};
+
+// Registry of per-thread shards, aggregated on read (stats line, Prometheus
+// scrape). Registration takes a lock; shards live as long as the registry.
+class Metrics {
+public:
+    MetricShard& register_thread() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        shards_.push_back(std::make_unique<MetricShard>());
+        return *shards_.back();
+    }
+
+    std::uint64_t total(Counter c) const {
+        std::lock_guard<std::mutex> lock(mutex_);
+        std::uint64_t sum = 0;
+        for (const auto& shard : shards_) sum += shard->counters[static_cast<std::size_t>(c)].load(std::memory_order_relaxed);
+        return sum;
+    }
+
+    // Merged latency histogram; Snapshot is a few KB, so keep it off the stack of hot code
+    std::unique_ptr<LatencyHistogram::Snapshot> latency() const {
+        auto snapshot = std::make_unique<LatencyHistogram::Snapshot>();
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (const auto& shard : shards_) shard->latency.add_to(*snapshot);
+        return snapshot;
+    }
+
+    // Prometheus text exposition format (version 0.0.4)
+    void render_prometheus(std::string& out) const {
+        std::string_view previous;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(Counter::Count); ++i) {
+            const CounterInfo& info = counter_info(static_cast<Counter>(i));
+            if (info.name != previous) {
+                out.append("# HELP ").append(info.name).append(" ").append(info.help).append("\n");
+                out.append("# TYPE ").append(info.name).append(" counter\n");
+                previous = info.name;
+            }
+            out.append(info.name);
+            if (!info.label.empty()) out.append("{").append(info.label).append("}");
+            out.append(" ").append(std::to_string(total(static_cast<Counter>(i)))).append("\n");
+        }
+
+        // Cumulative buckets at powers of two from 1 us to ~17 s, in seconds
+        auto snapshot = latency();
+        out.append("# HELP ids_capture_to_verdict_seconds Time from capture to the end of packet processing\n");
+        out.append("# TYPE ids_capture_to_verdict_seconds histogram\n");
+        char le[32];
+        for (unsigned bits = 10; bits <= 34; ++bits) {
+            std::uint64_t limit = std::uint64_t{1} << bits;
+            std::snprintf(le, sizeof(le), "%.9g", static_cast<double>(limit) * 1e-9);
+            out.append("ids_capture_to_verdict_seconds_bucket{le=\"").append(le).append("\"} ");
+            out.append(std::to_string(snapshot->count_below(limit))).append("\n");
+        }
+        out.append("ids_capture_to_verdict_seconds_bucket{le=\"+Inf\"} ").append(std::to_string(snapshot->count)).append("\n");
+        std::snprintf(le, sizeof(le), "%.9f", static_cast<double>(snapshot->sum) * 1e-9);
+        out.append("ids_capture_to_verdict_seconds_sum ").append(le).append("\n");
+        out.append("ids_capture_to_verdict_seconds_count ").append(std::to_string(snapshot->count)).append("\n");
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<MetricShard>> shards_;
+};
+
+} // namespace core
@@ -0,0 +1,162 @@
+#include "output/MetricsServer.hpp"
+#include <cstring>
+#include <iostream>
+#include <string>
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <winsock2.h>
+#include <ws2tcpip.h>
+#pragma comment(lib, "ws2_32.lib")
+#else
+#include <arpa/inet.h>
+#include <cerrno>
+#include <netinet/in.h>
+#include <poll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#endif
+
+namespace output {
+
+namespace {
+
+#ifdef _WIN32
+using Socket = SOCKET;
+constexpr Socket kInvalid = INVALID_SOCKET;
+void close_socket(Socket s) { closesocket(s); }
+#else
+using Socket = int;
+constexpr Socket kInvalid = -1;
+void close_socket(Socket s) { ::close(s); }
+#endif
+
+// Waits up to timeout_ms for s to become readable
+bool wait_readable(Socket s, int timeout_ms) {
+#ifdef _WIN32
+    WSAPOLLFD fd{};
+    fd.fd = s;
+    fd.events = POLLRDNORM;
+    return WSAPoll(&fd, 1, timeout_ms) > 0;
+#else
+    pollfd fd{};
+    fd.fd = s;
+    fd.events = POLLIN;
+    return ::poll(&fd, 1, timeout_ms) > 0;
+#endif
+}
+
+bool send_all(Socket s, const char* data, std::size_t size) {
+    while (size != 0) {
+#ifdef _WIN32
+        int sent = ::send(s, data, static_cast<int>(size), 0);
+        if (sent <= 0) return false;
+#else
+        ssize_t sent = ::send(s, data, size, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return false;
+#endif
+        data += sent;
+        size -= static_cast<std::size_t>(sent);
+    }
+    return true;
+}
+
+} // namespace
+
+MetricsServer::~MetricsServer() {
+    stop();
+}
+
+bool MetricsServer::start(std::uint16_t port) {
+    if (thread_.joinable()) return true;
+#ifdef _WIN32
+    WSADATA wsa{};
+    if (WSAStartup(MAKEWORD(2, 2), &wsa) != 0) return false;
+#endif
+    Socket s = ::socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+    if (s == kInvalid) {
+        std::cerr << "Cannot create metrics socket" << std::endl;
+        return false;
+    }
+    int reuse = 1;
+    ::setsockopt(s, SOL_SOCKET, SO_REUSEADDR, reinterpret_cast<const char*>(&reuse), sizeof(reuse));
+
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(port);
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (::bind(s, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0 || ::listen(s, 8) != 0) {
+        std::cerr << "Cannot listen for metrics on 127.0.0.1:" << port << std::endl;
+        close_socket(s);
+        return false;
+    }
+    listener_ = static_cast<std::intptr_t>(s);
+    stopping_ = false;
+    thread_ = std::thread([this] { run(); });
+    return true;
+}
+
+void MetricsServer::stop() {
+    if (!thread_.joinable()) return;
+    stopping_ = true;
+    thread_.join();
+    close_socket(static_cast<Socket>(listener_));
+    listener_ = -1;
+#ifdef _WIN32
+    WSACleanup();
+#endif
+}
+
+void MetricsServer::run() {
+    auto listener = static_cast<Socket>(listener_);
+    while (!stopping_.load(std::memory_order_acquire)) {
+        // Short poll so stop() is noticed without closing the socket under accept
+        if (!wait_readable(listener, 200)) continue;
+        Socket client = ::accept(listener, nullptr, nullptr);
+        if (client == kInvalid) continue;
+        serve(static_cast<std::intptr_t>(client));
+        close_socket(client);
+    }
+}
+
+void MetricsServer::serve(std::intptr_t handle) {
+    auto client = static_cast<Socket>(handle);
+    // Only the request line matters; read until the end of the headers
+    std::string request;
+    char buf[1024];
+    while (request.find("\r\n\r\n") == std::string::npos && request.size() < 8192) {
+        if (!wait_readable(client, 1000)) return;
+#ifdef _WIN32
+        int n = ::recv(client, buf, static_cast<int>(sizeof(buf)), 0);
+#else
+        ssize_t n = ::recv(client, buf, sizeof(buf), 0);
+#endif
+        if (n <= 0) return;
+        request.append(buf, static_cast<std::size_t>(n));
+    }
+
+    std::string body;
+    const char* status = "200 OK";
+    if (request.rfind("GET /metrics ", 0) == 0 || request.rfind("GET / ", 0) == 0) {
+        body.reserve(8192);
+        metrics_.render_prometheus(body);
+    } else {
+        status = "404 Not Found";
+        body = "not found\n";
+    }
+    std::string response = "HTTP/1.1 ";
+    response.append(status);
+    response.append("\r\nContent-Type: text/plain; version=0.0.4; charset=utf-8\r\nContent-Length: ");
+    response.append(std::to_string(body.size()));
+    response.append("\r\nConnection: close\r\n\r\n");
+    response.append(body);
+    send_all(client, response.data(), response.size());
+}
+
+} // namespace output
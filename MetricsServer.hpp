@@ -0,0 +1,34 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <thread>
+#include "core/Metrics.hpp"
+
+namespace output {
+
+// Minimal HTTP endpoint on the loopback interface serving the metrics
+// registry in Prometheus text format at /metrics. One thread, one request
+// per connection; scrapes aggregate the per-thread shards at read time.
+class MetricsServer {
+public:
+    explicit MetricsServer(const core::Metrics& metrics) : metrics_(metrics) {}
+    ~MetricsServer();
+
+    MetricsServer(const MetricsServer&) = delete;
+    MetricsServer& operator=(const MetricsServer&) = delete;
+
+    // Listens on 127.0.0.1:port and starts the server thread
+    bool start(std::uint16_t port);
+    void stop();
+
+private:
+    void run();
+    void serve(std::intptr_t client);
+
+    const core::Metrics& metrics_;
+    std::intptr_t listener_{-1}; // platform socket handle
+    std::thread thread_;
+    std::atomic<bool> stopping_{false};
+};
+
+} // namespace output
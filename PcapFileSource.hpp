@@ -0,0 +1,127 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "capture/ISource.hpp"
+#include "core/MappedFile.hpp"
+#include "core/Packet.hpp"
+
+namespace capture {
+
+// Reader for classic libpcap capture files (not pcapng): either byte order,
+// microsecond or nanosecond timestamps, Ethernet or raw IP link types.
+// Packets are stamped with the time they are handed on, not the capture
+// time in the file, so latency figures measure this process.
+class PcapFileSource : public ISource {
+public:
+    // loops: times the file is replayed (0 = until stopped)
+    explicit PcapFileSource(std::string path, std::size_t loops = 1) : path_(std::move(path)), loops_(loops) {}
+    ~PcapFileSource() override { stop(); }
+
+    // Reads every packet of the file; false (with a message) if it can't be
+    // opened or isn't a pcap file. A truncated last record is ignored.
+    static bool read_file(const std::string& path, std::vector<core::Packet>& out) {
+        core::MappedFile file;
+        if (!file.open(path)) {
+            std::cerr << "Cannot open pcap file: " << path << std::endl;
+            return false;
+        }
+        const std::uint8_t* p = file.data();
+        std::size_t size = file.size();
+        if (size < kFileHeader) {
+            std::cerr << "Not a pcap file: " << path << std::endl;
+            return false;
+        }
+        std::uint32_t magic = load32(p, false);
+        bool swapped;
+        if (magic == kMagicMicros || magic == kMagicNanos) {
+            swapped = false;
+        } else if (byteswap32(magic) == kMagicMicros || byteswap32(magic) == kMagicNanos) {
+            swapped = true;
+        } else {
+            std::cerr << "Not a pcap file (pcapng is not supported): " << path << std::endl;
+            return false;
+        }
+        core::LinkType link;
+        switch (load32(p + 20, swapped) & 0x0FFFFFFF) {
+        case kLinkEthernet: link = core::LinkType::Ethernet; break;
+        case kLinkRaw:
+        case kLinkRawOld:
+        case kLinkIpv4: link = core::LinkType::None; break;
+        default:
+            std::cerr << "Unsupported pcap link type in " << path << std::endl;
+            return false;
+        }
+
+        std::size_t pos = kFileHeader;
+        while (size - pos >= kRecordHeader) {
+            std::uint32_t captured = load32(p + pos + 8, swapped);
+            pos += kRecordHeader;
+            if (captured > size - pos) break;
+            core::Packet& packet = out.emplace_back();
+            packet.bytes.assign(p + pos, p + pos + captured);
+            packet.link = link;
+            pos += captured;
+        }
+        return true;
+    }
+
+    void start(Callback cb) override {
+        stop();
+        packets_.clear();
+        if (!read_file(path_, packets_)) return;
+        running_ = true;
+        worker_ = std::thread([this, cb]() { run(cb); });
+    }
+
+    void stop() override {
+        running_ = false;
+        if (worker_.joinable()) worker_.join();
+    }
+
+private:
+    static constexpr std::size_t kFileHeader = 24;
+    static constexpr std::size_t kRecordHeader = 16;
+    static constexpr std::uint32_t kMagicMicros = 0xA1B2C3D4;
+    static constexpr std::uint32_t kMagicNanos = 0xA1B23C4D;
+    static constexpr std::uint32_t kLinkEthernet = 1;
+    static constexpr std::uint32_t kLinkRawOld = 12;
+    static constexpr std::uint32_t kLinkRaw = 101;
+    static constexpr std::uint32_t kLinkIpv4 = 228;
+
+    static std::uint32_t byteswap32(std::uint32_t v) {
+        return (v >> 24) | ((v >> 8) & 0xFF00) | ((v << 8) & 0xFF0000) | (v << 24);
+    }
+    static std::uint32_t load32(const std::uint8_t* p, bool swapped) {
+        std::uint32_t v;
+        std::memcpy(&v, p, sizeof(v));
+        return swapped ? byteswap32(v) : v;
+    }
+
+    void run(Callback cb) {
+        for (std::size_t loop = 0; running_ && (loops_ == 0 || loop < loops_); ++loop) {
+            for (const core::Packet& original : packets_) {
+                if (!running_) break;
+                core::Packet packet;
+                packet.bytes = original.bytes;
+                packet.link = original.link;
+                packet.ts = std::chrono::steady_clock::now();
+                cb(std::move(packet));
+            }
+        }
+    }
+
+    std::string path_;
+    std::size_t loops_;
+    std::vector<core::Packet> packets_;
+    std::atomic<bool> running_{false};
+    std::thread worker_{};
+};
+
+} // namespace capture
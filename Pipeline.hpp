@@ -0,0 +1,262 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <utility>
+#include <vector>
+#include "core/Affinity.hpp"
+#include "core/dsa/RingBufferSPSC.hpp"
+
+namespace core {
+
+struct PipelineConfig {
+    enum class Mode { Fused, Staged };
+
+    Mode mode{Mode::Fused};
+    std::size_t detect_threads{2}; // staged: detection lanes, one thread each
+    std::size_t batch_size{64};    // tasks per batch (and per engine refresh in fused mode)
+    std::size_t burst_size{16};    // packets pulled at once and handed to burst() before prepare
+    std::vector<int> lane_cpus{};  // staged: CPU per lane thread, -1 or missing = unpinned
+};
+
+// Batches of T handed from one producer thread to one consumer thread.
+// Filled batches travel through one SPSC ring and emptied ones come back
+// through another, so batches, and any buffers their elements own, are
+// allocated once and reused.
+template <typename T>
+class BatchChannel {
+public:
+    static constexpr std::size_t kBatches = 64;
+
+    struct Batch {
+        std::vector<T> items;
+        std::size_t size{0};
+    };
+
+    explicit BatchChannel(std::size_t batch_size) : batches_(std::make_unique<Batch[]>(kBatches)) {
+        for (std::size_t i = 0; i < kBatches; ++i) {
+            batches_[i].items.resize(batch_size);
+            free_.try_push(&batches_[i]);
+        }
+    }
+
+    BatchChannel(const BatchChannel&) = delete;
+    BatchChannel& operator=(const BatchChannel&) = delete;
+
+    // Producer side. acquire() returns nullptr while every batch is in flight.
+    Batch* acquire() {
+        Batch* b = nullptr;
+        if (!free_.try_pop(b)) return nullptr;
+        b->size = 0;
+        return b;
+    }
+    void publish(Batch* b) { full_.try_push(b); } // cannot fail: the ring holds every batch
+
+    // Consumer side
+    Batch* receive() {
+        Batch* b = nullptr;
+        return full_.try_pop(b) ? b : nullptr;
+    }
+    void recycle(Batch* b) { free_.try_push(b); }
+
+private:
+    std::unique_ptr<Batch[]> batches_;
+    core::dsa::RingBufferSPSC<Batch*, kBatches> full_;
+    core::dsa::RingBufferSPSC<Batch*, kBatches> free_;
+};
+
+// Written by the pipeline threads, read by the stats thread
+struct PipelineStats {
+    std::atomic<std::uint64_t> batches{0};     // batches handed to detection lanes (staged)
+    std::atomic<std::uint64_t> lane_stalls{0}; // times the prepare stage waited for a free batch
+
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Runs the packet path as two stages:
+//   prepare  decode, flow tracking, reassembly: needs the flow state, so it
+//            runs on one thread
+//   detect   matching and alerting, which only needs the prepared task
+// Fused mode runs both on the calling thread, packet by packet (run to
+// completion). Staged mode runs prepare on the calling thread and detect on
+// `detect_threads` lanes, each fed by its own batch channel; lane(task)
+// picks the lane, so tasks that share state in detection (e.g. a source
+// address for thresholds) should map to the same lane.
+//
+// Packets are pulled in bursts of up to `burst_size` (whatever is ready,
+// never waiting for more), and burst(tasks, n) sees each burst before the
+// tasks are prepared one by one, so lookups for the whole burst can be
+// issued together (see flow::FlowTable::lookup_batch).
+//
+// Task must be default constructible and hold the packet it was prepared
+// from; tasks are swapped in and out of batch slots, never copied.
+template <typename Task>
+class Pipeline {
+public:
+    explicit Pipeline(PipelineConfig config) : config_(config) {
+        if (config_.batch_size == 0) config_.batch_size = 1;
+        if (config_.detect_threads == 0) config_.detect_threads = 1;
+        if (config_.burst_size == 0) config_.burst_size = 1;
+    }
+
+    std::size_t lanes() const { return config_.mode == PipelineConfig::Mode::Staged ? config_.detect_threads : 1; }
+    const PipelineStats& stats() const { return stats_; }
+    int lane_cpu(std::size_t lane) const { return lane < config_.lane_cpus.size() ? config_.lane_cpus[lane] : -1; }
+
+    // Runs until stop is set and pull has nothing left.
+    //   pull(Packet&) -> bool          next input packet, false if none right now
+    //   burst(Task*, size_t n)         the next n pulled tasks, before any is prepared
+    //   prepare(Task&) -> bool         task.packet holds the input; true if it needs detection
+    //   lane(const Task&) -> size_t    detection lane (staged), taken modulo lanes()
+    //   detect(size_t lane, Task&)     stage 2
+    //   boundary(size_t lane)          between batches and when idle (engine refresh)
+    template <typename Pull, typename Burst, typename Prepare, typename Lane, typename Detect, typename Boundary>
+    void run(const std::atomic<bool>& stop, Pull&& pull, Burst&& burst, Prepare&& prepare, Lane&& lane,
+             Detect&& detect, Boundary&& boundary) {
+        if (config_.mode == PipelineConfig::Mode::Fused) {
+            run_fused(stop, pull, burst, prepare, detect, boundary);
+        } else {
+            run_staged(stop, pull, burst, prepare, lane, detect, boundary);
+        }
+    }
+
+    // Without a burst stage
+    template <typename Pull, typename Prepare, typename Lane, typename Detect, typename Boundary>
+    void run(const std::atomic<bool>& stop, Pull&& pull, Prepare&& prepare, Lane&& lane, Detect&& detect,
+             Boundary&& boundary) {
+        run(stop, pull, [](Task*, std::size_t) {}, prepare, lane, detect, boundary);
+    }
+
+private:
+    using Channel = BatchChannel<Task>;
+    using Batch = typename Channel::Batch;
+
+    // Pulls the next packets into tasks[i].packet: waits (calling idle) for
+    // the first, then takes up to tasks.size() that are ready. 0 once stop
+    // is set and the input is drained.
+    template <typename Pull, typename Idle>
+    static std::size_t next(const std::atomic<bool>& stop, Pull& pull, std::vector<Task>& tasks, Idle&& idle) {
+        for (;;) {
+            if (pull(tasks[0].packet)) break;
+            // The producer stops before `stop` is set, so one more pull drains it
+            if (stop.load(std::memory_order_acquire)) {
+                if (pull(tasks[0].packet)) break;
+                return 0;
+            }
+            idle();
+        }
+        std::size_t n = 1;
+        while (n < tasks.size() && pull(tasks[n].packet)) ++n;
+        return n;
+    }
+
+    template <typename Pull, typename Burst, typename Prepare, typename Detect, typename Boundary>
+    void run_fused(const std::atomic<bool>& stop, Pull& pull, Burst& burst, Prepare& prepare, Detect& detect,
+                   Boundary& boundary) {
+        using namespace std::chrono_literals;
+        std::vector<Task> tasks(config_.burst_size);
+        std::size_t batch = 0;
+        auto idle = [&] {
+            batch = 0;
+            boundary(std::size_t{0});
+            std::this_thread::sleep_for(1ms);
+        };
+        while (std::size_t n = next(stop, pull, tasks, idle)) {
+            burst(tasks.data(), n);
+            for (std::size_t t = 0; t < n; ++t) {
+                if (++batch == config_.batch_size) {
+                    batch = 0;
+                    boundary(std::size_t{0});
+                }
+                if (prepare(tasks[t])) detect(std::size_t{0}, tasks[t]);
+            }
+        }
+    }
+
+    template <typename Pull, typename Burst, typename Prepare, typename Lane, typename Detect, typename Boundary>
+    void run_staged(const std::atomic<bool>& stop, Pull& pull, Burst& burst, Prepare& prepare, Lane& lane,
+                    Detect& detect, Boundary& boundary) {
+        using namespace std::chrono_literals;
+        const std::size_t lane_count = config_.detect_threads;
+        // Each channel is allocated from its consumer's CPU, so its batches
+        // sit on the lane's NUMA node
+        std::vector<std::unique_ptr<Channel>> channels;
+        for (std::size_t i = 0; i < lane_count; ++i) {
+            channels.push_back(on_cpu(lane_cpu(i), [&] { return std::make_unique<Channel>(config_.batch_size); }));
+        }
+        std::atomic<bool> lanes_stop{false};
+
+        std::vector<std::thread> threads;
+        for (std::size_t i = 0; i < lane_count; ++i) {
+            threads.emplace_back([&, i] {
+                if (lane_cpu(i) >= 0) pin_current_thread(lane_cpu(i));
+                Channel& channel = *channels[i];
+                for (;;) {
+                    Batch* b = channel.receive();
+                    if (!b) {
+                        boundary(i);
+                        if (lanes_stop.load(std::memory_order_acquire)) {
+                            b = channel.receive();
+                            if (!b) break;
+                        } else {
+                            std::this_thread::sleep_for(50us);
+                            continue;
+                        }
+                    }
+                    for (std::size_t t = 0; t < b->size; ++t) detect(i, b->items[t]);
+                    channel.recycle(b);
+                    boundary(i);
+                }
+            });
+        }
+
+        // Open batch per lane; partial batches are flushed whenever the input runs dry
+        std::vector<Batch*> open(lane_count, nullptr);
+        auto flush = [&](std::size_t l) {
+            if (!open[l] || open[l]->size == 0) return;
+            channels[l]->publish(open[l]);
+            open[l] = nullptr;
+            PipelineStats::bump(stats_.batches);
+        };
+        auto flush_all = [&] {
+            for (std::size_t l = 0; l < lane_count; ++l) flush(l);
+        };
+        auto idle = [&] {
+            flush_all();
+            std::this_thread::sleep_for(1ms);
+        };
+
+        std::vector<Task> tasks(config_.burst_size);
+        while (std::size_t n = next(stop, pull, tasks, idle)) {
+            burst(tasks.data(), n);
+            for (std::size_t t = 0; t < n; ++t) {
+                Task& task = tasks[t];
+                if (!prepare(task)) continue;
+                std::size_t l = static_cast<std::size_t>(lane(static_cast<const Task&>(task))) % lane_count;
+                while (!open[l]) {
+                    open[l] = channels[l]->acquire();
+                    if (!open[l]) {
+                        PipelineStats::bump(stats_.lane_stalls);
+                        std::this_thread::yield();
+                    }
+                }
+                // Swap, so the slot's old buffers come back for the next pull
+                std::swap(open[l]->items[open[l]->size++], task);
+                if (open[l]->size == config_.batch_size) flush(l);
+            }
+        }
+        flush_all();
+        lanes_stop.store(true, std::memory_order_release);
+        for (auto& t : threads) t.join();
+    }
+
+    PipelineConfig config_;
+    PipelineStats stats_;
+};
+
+} // namespace core
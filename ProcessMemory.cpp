@@ -0,0 +1,58 @@
+#include "core/ProcessMemory.hpp"
+
+#ifdef _WIN32
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#include <psapi.h>
+#pragma comment(lib, "psapi.lib")
+#elif defined(__linux__)
+#include <fstream>
+#include <string>
+#else
+#include <sys/resource.h>
+#endif
+
+namespace core {
+
+bool query_process_memory(ProcessMemory& out) {
+#ifdef _WIN32
+    PROCESS_MEMORY_COUNTERS counters{};
+    if (!GetProcessMemoryInfo(GetCurrentProcess(), &counters, sizeof(counters))) return false;
+    out.resident_bytes = counters.WorkingSetSize;
+    out.peak_bytes = counters.PeakWorkingSetSize;
+    return true;
+#elif defined(__linux__)
+    // VmRSS / VmHWM are reported in kB
+    std::ifstream status("/proc/self/status");
+    if (!status.is_open()) return false;
+    std::string line;
+    bool have_rss = false, have_peak = false;
+    while (std::getline(status, line)) {
+        if (line.rfind("VmRSS:", 0) == 0) {
+            out.resident_bytes = std::stoull(line.substr(6)) * 1024;
+            have_rss = true;
+        } else if (line.rfind("VmHWM:", 0) == 0) {
+            out.peak_bytes = std::stoull(line.substr(6)) * 1024;
+            have_peak = true;
+        }
+    }
+    return have_rss && have_peak;
+#else
+    struct rusage usage{};
+    if (getrusage(RUSAGE_SELF, &usage) != 0) return false;
+#ifdef __APPLE__
+    out.peak_bytes = static_cast<std::size_t>(usage.ru_maxrss); // bytes on macOS
+#else
+    out.peak_bytes = static_cast<std::size_t>(usage.ru_maxrss) * 1024;
+#endif
+    out.resident_bytes = out.peak_bytes; // no portable current-RSS query
+    return true;
+#endif
+}
+
+} // namespace core
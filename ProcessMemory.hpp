@@ -0,0 +1,14 @@
+#pragma once
+#include <cstddef>
+
+namespace core {
+
+struct ProcessMemory {
+    std::size_t resident_bytes{0}; // current working set / RSS
+    std::size_t peak_bytes{0};     // peak working set / RSS since process start
+};
+
+// Returns false if the platform doesn't expose the numbers
+bool query_process_memory(ProcessMemory& out);
+
+} // namespace core
@@ -0,0 +1,945 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace core { namespace dsa {
+
+// PCRE-subset regular expressions for payload signatures.
+//
+// Supported: literals, escapes (\d \w \s \D \W \S \t \n \r \f \v \e \xHH and
+// escaped punctuation), '.', bracket classes with ranges and negation,
+// groups ( ), (?: ), (?<name> ), alternation, the quantifiers * + ? {n}
+// {n,} {n,m} (lazy forms accepted), and the anchors ^ \A $ \z \Z.
+// Flags: 'i' (ASCII case-insensitive) and 's' ('.' also matches '\n').
+// Backreferences, lookaround and word boundaries are rejected at compile
+// time.
+//
+// A compiled Regex is immutable: it holds a Thompson NFA plus the literals
+// every match must contain. Searching uses a lazily built DFA stored in a
+// caller-owned RegexCache, so one Regex can be shared between threads as
+// long as each thread brings its own cache. The cache is size-capped; when
+// it overflows too often the search falls back to NFA simulation.
+
+class Regex;
+
+class RegexCache {
+public:
+    explicit RegexCache(std::size_t max_bytes = 64 * 1024, std::size_t max_resets = 4)
+        : max_bytes_(max_bytes), max_resets_(max_resets) {}
+
+    std::size_t state_count() const { return flags_.size(); }
+    std::size_t memory_usage() const { return memory_; }
+    std::size_t reset_count() const { return resets_; }
+    bool nfa_only() const { return nfa_only_; }
+
+private:
+    friend class Regex;
+
+    static constexpr std::uint8_t kAccept = 1;      // match already seen
+    static constexpr std::uint8_t kAcceptAtEnd = 2; // match if input ends here
+    static constexpr std::uint8_t kDead = 4;        // no match can follow
+
+    void clear() {
+        trans_.clear();
+        sets_.clear();
+        flags_.clear();
+        index_.clear();
+        memory_ = 0;
+    }
+
+    std::size_t max_bytes_;
+    std::size_t max_resets_;
+    const Regex* owner_{nullptr};
+    std::size_t resets_{0};
+    bool nfa_only_{false};
+
+    std::vector<std::int32_t> trans_;             // state * classes -> state, -1 unknown
+    std::vector<std::vector<std::uint32_t>> sets_; // NFA states of each DFA state
+    std::vector<std::uint8_t> flags_;
+    std::unordered_map<std::string, std::int32_t> index_;
+    std::int32_t start_{-1};
+    std::size_t memory_{0};
+
+    // Scratch for closure computation and NFA simulation
+    std::vector<std::uint32_t> mark_;
+    std::uint32_t gen_{0};
+    std::vector<std::uint32_t> stack_;
+    std::vector<std::uint32_t> cur_;
+    std::vector<std::uint32_t> next_;
+};
+
+class Regex {
+    using ByteSet = std::array<std::uint64_t, 4>;
+
+    struct State {
+        enum Kind : std::uint8_t { Byte, Split, Empty, Bol, Eol, Match };
+        Kind kind{Empty};
+        std::uint32_t out{0};
+        std::uint32_t out1{0};
+        std::uint32_t set{0}; // index into sets_ for Byte states
+    };
+
+    struct Node {
+        enum Kind : std::uint8_t { Empty, Set, Concat, Alt, Repeat, Bol, Eol };
+        Kind kind{Empty};
+        ByteSet set{};
+        std::vector<std::uint32_t> kids{};
+        int min{0};
+        int max{0}; // -1 = unbounded
+    };
+
+    struct LiteralInfo {
+        bool has_exact{false};
+        std::vector<std::string> exact{};    // node matches exactly one of these
+        std::vector<std::string> prefix{};   // every match starts with one of these
+        std::vector<std::string> required{}; // every match contains one of these
+    };
+
+public:
+    static constexpr std::size_t kMaxNfaStates = 16384;
+    static constexpr std::size_t kMaxLiteralSet = 16;
+
+    // Compile a pattern; flags is a string of PCRE modifier letters ("i", "s").
+    bool compile(std::string_view pattern, std::string_view flags = {}) {
+        *this = Regex{};
+        pattern_ = std::string(pattern);
+        for (char f : flags) {
+            if (f == 'i') case_insensitive_ = true;
+            else if (f == 's') dot_all_ = true;
+            else return fail(std::string("unsupported flag '") + f + "'");
+        }
+
+        src_ = pattern;
+        pos_ = 0;
+        std::uint32_t root = 0;
+        if (!parse_alt(root, 0)) return false;
+        if (pos_ != src_.size()) return fail("unmatched ')'");
+
+        LiteralInfo info = literal_info(root);
+        if (info.has_exact) promote_exact(info, info.required);
+        required_literals_ = std::move(info.required);
+
+        build_byte_classes();
+        states_.push_back(State{State::Match, 0, 0, 0});
+        std::uint32_t match = 0;
+        std::uint32_t start = 0;
+        if (!emit(root, match, start)) return false;
+        start_ = start;
+
+        nodes_.clear();
+        nodes_.shrink_to_fit();
+        compiled_ = true;
+        return true;
+    }
+
+    bool compiled() const { return compiled_; }
+    const std::string& error() const { return error_; }
+    const std::string& pattern() const { return pattern_; }
+    std::size_t state_count() const { return states_.size(); }
+
+    // Approximate heap bytes of the compiled program (excludes per-thread caches)
+    std::size_t memory_usage() const {
+        std::size_t bytes = states_.capacity() * sizeof(State) + sets_.capacity() * sizeof(ByteSet) +
+                            pattern_.capacity();
+        for (const auto& l : required_literals_) bytes += sizeof(std::string) + l.capacity();
+        return bytes;
+    }
+
+    // Any match must contain at least one of these strings. Empty when no
+    // useful literal could be extracted and the regex must run unfiltered.
+    const std::vector<std::string>& required_literals() const { return required_literals_; }
+
+    // Unanchored search for the earliest match end. Returns true on match and
+    // stores the end offset of the match in match_end when non-null.
+    bool search(std::string_view text, RegexCache& cache, std::size_t* match_end = nullptr) const {
+        if (!compiled_) return false;
+        if (cache.owner_ != this) attach(cache);
+        if (cache.nfa_only_) return run_nfa(text, 0, initial_set(cache), cache, match_end);
+
+        const std::size_t k = class_count_;
+        std::int32_t s = cache.start_;
+        for (std::size_t i = 0; i < text.size(); ++i) {
+            std::uint8_t f = cache.flags_[s];
+            if (f & RegexCache::kAccept) {
+                if (match_end) *match_end = i;
+                return true;
+            }
+            if (f & RegexCache::kDead) return false;
+
+            std::uint8_t c = byte_class_[static_cast<std::uint8_t>(text[i])];
+            std::int32_t next = cache.trans_[s * k + c];
+            if (next < 0) {
+                next = transition(cache, s, c);
+                if (next < 0) {
+                    // DFA abandoned; continue from the same NFA position
+                    std::vector<std::uint32_t> set = std::move(cache.cur_);
+                    return run_nfa(text, i + 1, std::move(set), cache, match_end);
+                }
+            }
+            s = next;
+        }
+
+        if (cache.flags_[s] & (RegexCache::kAccept | RegexCache::kAcceptAtEnd)) {
+            if (match_end) *match_end = text.size();
+            return true;
+        }
+        return false;
+    }
+
+private:
+    bool fail(std::string msg) {
+        error_ = std::move(msg);
+        if (!pattern_.empty()) error_ += " in /" + pattern_ + "/";
+        compiled_ = false;
+        return false;
+    }
+
+    // ---- byte sets ----
+
+    static void set_bit(ByteSet& s, unsigned b) { s[b >> 6] |= std::uint64_t{1} << (b & 63); }
+    static bool test_bit(const ByteSet& s, unsigned b) { return (s[b >> 6] >> (b & 63)) & 1; }
+    static void set_range(ByteSet& s, unsigned lo, unsigned hi) { for (unsigned b = lo; b <= hi; ++b) set_bit(s, b); }
+    static void invert(ByteSet& s) { for (auto& w : s) w = ~w; }
+    static void merge(ByteSet& s, const ByteSet& o) { for (int i = 0; i < 4; ++i) s[i] |= o[i]; }
+
+    static std::size_t count(const ByteSet& s) {
+        std::size_t n = 0;
+        for (unsigned b = 0; b < 256; ++b) n += test_bit(s, b);
+        return n;
+    }
+
+    void fold_case(ByteSet& s) const {
+        if (!case_insensitive_) return;
+        for (unsigned b = 'a'; b <= 'z'; ++b) {
+            if (test_bit(s, b) || test_bit(s, b - 32)) {
+                set_bit(s, b);
+                set_bit(s, b - 32);
+            }
+        }
+    }
+
+    // ---- parser ----
+
+    bool at_end() const { return pos_ >= src_.size(); }
+    char peek() const { return src_[pos_]; }
+
+    std::uint32_t add_node(Node n) {
+        nodes_.push_back(std::move(n));
+        return static_cast<std::uint32_t>(nodes_.size() - 1);
+    }
+
+    bool parse_alt(std::uint32_t& out, int depth) {
+        if (depth > 128) return fail("nesting too deep");
+        std::vector<std::uint32_t> branches;
+        while (true) {
+            std::uint32_t branch = 0;
+            if (!parse_concat(branch, depth)) return false;
+            branches.push_back(branch);
+            if (at_end() || peek() != '|') break;
+            ++pos_;
+        }
+        if (branches.size() == 1) {
+            out = branches[0];
+        } else {
+            Node n;
+            n.kind = Node::Alt;
+            n.kids = std::move(branches);
+            out = add_node(std::move(n));
+        }
+        return true;
+    }
+
+    bool parse_concat(std::uint32_t& out, int depth) {
+        Node n;
+        n.kind = Node::Concat;
+        while (!at_end() && peek() != '|' && peek() != ')') {
+            std::uint32_t atom = 0;
+            if (!parse_atom(atom, depth)) return false;
+            if (!parse_quantifiers(atom)) return false;
+            n.kids.push_back(atom);
+        }
+        if (n.kids.empty()) {
+            out = add_node(Node{});
+        } else if (n.kids.size() == 1) {
+            out = n.kids[0];
+        } else {
+            out = add_node(std::move(n));
+        }
+        return true;
+    }
+
+    bool parse_number(int& value) {
+        std::size_t start = pos_;
+        value = 0;
+        while (!at_end() && peek() >= '0' && peek() <= '9') {
+            value = value * 10 + (peek() - '0');
+            if (value > 1000) return false;
+            ++pos_;
+        }
+        return pos_ > start;
+    }
+
+    bool parse_quantifiers(std::uint32_t& atom) {
+        bool quantified = false;
+        while (!at_end()) {
+            int min = 0;
+            int max = 0;
+            char c = peek();
+            if (c == '*') { min = 0; max = -1; ++pos_; }
+            else if (c == '+') { min = 1; max = -1; ++pos_; }
+            else if (c == '?') { min = 0; max = 1; ++pos_; }
+            else if (c == '{') {
+                // PCRE treats a '{' that doesn't start a valid quantifier as a literal
+                std::size_t save = pos_;
+                ++pos_;
+                bool ok = parse_number(min);
+                if (ok && !at_end() && peek() == ',') {
+                    ++pos_;
+                    if (!at_end() && peek() == '}') max = -1;
+                    else ok = parse_number(max) && max >= min;
+                } else {
+                    max = min;
+                }
+                if (!ok || at_end() || peek() != '}') {
+                    pos_ = save;
+                    return true;
+                }
+                ++pos_;
+            } else {
+                return true;
+            }
+
+            if (!at_end() && peek() == '?') ++pos_; // lazy: same language
+            else if (!at_end() && peek() == '+') return fail("possessive quantifiers not supported");
+            if (quantified) return fail("nothing to repeat");
+            quantified = true;
+
+            Node n;
+            n.kind = Node::Repeat;
+            n.kids.push_back(atom);
+            n.min = min;
+            n.max = max;
+            atom = add_node(std::move(n));
+        }
+        return true;
+    }
+
+    bool parse_atom(std::uint32_t& out, int depth) {
+        char c = src_[pos_++];
+        Node n;
+        switch (c) {
+            case '(': {
+                if (!at_end() && peek() == '?') {
+                    ++pos_;
+                    if (at_end()) return fail("bad group");
+                    char g = src_[pos_++];
+                    if (g == 'P' && !at_end() && peek() == '<') g = src_[pos_++];
+                    if (g == '<') {
+                        if (!at_end() && (peek() == '=' || peek() == '!')) return fail("lookbehind not supported");
+                        while (!at_end() && peek() != '>') ++pos_;
+                        if (at_end()) return fail("bad group name");
+                        ++pos_;
+                    } else if (g == 'i' && !at_end() && peek() == ')' && pos_ == 3) {
+                        // leading (?i) is the same as the 'i' flag
+                        ++pos_;
+                        case_insensitive_ = true;
+                        out = add_node(Node{});
+                        return true;
+                    } else if (g != ':') {
+                        return fail("unsupported group type");
+                    }
+                }
+                if (!parse_alt(out, depth + 1)) return false;
+                if (at_end() || peek() != ')') return fail("missing ')'");
+                ++pos_;
+                return true;
+            }
+            case ')':
+                return fail("unmatched ')'");
+            case '*': case '+': case '?':
+                return fail("quantifier without operand");
+            case '^':
+                n.kind = Node::Bol;
+                break;
+            case '$':
+                n.kind = Node::Eol;
+                break;
+            case '.':
+                n.kind = Node::Set;
+                invert(n.set);
+                if (!dot_all_) n.set[0] &= ~(std::uint64_t{1} << '\n');
+                break;
+            case '[':
+                n.kind = Node::Set;
+                if (!parse_class(n.set)) return false;
+                break;
+            case '\\': {
+                if (at_end()) return fail("trailing backslash");
+                char e = src_[pos_++];
+                if (e == 'A') { n.kind = Node::Bol; break; }
+                if (e == 'z' || e == 'Z') { n.kind = Node::Eol; break; }
+                n.kind = Node::Set;
+                if (!parse_escape(e, n.set)) return false;
+                break;
+            }
+            default:
+                n.kind = Node::Set;
+                set_bit(n.set, static_cast<std::uint8_t>(c));
+                break;
+        }
+        if (n.kind == Node::Set) fold_case(n.set);
+        out = add_node(std::move(n));
+        return true;
+    }
+
+    static int hex_value(char c) {
+        if (c >= '0' && c <= '9') return c - '0';
+        if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+        if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+        return -1;
+    }
+
+    // Parses the escape after '\'. Sets single_byte when it denotes one byte.
+    bool parse_escape(char e, ByteSet& set, int* single_byte = nullptr) {
+        ByteSet tmp{};
+        int byte = -1;
+        switch (e) {
+            case 'd': case 'D':
+                set_range(tmp, '0', '9');
+                break;
+            case 'w': case 'W':
+                set_range(tmp, '0', '9');
+                set_range(tmp, 'a', 'z');
+                set_range(tmp, 'A', 'Z');
+                set_bit(tmp, '_');
+                break;
+            case 's': case 'S':
+                for (unsigned b : {' ', '\t', '\n', '\r', '\f', '\v'}) set_bit(tmp, b);
+                break;
+            case 't': byte = '\t'; break;
+            case 'n': byte = '\n'; break;
+            case 'r': byte = '\r'; break;
+            case 'f': byte = '\f'; break;
+            case 'v': byte = '\v'; break;
+            case 'e': byte = 0x1B; break;
+            case '0': byte = 0; break;
+            case 'x': {
+                if (pos_ + 2 > src_.size()) return fail("bad \\x escape");
+                int hi = hex_value(src_[pos_]);
+                int lo = hex_value(src_[pos_ + 1]);
+                if (hi < 0 || lo < 0) return fail("bad \\x escape");
+                pos_ += 2;
+                byte = hi * 16 + lo;
+                break;
+            }
+            default:
+                if ((e >= 'a' && e <= 'z') || (e >= 'A' && e <= 'Z') || (e >= '1' && e <= '9')) {
+                    return fail(std::string("unsupported escape \\") + e);
+                }
+                byte = static_cast<std::uint8_t>(e);
+                break;
+        }
+        if (byte >= 0) set_bit(tmp, static_cast<unsigned>(byte));
+        else if (e == 'D' || e == 'W' || e == 'S') invert(tmp);
+        if (single_byte) *single_byte = byte;
+        merge(set, tmp);
+        return true;
+    }
+
+    bool parse_class(ByteSet& set) {
+        bool negate = false;
+        if (!at_end() && peek() == '^') { negate = true; ++pos_; }
+        bool first = true;
+        while (true) {
+            if (at_end()) return fail("missing ']'");
+            char c = src_[pos_++];
+            if (c == ']' && !first) break;
+            first = false;
+
+            int lo = static_cast<std::uint8_t>(c);
+            if (c == '\\') {
+                if (at_end()) return fail("trailing backslash");
+                if (!parse_escape(src_[pos_++], set, &lo)) return false;
+                if (lo < 0) continue; // \d, \w, ... inside a class
+            } else if (c == '[' && !at_end() && peek() == ':') {
+                return fail("POSIX classes not supported");
+            }
+
+            // Range a-z (a trailing '-' is literal)
+            if (pos_ + 1 < src_.size() && peek() == '-' && src_[pos_ + 1] != ']') {
+                ++pos_;
+                char h = src_[pos_++];
+                int hi = static_cast<std::uint8_t>(h);
+                if (h == '\\') {
+                    if (at_end()) return fail("trailing backslash");
+                    ByteSet ignored{};
+                    if (!parse_escape(src_[pos_++], ignored, &hi)) return false;
+                    if (hi < 0) return fail("bad class range");
+                }
+                if (hi < lo) return fail("bad class range");
+                set_range(set, static_cast<unsigned>(lo), static_cast<unsigned>(hi));
+            } else {
+                set_bit(set, static_cast<unsigned>(lo));
+            }
+        }
+        fold_case(set);
+        if (negate) invert(set);
+        return true;
+    }
+
+    // ---- literal extraction ----
+
+    static std::size_t min_length(const std::vector<std::string>& v) {
+        std::size_t n = SIZE_MAX;
+        for (const auto& s : v) n = std::min(n, s.size());
+        return v.empty() ? 0 : n;
+    }
+
+    // Keeps the more selective of two any-of literal sets: longer shortest
+    // literal wins, then fewer alternatives.
+    static void keep_better(std::vector<std::string>& best, std::vector<std::string> cand) {
+        if (cand.empty()) return;
+        std::size_t a = min_length(best);
+        std::size_t b = min_length(cand);
+        if (best.empty() || b > a || (b == a && cand.size() < best.size())) best = std::move(cand);
+    }
+
+    static void promote_exact(const LiteralInfo& info, std::vector<std::string>& best) {
+        if (info.exact.empty()) return;
+        for (const auto& s : info.exact) if (s.empty()) return;
+        keep_better(best, info.exact);
+    }
+
+    static void dedupe(std::vector<std::string>& v) {
+        std::sort(v.begin(), v.end());
+        v.erase(std::unique(v.begin(), v.end()), v.end());
+    }
+
+    static bool cross(const std::vector<std::string>& a, const std::vector<std::string>& b,
+                      std::vector<std::string>& out) {
+        if (a.size() * b.size() > kMaxLiteralSet) return false;
+        out.clear();
+        for (const auto& x : a) for (const auto& y : b) out.push_back(x + y);
+        dedupe(out);
+        return true;
+    }
+
+    static const std::vector<std::string>& starts(const LiteralInfo& k) {
+        return k.has_exact ? k.exact : k.prefix;
+    }
+
+    static void promote(std::vector<std::string>& best, std::vector<std::string> cand) {
+        LiteralInfo tmp;
+        tmp.exact = std::move(cand);
+        promote_exact(tmp, best);
+    }
+
+    LiteralInfo literal_info(std::uint32_t id) const {
+        const Node& n = nodes_[id];
+        LiteralInfo r;
+        switch (n.kind) {
+            case Node::Empty:
+            case Node::Bol:
+            case Node::Eol:
+                r.has_exact = true;
+                r.exact.push_back({});
+                break;
+            case Node::Set: {
+                if (count(n.set) > 10) break;
+                r.has_exact = true;
+                for (unsigned b = 0; b < 256; ++b) {
+                    if (test_bit(n.set, b)) r.exact.push_back(std::string(1, static_cast<char>(b)));
+                }
+                break;
+            }
+            case Node::Concat: {
+                // Grow runs of exact children by cross product; when a run
+                // ends, extend it by the next child's known prefix.
+                bool whole_exact = true;
+                bool run_open = false;
+                bool prefix_open = true;
+                std::vector<std::string> run;
+                for (std::uint32_t kid : n.kids) {
+                    LiteralInfo k = literal_info(kid);
+                    std::vector<std::string> joined;
+                    if (k.has_exact && run_open && cross(run, k.exact, joined)) {
+                        run = std::move(joined);
+                        continue;
+                    }
+                    if (run_open) {
+                        whole_exact = false;
+                        std::vector<std::string> ext;
+                        bool extended = !starts(k).empty() && cross(run, starts(k), ext);
+                        if (prefix_open) {
+                            r.prefix = extended ? ext : run;
+                            prefix_open = false;
+                        }
+                        promote(r.required, std::move(run));
+                        if (extended) promote(r.required, std::move(ext));
+                    } else if (prefix_open) {
+                        r.prefix = starts(k);
+                        prefix_open = false;
+                    }
+                    run_open = k.has_exact;
+                    if (k.has_exact) {
+                        run = std::move(k.exact);
+                    } else {
+                        whole_exact = false;
+                        keep_better(r.required, std::move(k.required));
+                    }
+                }
+                if (run_open && whole_exact) {
+                    r.has_exact = true;
+                    r.exact = std::move(run);
+                } else if (run_open) {
+                    promote(r.required, std::move(run));
+                }
+                break;
+            }
+            case Node::Alt: {
+                bool all_exact = true;
+                bool all_prefix = true;
+                bool all_required = true;
+                std::vector<std::string> exact;
+                std::vector<std::string> prefix;
+                std::vector<std::string> required;
+                for (std::uint32_t kid : n.kids) {
+                    LiteralInfo k = literal_info(kid);
+                    std::vector<std::string> best = k.required;
+                    if (k.has_exact) promote_exact(k, best);
+                    if (k.has_exact) exact.insert(exact.end(), k.exact.begin(), k.exact.end());
+                    else all_exact = false;
+                    if (starts(k).empty()) all_prefix = false;
+                    else prefix.insert(prefix.end(), starts(k).begin(), starts(k).end());
+                    if (best.empty()) all_required = false;
+                    else required.insert(required.end(), best.begin(), best.end());
+                }
+                dedupe(exact);
+                dedupe(prefix);
+                dedupe(required);
+                if (all_exact && exact.size() <= kMaxLiteralSet) {
+                    r.has_exact = true;
+                    r.exact = std::move(exact);
+                    break;
+                }
+                if (all_prefix && prefix.size() <= kMaxLiteralSet) r.prefix = std::move(prefix);
+                if (all_required && required.size() <= kMaxLiteralSet) r.required = std::move(required);
+                break;
+            }
+            case Node::Repeat: {
+                LiteralInfo k = literal_info(n.kids[0]);
+                if (n.min == 0) {
+                    if (n.max == 1 && k.has_exact && k.exact.size() < kMaxLiteralSet) {
+                        r.has_exact = true;
+                        r.exact = std::move(k.exact);
+                        r.exact.push_back({});
+                        dedupe(r.exact);
+                    }
+                    break;
+                }
+                r.required = k.required;
+                if (!k.has_exact) {
+                    r.prefix = std::move(k.prefix);
+                    break;
+                }
+                // x{n} stays exact while small; otherwise the first copies are a prefix
+                std::vector<std::string> acc = k.exact;
+                std::vector<std::string> joined;
+                int copies = 1;
+                while (copies < n.min && cross(acc, k.exact, joined)) {
+                    acc = std::move(joined);
+                    ++copies;
+                }
+                if (copies == n.min && n.max == n.min) {
+                    r.has_exact = true;
+                    r.exact = std::move(acc);
+                } else {
+                    r.prefix = acc;
+                    promote(r.required, std::move(acc));
+                }
+                break;
+            }
+        }
+        return r;
+    }
+
+    // ---- NFA construction ----
+
+    void build_byte_classes() {
+        std::vector<ByteSet> sets;
+        for (const auto& n : nodes_) if (n.kind == Node::Set) sets.push_back(n.set);
+
+        std::array<std::uint32_t, 256> cls{};
+        std::uint32_t classes = 1;
+        for (const auto& s : sets) {
+            std::vector<std::int32_t> remap(classes * 2, -1);
+            std::uint32_t next = 0;
+            for (unsigned b = 0; b < 256; ++b) {
+                std::uint32_t key = cls[b] * 2 + (test_bit(s, b) ? 1 : 0);
+                if (remap[key] < 0) remap[key] = static_cast<std::int32_t>(next++);
+                cls[b] = static_cast<std::uint32_t>(remap[key]);
+            }
+            classes = next;
+        }
+
+        class_count_ = classes;
+        class_rep_.assign(classes, 0);
+        for (unsigned b = 256; b-- > 0;) {
+            byte_class_[b] = static_cast<std::uint8_t>(cls[b]);
+            class_rep_[cls[b]] = static_cast<std::uint8_t>(b);
+        }
+    }
+
+    std::uint32_t add_state(State s) {
+        states_.push_back(s);
+        return static_cast<std::uint32_t>(states_.size() - 1);
+    }
+
+    // Continuation-passing Thompson construction: emits `id` so that it
+    // continues into `next` and stores its entry state in `entry`.
+    bool emit(std::uint32_t id, std::uint32_t next, std::uint32_t& entry) {
+        if (states_.size() > kMaxNfaStates) return fail("pattern too large");
+        const Node& n = nodes_[id];
+        switch (n.kind) {
+            case Node::Empty:
+                entry = next;
+                return true;
+            case Node::Bol:
+                entry = add_state(State{State::Bol, next, 0, 0});
+                return true;
+            case Node::Eol:
+                entry = add_state(State{State::Eol, next, 0, 0});
+                return true;
+            case Node::Set:
+                sets_.push_back(n.set);
+                entry = add_state(State{State::Byte, next, 0, static_cast<std::uint32_t>(sets_.size() - 1)});
+                return true;
+            case Node::Concat: {
+                std::uint32_t cur = next;
+                for (std::size_t i = n.kids.size(); i-- > 0;) {
+                    if (!emit(n.kids[i], cur, cur)) return false;
+                }
+                entry = cur;
+                return true;
+            }
+            case Node::Alt: {
+                std::uint32_t cur = 0;
+                if (!emit(n.kids.back(), next, cur)) return false;
+                for (std::size_t i = n.kids.size() - 1; i-- > 0;) {
+                    std::uint32_t branch = 0;
+                    if (!emit(n.kids[i], next, branch)) return false;
+                    cur = add_state(State{State::Split, branch, cur, 0});
+                }
+                entry = cur;
+                return true;
+            }
+            case Node::Repeat: {
+                std::uint32_t kid = n.kids[0];
+                std::uint32_t cur = next;
+                if (n.max < 0) {
+                    std::uint32_t loop = add_state(State{State::Split, 0, next, 0});
+                    std::uint32_t body = 0;
+                    if (!emit(kid, loop, body)) return false;
+                    states_[loop].out = body;
+                    cur = loop;
+                } else {
+                    for (int i = n.min; i < n.max; ++i) {
+                        std::uint32_t body = 0;
+                        if (!emit(kid, cur, body)) return false;
+                        cur = add_state(State{State::Split, body, next, 0});
+                    }
+                }
+                for (int i = 0; i < n.min; ++i) {
+                    if (!emit(kid, cur, cur)) return false;
+                }
+                entry = cur;
+                return true;
+            }
+        }
+        return fail("internal error");
+    }
+
+    // ---- lazy DFA ----
+
+    // Adds the epsilon closure of s to out, keeping only states that matter
+    // for transitions or acceptance (Byte, Eol, Match).
+    void closure(RegexCache& c, std::uint32_t s, bool at_start, std::vector<std::uint32_t>& out,
+                 bool at_end = false) const {
+        c.stack_.clear();
+        c.stack_.push_back(s);
+        while (!c.stack_.empty()) {
+            std::uint32_t x = c.stack_.back();
+            c.stack_.pop_back();
+            if (c.mark_[x] == c.gen_) continue;
+            c.mark_[x] = c.gen_;
+            const State& st = states_[x];
+            switch (st.kind) {
+                case State::Eol:
+                    if (at_end) c.stack_.push_back(st.out);
+                    else out.push_back(x);
+                    break;
+                case State::Byte:
+                case State::Match:
+                    out.push_back(x);
+                    break;
+                case State::Split:
+                    c.stack_.push_back(st.out1);
+                    c.stack_.push_back(st.out);
+                    break;
+                case State::Empty:
+                    c.stack_.push_back(st.out);
+                    break;
+                case State::Bol:
+                    if (at_start) c.stack_.push_back(st.out);
+                    break;
+            }
+        }
+    }
+
+    void next_gen(RegexCache& c) const {
+        if (++c.gen_ == 0) {
+            std::fill(c.mark_.begin(), c.mark_.end(), 0);
+            c.gen_ = 1;
+        }
+    }
+
+    std::vector<std::uint32_t> initial_set(RegexCache& c) const {
+        std::vector<std::uint32_t> set;
+        next_gen(c);
+        closure(c, start_, true, set);
+        std::sort(set.begin(), set.end());
+        return set;
+    }
+
+    // Advances an NFA state set over one byte, re-seeding the unanchored start.
+    void step(RegexCache& c, const std::vector<std::uint32_t>& from, std::uint8_t byte,
+              std::vector<std::uint32_t>& to) const {
+        to.clear();
+        next_gen(c);
+        for (std::uint32_t x : from) {
+            const State& st = states_[x];
+            if (st.kind == State::Byte && test_bit(sets_[st.set], byte)) closure(c, st.out, false, to);
+        }
+        closure(c, start_, false, to);
+        std::sort(to.begin(), to.end());
+    }
+
+    std::uint8_t set_flags(RegexCache& c, const std::vector<std::uint32_t>& set) const {
+        std::uint8_t f = set.empty() ? RegexCache::kDead : 0;
+        bool has_eol = false;
+        for (std::uint32_t x : set) {
+            if (states_[x].kind == State::Match) f |= RegexCache::kAccept;
+            else if (states_[x].kind == State::Eol) has_eol = true;
+        }
+        if (has_eol && !(f & RegexCache::kAccept)) {
+            // Eol only holds at end of input: see whether Match is reachable through it
+            std::vector<std::uint32_t> tail;
+            next_gen(c);
+            for (std::uint32_t x : set) {
+                if (states_[x].kind == State::Eol) closure(c, x, false, tail, true);
+            }
+            for (std::uint32_t t : tail) {
+                if (states_[t].kind == State::Match) f |= RegexCache::kAcceptAtEnd;
+            }
+        }
+        return f;
+    }
+
+    std::int32_t intern(RegexCache& c, const std::vector<std::uint32_t>& set) const {
+        std::string key(reinterpret_cast<const char*>(set.data()), set.size() * sizeof(std::uint32_t));
+        auto it = c.index_.find(key);
+        if (it != c.index_.end()) return it->second;
+
+        std::size_t cost = class_count_ * sizeof(std::int32_t) + key.size() * 2 + 96;
+        if (c.memory_ + cost > c.max_bytes_ && !c.flags_.empty()) return -1;
+
+        std::int32_t id = static_cast<std::int32_t>(c.flags_.size());
+        c.flags_.push_back(set_flags(c, set));
+        c.trans_.resize(c.trans_.size() + class_count_, -1);
+        c.sets_.push_back(set);
+        c.index_.emplace(std::move(key), id);
+        c.memory_ += cost;
+        return id;
+    }
+    void attach(RegexCache& c) const {
+        c.clear();
+        c.owner_ = this;
+        c.resets_ = 0;
+        c.nfa_only_ = false;
+        c.mark_.assign(states_.size(), 0);
+        c.gen_ = 0;
+        c.start_ = intern(c, initial_set(c));
+    }
+
+    // Computes and caches the transition from DFA state s on byte class cls.
+    // On cache overflow the cache is flushed and s is re-interned; after too
+    // many flushes the DFA is abandoned (returns -1, NFA set left in c.cur_).
+    std::int32_t transition(RegexCache& c, std::int32_t& s, std::uint8_t cls) const {
+        std::vector<std::uint32_t> next;
+        step(c, c.sets_[s], class_rep_[cls], next);
+        std::int32_t t = intern(c, next);
+        if (t >= 0) {
+            c.trans_[s * class_count_ + cls] = t;
+            return t;
+        }
+
+        if (++c.resets_ <= c.max_resets_) {
+            std::vector<std::uint32_t> from = c.sets_[s];
+            bool was_start = (s == c.start_);
+            c.clear();
+            c.start_ = intern(c, initial_set(c));
+            s = was_start ? c.start_ : intern(c, from);
+            t = s < 0 ? -1 : intern(c, next);
+            if (t >= 0) {
+                c.trans_[s * class_count_ + cls] = t;
+                return t;
+            }
+        }
+        c.nfa_only_ = true;
+        c.cur_ = std::move(next);
+        return -1;
+    }
+
+    bool run_nfa(std::string_view text, std::size_t pos, std::vector<std::uint32_t> set,
+                 RegexCache& c, std::size_t* match_end) const {
+        std::vector<std::uint32_t>& cur = c.cur_;
+        std::vector<std::uint32_t>& nxt = c.next_;
+        cur = std::move(set);
+        for (std::size_t i = pos;; ++i) {
+            std::uint8_t f = set_flags(c, cur);
+            if ((f & RegexCache::kAccept) || (i == text.size() && (f & RegexCache::kAcceptAtEnd))) {
+                if (match_end) *match_end = i;
+                return true;
+            }
+            if (i == text.size() || (f & RegexCache::kDead)) return false;
+            step(c, cur, static_cast<std::uint8_t>(text[i]), nxt);
+            std::swap(cur, nxt);
+        }
+    }
+
+    // Parse state (only valid during compile)
+    std::string_view src_{};
+    std::size_t pos_{0};
+    std::vector<Node> nodes_{};
+
+    std::string pattern_{};
+    std::string error_{};
+    bool case_insensitive_{false};
+    bool dot_all_{false};
+    bool compiled_{false};
+
+    std::vector<State> states_{};
+    std::vector<ByteSet> sets_{};
+    std::uint32_t start_{0};
+    std::array<std::uint8_t, 256> byte_class_{};
+    std::vector<std::uint8_t> class_rep_{};
+    std::size_t class_count_{1};
+    std::vector<std::string> required_literals_{};
+};
+
+}} // namespace core::dsa
@@ -0,0 +1,141 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <vector>
+
+#include "core/Hash.hpp"
+#include "core/Packet.hpp"
+
+namespace detect {
+
+// One match of Engine::match before it is turned into a MatchResult:
+// enough to rebuild the result (and its context) from the same payload
+struct MatchHit {
+    std::uint32_t rule;           // rule index in the engine
+    std::uint32_t position;       // match offset in the payload
+    std::uint32_t context_length; // matched literal length (0 for regex end offsets)
+};
+
+// Everything besides the payload that decides a match outcome: the
+// signature group scanned, the protocol and the flow's address classes
+struct ResultScope {
+    std::uint32_t src_class{0};
+    std::uint32_t dst_class{0};
+    std::uint8_t group{0};
+    std::uint8_t proto{0};
+
+    bool operator==(const ResultScope&) const = default;
+
+    // Seed for the payload hash, each field kept apart rather than folded
+    std::uint64_t seed() const {
+        return core::hash64(std::uint64_t{group} << 8 | proto,
+                            core::hash64(std::uint64_t{src_class} << 32 | dst_class));
+    }
+};
+
+// Written by the owning worker only and read by the stats thread, so plain
+// relaxed load/store pairs suffice
+struct ResultCacheStats {
+    std::atomic<std::uint64_t> lookups{0};
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> saved_bytes{0}; // payload bytes not scanned thanks to a hit
+    std::atomic<std::uint64_t> uncacheable{0}; // outcomes with more than kMaxHits matches or long payloads
+
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Per-worker cache of match outcomes for repeated payloads (beacons,
+// retransmissions, health checks). Indexed by a 64-bit hash of the payload
+// seeded with its ResultScope, but a hit also compares the stored scope
+// and payload bytes: the hash is not collision resistant,
+// and a crafted payload that collided with a benign one would otherwise
+// inherit its "no match". Direct-mapped, fixed size: a colliding payload
+// simply replaces the entry. Payloads over kMaxPayload bytes are not
+// cached. The whole cache is dropped when the engine generation changes.
+class ResultCache {
+public:
+    static constexpr std::size_t kMaxHits = 4;
+    static constexpr std::size_t kMaxPayload = 2048;
+
+    struct alignas(64) Entry {
+        std::uint64_t key{0};
+        ResultScope scope{};
+        std::uint32_t length{0};
+        std::uint8_t count{0};
+        bool valid{false};
+        MatchHit hits[kMaxHits]{};
+    };
+
+    // capacity is rounded up to a power of two; 0 disables the cache
+    explicit ResultCache(std::size_t capacity = 0, ResultCacheStats* stats = nullptr)
+        : capacity_(capacity ? std::bit_ceil(capacity) : 0), stats_(stats ? stats : &own_stats_) {
+        if (capacity_) {
+            entries_ = std::make_unique<Entry[]>(capacity_);
+            payloads_ = std::make_unique<std::vector<std::uint8_t>[]>(capacity_);
+        }
+    }
+
+    bool enabled() const { return capacity_ != 0; }
+
+    // Drops every entry if the outcomes were produced by another engine
+    void sync(std::uint64_t engine_generation) {
+        if (engine_generation == generation_) return;
+        generation_ = engine_generation;
+        for (std::size_t i = 0; i < capacity_; ++i) entries_[i].valid = false;
+    }
+
+    const Entry* find(std::uint64_t key, const ResultScope& scope, core::ByteSpan payload) {
+        ResultCacheStats::bump(stats_->lookups);
+        std::size_t index = key & (capacity_ - 1);
+        const Entry& entry = entries_[index];
+        if (!entry.valid || entry.key != key || !(entry.scope == scope) || entry.length != payload.size()) {
+            return nullptr;
+        }
+        if (payload.size() && std::memcmp(payloads_[index].data(), payload.data(), payload.size()) != 0) return nullptr;
+        ResultCacheStats::bump(stats_->hits);
+        ResultCacheStats::bump(stats_->saved_bytes, payload.size());
+        return &entry;
+    }
+
+    // The payload is copied into the entry; its buffer only grows, so a
+    // warm cache stores without allocating
+    void store(std::uint64_t key, const ResultScope& scope, core::ByteSpan payload, const MatchHit* hits,
+               std::size_t count) {
+        if (count > kMaxHits || payload.size() > kMaxPayload) {
+            ResultCacheStats::bump(stats_->uncacheable);
+            return;
+        }
+        std::size_t index = key & (capacity_ - 1);
+        Entry& entry = entries_[index];
+        payloads_[index].assign(payload.begin(), payload.end());
+        entry.key = key;
+        entry.scope = scope;
+        entry.length = static_cast<std::uint32_t>(payload.size());
+        entry.count = static_cast<std::uint8_t>(count);
+        for (std::size_t i = 0; i < count; ++i) entry.hits[i] = hits[i];
+        entry.valid = true;
+    }
+
+    std::size_t capacity() const { return capacity_; }
+    std::size_t memory_usage() const {
+        std::size_t bytes = sizeof(*this) + capacity_ * (sizeof(Entry) + sizeof(std::vector<std::uint8_t>));
+        for (std::size_t i = 0; i < capacity_; ++i) bytes += payloads_[i].capacity();
+        return bytes;
+    }
+    const ResultCacheStats& stats() const { return *stats_; }
+
+private:
+    std::size_t capacity_;
+    std::unique_ptr<Entry[]> entries_;
+    std::unique_ptr<std::vector<std::uint8_t>[]> payloads_; // bytes of each entry's payload
+    std::uint64_t generation_{0};
+    ResultCacheStats own_stats_;
+    ResultCacheStats* stats_;
+};
+
+} // namespace detect
@@ -106,7 +106,6 @@ public:
 private:
     bool resize() {
         auto old_table = std::move(table_);
-        std::size_t old_size = size_;
         
         capacity_ *= 2;
         mask_ = capacity_ - 1;
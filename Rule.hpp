@@ -1,12 +1,34 @@
 #pragma once
+#include <cstdint>
 #include <string>
 
 namespace detect {
 
+// Alert rate control (rule option threshold=...), counted per rule and
+// tracked address in fixed time windows of `seconds`:
+//   limit      alert on the first `count` hits of each window
+//   threshold  alert on every `count`-th hit
+//   both       alert once per window, when the `count`-th hit is reached
+struct RuleThreshold {
+    enum class Type : std::uint8_t { None, Limit, Threshold, Both };
+    enum class Track : std::uint8_t { BySrc, ByDst, ByRule };
+
+    Type type{Type::None};
+    Track track{Track::BySrc};
+    std::uint32_t count{0};
+    std::uint32_t seconds{0};
+};
+
 struct Rule {
     int id{0};
     std::string message{};
     std::string payload_pattern{}; // naive content match for demo
+    std::string pcre{};            // PCRE-subset regex, verified after its literals hit
+    std::string pcre_flags{};      // PCRE modifier letters ("i", "s")
+    std::uint8_t proto{0};         // IP protocol the rule applies to, 0 = any
+    std::string src{};             // source address filter: CIDRs separated by ',', '!' negates; empty = any
+    std::string dst{};             // destination address filter, same format
+    RuleThreshold threshold{};     // alert rate control; type None = every match alerts
 };
 
 } // namespace detect
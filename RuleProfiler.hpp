@@ -0,0 +1,169 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <iomanip>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <vector>
+
+// Rule profiling hooks are compiled in unless the build defines
+// IDS_RULE_PROFILING=0; compiled in but not enabled they cost one
+// predictable branch per fast-pattern hit and regex verification.
+#ifndef IDS_RULE_PROFILING
+#define IDS_RULE_PROFILING 1
+#endif
+
+#if IDS_RULE_PROFILING && (defined(__x86_64__) || defined(__i386__))
+#include <x86intrin.h>
+#define IDS_PROFILE_RDTSC 1
+#elif IDS_RULE_PROFILING && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#define IDS_PROFILE_RDTSC 1
+#endif
+
+namespace detect {
+
+// Timestamp counter for short intervals: TSC ticks where available, else
+// steady_clock nanoseconds
+inline std::uint64_t profile_ticks() {
+#if defined(IDS_PROFILE_RDTSC)
+    return __rdtsc();
+#else
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                                          std::chrono::steady_clock::now().time_since_epoch())
+                                          .count());
+#endif
+}
+
+struct RuleCounters {
+    std::atomic<std::uint64_t> candidates{0};    // fast-pattern (literal) hits, or queued unfiltered regexes
+    std::atomic<std::uint64_t> verifications{0}; // regex runs
+    std::atomic<std::uint64_t> matches{0};
+    std::atomic<std::uint64_t> ticks{0};         // spent in regex verification
+
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+class RuleProfiler;
+
+// One worker's per-rule counters, indexed by rule index in the engine the
+// worker currently matches with. Written by that worker only; reset when
+// the worker picks up a new engine, so a report covers the rules as they
+// are since the last reload.
+class RuleProfile {
+public:
+    std::uint64_t generation() const { return generation_; }
+
+    RuleCounters& rule(std::size_t index) { return counters_[index]; }
+
+    // Called by the engine when the worker's scratch meets another engine
+    void reset(std::uint64_t engine_generation, std::size_t rule_count);
+
+private:
+    friend class RuleProfiler;
+
+    explicit RuleProfile(std::mutex& registry_mutex) : registry_mutex_(registry_mutex) {}
+
+    std::mutex& registry_mutex_;
+    std::uint64_t generation_{0};
+    std::size_t rule_count_{0};
+    std::unique_ptr<RuleCounters[]> counters_;
+};
+
+// Registry of per-worker profiles, merged when a report is printed
+class RuleProfiler {
+public:
+    RuleProfile& register_thread() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        profiles_.push_back(std::unique_ptr<RuleProfile>(new RuleProfile(mutex_)));
+        return *profiles_.back();
+    }
+
+    // Top rules by verification time (then candidates) for engine, which
+    // must provide generation(), rule_count() and rule(index)
+    template <typename EngineT>
+    void report(const EngineT& engine, std::ostream& out, std::size_t top_n = 20) const {
+#if !IDS_RULE_PROFILING
+        (void)engine;
+        (void)top_n;
+        out << "Rule profiling is compiled out (IDS_RULE_PROFILING=0)\n";
+#else
+        struct Row {
+            std::size_t rule;
+            std::uint64_t candidates, verifications, matches, ticks;
+        };
+        std::vector<Row> rows(engine.rule_count());
+        for (std::size_t i = 0; i < rows.size(); ++i) rows[i] = Row{i, 0, 0, 0, 0};
+        std::size_t workers = 0;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (const auto& profile : profiles_) {
+                if (profile->generation_ != engine.generation() || profile->rule_count_ != rows.size()) continue;
+                ++workers;
+                for (std::size_t i = 0; i < rows.size(); ++i) {
+                    const RuleCounters& c = profile->counters_[i];
+                    rows[i].candidates += c.candidates.load(std::memory_order_relaxed);
+                    rows[i].verifications += c.verifications.load(std::memory_order_relaxed);
+                    rows[i].matches += c.matches.load(std::memory_order_relaxed);
+                    rows[i].ticks += c.ticks.load(std::memory_order_relaxed);
+                }
+            }
+        }
+        std::sort(rows.begin(), rows.end(), [](const Row& a, const Row& b) {
+            return a.ticks != b.ticks ? a.ticks > b.ticks : a.candidates > b.candidates;
+        });
+        std::uint64_t total_ticks = 0;
+        for (const Row& r : rows) total_ticks += r.ticks;
+
+        out << "Rule profile (" << workers << " workers, since the last rule load; "
+#if defined(IDS_PROFILE_RDTSC)
+            << "ticks = TSC cycles"
+#else
+            << "ticks = ns"
+#endif
+            << ")\n";
+        out << std::setw(8) << "sid" << std::setw(12) << "candidates" << std::setw(10) << "verified"
+            << std::setw(10) << "matches" << std::setw(14) << "ticks" << std::setw(10) << "tick/vfy"
+            << std::setw(8) << "%time" << "  signature\n";
+        std::ios::fmtflags flags = out.flags();
+        std::streamsize precision = out.precision();
+        std::size_t shown = 0;
+        for (const Row& r : rows) {
+            if (shown == top_n || (r.candidates == 0 && r.ticks == 0)) break;
+            ++shown;
+            const auto& rule = engine.rule(r.rule);
+            out << std::setw(8) << rule.id << std::setw(12) << r.candidates << std::setw(10) << r.verifications
+                << std::setw(10) << r.matches << std::setw(14) << r.ticks << std::setw(10)
+                << (r.verifications ? r.ticks / r.verifications : 0) << std::setw(7) << std::fixed
+                << std::setprecision(1)
+                << (total_ticks ? 100.0 * static_cast<double>(r.ticks) / static_cast<double>(total_ticks) : 0.0)
+                << "%  " << rule.message << "\n";
+        }
+        out.flags(flags);
+        out.precision(precision);
+        if (shown == 0) out << "  (no rule activity)\n";
+#endif
+    }
+
+private:
+    mutable std::mutex mutex_;
+    std::vector<std::unique_ptr<RuleProfile>> profiles_;
+};
+
+// The registry lock is held only while the counter array is swapped, which
+// happens once per reload
+inline void RuleProfile::reset(std::uint64_t engine_generation, std::size_t rule_count) {
+    auto counters = std::make_unique<RuleCounters[]>(rule_count);
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    generation_ = engine_generation;
+    rule_count_ = rule_count;
+    counters_ = std::move(counters);
+}
+
+} // namespace detect
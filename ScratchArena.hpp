@@ -0,0 +1,88 @@
+#pragma once
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+namespace core {
+
+// Monotonic std::pmr resource for per-packet temporaries (decoded DNS
+// questions, HTTP fields, match results) that are all dead by the next
+// batch boundary. Allocation bumps a pointer, deallocate() does nothing and
+// reset() makes the whole arena reusable. One thread owns an arena.
+//
+// Unlike std::pmr::monotonic_buffer_resource, memory is kept across
+// resets: when a batch needed more than one block, reset() replaces the
+// blocks with a single block of their combined size, so a steady workload
+// stops touching the heap once the arena has grown to its batch size.
+class ScratchArena : public std::pmr::memory_resource {
+public:
+    explicit ScratchArena(std::size_t initial_bytes = 64 * 1024) { add_block(std::max<std::size_t>(initial_bytes, 256)); }
+
+    ScratchArena(const ScratchArena&) = delete;
+    ScratchArena& operator=(const ScratchArena&) = delete;
+
+    // Call at a batch boundary, when nothing allocated since the last reset
+    // is alive any more
+    void reset() {
+        if (blocks_.size() > 1) {
+            std::size_t total = 0;
+            for (const auto& b : blocks_) total += b.size;
+            blocks_.clear();
+            add_block(total);
+        }
+        offset_ = 0;
+        used_ = 0;
+    }
+
+    std::size_t capacity() const {
+        std::size_t total = 0;
+        for (const auto& b : blocks_) total += b.size;
+        return total;
+    }
+    std::size_t high_water() const { return high_water_; } // most bytes handed out between resets
+    std::uint64_t growths() const { return growths_; }      // blocks added because a batch didn't fit
+
+private:
+    struct Block {
+        std::unique_ptr<std::byte[]> data;
+        std::size_t size;
+    };
+
+    void* do_allocate(std::size_t bytes, std::size_t align) override {
+        for (;;) {
+            Block& b = blocks_.back();
+            auto base = reinterpret_cast<std::uintptr_t>(b.data.get());
+            std::uintptr_t at = (base + offset_ + align - 1) & ~(static_cast<std::uintptr_t>(align) - 1);
+            std::size_t end = static_cast<std::size_t>(at - base) + bytes;
+            if (end <= b.size) {
+                used_ += end - offset_;
+                high_water_ = std::max(high_water_, used_);
+                offset_ = end;
+                return reinterpret_cast<void*>(at);
+            }
+            ++growths_;
+            used_ += b.size - offset_;
+            add_block(std::max(b.size * 2, bytes + align));
+        }
+    }
+
+    void do_deallocate(void*, std::size_t, std::size_t) override {}
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override { return this == &other; }
+
+    void add_block(std::size_t size) {
+        blocks_.push_back(Block{std::make_unique_for_overwrite<std::byte[]>(size), size});
+        offset_ = 0;
+    }
+
+    std::vector<Block> blocks_;
+    std::size_t offset_{0};     // in the last block
+    std::size_t used_{0};       // bytes handed out (and skipped) since the last reset
+    std::size_t high_water_{0};
+    std::uint64_t growths_{0};
+};
+
+} // namespace core
@@ -0,0 +1,435 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <functional>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include "core/Hash.hpp"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IDS_SWISS_SSE2 1
+#endif
+
+#if defined(__GNUC__) || defined(__clang__)
+#define IDS_SWISS_PREFETCH(p) __builtin_prefetch(p)
+#elif defined(_MSC_VER)
+#include <xmmintrin.h>
+#define IDS_SWISS_PREFETCH(p) _mm_prefetch(reinterpret_cast<const char*>(p), _MM_HINT_T0)
+#else
+#define IDS_SWISS_PREFETCH(p) ((void)0)
+#endif
+
+namespace core { namespace dsa {
+
+namespace swiss_detail {
+
+// Selects the lookup argument type: any K when both Hash and Eq are
+// transparent, otherwise Key (so callers get the usual conversions)
+template <bool Transparent>
+struct KeyArg {
+    template <typename K, typename Key>
+    using type = Key;
+};
+
+template <>
+struct KeyArg<true> {
+    template <typename K, typename Key>
+    using type = K;
+};
+
+template <typename T, typename = void>
+struct IsTransparent : std::false_type {};
+
+template <typename T>
+struct IsTransparent<T, std::void_t<typename T::is_transparent>> : std::true_type {};
+
+inline unsigned lowest_bit(std::uint32_t mask) {
+#if defined(__GNUC__) || defined(__clang__)
+    return static_cast<unsigned>(__builtin_ctz(mask));
+#else
+    unsigned i = 0;
+    while (!(mask & 1u)) {
+        mask >>= 1;
+        ++i;
+    }
+    return i;
+#endif
+}
+
+} // namespace swiss_detail
+
+// Open-addressing hash table with SIMD metadata probing (Swiss-table style).
+//
+// A separate control-byte array holds 0x80 for an empty slot, 0xFE for an
+// erased one (tombstone) or the low 7 bits of the key's hash (H2) for a
+// full one. Lookups load 16 control bytes
+// from the home slot and compare them against H2 in one SSE2 compare, so
+// keys are only touched for likely matches and a miss usually costs one
+// control-byte load. The first 15 control bytes are mirrored past the end
+// so a window never needs to wrap.
+//
+// Probing is linear and lookups stop at the first empty slot. erase()
+// leaves a tombstone, unless the next slot is empty (nothing probes past
+// it then), so it costs one lookup; inserts reuse tombstones, and once
+// tombstones and entries reach the maximum load the table is rehashed,
+// in place unless it is mostly live, so long-lived tables don't degrade
+// under churn. Slots hold {key, value} in place: values may be
+// move-only and are never copied on insert or lookup.
+//
+// find() returns a pointer into the table. Pointers are invalidated by any
+// insert that grows the table and by erase().
+//
+// For batches of lookups, hash() each key and prefetch() its home window
+// first, then call the overloads taking the hash, so the cache misses of
+// the whole batch overlap instead of being waited out one at a time.
+//
+// Allocator is rebound for the control bytes and the slots (see
+// core::ArenaAllocator).
+template <typename Key, typename Value, typename Hash = std::hash<Key>, typename Eq = std::equal_to<Key>,
+          typename Allocator = std::allocator<Key>>
+class SwissTable {
+    static constexpr bool kTransparent =
+        swiss_detail::IsTransparent<Hash>::value && swiss_detail::IsTransparent<Eq>::value;
+
+    template <typename K>
+    using key_arg = typename swiss_detail::KeyArg<kTransparent>::template type<K, Key>;
+
+    template <typename U>
+    using Rebind = typename std::allocator_traits<Allocator>::template rebind_alloc<U>;
+
+public:
+    struct Slot {
+        Key key;
+        Value value;
+
+        template <typename K, typename... Args>
+        explicit Slot(K&& k, Args&&... args) : key(std::forward<K>(k)), value(std::forward<Args>(args)...) {}
+    };
+
+    explicit SwissTable(std::size_t capacity = 0, const Allocator& alloc = Allocator())
+        : ctrl_(Rebind<std::uint8_t>(alloc)), slot_alloc_(alloc) {
+        if (capacity) reserve(capacity);
+    }
+
+    SwissTable(const SwissTable&) = delete;
+    SwissTable& operator=(const SwissTable&) = delete;
+
+    SwissTable(SwissTable&& other) noexcept { swap(other); }
+
+    SwissTable& operator=(SwissTable&& other) noexcept {
+        if (this != &other) {
+            destroy();
+            swap(other);
+        }
+        return *this;
+    }
+
+    ~SwissTable() { destroy(); }
+
+    template <typename K = Key>
+    Value* find(const key_arg<K>& key) {
+        std::size_t index = find_index(key, hash_of(key));
+        return index == kNotFound ? nullptr : &slots_[index].value;
+    }
+
+    template <typename K = Key>
+    const Value* find(const key_arg<K>& key) const {
+        std::size_t index = find_index(key, hash_of(key));
+        return index == kNotFound ? nullptr : &slots_[index].value;
+    }
+
+    template <typename K = Key>
+    bool contains(const key_arg<K>& key) const {
+        return find_index(key, hash_of(key)) != kNotFound;
+    }
+
+    // Hash of a key as used by the overloads below
+    template <typename K = Key>
+    std::uint64_t hash(const key_arg<K>& key) const {
+        return hash_of(key);
+    }
+
+    // Starts loading the control bytes and first slot a lookup of hash reads
+    void prefetch(std::uint64_t hash) const {
+        if (capacity_ == 0) return;
+        std::size_t pos = home(hash);
+        IDS_SWISS_PREFETCH(ctrl_.data() + pos);
+        IDS_SWISS_PREFETCH(slots_ + pos);
+    }
+
+    template <typename K = Key>
+    Value* find(const key_arg<K>& key, std::uint64_t hash) {
+        std::size_t index = find_index(key, hash);
+        return index == kNotFound ? nullptr : &slots_[index].value;
+    }
+
+    template <typename K = Key, typename... Args>
+    std::pair<Value*, bool> try_emplace_hashed(const key_arg<K>& key, std::uint64_t hash, Args&&... args) {
+        return emplace_impl(key, hash, std::forward<Args>(args)...);
+    }
+
+    template <typename K = Key>
+    bool erase(const key_arg<K>& key, std::uint64_t hash) {
+        std::size_t index = find_index(key, hash);
+        if (index == kNotFound) return false;
+        erase_at(index);
+        return true;
+    }
+
+    // Constructs Value(args...) only if key is absent. Returns the value and
+    // whether it was inserted.
+    template <typename... Args>
+    std::pair<Value*, bool> try_emplace(Key&& key, Args&&... args) {
+        std::uint64_t hash = hash_of(key);
+        return emplace_impl(std::move(key), hash, std::forward<Args>(args)...);
+    }
+
+    template <typename K = Key, typename... Args>
+    std::pair<Value*, bool> try_emplace(const key_arg<K>& key, Args&&... args) {
+        return emplace_impl(key, hash_of(key), std::forward<Args>(args)...);
+    }
+
+    template <typename V>
+    std::pair<Value*, bool> insert_or_assign(const Key& key, V&& value) {
+        auto result = try_emplace(key, std::forward<V>(value));
+        if (!result.second) *result.first = std::forward<V>(value);
+        return result;
+    }
+
+    template <typename K = Key>
+    bool erase(const key_arg<K>& key) {
+        std::size_t index = find_index(key, hash_of(key));
+        if (index == kNotFound) return false;
+        erase_at(index);
+        return true;
+    }
+
+    // f(const Key&, Value&) for every entry, in slot order
+    template <typename F>
+    void for_each(F&& f) {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (is_full(ctrl_[i])) f(static_cast<const Key&>(slots_[i].key), slots_[i].value);
+        }
+    }
+
+    template <typename F>
+    void for_each(F&& f) const {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (is_full(ctrl_[i])) f(slots_[i].key, static_cast<const Value&>(slots_[i].value));
+        }
+    }
+
+    void clear() {
+        for (std::size_t i = 0; i < capacity_; ++i) {
+            if (is_full(ctrl_[i])) slots_[i].~Slot();
+        }
+        std::fill(ctrl_.begin(), ctrl_.end(), kEmpty);
+        size_ = 0;
+        deleted_ = 0;
+    }
+
+    // Grows so that n entries fit without growing again, however many are
+    // erased and replaced
+    void reserve(std::size_t n) {
+        std::size_t capacity = capacity_for(n);
+        if (capacity > capacity_) rehash(capacity);
+    }
+
+    // Slot count reserve(n) ends up with; the table then holds that many
+    // slots plus capacity + 15 control bytes
+    static std::size_t capacity_for(std::size_t n) {
+        std::size_t capacity = kGroup;
+        while (n > max_live(capacity)) capacity <<= 1;
+        return capacity;
+    }
+
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    std::size_t capacity() const { return capacity_; }
+    double load_factor() const { return capacity_ ? static_cast<double>(size_) / capacity_ : 0.0; }
+
+    std::size_t memory_usage() const { return ctrl_.capacity() + capacity_ * sizeof(Slot); }
+
+    void swap(SwissTable& other) noexcept {
+        std::swap(ctrl_, other.ctrl_);
+        std::swap(slots_, other.slots_);
+        std::swap(capacity_, other.capacity_);
+        std::swap(size_, other.size_);
+        std::swap(deleted_, other.deleted_);
+        std::swap(slot_alloc_, other.slot_alloc_);
+        std::swap(hasher_, other.hasher_);
+        std::swap(eq_, other.eq_);
+    }
+
+private:
+    static constexpr std::size_t kGroup = 16;
+    static constexpr std::uint8_t kEmpty = 0x80;
+    static constexpr std::uint8_t kDeleted = 0xFE;
+    static constexpr std::size_t kNotFound = ~std::size_t{0};
+
+    // 7/8 maximum load, counting tombstones; the cluster length this allows
+    // is a couple of 16-slot windows
+    static std::size_t max_load(std::size_t capacity) { return capacity - capacity / 8; }
+
+    // Live entries before the table grows; the rest of max_load() is room
+    // for tombstones, so a table at this size under churn rehashes in place
+    // at most once per max_load() / 8 erases
+    static std::size_t max_live(std::size_t capacity) { return max_load(capacity) - max_load(capacity) / 8; }
+
+    static bool is_full(std::uint8_t c) { return !(c & 0x80); }
+
+    // The user hash is re-mixed so std::hash's identity mapping for integers
+    // still spreads H1 and H2
+    template <typename K>
+    std::uint64_t hash_of(const K& key) const {
+        return core::hash64(static_cast<std::uint64_t>(hasher_(key)));
+    }
+
+    std::size_t home(std::uint64_t hash) const { return static_cast<std::size_t>(hash >> 7) & (capacity_ - 1); }
+    static std::uint8_t h2(std::uint64_t hash) { return static_cast<std::uint8_t>(hash & 0x7F); }
+
+    struct Window {
+        std::uint32_t match; // slots whose control byte equals H2
+        std::uint32_t empty; // empty slots
+        std::uint32_t free;  // empty or erased slots
+    };
+
+    Window probe(std::size_t pos, std::uint8_t tag) const {
+        const std::uint8_t* ctrl = ctrl_.data() + pos;
+#if defined(IDS_SWISS_SSE2)
+        __m128i bytes = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+        auto match = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(tag)))));
+        auto empty = static_cast<std::uint32_t>(
+            _mm_movemask_epi8(_mm_cmpeq_epi8(bytes, _mm_set1_epi8(static_cast<char>(kEmpty)))));
+        auto free = static_cast<std::uint32_t>(_mm_movemask_epi8(bytes));
+        return Window{match, empty, free};
+#else
+        Window w{0, 0, 0};
+        for (std::size_t i = 0; i < kGroup; ++i) {
+            w.match |= static_cast<std::uint32_t>(ctrl[i] == tag) << i;
+            w.empty |= static_cast<std::uint32_t>(ctrl[i] == kEmpty) << i;
+            w.free |= static_cast<std::uint32_t>(!is_full(ctrl[i])) << i;
+        }
+        return w;
+#endif
+    }
+
+    void set_ctrl(std::size_t i, std::uint8_t c) {
+        ctrl_[i] = c;
+        if (i < kGroup - 1) ctrl_[capacity_ + i] = c;
+    }
+
+    // Returns the slot holding key, or kNotFound. If insert_at is given it
+    // receives the first empty or erased slot of the probe sequence.
+    template <typename K>
+    std::size_t find_index(const K& key, std::uint64_t hash, std::size_t* insert_at = nullptr) const {
+        if (capacity_ == 0) return kNotFound;
+        std::uint8_t tag = h2(hash);
+        std::size_t mask = capacity_ - 1;
+        std::size_t first_free = kNotFound;
+        for (std::size_t pos = home(hash);; pos = (pos + kGroup) & mask) {
+            Window w = probe(pos, tag);
+            if (first_free == kNotFound && w.free) first_free = (pos + swiss_detail::lowest_bit(w.free)) & mask;
+            // Entries never sit past an empty slot in their probe sequence
+            std::uint32_t match = w.empty ? w.match & ((w.empty & (0u - w.empty)) - 1) : w.match;
+            while (match) {
+                std::size_t index = (pos + swiss_detail::lowest_bit(match)) & mask;
+                if (eq_(slots_[index].key, key)) return index;
+                match &= match - 1;
+            }
+            if (w.empty) {
+                if (insert_at) *insert_at = first_free;
+                return kNotFound;
+            }
+        }
+    }
+
+    template <typename K, typename... Args>
+    std::pair<Value*, bool> emplace_impl(K&& key, std::uint64_t hash, Args&&... args) {
+        std::size_t insert_at = kNotFound;
+        std::size_t index = find_index(key, hash, &insert_at);
+        if (index != kNotFound) return {&slots_[index].value, false};
+        bool reuses_tombstone = insert_at != kNotFound && ctrl_[insert_at] == kDeleted;
+        if (!reuses_tombstone && size_ + deleted_ + 1 > max_load(capacity_)) {
+            // Mostly tombstones: clean up at the same size instead of growing
+            bool grow = capacity_ == 0 || size_ + 1 > max_live(capacity_);
+            rehash(grow ? (capacity_ ? capacity_ * 2 : kGroup) : capacity_);
+            find_index(key, hash, &insert_at);
+        }
+        if (ctrl_[insert_at] == kDeleted) --deleted_;
+        new (&slots_[insert_at]) Slot(std::forward<K>(key), std::forward<Args>(args)...);
+        set_ctrl(insert_at, h2(hash));
+        ++size_;
+        return {&slots_[insert_at].value, true};
+    }
+
+    // Lookups walk contiguously from the home slot to the first empty slot,
+    // so a slot followed by an empty one can become empty itself; any other
+    // becomes a tombstone that keeps the probe sequences through it intact
+    void erase_at(std::size_t index) {
+        slots_[index].~Slot();
+        if (ctrl_[(index + 1) & (capacity_ - 1)] == kEmpty) {
+            set_ctrl(index, kEmpty);
+        } else {
+            set_ctrl(index, kDeleted);
+            ++deleted_;
+        }
+        --size_;
+    }
+
+    void rehash(std::size_t capacity) {
+        CtrlBytes old_ctrl(capacity + kGroup - 1, kEmpty, ctrl_.get_allocator());
+        Slot* old_slots = allocate(capacity);
+        std::size_t old_capacity = capacity_;
+        std::swap(ctrl_, old_ctrl);
+        std::swap(slots_, old_slots);
+        capacity_ = capacity;
+        deleted_ = 0;
+
+        std::size_t mask = capacity_ - 1;
+        for (std::size_t i = 0; i < old_capacity; ++i) {
+            if (!is_full(old_ctrl[i])) continue;
+            std::uint64_t hash = hash_of(old_slots[i].key);
+            std::size_t pos = home(hash);
+            while (is_full(ctrl_[pos])) pos = (pos + 1) & mask;
+            new (&slots_[pos]) Slot(std::move(old_slots[i]));
+            old_slots[i].~Slot();
+            set_ctrl(pos, h2(hash));
+        }
+        deallocate(old_slots, old_capacity);
+    }
+
+    Slot* allocate(std::size_t n) { return std::allocator_traits<Rebind<Slot>>::allocate(slot_alloc_, n); }
+
+    void deallocate(Slot* p, std::size_t n) {
+        if (p) std::allocator_traits<Rebind<Slot>>::deallocate(slot_alloc_, p, n);
+    }
+
+    void destroy() {
+        if (!slots_) return;
+        clear();
+        deallocate(slots_, capacity_);
+        slots_ = nullptr;
+        ctrl_.clear();
+        capacity_ = 0;
+    }
+
+    using CtrlBytes = std::vector<std::uint8_t, Rebind<std::uint8_t>>;
+
+    CtrlBytes ctrl_;                 // capacity_ + 15 bytes; the tail mirrors the first 15
+    Slot* slots_{nullptr};
+    Rebind<Slot> slot_alloc_;
+    std::size_t capacity_{0};        // power of two, at least kGroup
+    std::size_t size_{0};
+    std::size_t deleted_{0};         // tombstones
+    Hash hasher_;
+    Eq eq_;
+};
+
+}} // namespace core::dsa
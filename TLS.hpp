@@ -0,0 +1,318 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+#include "core/Md5.hpp"
+#include "core/Packet.hpp"
+
+namespace decode {
+
+enum class TlsContentType : std::uint8_t {
+    None = 0,
+    ChangeCipherSpec = 20,
+    Alert = 21,
+    Handshake = 22,
+    ApplicationData = 23,
+};
+
+// Content type of a TLS record header at the start of payload, or None if
+// the bytes don't look like one (SSL 3.0 to TLS 1.3 record versions)
+inline TlsContentType tls_record_type(core::ByteSpan payload) {
+    if (payload.size() < 5 || payload[0] < 20 || payload[0] > 23) return TlsContentType::None;
+    if (payload[1] != 0x03 || payload[2] > 0x04) return TlsContentType::None;
+    std::size_t length = static_cast<std::size_t>((payload[3] << 8) | payload[4]);
+    if (length == 0 || length > 16384 + 2048) return TlsContentType::None;
+    return static_cast<TlsContentType>(payload[0]);
+}
+
+// ClientHello or ServerHello fields. Views point into the message buffer
+// that was parsed and are only valid as long as it is.
+struct TlsHello {
+    enum class Kind : std::uint8_t { Client = 1, Server = 2 };
+
+    Kind kind{Kind::Client};
+    std::uint16_t legacy_version{0}; // version field of the hello (0x0303 for TLS 1.2 and 1.3)
+    std::uint16_t version{0};        // supported_versions: highest offered / selected; else legacy
+    core::ByteSpan cipher_suites{};  // 2-byte big-endian suites; ServerHello: the selected one
+    std::string_view sni{};          // ClientHello host_name
+    core::ByteSpan alpn{};           // ProtocolNameList entries (1-byte length + name)
+    std::string_view alpn_first{};   // first ALPN protocol (ServerHello: the selected one)
+    std::array<std::uint8_t, 16> ja3{}; // JA3 (client) or JA3S (server) MD5; zero if not computed
+
+    std::size_t cipher_count() const { return cipher_suites.size() / 2; }
+    std::uint16_t cipher(std::size_t i) const {
+        return static_cast<std::uint16_t>((cipher_suites[2 * i] << 8) | cipher_suites[2 * i + 1]);
+    }
+
+    // Lower-case hex of the fingerprint into out[0..32], NUL terminated
+    void ja3_hex(char (&out)[33]) const {
+        static const char digits[] = "0123456789abcdef";
+        for (std::size_t i = 0; i < ja3.size(); ++i) {
+            out[2 * i] = digits[ja3[i] >> 4];
+            out[2 * i + 1] = digits[ja3[i] & 15];
+        }
+        out[32] = '\0';
+    }
+};
+
+namespace tls_detail {
+
+// Bounds-checked big-endian reader; any overrun clears ok and yields zeros
+struct Cursor {
+    core::ByteSpan data;
+    std::size_t pos{0};
+    bool ok{true};
+
+    std::size_t remaining() const { return data.size() - pos; }
+    bool take(std::size_t n) {
+        if (!ok || remaining() < n) return ok = false;
+        pos += n;
+        return true;
+    }
+    std::uint8_t u8() { return take(1) ? data[pos - 1] : 0; }
+    std::uint16_t u16() { return take(2) ? static_cast<std::uint16_t>((data[pos - 2] << 8) | data[pos - 1]) : 0; }
+    std::uint32_t u24() {
+        if (!take(3)) return 0;
+        return (static_cast<std::uint32_t>(data[pos - 3]) << 16) | (static_cast<std::uint32_t>(data[pos - 2]) << 8) |
+               data[pos - 1];
+    }
+    core::ByteSpan bytes(std::size_t n) { return take(n) ? data.subspan(pos - n, n) : core::ByteSpan{}; }
+};
+
+// GREASE values (RFC 8701): 0x0a0a, 0x1a1a, ... 0xfafa; JA3 ignores them
+inline bool is_grease(std::uint16_t v) { return (v & 0x0f0f) == 0x0a0a && (v >> 8) == (v & 0xff); }
+
+// Feeds the JA3 string ("771,4865-4866,0-23,29-23,0") to MD5 as it is
+// walked: decimal values joined by '-', fields by ','
+struct Ja3Writer {
+    core::Md5 md5;
+    bool first{true};
+
+    void value(std::uint16_t v) {
+        char buf[6];
+        char* p = buf + sizeof(buf);
+        do {
+            *--p = static_cast<char>('0' + v % 10);
+            v = static_cast<std::uint16_t>(v / 10);
+        } while (v != 0);
+        if (!first) md5.update('-');
+        md5.update(p, static_cast<std::size_t>(buf + sizeof(buf) - p));
+        first = false;
+    }
+    void list16(core::ByteSpan list) {
+        for (std::size_t i = 0; i + 1 < list.size(); i += 2) {
+            auto v = static_cast<std::uint16_t>((list[i] << 8) | list[i + 1]);
+            if (!is_grease(v)) value(v);
+        }
+    }
+    void next_field() {
+        md5.update(',');
+        first = true;
+    }
+};
+
+} // namespace tls_detail
+
+// Parses a ClientHello or ServerHello handshake message (4-byte handshake
+// header included). With fingerprint set, computes JA3 for a ClientHello
+// and JA3S for a ServerHello without building the fingerprint string.
+inline bool parse_tls_hello(core::ByteSpan message, TlsHello& out, bool fingerprint = true) {
+    tls_detail::Cursor header{message};
+    std::uint8_t type = header.u8();
+    std::uint32_t length = header.u24();
+    if (!header.ok || (type != 1 && type != 2) || length > header.remaining()) return false;
+
+    out = TlsHello{};
+    out.kind = type == 1 ? TlsHello::Kind::Client : TlsHello::Kind::Server;
+    bool client = out.kind == TlsHello::Kind::Client;
+    tls_detail::Cursor c{message.subspan(4, length)};
+
+    out.legacy_version = c.u16();
+    c.take(32);        // random
+    c.take(c.u8());    // legacy_session_id
+    if (client) {
+        std::uint16_t suites = c.u16();
+        if (suites % 2 != 0) return false;
+        out.cipher_suites = c.bytes(suites);
+        c.take(c.u8()); // legacy_compression_methods
+    } else {
+        out.cipher_suites = c.bytes(2);
+        c.take(1);
+    }
+    core::ByteSpan extensions{};
+    if (c.ok && c.remaining() != 0) extensions = c.bytes(c.u16());
+    if (!c.ok) return false;
+    out.version = out.legacy_version;
+
+    tls_detail::Ja3Writer ja3;
+    if (fingerprint) {
+        ja3.value(out.legacy_version);
+        ja3.next_field();
+        ja3.list16(out.cipher_suites);
+        ja3.next_field();
+    }
+
+    core::ByteSpan groups{}, point_formats{};
+    tls_detail::Cursor ext{extensions};
+    while (ext.remaining() != 0) {
+        std::uint16_t ext_type = ext.u16();
+        tls_detail::Cursor body{ext.bytes(ext.u16())};
+        if (!ext.ok) return false;
+        if (fingerprint && !tls_detail::is_grease(ext_type)) ja3.value(ext_type);
+
+        switch (ext_type) {
+        case 0: { // server_name
+            if (!client || body.remaining() == 0) break;
+            tls_detail::Cursor list{body.bytes(body.u16())};
+            while (list.ok && list.remaining() != 0) {
+                std::uint8_t name_type = list.u8();
+                core::ByteSpan name = list.bytes(list.u16());
+                if (list.ok && name_type == 0 && !name.empty()) {
+                    out.sni = std::string_view(reinterpret_cast<const char*>(name.data()), name.size());
+                    break;
+                }
+            }
+            break;
+        }
+        case 10: // supported_groups
+            groups = body.bytes(body.u16());
+            break;
+        case 11: // ec_point_formats
+            point_formats = body.bytes(body.u8());
+            break;
+        case 16: { // application_layer_protocol_negotiation
+            out.alpn = body.bytes(body.u16());
+            tls_detail::Cursor list{out.alpn};
+            core::ByteSpan name = list.bytes(list.u8());
+            if (list.ok) out.alpn_first = std::string_view(reinterpret_cast<const char*>(name.data()), name.size());
+            break;
+        }
+        case 43: // supported_versions
+            if (client) {
+                tls_detail::Cursor list{body.bytes(body.u8())};
+                while (list.ok && list.remaining() >= 2) {
+                    std::uint16_t v = list.u16();
+                    if (!tls_detail::is_grease(v) && v > out.version) out.version = v;
+                }
+            } else {
+                std::uint16_t v = body.u16();
+                if (body.ok) out.version = v;
+            }
+            break;
+        default:
+            break;
+        }
+    }
+
+    if (fingerprint) {
+        if (client) {
+            ja3.next_field();
+            ja3.list16(groups);
+            ja3.next_field();
+            for (std::uint8_t format : point_formats) ja3.value(format);
+        }
+        out.ja3 = ja3.md5.finish();
+    }
+    return true;
+}
+
+// The hello message when the first TLS record of payload holds all of it:
+// the common single-segment case, parsed in place without copying
+inline bool tls_hello_message(core::ByteSpan payload, core::ByteSpan& message) {
+    if (tls_record_type(payload) != TlsContentType::Handshake || payload.size() < 9) return false;
+    std::size_t record_end = 5 + static_cast<std::size_t>((payload[3] << 8) | payload[4]);
+    if (payload[5] != 1 && payload[5] != 2) return false;
+    std::size_t message_end = 9 + ((static_cast<std::size_t>(payload[6]) << 16) |
+                                   (static_cast<std::size_t>(payload[7]) << 8) | payload[8]);
+    if (message_end > record_end || message_end > payload.size()) return false;
+    message = payload.subspan(5, message_end - 5);
+    return true;
+}
+
+// Collects a hello message that spans several TLS records and/or TCP
+// segments into a fixed buffer, stripping record headers. Segments are fed
+// with their TCP sequence numbers: retransmitted bytes are skipped, a gap
+// ends the attempt.
+class TlsHelloReader {
+public:
+    static constexpr std::size_t kMaxMessage = 16 * 1024;
+
+    enum class Status : std::uint8_t {
+        NeedMore, // hello incomplete; feed the next segment
+        Done,     // message() holds the whole hello
+        NotTls,   // the flow doesn't start with a TLS hello
+        Error,    // malformed, oversized or out of order
+    };
+
+    void reset(std::uint32_t seq) {
+        next_seq_ = seq;
+        length_ = 0;
+        need_ = 0;
+        header_length_ = 0;
+        record_left_ = 0;
+    }
+
+    Status feed(std::uint32_t seq, core::ByteSpan segment) {
+        auto offset = static_cast<std::int32_t>(seq - next_seq_);
+        if (offset > 0) return Status::Error;
+        if (static_cast<std::size_t>(-static_cast<std::int64_t>(offset)) >= segment.size()) return Status::NeedMore;
+        segment = segment.subspan(static_cast<std::size_t>(-static_cast<std::int64_t>(offset)));
+        next_seq_ += static_cast<std::uint32_t>(segment.size());
+
+        while (!segment.empty()) {
+            if (header_length_ < 5) {
+                std::size_t take = std::min<std::size_t>(5 - header_length_, segment.size());
+                std::memcpy(header_ + header_length_, segment.data(), take);
+                header_length_ = static_cast<std::uint8_t>(header_length_ + take);
+                segment = segment.subspan(take);
+                if (header_length_ < 5) break;
+                if (header_[0] != 22 || header_[1] != 0x03) return length_ == 0 ? Status::NotTls : Status::Error;
+                record_left_ = static_cast<std::size_t>((header_[3] << 8) | header_[4]);
+                if (record_left_ == 0 || record_left_ > 16384 + 2048) return Status::Error;
+                continue;
+            }
+            std::size_t take = std::min(record_left_, segment.size());
+            std::size_t copy = std::min(take, kMaxMessage - length_);
+            std::memcpy(buffer_.data() + length_, segment.data(), copy);
+            length_ += copy;
+            record_left_ -= take;
+            segment = segment.subspan(take);
+            if (record_left_ == 0) header_length_ = 0;
+
+            if (need_ == 0 && length_ >= 4) {
+                if (buffer_[0] != 1 && buffer_[0] != 2) return Status::NotTls;
+                need_ = 4 + ((static_cast<std::size_t>(buffer_[1]) << 16) |
+                             (static_cast<std::size_t>(buffer_[2]) << 8) | buffer_[3]);
+                if (need_ > kMaxMessage) return Status::Error;
+            }
+            if (need_ != 0 && length_ >= need_) return Status::Done;
+        }
+        return Status::NeedMore;
+    }
+
+    core::ByteSpan message() const { return core::ByteSpan(buffer_.data(), need_); }
+
+private:
+    std::uint32_t next_seq_{0};
+    std::size_t length_{0};      // message bytes collected
+    std::size_t need_{0};        // full message size once its header is in
+    std::size_t record_left_{0}; // body bytes left in the current record
+    std::uint8_t header_[5]{};
+    std::uint8_t header_length_{0};
+    std::array<std::uint8_t, kMaxMessage> buffer_{};
+};
+
+// Server Name Indication from a TLS ClientHello held whole in the first
+// record of this payload
+inline bool extract_tls_sni(core::ByteSpan payload, std::string_view& sni) {
+    core::ByteSpan message;
+    TlsHello hello;
+    if (!tls_hello_message(payload, message) || !parse_tls_hello(message, hello, false)) return false;
+    if (hello.kind != TlsHello::Kind::Client || hello.sni.empty()) return false;
+    sni = hello.sni;
+    return true;
+}
+
+} // namespace decode
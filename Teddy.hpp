@@ -0,0 +1,215 @@
+#pragma once
+#include <algorithm>
+#include <array>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/CpuFeatures.hpp"
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace core { namespace dsa {
+
+// Teddy-style packed multi-literal matcher for small pattern sets (up to 64).
+//
+// Patterns are spread over 8 buckets. For each of the first m bytes of a
+// pattern (m = min(3, shortest pattern)) two 16-entry tables map the low
+// and high nibble of a byte to the set of buckets whose patterns have a
+// byte with that nibble at that offset. A PSHUFB per nibble looks up 16
+// (SSSE3) or 32 (AVX2) positions at once; ANDing the results over the m
+// offsets leaves, per position, the buckets whose fingerprint matched.
+// Only those candidates are verified with memcmp. Without SSSE3 the same
+// tables are walked one byte at a time. The SIMD kernel is chosen at run
+// time from the CPU (core::cpu_simd_level), so a default x64 build never
+// executes PSHUFB on a CPU that lacks it.
+class Teddy {
+public:
+    static constexpr std::size_t kMaxPatterns = 64;
+    static constexpr std::size_t kBuckets = 8;
+    static constexpr std::size_t kMaxFingerprint = 3;
+
+    bool build(const std::vector<std::string>& patterns) {
+        patterns_ = patterns;
+        for (auto& b : buckets_) b.clear();
+        for (auto& m : lo_) m.fill(0);
+        for (auto& m : hi_) m.fill(0);
+        if (patterns_.empty() || patterns_.size() > kMaxPatterns) return false;
+
+        std::size_t shortest = SIZE_MAX;
+        for (const auto& p : patterns_) shortest = std::min(shortest, p.size());
+        if (shortest == 0) return false;
+        fingerprint_ = std::min(kMaxFingerprint, shortest);
+
+        // Patterns sharing leading bytes go to the same bucket so their
+        // fingerprints don't widen each other's masks.
+        std::vector<std::uint32_t> order(patterns_.size());
+        for (std::uint32_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+            return patterns_[a].compare(0, fingerprint_, patterns_[b], 0, fingerprint_) < 0;
+        });
+        for (std::size_t i = 0; i < order.size(); ++i) {
+            std::size_t bucket = i * kBuckets / order.size();
+            buckets_[bucket].push_back(order[i]);
+            const std::string& p = patterns_[order[i]];
+            for (std::size_t k = 0; k < fingerprint_; ++k) {
+                auto c = static_cast<std::uint8_t>(p[k]);
+                lo_[k][c & 0x0F] |= static_cast<std::uint8_t>(1u << bucket);
+                hi_[k][c >> 4] |= static_cast<std::uint8_t>(1u << bucket);
+            }
+        }
+        return true;
+    }
+
+    std::size_t pattern_count() const { return patterns_.size(); }
+    const std::string& get_pattern(std::size_t id) const { return patterns_[id]; }
+
+    // Kernel in use; limit_simd() lowers it (benchmarks, testing fallbacks)
+    SimdLevel simd_level() const { return simd_; }
+    void limit_simd(SimdLevel level) { simd_ = std::min(simd_, level); }
+
+    std::size_t memory_usage() const {
+        std::size_t bytes = 0;
+        for (const auto& p : patterns_) bytes += sizeof(std::string) + p.capacity();
+        for (const auto& b : buckets_) bytes += b.capacity() * sizeof(std::uint32_t);
+        return bytes;
+    }
+
+    // Calls on_match(start_position, pattern_id) for every occurrence
+    template <typename F>
+    void scan(std::string_view text, F&& on_match) const {
+        if (patterns_.empty() || text.size() < fingerprint_) return;
+        const auto* data = reinterpret_cast<const std::uint8_t*>(text.data());
+        const std::size_t n = text.size();
+        const std::size_t last = n - fingerprint_; // last start where the fingerprint fits
+        std::size_t i = 0;
+
+#if defined(IDS_X86_SIMD)
+        if (simd_ == SimdLevel::Avx2) {
+            i = scan_avx2(data, n, last, on_match);
+        } else if (simd_ == SimdLevel::Ssse3) {
+            i = scan_ssse3(data, n, last, on_match);
+        }
+#endif
+
+        // Scalar tail (and the whole input without SSSE3)
+        for (; i <= last; ++i) {
+            std::uint8_t buckets = 0xFF;
+            for (std::size_t k = 0; k < fingerprint_ && buckets; ++k) {
+                std::uint8_t c = data[i + k];
+                buckets &= lo_[k][c & 0x0F] & hi_[k][c >> 4];
+            }
+            if (buckets) verify(buckets, i, data, n, on_match);
+        }
+    }
+
+private:
+#if defined(IDS_X86_SIMD)
+    // Kernels return the first position left for the scalar tail
+    template <typename F>
+    IDS_TARGET_AVX2 std::size_t scan_avx2(const std::uint8_t* data, std::size_t n, std::size_t last,
+                                          F& on_match) const {
+        const __m256i nibble = _mm256_set1_epi8(0x0F);
+        __m256i lo[kMaxFingerprint];
+        __m256i hi[kMaxFingerprint];
+        for (std::size_t k = 0; k < fingerprint_; ++k) {
+            lo[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_[k].data())));
+            hi[k] = _mm256_broadcastsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_[k].data())));
+        }
+        std::size_t i = 0;
+        for (; i + 32 <= last + 1; i += 32) {
+            __m256i res = _mm256_set1_epi8(-1);
+            for (std::size_t k = 0; k < fingerprint_; ++k) {
+                __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + i + k));
+                __m256i l = _mm256_shuffle_epi8(lo[k], _mm256_and_si256(v, nibble));
+                __m256i h = _mm256_shuffle_epi8(hi[k], _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble));
+                res = _mm256_and_si256(res, _mm256_and_si256(l, h));
+            }
+            auto nonzero = ~static_cast<std::uint32_t>(
+                _mm256_movemask_epi8(_mm256_cmpeq_epi8(res, _mm256_setzero_si256())));
+            if (nonzero) {
+                alignas(32) std::uint8_t lanes[32];
+                _mm256_store_si256(reinterpret_cast<__m256i*>(lanes), res);
+                report_lanes(nonzero, lanes, i, data, n, on_match);
+            }
+        }
+        return i;
+    }
+
+    template <typename F>
+    IDS_TARGET_SSSE3 std::size_t scan_ssse3(const std::uint8_t* data, std::size_t n, std::size_t last,
+                                            F& on_match) const {
+        const __m128i nibble = _mm_set1_epi8(0x0F);
+        __m128i lo[kMaxFingerprint];
+        __m128i hi[kMaxFingerprint];
+        for (std::size_t k = 0; k < fingerprint_; ++k) {
+            lo[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(lo_[k].data()));
+            hi[k] = _mm_loadu_si128(reinterpret_cast<const __m128i*>(hi_[k].data()));
+        }
+        std::size_t i = 0;
+        for (; i + 16 <= last + 1; i += 16) {
+            __m128i res = _mm_set1_epi8(-1);
+            for (std::size_t k = 0; k < fingerprint_; ++k) {
+                __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i + k));
+                __m128i l = _mm_shuffle_epi8(lo[k], _mm_and_si128(v, nibble));
+                __m128i h = _mm_shuffle_epi8(hi[k], _mm_and_si128(_mm_srli_epi16(v, 4), nibble));
+                res = _mm_and_si128(res, _mm_and_si128(l, h));
+            }
+            auto nonzero = static_cast<std::uint32_t>(
+                ~_mm_movemask_epi8(_mm_cmpeq_epi8(res, _mm_setzero_si128())) & 0xFFFF);
+            if (nonzero) {
+                alignas(16) std::uint8_t lanes[16];
+                _mm_store_si128(reinterpret_cast<__m128i*>(lanes), res);
+                report_lanes(nonzero, lanes, i, data, n, on_match);
+            }
+        }
+        return i;
+    }
+#endif
+
+    template <typename F>
+    void report_lanes(std::uint32_t nonzero, const std::uint8_t* lanes, std::size_t base,
+                      const std::uint8_t* data, std::size_t n, F& on_match) const {
+        while (nonzero) {
+            unsigned lane = lowest_bit(nonzero);
+            nonzero &= nonzero - 1;
+            verify(lanes[lane], base + lane, data, n, on_match);
+        }
+    }
+
+    template <typename F>
+    void verify(std::uint8_t buckets, std::size_t pos, const std::uint8_t* data, std::size_t n,
+                F& on_match) const {
+        while (buckets) {
+            unsigned b = lowest_bit(buckets);
+            buckets &= static_cast<std::uint8_t>(buckets - 1);
+            for (std::uint32_t id : buckets_[b]) {
+                const std::string& p = patterns_[id];
+                if (p.size() <= n - pos && std::memcmp(data + pos, p.data(), p.size()) == 0) on_match(pos, id);
+            }
+        }
+    }
+
+    static unsigned lowest_bit(std::uint32_t v) {
+#if defined(_MSC_VER) && !defined(__clang__)
+        unsigned long idx;
+        _BitScanForward(&idx, v);
+        return static_cast<unsigned>(idx);
+#else
+        return static_cast<unsigned>(__builtin_ctz(v));
+#endif
+    }
+
+    std::vector<std::string> patterns_;
+    std::array<std::vector<std::uint32_t>, kBuckets> buckets_{};
+    std::array<std::array<std::uint8_t, 16>, kMaxFingerprint> lo_{};
+    std::array<std::array<std::uint8_t, 16>, kMaxFingerprint> hi_{};
+    std::size_t fingerprint_{1};
+    SimdLevel simd_{cpu_simd_level()};
+};
+
+}} // namespace core::dsa
@@ -0,0 +1,24 @@
+#pragma once
+#include <iostream>
+
+namespace test {
+
+// Shared by the test_*.cpp programs. check() records a failed expectation
+// and keeps going, so one run lists every failure; report() prints
+// "ok <name>" or "FAILED <name>" and gives main's exit status (0 = pass).
+
+inline int failures = 0;
+
+inline void check(bool ok, const char* what) {
+    if (!ok) {
+        std::cerr << "FAIL: " << what << "\n";
+        ++failures;
+    }
+}
+
+inline int report(const char* name) {
+    std::cout << (failures ? "FAILED " : "ok ") << name << "\n";
+    return failures ? 1 : 0;
+}
+
+} // namespace test
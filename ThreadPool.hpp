@@ -0,0 +1,144 @@
+#pragma once
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <map>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <type_traits>
+#include <vector>
+
+namespace core {
+
+// Fixed-size worker pool for startup and reload work (rule parsing, regex
+// compilation, automaton builds). Not meant for the packet path.
+//
+// Tasks must not wait on other tasks of the same pool: parallel_for()
+// called from inside a task runs inline instead of deadlocking.
+class ThreadPool {
+public:
+    explicit ThreadPool(std::size_t threads = std::thread::hardware_concurrency()) {
+        threads = std::max<std::size_t>(threads, 1);
+        for (std::size_t i = 0; i < threads; ++i) {
+            workers_.emplace_back([this]() { worker_loop(); });
+        }
+    }
+
+    ~ThreadPool() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            stopping_ = true;
+        }
+        cv_.notify_all();
+        for (auto& t : workers_) t.join();
+    }
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    std::size_t size() const { return workers_.size(); }
+
+    // Wall time spent in parallel_for regions handed to the workers, for
+    // telling the parallel share of a job from its serial remainder
+    double parallel_seconds() const {
+        return static_cast<double>(parallel_ns_.load(std::memory_order_relaxed)) * 1e-9;
+    }
+
+    // Lower bound on the wall time the parallel regions so far would take on
+    // `cores` cores: a region of n tasks uses at most n of them and its
+    // wall time here is taken as its work, split evenly over its tasks (true
+    // when the pool has more threads than the machine has cores)
+    double parallel_seconds_on(std::size_t cores) const {
+        std::lock_guard<std::mutex> lock(regions_mutex_);
+        double seconds = 0.0;
+        for (const auto& [tasks, ns] : parallel_ns_by_tasks_) {
+            std::size_t usable = std::min(std::max<std::size_t>(cores, 1), tasks);
+            seconds += static_cast<double>(ns) * 1e-9 / static_cast<double>(usable);
+        }
+        return seconds;
+    }
+
+    template <typename F>
+    auto submit(F&& f) -> std::future<std::invoke_result_t<F>> {
+        using R = std::invoke_result_t<F>;
+        auto task = std::make_shared<std::packaged_task<R()>>(std::forward<F>(f));
+        std::future<R> result = task->get_future();
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            tasks_.emplace([task]() { (*task)(); });
+        }
+        cv_.notify_one();
+        return result;
+    }
+
+    // Runs f(i) for i in [0, count) on the pool and waits for all of them.
+    // Exceptions from f are rethrown here.
+    template <typename F>
+    void parallel_for(std::size_t count, F&& f) {
+        if (count == 0) return;
+        if (count == 1 || on_worker_thread()) {
+            for (std::size_t i = 0; i < count; ++i) f(i);
+            return;
+        }
+        auto start = std::chrono::steady_clock::now();
+        std::vector<std::future<void>> pending;
+        pending.reserve(count);
+        for (std::size_t i = 0; i < count; ++i) pending.push_back(submit([&f, i]() { f(i); }));
+        for (auto& p : pending) p.wait();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+        parallel_ns_.fetch_add(static_cast<std::uint64_t>(ns), std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(regions_mutex_);
+            parallel_ns_by_tasks_[count] += static_cast<std::uint64_t>(ns);
+        }
+        for (auto& p : pending) p.get();
+    }
+
+    // Splits [0, n) into about one contiguous range per worker (at least
+    // min_chunk items each) and runs f(begin, end) on each.
+    template <typename F>
+    void parallel_ranges(std::size_t n, std::size_t min_chunk, F&& f) {
+        std::size_t chunks = std::min(size(), (n + min_chunk - 1) / std::max<std::size_t>(min_chunk, 1));
+        chunks = std::max<std::size_t>(chunks, 1);
+        parallel_for(chunks, [&](std::size_t c) { f(n * c / chunks, n * (c + 1) / chunks); });
+    }
+
+private:
+    bool on_worker_thread() const {
+        auto self = std::this_thread::get_id();
+        for (const auto& t : workers_) {
+            if (t.get_id() == self) return true;
+        }
+        return false;
+    }
+
+    void worker_loop() {
+        for (;;) {
+            std::function<void()> task;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this]() { return stopping_ || !tasks_.empty(); });
+                if (stopping_ && tasks_.empty()) return;
+                task = std::move(tasks_.front());
+                tasks_.pop();
+            }
+            task();
+        }
+    }
+
+    std::vector<std::thread> workers_;
+    std::queue<std::function<void()>> tasks_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    bool stopping_{false};
+    std::atomic<std::uint64_t> parallel_ns_{0};
+    mutable std::mutex regions_mutex_;
+    std::map<std::size_t, std::uint64_t> parallel_ns_by_tasks_; // region wall time by task count
+};
+
+} // namespace core
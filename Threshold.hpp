@@ -0,0 +1,156 @@
+#pragma once
+#include <atomic>
+#include <bit>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include "core/Hash.hpp"
+#include "detect/Rule.hpp"
+#include "flow/FlowTable.hpp"
+
+namespace detect {
+
+// Parses a threshold option value, Suricata style:
+//   "type limit, track by_src, count 10, seconds 60"
+// type and count are required; track defaults to by_src, seconds to 60.
+inline bool parse_threshold(std::string_view text, RuleThreshold& out) {
+    RuleThreshold parsed;
+    parsed.seconds = 60;
+    bool has_count = false;
+    while (!text.empty()) {
+        auto comma = text.find(',');
+        std::string_view item = text.substr(0, comma);
+        text = comma == std::string_view::npos ? std::string_view{} : text.substr(comma + 1);
+
+        auto first = item.find_first_not_of(" \t");
+        if (first == std::string_view::npos) continue;
+        item = item.substr(first, item.find_last_not_of(" \t") - first + 1);
+        auto space = item.find_first_of(" \t");
+        if (space == std::string_view::npos) return false;
+        std::string_view name = item.substr(0, space);
+        std::string_view value = item.substr(item.find_first_not_of(" \t", space));
+
+        if (name == "type") {
+            if (value == "limit") parsed.type = RuleThreshold::Type::Limit;
+            else if (value == "threshold") parsed.type = RuleThreshold::Type::Threshold;
+            else if (value == "both") parsed.type = RuleThreshold::Type::Both;
+            else return false;
+        } else if (name == "track") {
+            if (value == "by_src") parsed.track = RuleThreshold::Track::BySrc;
+            else if (value == "by_dst") parsed.track = RuleThreshold::Track::ByDst;
+            else if (value == "by_rule") parsed.track = RuleThreshold::Track::ByRule;
+            else return false;
+        } else if (name == "count" || name == "seconds") {
+            std::uint64_t n = 0;
+            for (char c : value) {
+                if (c < '0' || c > '9' || n > 0xFFFFFFFFull / 10) return false;
+                n = n * 10 + static_cast<unsigned>(c - '0');
+            }
+            if (n == 0 || n > 0xFFFFFFFFull) return false;
+            (name == "count" ? parsed.count : parsed.seconds) = static_cast<std::uint32_t>(n);
+            has_count |= name == "count";
+        } else {
+            return false;
+        }
+    }
+    if (parsed.type == RuleThreshold::Type::None || !has_count) return false;
+    out = parsed;
+    return true;
+}
+
+// Written by the owning worker only and read by the stats thread
+struct ThresholdStats {
+    std::atomic<std::uint64_t> checked{0};    // matches of rules with a threshold
+    std::atomic<std::uint64_t> suppressed{0}; // alerts withheld (never formatted or queued)
+    std::atomic<std::uint64_t> evicted{0};    // live counters replaced because their probe window was full
+
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Per-worker alert counters for thresholded rules, keyed by the engine's
+// rule index and tracked address. (Rule ids restart at 1 in every rule
+// file, so two files' rules would share counters.) Fixed size, open addressing over a short probe window:
+// a counter whose time window has passed is reset (or reused by another
+// key) on the next access, and when every slot in the window is live the
+// one expiring first is replaced, so memory stays bounded under floods of
+// distinct sources. Windows are aligned time buckets (now / seconds), which
+// keeps each counter at 16 bytes with no timestamps per hit.
+class ThresholdTable {
+public:
+    static constexpr std::size_t kProbe = 8;
+
+    // capacity is rounded up to a power of two
+    explicit ThresholdTable(std::size_t capacity = 65536, ThresholdStats* stats = nullptr)
+        : mask_(std::bit_ceil(capacity < kProbe ? kProbe : capacity) - 1),
+          entries_(std::make_unique<Entry[]>(mask_ + 1)),
+          stats_(stats ? stats : &own_stats_) {}
+
+    // True if this match of rule (Engine::rule(rule_index)) should be
+    // alerted. now_seconds is any monotonic clock in seconds.
+    bool allow(const Rule& rule, std::size_t rule_index, const flow::FlowKey& key, std::uint64_t now_seconds) {
+        const RuleThreshold& t = rule.threshold;
+        if (t.type == RuleThreshold::Type::None) return true;
+        ThresholdStats::bump(stats_->checked);
+
+        std::uint32_t address = t.track == RuleThreshold::Track::BySrc   ? key.src
+                                : t.track == RuleThreshold::Track::ByDst ? key.dst
+                                                                         : 0;
+        std::uint64_t k = (std::uint64_t{static_cast<std::uint32_t>(rule_index)} << 32) | address;
+        auto window_end = static_cast<std::uint32_t>((now_seconds / t.seconds + 1) * t.seconds);
+        auto now = static_cast<std::uint32_t>(now_seconds);
+
+        Entry* slot = nullptr;
+        Entry* victim = nullptr;
+        std::size_t index = static_cast<std::size_t>(core::hash64(k)) & mask_;
+        for (std::size_t i = 0; i < kProbe; ++i) {
+            Entry& e = entries_[(index + i) & mask_];
+            if (e.window_end != 0 && e.key == k) {
+                slot = &e;
+                break;
+            }
+            if (!victim || e.window_end < victim->window_end) victim = &e;
+        }
+        if (!slot) {
+            if (victim->window_end > now) ThresholdStats::bump(stats_->evicted);
+            slot = victim;
+            slot->key = k;
+            slot->window_end = 0;
+        }
+        if (slot->window_end <= now) {
+            slot->window_end = window_end;
+            slot->count = 0;
+        }
+
+        std::uint32_t hits = ++slot->count;
+        bool alert;
+        switch (t.type) {
+        case RuleThreshold::Type::Limit: alert = hits <= t.count; break;
+        case RuleThreshold::Type::Threshold:
+            alert = hits >= t.count;
+            if (alert) slot->count = 0;
+            break;
+        default: alert = hits == t.count; break;
+        }
+        if (!alert) ThresholdStats::bump(stats_->suppressed);
+        return alert;
+    }
+
+    const ThresholdStats& stats() const { return *stats_; }
+
+private:
+    struct Entry {
+        std::uint64_t key{0};        // rule index << 32 | tracked address
+        std::uint32_t window_end{0}; // end of the current window in seconds, 0 = empty
+        std::uint32_t count{0};      // hits in the current window
+    };
+
+    std::size_t mask_;
+    std::unique_ptr<Entry[]> entries_;
+    ThresholdStats own_stats_;
+    ThresholdStats* stats_;
+};
+
+} // namespace detect
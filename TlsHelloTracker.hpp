@@ -0,0 +1,79 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "core/dsa/SwissTable.hpp"
+#include "decode/TLS.hpp"
+#include "flow/FlowTable.hpp"
+
+namespace flow {
+
+// Per-worker TLS hello extraction. A hello held in the first segment is
+// parsed in place; one that continues into later segments is collected by
+// a TlsHelloReader from a fixed pool allocated up front. When every reader
+// is busy the oldest pending hello is abandoned.
+class TlsHelloTracker {
+public:
+    using Status = decode::TlsHelloReader::Status;
+
+    explicit TlsHelloTracker(std::size_t slots = 32)
+        : readers_(slots), keys_(slots), busy_(slots, false), index_(slots) {}
+
+    // Feeds the next (non-empty) TCP payload of a flow whose hello isn't
+    // known yet. On Done, hello is filled; its views are valid until the
+    // next call.
+    Status feed(const FlowKey& key, std::uint32_t seq, core::ByteSpan payload, decode::TlsHello& hello) {
+        if (std::uint32_t* slot = index_.find(key)) {
+            std::uint32_t s = *slot;
+            Status status = readers_[s].feed(seq, payload);
+            if (status == Status::NeedMore) return status;
+            release(s);
+            return status == Status::Done ? parse(readers_[s].message(), hello) : status;
+        }
+
+        core::ByteSpan message;
+        if (decode::tls_hello_message(payload, message)) return parse(message, hello);
+        bool partial_header = payload.size() < 5 && payload[0] == 22;
+        if (!partial_header && decode::tls_record_type(payload) != decode::TlsContentType::Handshake) {
+            return Status::NotTls;
+        }
+
+        // The hello continues past this segment (or this record)
+        std::uint32_t s = static_cast<std::uint32_t>(cursor_);
+        cursor_ = (cursor_ + 1) % readers_.size();
+        if (busy_[s]) {
+            release(s);
+            ++abandoned_;
+        }
+        readers_[s].reset(seq);
+        Status status = readers_[s].feed(seq, payload);
+        if (status == Status::Done) return parse(readers_[s].message(), hello);
+        if (status == Status::NeedMore) {
+            keys_[s] = key;
+            busy_[s] = true;
+            index_.try_emplace(key, s);
+        }
+        return status;
+    }
+
+    std::size_t pending() const { return index_.size(); }
+    std::uint64_t abandoned() const { return abandoned_; }
+
+private:
+    static Status parse(core::ByteSpan message, decode::TlsHello& hello) {
+        return decode::parse_tls_hello(message, hello) ? Status::Done : Status::Error;
+    }
+
+    void release(std::uint32_t slot) {
+        index_.erase(keys_[slot]);
+        busy_[slot] = false;
+    }
+
+    std::vector<decode::TlsHelloReader> readers_;
+    std::vector<FlowKey> keys_;
+    std::vector<bool> busy_;
+    core::dsa::SwissTable<FlowKey, std::uint32_t, FlowKeyHash> index_;
+    std::size_t cursor_{0};
+    std::uint64_t abandoned_{0};
+};
+
+} // namespace flow
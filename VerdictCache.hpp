@@ -0,0 +1,129 @@
+#pragma once
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <vector>
+#include "core/dsa/SwissTable.hpp"
+#include "flow/FlowTable.hpp"
+#include "ips/Action.hpp"
+
+namespace ips {
+
+// Counters are written by the decision thread only and read by the stats
+// thread, so plain relaxed load/store pairs suffice
+struct VerdictStats {
+    std::atomic<std::uint64_t> fast_drops{0};   // dropped from a cached drop verdict
+    std::atomic<std::uint64_t> fast_passes{0};  // passed: flow beyond the inspection depth
+    std::atomic<std::uint64_t> inspected{0};    // went through the full decision
+    std::atomic<std::uint64_t> expired{0};      // entries removed (idle, or FIN/RST when not dropped)
+    std::atomic<std::uint64_t> untracked{0};    // inspected without an entry: table full
+
+    static void bump(std::atomic<std::uint64_t>& counter, std::uint64_t n = 1) {
+        counter.store(counter.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+    }
+};
+
+// Per-flow verdicts for the inline (WinDivert) path, consulted right after
+// decode. A flow that was dropped once stays dropped; a flow that has had
+// inspect_depth payload bytes pass inspection is passed from then on.
+// Either way later packets skip inspection entirely.
+//
+// Entries expire after idle_timeout without packets. A TCP FIN/RST also
+// ends a flow's pass or pending entry, but not a drop: the FIN of a dropped
+// flow was itself dropped, so the endpoint never saw it and the same
+// 5-tuple could carry on unchecked. Used from the decision thread only.
+class VerdictCache {
+public:
+    enum class Verdict : std::uint8_t { None, Pass, Drop };
+
+    struct Config {
+        std::size_t capacity{16384};
+        std::uint64_t inspect_depth{1024 * 1024}; // payload bytes; 0 = never cache pass verdicts
+        std::chrono::steady_clock::duration idle_timeout{std::chrono::seconds(60)};
+    };
+
+    explicit VerdictCache(const Config& config) : config_(config), table_(config.capacity) {}
+
+    // Cached verdict for the flow, or None if the packet needs inspection
+    Verdict lookup(const flow::FlowKey& key, std::chrono::steady_clock::time_point now) {
+        maybe_expire(now);
+        Entry* entry = table_.find(key);
+        if (!entry) return Verdict::None;
+        if (now - entry->last_seen > config_.idle_timeout) {
+            table_.erase(key);
+            VerdictStats::bump(stats_.expired);
+            return Verdict::None;
+        }
+        entry->last_seen = now;
+        if (entry->verdict == Verdict::Drop) VerdictStats::bump(stats_.fast_drops);
+        else if (entry->verdict == Verdict::Pass) VerdictStats::bump(stats_.fast_passes);
+        return entry->verdict;
+    }
+
+    // Records the outcome of a full inspection of payload_bytes
+    void record(const flow::FlowKey& key, Decision decision, std::size_t payload_bytes,
+                std::chrono::steady_clock::time_point now) {
+        VerdictStats::bump(stats_.inspected);
+        Entry* entry = table_.find(key);
+        if (!entry) {
+            if (table_.size() >= config_.capacity) expire(now);
+            if (table_.size() >= config_.capacity) {
+                VerdictStats::bump(stats_.untracked);
+                return;
+            }
+            entry = table_.try_emplace(key, Entry{}).first;
+        }
+        entry->last_seen = now;
+        if (decision == Decision::Drop) {
+            entry->verdict = Verdict::Drop;
+            return;
+        }
+        entry->inspected_bytes += payload_bytes;
+        if (config_.inspect_depth != 0 && entry->inspected_bytes >= config_.inspect_depth) {
+            entry->verdict = Verdict::Pass;
+        }
+    }
+
+    // Flow teardown (TCP FIN/RST); drop verdicts stay until idle
+    void end_flow(const flow::FlowKey& key) {
+        Entry* entry = table_.find(key);
+        if (!entry || entry->verdict == Verdict::Drop) return;
+        table_.erase(key);
+        VerdictStats::bump(stats_.expired);
+    }
+
+    // Removes entries idle for longer than the timeout
+    void expire(std::chrono::steady_clock::time_point now) {
+        expired_keys_.clear();
+        table_.for_each([&](const flow::FlowKey& key, const Entry& entry) {
+            if (now - entry.last_seen > config_.idle_timeout) expired_keys_.push_back(key);
+        });
+        for (const auto& key : expired_keys_) table_.erase(key);
+        VerdictStats::bump(stats_.expired, expired_keys_.size());
+        last_sweep_ = now;
+    }
+
+    std::size_t size() const { return table_.size(); }
+    const VerdictStats& stats() const { return stats_; }
+
+private:
+    struct Entry {
+        Verdict verdict{Verdict::None};
+        std::uint64_t inspected_bytes{0};
+        std::chrono::steady_clock::time_point last_seen{};
+    };
+
+    // Sweeps at most once per timeout period, so idle flows are gone within
+    // two timeouts even if they never send another packet
+    void maybe_expire(std::chrono::steady_clock::time_point now) {
+        if (now - last_sweep_ >= config_.idle_timeout) expire(now);
+    }
+
+    Config config_;
+    core::dsa::SwissTable<flow::FlowKey, Entry, flow::FlowKeyHash> table_;
+    std::vector<flow::FlowKey> expired_keys_;
+    std::chrono::steady_clock::time_point last_sweep_{};
+    VerdictStats stats_;
+};
+
+} // namespace ips
@@ -0,0 +1,86 @@
+// Blocked Bloom filter benchmark: one contains_hash() call per key vs
+// contains_batch() with the scalar kernel and with the AVX2 kernel (when
+// the CPU has it), on a filter that fits in cache and on one that doesn't.
+// Half the queried keys were inserted.
+//
+//   bench_bloom [small_keys] [large_keys]
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/CpuFeatures.hpp"
+#include "core/dsa/BlockedBloomFilter.hpp"
+
+using Clock = std::chrono::steady_clock;
+using core::dsa::BlockedBloomFilter;
+
+static double ns_per_key(Clock::time_point start, std::size_t keys) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(keys);
+}
+
+static void report(const char* label, double ns, std::uint64_t hits, double base) {
+    std::cout << "  " << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << ns << " ns/key";
+    if (base > 0) std::cout << "  x" << base / ns;
+    std::cout << "   (hits " << hits << ")\n";
+}
+
+static void batch(BlockedBloomFilter& filter, const std::vector<std::uint64_t>& queries, core::SimdLevel level,
+                  const char* label, double base) {
+    constexpr std::size_t kBatch = 64;
+    filter.limit_simd(level);
+    if (filter.simd_level() != level) {
+        std::cout << "  " << std::left << std::setw(16) << label << "not available on this CPU\n";
+        return;
+    }
+    std::uint8_t out[kBatch];
+    std::uint64_t hits = 0;
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < queries.size(); i += kBatch) {
+        std::size_t n = std::min(kBatch, queries.size() - i);
+        filter.contains_batch(queries.data() + i, n, out);
+        for (std::size_t j = 0; j < n; ++j) hits += out[j];
+    }
+    report(label, ns_per_key(start, queries.size()), hits, base);
+}
+
+static void scenario(std::size_t keys) {
+    std::mt19937_64 rng(keys);
+    std::vector<std::uint64_t> inserted(keys);
+    for (auto& h : inserted) h = rng();
+    std::vector<std::uint64_t> queries(8'000'000);
+    for (std::size_t i = 0; i < queries.size(); ++i) queries[i] = i % 2 ? inserted[rng() % keys] : rng();
+
+    std::cout << keys << " keys, " << keys * 10 / 8 / 1024 << " KiB filter, " << queries.size() << " queries:\n";
+    // Built and queried fresh for each kernel, since limit_simd() only lowers
+    auto build = [&] {
+        BlockedBloomFilter filter(keys);
+        filter.insert_batch(inserted.data(), inserted.size());
+        return filter;
+    };
+
+    BlockedBloomFilter single = build();
+    std::uint64_t hits = 0;
+    auto start = Clock::now();
+    for (auto h : queries) hits += single.contains_hash(h) ? 1 : 0;
+    double base = ns_per_key(start, queries.size());
+    report("one by one", base, hits, 0);
+
+    BlockedBloomFilter scalar = build();
+    batch(scalar, queries, core::SimdLevel::None, "batch scalar", base);
+    BlockedBloomFilter avx2 = build();
+    batch(avx2, queries, core::SimdLevel::Avx2, "batch AVX2", base);
+}
+
+int main(int argc, char** argv) {
+    std::size_t small = argc > 1 ? std::stoul(argv[1]) : 100000;
+    std::size_t large = argc > 2 ? std::stoul(argv[2]) : 20000000;
+    std::cout << "CPU SIMD level: " << core::simd_level_name(core::cpu_simd_level()) << "\n";
+    scenario(small);
+    scenario(large);
+    return 0;
+}
@@ -0,0 +1,120 @@
+// Rule compilation benchmark: load_rules + Engine::add_rules + build on a
+// synthetic rule file, serially and on thread pools of increasing size.
+// Also reports the share of the pooled compile spent in parallel regions
+// (ThreadPool::parallel_seconds) and the speedup they allow at most on more
+// cores (Amdahl, with each region capped at its task count), which can be
+// read even on a machine with few cores.
+//
+//   bench_compile [rules] [max_threads]
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "config/ConfigLoader.hpp"
+#include "core/ThreadPool.hpp"
+#include "detect/Engine.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// One rule per line: 80% literals, 20% regexes with a literal prefix
+static std::string write_rules(std::size_t count) {
+    std::string path = "bench_compile_rules.txt";
+    std::ofstream out(path, std::ios::binary);
+    std::mt19937 rng(7);
+    auto word = [&](std::size_t len) {
+        std::string w;
+        for (std::size_t i = 0; i < len; ++i) w += static_cast<char>('a' + rng() % 26);
+        return w;
+    };
+    for (std::size_t i = 0; i < count; ++i) {
+        if (rng() % 5 == 0) {
+            out << "Regex rule " << i << "|/" << word(5) << "[0-9]{2,4}" << word(3) << "/i\n";
+        } else {
+            out << "Literal rule " << i << "|" << word(6 + rng() % 8) << "\n";
+        }
+    }
+    return path;
+}
+
+struct Result {
+    double seconds;
+    double parallel_seconds;
+    std::vector<double> parallel_on; // parallel_seconds_on(kCores[i])
+    std::size_t rules;
+};
+
+static constexpr std::size_t kCores[] = {2, 4, 8, 16};
+
+static Result compile(const std::string& path, core::ThreadPool* pool) {
+    double parallel_before = pool ? pool->parallel_seconds() : 0.0;
+    std::vector<double> on_before;
+    for (std::size_t cores : kCores) on_before.push_back(pool ? pool->parallel_seconds_on(cores) : 0.0);
+    auto start = Clock::now();
+    auto rules = config::load_rules(path, pool);
+    auto engine = std::make_unique<detect::Engine>();
+    engine->add_rules(std::move(rules), pool);
+    engine->build(pool);
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    double parallel = pool ? pool->parallel_seconds() - parallel_before : 0.0;
+    std::vector<double> parallel_on;
+    for (std::size_t i = 0; i < std::size(kCores); ++i) {
+        parallel_on.push_back(pool ? pool->parallel_seconds_on(kCores[i]) - on_before[i] : 0.0);
+    }
+    return {seconds, parallel, parallel_on, engine->rule_count()};
+}
+
+static Result best_of(const std::string& path, core::ThreadPool* pool, int rounds) {
+    Result best = compile(path, pool);
+    for (int i = 1; i < rounds; ++i) {
+        Result r = compile(path, pool);
+        if (r.seconds < best.seconds) best = r;
+    }
+    return best;
+}
+
+int main(int argc, char** argv) {
+    std::size_t count = argc > 1 ? std::stoul(argv[1]) : 60000;
+    std::size_t hw = std::max(1u, std::thread::hardware_concurrency());
+    std::size_t max_threads = argc > 2 ? std::stoul(argv[2]) : std::max<std::size_t>(hw, 8);
+    std::string path = write_rules(count);
+    constexpr int kRounds = 3;
+
+    Result serial = best_of(path, nullptr, kRounds);
+    std::cout << "\n" << serial.rules << " rules, " << hw << " hardware threads\n";
+    std::cout << "  " << std::left << std::setw(10) << "serial" << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << serial.seconds * 1e3 << " ms\n";
+
+    Result widest{};
+    for (std::size_t threads = 1; threads <= max_threads; threads *= 2) {
+        core::ThreadPool pool(threads);
+        Result r = best_of(path, &pool, kRounds);
+        if (threads * 2 > max_threads) widest = r;
+        std::cout << "  " << std::left << std::setw(10) << (std::to_string(threads) + " thr") << std::right
+                  << std::setw(9) << r.seconds * 1e3 << " ms  x" << std::setprecision(2) << serial.seconds / r.seconds
+                  << (threads > hw ? "  (oversubscribed)" : "") << std::setprecision(1) << "\n";
+    }
+
+    // With a pool larger than the core count the parallel regions run their
+    // tasks back to back, so their wall time is the parallel work itself.
+    // Each region's work is assumed to split evenly over its tasks, and a
+    // region never uses more cores than it has tasks.
+    double serial_part = widest.seconds - widest.parallel_seconds;
+    std::cout << "Parallel regions: " << std::setprecision(1) << widest.parallel_seconds / widest.seconds * 100.0
+              << "% of the pooled compile; at most";
+    for (std::size_t i = 0; i < std::size(kCores); ++i) {
+        double bound = widest.seconds / (serial_part + widest.parallel_on[i]);
+        std::cout << "  " << kCores[i] << " cores x" << std::setprecision(2) << bound;
+    }
+    std::cout << "\n";
+    std::remove(path.c_str());
+    return 0;
+}
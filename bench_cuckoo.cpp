@@ -0,0 +1,84 @@
+// Concurrent cuckoo hash benchmark: the load factor each table reaches
+// before its first resize (insert random keys until generation() moves,
+// over several seeds and table sizes), then writer insert time and Reader
+// lookup time for hits and misses at 95% load.
+//
+//   bench_cuckoo [slots] [seeds]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/dsa/ConcurrentCuckooHash.hpp"
+
+using Clock = std::chrono::steady_clock;
+using Table = core::dsa::ConcurrentCuckooHash<std::uint64_t, std::uint64_t>;
+
+static double ns_per_op(Clock::time_point start, std::size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+// Size of the table just before the insert that made it grow
+static double load_at_first_resize(std::size_t slots, std::uint64_t seed) {
+    Table table(slots);
+    std::mt19937_64 rng(seed);
+    std::size_t before = 0;
+    while (table.generation() == 0) {
+        before = table.size();
+        table.insert_or_assign(rng(), 0);
+    }
+    return static_cast<double>(before) / static_cast<double>(slots);
+}
+
+static void load_factors(std::size_t slots, int seeds) {
+    std::vector<double> loads;
+    for (int s = 0; s < seeds; ++s) loads.push_back(load_at_first_resize(slots, static_cast<std::uint64_t>(s) + 1));
+    std::sort(loads.begin(), loads.end());
+    double mean = 0;
+    for (double l : loads) mean += l;
+    mean /= static_cast<double>(loads.size());
+    std::cout << "  " << std::setw(9) << slots << " slots: min " << std::fixed << std::setprecision(1)
+              << loads.front() * 100.0 << "%  mean " << mean * 100.0 << "%  max " << loads.back() * 100.0 << "%\n";
+}
+
+static void throughput(std::size_t slots) {
+    Table table(slots);
+    std::mt19937_64 rng(99);
+    std::vector<std::uint64_t> keys;
+    auto start = Clock::now();
+    // 95%: below the lowest first-resize load measured above
+    while (keys.size() < slots * 95 / 100) {
+        keys.push_back(rng());
+        table.insert_or_assign(keys.back(), keys.back());
+    }
+    double insert_ns = ns_per_op(start, keys.size());
+    std::vector<std::uint64_t> order(keys);
+    std::shuffle(order.begin(), order.end(), rng);
+
+    Table::Reader reader(table);
+    std::uint64_t found = 0, value = 0;
+    start = Clock::now();
+    for (auto k : order) found += reader.find(k, value) ? 1 : 0;
+    double hit_ns = ns_per_op(start, order.size());
+    start = Clock::now();
+    for (std::size_t i = 0; i < order.size(); ++i) found += reader.find(rng(), value) ? 1 : 0;
+    double miss_ns = ns_per_op(start, order.size());
+
+    std::cout << "  " << keys.size() << " keys (" << std::setprecision(1) << table.load_factor() * 100.0
+              << "% load, " << table.memory_usage() / 1024 << " KiB): insert " << std::setprecision(1) << insert_ns
+              << " ns  hit " << hit_ns << " ns  miss " << miss_ns << " ns   (found " << found << ")\n";
+}
+
+int main(int argc, char** argv) {
+    std::size_t slots = argc > 1 ? std::stoul(argv[1]) : (std::size_t{1} << 20);
+    int seeds = argc > 2 ? std::stoi(argv[2]) : 20;
+    std::cout << "Load factor at the first resize (" << seeds << " seeds):\n";
+    for (std::size_t s = 1024; s <= slots; s *= 16) load_factors(s, seeds);
+    std::cout << "Writer inserts and Reader lookups:\n";
+    throughput(slots);
+    return 0;
+}
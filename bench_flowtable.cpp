@@ -0,0 +1,142 @@
+// Flow table benchmark: decode + flow lookup per packet, one lookup at a
+// time (FlowTable::touch) vs bursts resolved with lookup_batch, which
+// hashes and prefetches a whole burst before resolving it. Packets are
+// Ethernet/IPv4/TCP frames spread uniformly over `flows` live flows (all
+// hits once warm), then over twice as many (half the lookups evict).
+//
+//   bench_flowtable [flows] [packets]
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Packet.hpp"
+#include "decode/Ethernet.hpp"
+#include "flow/FlowTable.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+// Frames in one flat buffer, kStride bytes apart
+struct Traffic {
+    static constexpr std::size_t kStride = 64;
+    static constexpr std::size_t kFrame = 60; // 14 Ethernet + 20 IPv4 + 20 TCP + 6 payload
+
+    std::vector<std::uint8_t> bytes;
+    std::size_t packets{0};
+
+    core::ByteSpan frame(std::size_t i) const { return {bytes.data() + i * kStride, kFrame}; }
+};
+
+static void put16(std::uint8_t* p, std::uint32_t v) {
+    p[0] = static_cast<std::uint8_t>(v >> 8);
+    p[1] = static_cast<std::uint8_t>(v);
+}
+
+static void put32(std::uint8_t* p, std::uint32_t v) {
+    put16(p, v >> 16);
+    put16(p + 2, v);
+}
+
+// Flow n is 10.x.y.z:(1024 + n % 60000) -> 192.168.1.1:443. Packets pick
+// flows at random, or in turn with seed 0.
+static Traffic make_traffic(std::size_t packets, std::size_t flows, std::uint64_t seed) {
+    Traffic t;
+    t.packets = packets;
+    t.bytes.assign(packets * Traffic::kStride, 0);
+    std::mt19937_64 rng(seed);
+    for (std::size_t i = 0; i < packets; ++i) {
+        auto n = static_cast<std::uint32_t>((seed ? rng() : i) % flows);
+        std::uint8_t* f = t.bytes.data() + i * Traffic::kStride;
+        put16(f + 12, 0x0800);
+        std::uint8_t* ip = f + 14;
+        ip[0] = 0x45;
+        put16(ip + 2, 46);
+        ip[8] = 64;
+        ip[9] = 6;
+        put32(ip + 12, 0x0A000000u + n);
+        put32(ip + 16, 0xC0A80101u);
+        std::uint8_t* tcp = ip + 20;
+        put16(tcp, 1024 + n % 60000);
+        put16(tcp + 2, 443);
+        put32(tcp + 4, static_cast<std::uint32_t>(i));
+        tcp[12] = 0x50;
+        tcp[13] = 0x18;
+    }
+    return t;
+}
+
+static bool decode_frame(core::ByteSpan frame, flow::DecodedFlow& out) {
+    decode::EthernetHeader eth{};
+    core::ByteSpan l3;
+    return decode::parse_ethernet(frame, eth, l3) && eth.ethertype == 0x0800 && flow::decode_flow(l3, out);
+}
+
+// Packets per second through decode and the flow table; burst 0 = touch()
+static double run(const Traffic& traffic, std::size_t flows, std::size_t burst, std::uint64_t& check) {
+    flow::FlowTable table(flows);
+    auto now = Clock::now();
+    // Warm: every flow the table holds is live
+    Traffic warm = make_traffic(flows, flows, 0);
+    flow::DecodedFlow d;
+    for (std::size_t i = 0; i < warm.packets; ++i) {
+        if (decode_frame(warm.frame(i), d)) table.touch(d.key, now);
+    }
+
+    std::vector<flow::DecodedFlow> decoded(burst ? burst : 1);
+    std::vector<flow::FlowKey> keys(burst ? burst : 1);
+    std::vector<flow::FlowEntry*> entries(burst ? burst : 1);
+    auto start = Clock::now();
+    if (burst == 0) {
+        for (std::size_t i = 0; i < traffic.packets; ++i) {
+            if (!decode_frame(traffic.frame(i), d)) continue;
+            table.touch(d.key, now).bytes += Traffic::kFrame;
+        }
+    } else {
+        for (std::size_t base = 0; base < traffic.packets; base += burst) {
+            std::size_t n = std::min(burst, traffic.packets - base);
+            std::size_t m = 0;
+            for (std::size_t i = 0; i < n; ++i) {
+                if (!decode_frame(traffic.frame(base + i), decoded[m])) continue;
+                keys[m] = decoded[m].key;
+                ++m;
+            }
+            table.lookup_batch(keys.data(), m, entries.data());
+            for (std::size_t i = 0; i < m; ++i) {
+                flow::FlowTable::touch_entry(*entries[i], now);
+                entries[i]->bytes += Traffic::kFrame;
+            }
+        }
+    }
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    check = table.size();
+    return static_cast<double>(traffic.packets) / seconds;
+}
+
+static void scenario(const char* title, const Traffic& traffic, std::size_t flows) {
+    std::cout << title << "\n";
+    std::uint64_t check = 0;
+    double base = run(traffic, flows, 0, check);
+    std::cout << "  " << std::left << std::setw(12) << "one by one" << std::right << std::fixed << std::setprecision(2)
+              << std::setw(8) << base / 1e6 << " Mpps\n";
+    for (std::size_t burst : {8, 16, 32, 64}) {
+        double pps = run(traffic, flows, burst, check);
+        std::cout << "  " << std::left << std::setw(12) << ("burst " + std::to_string(burst)) << std::right
+                  << std::setw(8) << pps / 1e6 << " Mpps  x" << std::setprecision(2) << pps / base
+                  << "   (flows " << check << ")\n";
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t flows = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    std::size_t packets = argc > 2 ? std::stoul(argv[2]) : 4000000;
+
+    std::cout << flows << " flows, " << packets << " packets\n";
+    scenario("All flows live (every lookup hits):", make_traffic(packets, flows, 1), flows);
+    scenario("Twice as many flows as the table holds (about half evict):", make_traffic(packets, flows * 2, 2),
+             flows);
+    return 0;
+}
@@ -0,0 +1,202 @@
+// Hash table benchmark: SwissTable vs RobinHoodHash vs std::unordered_map
+// with 64-bit keys (flow/IOC-style) and string keys (domain-style). Churn
+// is one erase plus one insert on a table kept at a constant size.
+//
+//   bench_hashtables [entries]
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "core/Hash.hpp"
+#include "core/dsa/RobinHoodHash.hpp"
+#include "core/dsa/SwissTable.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Keys {
+    std::vector<std::uint64_t> present; // inserted
+    std::vector<std::uint64_t> absent;  // never inserted
+};
+
+static Keys make_keys(std::size_t n) {
+    std::mt19937_64 rng(42);
+    Keys keys;
+    keys.present.resize(n);
+    keys.absent.resize(n);
+    for (auto& k : keys.present) k = rng() | 1;  // odd
+    for (auto& k : keys.absent) k = rng() & ~1ull; // even
+    return keys;
+}
+
+static double ns_per_op(Clock::time_point start, std::size_t ops) {
+    return std::chrono::duration<double, std::nano>(Clock::now() - start).count() / static_cast<double>(ops);
+}
+
+static void report(const char* label, double insert, double hit, double miss, double erase, double churn,
+                   std::uint64_t check) {
+    std::cout << "  " << std::left << std::setw(16) << label << std::right << std::fixed << std::setprecision(1)
+              << std::setw(9) << insert << std::setw(9) << hit << std::setw(9) << miss << std::setw(9) << erase;
+    if (churn > 0) {
+        std::cout << std::setw(9) << churn;
+    } else {
+        std::cout << std::setw(9) << "-";
+    }
+    std::cout << "   (check " << check << ")\n";
+}
+
+// Table adapters: insert / find (returns value or 0) / erase
+struct SwissU64 {
+    core::dsa::SwissTable<std::uint64_t, std::uint64_t> t;
+    void insert(std::uint64_t k, std::uint64_t v) { t.try_emplace(k, v); }
+    std::uint64_t find(std::uint64_t k) const {
+        const auto* v = t.find(k);
+        return v ? *v : 0;
+    }
+    void erase(std::uint64_t k) { t.erase(k); }
+};
+
+struct RobinU64 {
+    core::dsa::RobinHoodHash<std::uint64_t, std::uint64_t> t{1024};
+    void insert(std::uint64_t k, std::uint64_t v) { t.insert(k, v); }
+    std::uint64_t find(std::uint64_t k) const { return t.find(k).value_or(0); }
+    void erase(std::uint64_t k) { t.erase(k); }
+};
+
+struct StdU64 {
+    std::unordered_map<std::uint64_t, std::uint64_t> t;
+    void insert(std::uint64_t k, std::uint64_t v) { t.try_emplace(k, v); }
+    std::uint64_t find(std::uint64_t k) const {
+        auto it = t.find(k);
+        return it == t.end() ? 0 : it->second;
+    }
+    void erase(std::uint64_t k) { t.erase(k); }
+};
+
+template <typename Table>
+static void run_u64(const char* label, const Keys& keys) {
+    Table table;
+    std::size_t n = keys.present.size();
+    std::uint64_t check = 0;
+
+    auto start = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) table.insert(keys.present[i], i + 1);
+    double insert = ns_per_op(start, n);
+
+    start = Clock::now();
+    for (auto k : keys.present) check += table.find(k);
+    double hit = ns_per_op(start, n);
+
+    start = Clock::now();
+    for (auto k : keys.absent) check += table.find(k);
+    double miss = ns_per_op(start, n);
+
+    start = Clock::now();
+    for (std::size_t i = 0; i < n; i += 2) table.erase(keys.present[i]);
+    double erase = ns_per_op(start, n / 2);
+
+    // Flow-expiry churn on a full table: the oldest of n live keys is erased
+    // and a new one inserted, n times
+    Table churn_table;
+    for (auto k : keys.present) churn_table.insert(k, 1);
+    start = Clock::now();
+    for (std::size_t i = 0; i < n; ++i) {
+        churn_table.erase(keys.present[i]);
+        churn_table.insert(keys.absent[i], 1);
+    }
+    double churn = ns_per_op(start, n);
+    for (std::size_t i = 0; i < n; i += 97) check += churn_table.find(keys.absent[i]);
+
+    report(label, insert, hit, miss, erase, churn, check);
+}
+
+static std::vector<std::string> make_domains(std::size_t n, std::uint64_t seed) {
+    static const char* tlds[] = {".com", ".net", ".org", ".io", ".ru"};
+    std::mt19937_64 rng(seed);
+    std::vector<std::string> names(n);
+    for (auto& name : names) {
+        std::size_t len = 6 + rng() % 14;
+        for (std::size_t i = 0; i < len; ++i) name += static_cast<char>('a' + rng() % 26);
+        name += tlds[rng() % 5];
+    }
+    return names;
+}
+
+// Lookups take string_views from packet buffers: SwissTable probes them
+// directly (transparent hash); std::unordered_map (C++17) needs a std::string
+static void run_strings(std::size_t n) {
+    auto present = make_domains(n, 1);
+    auto absent = make_domains(n, 2);
+    for (auto& name : absent) name.insert(0, "x-");
+    std::vector<std::string_view> present_views(present.begin(), present.end());
+    std::vector<std::string_view> absent_views(absent.begin(), absent.end());
+
+    {
+        core::dsa::SwissTable<std::string, std::uint32_t, core::StringHash, std::equal_to<>> table;
+        std::uint64_t check = 0;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) table.try_emplace(present[i], static_cast<std::uint32_t>(i + 1));
+        double insert = ns_per_op(start, n);
+        start = Clock::now();
+        for (auto v : present_views) if (const auto* p = table.find(v)) check += *p;
+        double hit = ns_per_op(start, n);
+        start = Clock::now();
+        for (auto v : absent_views) if (const auto* p = table.find(v)) check += *p;
+        double miss = ns_per_op(start, n);
+        start = Clock::now();
+        for (std::size_t i = 0; i < n; i += 2) table.erase(present_views[i]);
+        double erase = ns_per_op(start, n / 2);
+        report("SwissTable", insert, hit, miss, erase, 0, check);
+    }
+    {
+        std::unordered_map<std::string, std::uint32_t> table;
+        std::uint64_t check = 0;
+        auto start = Clock::now();
+        for (std::size_t i = 0; i < n; ++i) table.try_emplace(present[i], static_cast<std::uint32_t>(i + 1));
+        double insert = ns_per_op(start, n);
+        start = Clock::now();
+        for (auto v : present_views) {
+            auto it = table.find(std::string(v));
+            if (it != table.end()) check += it->second;
+        }
+        double hit = ns_per_op(start, n);
+        start = Clock::now();
+        for (auto v : absent_views) {
+            auto it = table.find(std::string(v));
+            if (it != table.end()) check += it->second;
+        }
+        double miss = ns_per_op(start, n);
+        start = Clock::now();
+        for (std::size_t i = 0; i < n; i += 2) table.erase(std::string(present_views[i]));
+        double erase = ns_per_op(start, n / 2);
+        report("unordered_map", insert, hit, miss, erase, 0, check);
+    }
+}
+
+int main(int argc, char** argv) {
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : 1000000;
+
+#if defined(IDS_SWISS_SSE2)
+    const char* simd = "SSE2";
+#else
+    const char* simd = "scalar";
+#endif
+    std::cout << n << " entries, SwissTable probe: " << simd << "\n";
+    std::cout << "  ns/op            " << std::right << std::setw(9) << "insert" << std::setw(9) << "hit"
+              << std::setw(9) << "miss" << std::setw(9) << "erase" << std::setw(9) << "churn" << "\n";
+
+    std::cout << "uint64 keys:\n";
+    auto keys = make_keys(n);
+    run_u64<SwissU64>("SwissTable", keys);
+    run_u64<RobinU64>("RobinHoodHash", keys);
+    run_u64<StdU64>("unordered_map", keys);
+
+    std::cout << "domain keys:\n";
+    run_strings(n);
+    return 0;
+}
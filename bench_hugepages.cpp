@@ -0,0 +1,190 @@
+// Huge page benchmark: random accesses over a large table (standing in for
+// a DFA transition table) and flow table churn, on normal pages, on the
+// heap, and on transparent / 2 MB / 1 GB huge pages, with dTLB misses read
+// from perf counters (Linux; "n/a" where perf_event_open is unavailable,
+// e.g. perf_event_paranoid > 2 or other platforms). Backings that can't be
+// obtained fall back and are reported as such.
+//
+//   bench_hugepages [table_mb] [flows]
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Arena.hpp"
+#include "flow/FlowTable.hpp"
+
+#if defined(__linux__)
+#include <cstring>
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// One hardware counter for the calling thread, user space only
+class PerfCounter {
+public:
+    enum class Event { DtlbLoadMisses, Cycles };
+
+    explicit PerfCounter(Event event) {
+#if defined(__linux__)
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        if (event == Event::DtlbLoadMisses) {
+            attr.type = PERF_TYPE_HW_CACHE;
+            attr.config = PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                          (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        } else {
+            attr.type = PERF_TYPE_HARDWARE;
+            attr.config = PERF_COUNT_HW_CPU_CYCLES;
+        }
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        fd_ = static_cast<int>(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#else
+        (void)event;
+#endif
+    }
+    ~PerfCounter() {
+#if defined(__linux__)
+        if (fd_ >= 0) close(fd_);
+#endif
+    }
+
+    void start() {
+#if defined(__linux__)
+        if (fd_ < 0) return;
+        ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+        ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+    }
+
+    // Count since start(), or -1 if the counter isn't available
+    long long stop() {
+#if defined(__linux__)
+        if (fd_ < 0) return -1;
+        ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+        long long value = 0;
+        if (read(fd_, &value, sizeof(value)) != static_cast<ssize_t>(sizeof(value))) return -1;
+        return value;
+#else
+        return -1;
+#endif
+    }
+
+private:
+    int fd_{-1};
+};
+
+struct Sample {
+    double seconds;
+    long long tlb_misses;
+    long long cycles;
+};
+
+template <typename F>
+static Sample measure(F&& work) {
+    PerfCounter tlb(PerfCounter::Event::DtlbLoadMisses);
+    PerfCounter cycles(PerfCounter::Event::Cycles);
+    tlb.start();
+    cycles.start();
+    auto start = Clock::now();
+    work();
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    return {seconds, tlb.stop(), cycles.stop()};
+}
+
+static void report(const std::string& label, const std::string& backing, const Sample& s, std::uint64_t ops) {
+    std::cout << "  " << std::left << std::setw(12) << label << std::setw(24) << backing << std::right << std::fixed
+              << std::setprecision(1) << std::setw(8) << s.seconds * 1e9 / static_cast<double>(ops) << " ns/op";
+    if (s.tlb_misses >= 0) {
+        std::cout << std::setw(12) << s.tlb_misses << " dTLB misses (" << std::setprecision(3)
+                  << static_cast<double>(s.tlb_misses) / static_cast<double>(ops) << "/op)";
+    } else {
+        std::cout << "  dTLB misses n/a";
+    }
+    if (s.cycles >= 0) std::cout << std::setprecision(0) << std::setw(8) << static_cast<double>(s.cycles) / static_cast<double>(ops) << " cycles/op";
+    std::cout << "\n";
+}
+
+// Dependent loads through a single random cycle over the table (Sattolo's
+// shuffle), so every access is a fresh page with no prefetching help
+static void table_walk(std::size_t table_mb, core::HugePages pages, const char* label) {
+    std::size_t entries = (table_mb << 20) / sizeof(std::uint32_t);
+    core::PageRegion region;
+    if (!region.map(entries * sizeof(std::uint32_t), pages)) {
+        std::cout << "  " << label << ": cannot map " << table_mb << " MB\n";
+        return;
+    }
+    auto* table = reinterpret_cast<std::uint32_t*>(region.data());
+    for (std::size_t i = 0; i < entries; ++i) table[i] = static_cast<std::uint32_t>(i);
+    std::mt19937_64 rng(1);
+    for (std::size_t i = entries - 1; i > 0; --i) std::swap(table[i], table[rng() % i]);
+
+    const std::uint64_t steps = 10'000'000;
+    std::uint32_t at = 0;
+    Sample s = measure([&] {
+        for (std::uint64_t i = 0; i < steps; ++i) at = table[at];
+    });
+    volatile std::uint32_t sink = at; // keep the walk
+    (void)sink;
+    report(label, core::huge_pages_name(region.backing()), s, steps);
+}
+
+// Random touches over twice as many keys as the table holds, so about half
+// are misses that evict and insert
+static void flow_churn(std::size_t flows, core::HugePages pages, bool use_arena, const char* label) {
+    std::unique_ptr<core::Arena> arena;
+    if (use_arena) arena = std::make_unique<core::Arena>(flow::FlowTable::arena_bytes(flows), pages);
+    flow::FlowTable table(flows, arena.get());
+
+    std::mt19937_64 rng(2);
+    std::vector<flow::FlowKey> keys(flows * 2);
+    for (auto& k : keys) {
+        k.src = static_cast<std::uint32_t>(rng());
+        k.dst = static_cast<std::uint32_t>(rng());
+        k.sport = static_cast<std::uint16_t>(rng());
+        k.dport = 443;
+        k.proto = 6;
+    }
+    auto now = Clock::now();
+    for (std::size_t i = 0; i < flows; ++i) table.touch(keys[i], now); // warm: fill the table
+
+    const std::uint64_t ops = 5'000'000;
+    std::vector<std::uint32_t> order(ops);
+    for (auto& o : order) o = static_cast<std::uint32_t>(rng() % keys.size());
+    Sample s = measure([&] {
+        for (std::uint64_t i = 0; i < ops; ++i) table.touch(keys[order[i]], now).bytes += 1;
+    });
+    std::string backing = arena ? core::huge_pages_name(arena->backing()) : "heap";
+    if (arena && arena->used() + 4096 > arena->capacity()) backing += " (arena full)";
+    report(label, backing, s, ops);
+}
+
+int main(int argc, char** argv) {
+    std::size_t table_mb = argc > 1 ? std::stoul(argv[1]) : 512;
+    std::size_t flows = argc > 2 ? std::stoul(argv[2]) : 1000000;
+
+    std::cout << "Random walk over a " << table_mb << " MB table:\n";
+    table_walk(table_mb, core::HugePages::Off, "normal");
+    table_walk(table_mb, core::HugePages::Transparent, "thp");
+    table_walk(table_mb, core::HugePages::Huge2M, "2m");
+    table_walk(table_mb, core::HugePages::Huge1G, "1g");
+
+    std::cout << "Flow table, " << flows << " flows, touches over " << flows * 2 << " keys:\n";
+    flow_churn(flows, core::HugePages::Off, false, "heap");
+    flow_churn(flows, core::HugePages::Off, true, "arena");
+    flow_churn(flows, core::HugePages::Transparent, true, "arena thp");
+    flow_churn(flows, core::HugePages::Huge2M, true, "arena 2m");
+    flow_churn(flows, core::HugePages::Huge1G, true, "arena 1g");
+    return 0;
+}
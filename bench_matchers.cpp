@@ -0,0 +1,104 @@
+// Literal matcher benchmark: memchr vs Teddy vs Aho-Corasick DFA on the
+// literals of a rules file (default sample_rules.json).
+//
+//   bench_matchers [rules_file] [corpus_megabytes]
+#include <chrono>
+#include <cstdint>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "config/ConfigLoader.hpp"
+#include "core/dsa/LiteralMatcher.hpp"
+#include "core/dsa/Regex.hpp"
+
+using Kind = core::dsa::LiteralMatcher::Kind;
+
+static std::vector<std::string> rule_literals(const std::string& filename) {
+    std::vector<std::string> literals;
+    for (const auto& rule : config::load_rules(filename)) {
+        if (!rule.payload_pattern.empty()) literals.push_back(rule.payload_pattern);
+        if (!rule.pcre.empty()) {
+            core::dsa::Regex re;
+            if (re.compile(rule.pcre, rule.pcre_flags)) {
+                for (const auto& l : re.required_literals()) literals.push_back(l);
+            }
+        }
+    }
+    return literals;
+}
+
+// HTTP-ish text with a pattern planted roughly every 4 KB
+static std::string make_corpus(std::size_t bytes, const std::vector<std::string>& literals) {
+    static const char* words[] = {"GET ", "/index.html ", "HTTP/1.1\r\n", "Host: ", "example.org\r\n",
+                                  "User-Agent: ", "Mozilla/5.0 ", "Accept: ", "text/html ", "cookie=",
+                                  "session ", "id=", "value ", "the ", "quick ", "brown ", "fox "};
+    std::mt19937 rng(42);
+    std::string corpus;
+    corpus.reserve(bytes + 64);
+    while (corpus.size() < bytes) {
+        if (!literals.empty() && rng() % 256 == 0) corpus += literals[rng() % literals.size()];
+        corpus += words[rng() % (sizeof(words) / sizeof(words[0]))];
+    }
+    corpus.resize(bytes);
+    return corpus;
+}
+
+static void run(const char* label, const std::vector<std::string>& literals, Kind kind, const std::string& corpus) {
+    core::dsa::LiteralMatcher matcher;
+    matcher.build(literals, kind);
+
+    // Scan in 1500-byte "packets" to reflect per-payload call overhead
+    constexpr std::size_t kPacket = 1500;
+    constexpr int kRounds = 5;
+    std::uint64_t hits = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (int round = 0; round < kRounds; ++round) {
+        for (std::size_t off = 0; off < corpus.size(); off += kPacket) {
+            std::string_view pkt(corpus.data() + off, std::min(kPacket, corpus.size() - off));
+            matcher.scan(pkt, [&](std::size_t, std::size_t) { ++hits; });
+        }
+    }
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double mbps = static_cast<double>(corpus.size()) * kRounds / secs / (1024.0 * 1024.0);
+
+    std::cout << "  " << std::left << std::setw(14) << label << std::setw(14)
+              << core::dsa::LiteralMatcher::kind_name(matcher.kind()) << std::right << std::setw(10)
+              << std::fixed << std::setprecision(1) << mbps << " MB/s  hits=" << hits / kRounds << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::string rules = argc > 1 ? argv[1] : "sample_rules.json";
+    std::size_t megabytes = argc > 2 ? std::stoul(argv[2]) : 16;
+
+    auto literals = rule_literals(rules);
+    if (literals.empty()) {
+        std::cerr << "No literals in " << rules << std::endl;
+        return 1;
+    }
+    std::string corpus = make_corpus(megabytes * 1024 * 1024, literals);
+
+    std::cout << "Corpus " << megabytes << " MB, Teddy path: " << core::simd_level_name(core::cpu_simd_level())
+              << "\n";
+
+    std::vector<std::string> one{literals[1 % literals.size()]};
+    std::vector<std::string> small(literals.begin(), literals.begin() + std::min<std::size_t>(8, literals.size()));
+
+    std::cout << "1 literal (\"" << one[0] << "\"):\n";
+    run("memchr", one, Kind::Memchr, corpus);
+    run("teddy", one, Kind::Teddy, corpus);
+    run("dfa", one, Kind::AhoCorasick, corpus);
+
+    std::cout << small.size() << " literals:\n";
+    run("teddy", small, Kind::Teddy, corpus);
+    run("dfa", small, Kind::AhoCorasick, corpus);
+
+    std::cout << literals.size() << " literals (full rule set):\n";
+    run("teddy", literals, Kind::Teddy, corpus);
+    run("dfa", literals, Kind::AhoCorasick, corpus);
+    run("auto", literals, core::dsa::LiteralMatcher::choose(literals), corpus);
+    return 0;
+}
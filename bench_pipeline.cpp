@@ -0,0 +1,239 @@
+// Pipeline mode benchmark: the same packets (a pcap file, or synthesized
+// TCP flows) fed from a capture thread through the packet path run to
+// completion on one worker (fused) and split into a prepare thread plus
+// 1..N detection lanes (staged). Prepare is decode, flow table and
+// inspection budget; detect is the rule engine and thresholds.
+//
+//   bench_pipeline [pcap_file|-] [rules_file] [max_lanes] [repeat]
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "capture/PcapFileSource.hpp"
+#include "config/ConfigLoader.hpp"
+#include "core/Metrics.hpp"
+#include "core/Packet.hpp"
+#include "core/Pipeline.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/dsa/RingBufferSPSC.hpp"
+#include "decode/Ethernet.hpp"
+#include "detect/Engine.hpp"
+#include "detect/EngineHandle.hpp"
+#include "detect/Threshold.hpp"
+#include "flow/FlowTable.hpp"
+
+using Clock = std::chrono::steady_clock;
+
+struct Task {
+    core::Packet packet;
+    flow::FlowKey key{};
+    std::size_t payload_offset{0};
+    std::size_t payload_size{0};
+};
+
+struct Lane {
+    core::MetricShard& metrics;
+    detect::EngineReader reader;
+    detect::ThresholdTable thresholds;
+    std::uint64_t alerts{0};
+
+    Lane(const detect::EngineHandle& handle, core::MetricShard& shard)
+        : metrics(shard), reader(handle, 4096), thresholds(65536) {}
+};
+
+// Ethernet/IPv4/TCP packets over `flows` flows with 1000-byte text payloads;
+// about one in 50 carries a rule literal
+static std::vector<core::Packet> make_traffic(std::size_t packets, std::size_t flows,
+                                              const std::vector<std::string>& literals) {
+    static const char* words[] = {"GET ", "/index.html ", "HTTP/1.1\r\n", "Host: ", "example.org\r\n",
+                                  "Accept: ", "text/html ", "cookie=", "session ", "the ", "quick ", "fox "};
+    constexpr std::size_t kHeaders = 14 + 20 + 20, kPayload = 1000;
+    std::mt19937_64 rng(7);
+    std::vector<core::Packet> traffic(packets);
+    for (std::size_t i = 0; i < packets; ++i) {
+        auto& p = traffic[i].bytes;
+        p.assign(kHeaders, 0);
+        p[12] = 0x08;
+        std::uint8_t* ip = p.data() + 14;
+        ip[0] = 0x45;
+        auto total = static_cast<std::uint16_t>(20 + 20 + kPayload);
+        ip[2] = static_cast<std::uint8_t>(total >> 8);
+        ip[3] = static_cast<std::uint8_t>(total);
+        ip[8] = 64;
+        ip[9] = 6;
+        auto flow = static_cast<std::uint32_t>(rng() % flows);
+        ip[12] = 10;
+        ip[13] = static_cast<std::uint8_t>(flow >> 16);
+        ip[14] = static_cast<std::uint8_t>(flow >> 8);
+        ip[15] = static_cast<std::uint8_t>(flow);
+        ip[16] = 192; ip[17] = 0; ip[18] = 2; ip[19] = 1;
+        std::uint8_t* tcp = ip + 20;
+        tcp[0] = 0x80; tcp[1] = static_cast<std::uint8_t>(flow);
+        tcp[2] = 0x00; tcp[3] = 0x50;
+        tcp[12] = 0x50;
+        tcp[13] = 0x18;
+        std::string payload;
+        while (payload.size() < kPayload) {
+            if (!literals.empty() && rng() % 50 == 0) payload += literals[rng() % literals.size()];
+            payload += words[rng() % (sizeof(words) / sizeof(words[0]))];
+        }
+        p.insert(p.end(), payload.begin(), payload.begin() + kPayload);
+        traffic[i].link = core::LinkType::Ethernet;
+    }
+    return traffic;
+}
+
+struct Result {
+    double seconds;
+    std::uint64_t alerts;
+    std::uint64_t p50_ns, p99_ns;
+    std::uint64_t stalls;
+};
+
+static Result run(const std::vector<core::Packet>& traffic, std::size_t repeat, const detect::EngineHandle& handle,
+                  core::PipelineConfig config) {
+    core::Metrics metrics;
+    core::MetricShard& prepare_metrics = metrics.register_thread();
+    core::Pipeline<Task> pipeline(config);
+    std::vector<std::unique_ptr<Lane>> lanes;
+    for (std::size_t i = 0; i < pipeline.lanes(); ++i) {
+        lanes.push_back(std::make_unique<Lane>(handle, metrics.register_thread()));
+    }
+    flow::FlowTable flows(65536);
+    flow::InspectionPolicy policy;
+    policy.stream_depth = 1u << 20;
+
+    auto ring = std::make_unique<core::dsa::RingBufferSPSC<core::Packet, 4096>>();
+    std::atomic<bool> done{false};
+
+    auto start = Clock::now();
+    std::thread capture([&] {
+        for (std::size_t r = 0; r < repeat; ++r) {
+            for (const auto& original : traffic) {
+                core::Packet p;
+                p.bytes = original.bytes;
+                p.link = original.link;
+                p.ts = Clock::now();
+                while (!ring->try_push(std::move(p))) std::this_thread::yield();
+            }
+        }
+        done = true;
+    });
+
+    auto prepare = [&](Task& task) {
+        const core::Packet& pkt = task.packet;
+        core::ByteSpan bytes{pkt.bytes.data(), pkt.bytes.size()};
+        core::ByteSpan l3 = bytes;
+        decode::EthernetHeader eth{};
+        flow::DecodedFlow decoded;
+        if ((pkt.link == core::LinkType::Ethernet &&
+             (!decode::parse_ethernet(bytes, eth, l3) || eth.ethertype != 0x0800)) ||
+            !flow::decode_flow(l3, decoded)) {
+            core::record_latency(prepare_metrics, pkt.ts);
+            return false;
+        }
+        auto& entry = flows.touch(decoded.key, pkt.ts);
+        core::ByteSpan payload = decoded.payload;
+        flow::apply_inspection_budget(entry, decoded.key, payload, policy);
+        if (payload.empty()) {
+            core::record_latency(prepare_metrics, pkt.ts);
+            return false;
+        }
+        task.key = decoded.key;
+        task.payload_offset = static_cast<std::size_t>(payload.data() - pkt.bytes.data());
+        task.payload_size = payload.size();
+        return true;
+    };
+    auto detect = [&](std::size_t lane_index, Task& task) {
+        Lane& lane = *lanes[lane_index];
+        core::ByteSpan payload{task.packet.bytes.data() + task.payload_offset, task.payload_size};
+        auto now_seconds = static_cast<std::uint64_t>(
+            std::chrono::duration_cast<std::chrono::seconds>(task.packet.ts.time_since_epoch()).count());
+        for (const auto& match : lane.reader.match(payload, &task.key)) {
+            if (lane.thresholds.allow(*match.rule, match.rule_index, task.key, now_seconds)) ++lane.alerts;
+        }
+        core::record_latency(lane.metrics, task.packet.ts);
+    };
+    pipeline.run(done, [&](core::Packet& p) { return ring->try_pop(p); }, prepare,
+                 [](const Task& t) { return static_cast<std::size_t>((t.key.src * 0x9E3779B1u) >> 16); }, detect,
+                 [&](std::size_t lane) { lanes[lane]->reader.refresh(); });
+    double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+    capture.join();
+
+    Result result{seconds, 0, 0, 0, pipeline.stats().lane_stalls.load()};
+    for (const auto& lane : lanes) result.alerts += lane->alerts;
+    auto latency = metrics.latency();
+    result.p50_ns = latency->quantile(0.5);
+    result.p99_ns = latency->quantile(0.99);
+    return result;
+}
+
+static void report(const std::string& label, const Result& r, std::size_t packets, std::uint64_t bytes) {
+    std::cout << "  " << std::left << std::setw(18) << label << std::right << std::fixed << std::setprecision(0)
+              << std::setw(10) << static_cast<double>(packets) / r.seconds << " pkt/s" << std::setprecision(1)
+              << std::setw(9) << static_cast<double>(bytes) * 8 / r.seconds / 1e9 << " Gbit/s  p50 "
+              << std::setw(7) << static_cast<double>(r.p50_ns) / 1000 << " us  p99 " << std::setw(8)
+              << static_cast<double>(r.p99_ns) / 1000 << " us  alerts=" << r.alerts << " stalls=" << r.stalls
+              << "\n";
+}
+
+int main(int argc, char** argv) {
+    std::string pcap = argc > 1 ? argv[1] : "-";
+    std::string rules = argc > 2 ? argv[2] : "sample_rules.json";
+    std::size_t max_lanes = argc > 3 ? std::stoul(argv[3]) : 4;
+    std::size_t repeat = argc > 4 ? std::stoul(argv[4]) : 0;
+
+    core::ThreadPool pool;
+    auto engine = std::make_shared<detect::Engine>();
+    std::vector<std::string> literals;
+    for (auto& rule : config::load_rules(rules, &pool)) {
+        if (!rule.payload_pattern.empty()) literals.push_back(rule.payload_pattern);
+        engine->addRule(std::move(rule));
+    }
+    if (engine->rule_count() == 0) {
+        std::cerr << "No rules in " << rules << std::endl;
+        return 1;
+    }
+    engine->build(&pool);
+    detect::EngineHandle handle(std::move(engine));
+
+    std::vector<core::Packet> traffic;
+    if (pcap == "-") {
+        traffic = make_traffic(200000, 4096, literals);
+    } else if (!capture::PcapFileSource::read_file(pcap, traffic)) {
+        return 1;
+    }
+    if (traffic.empty()) {
+        std::cerr << "No packets in " << pcap << std::endl;
+        return 1;
+    }
+    std::uint64_t bytes_once = 0;
+    for (const auto& p : traffic) bytes_once += p.bytes.size();
+    // Repeat small captures up to about a million packets
+    if (repeat == 0) repeat = std::max<std::size_t>(1, 1000000 / traffic.size());
+    std::size_t packets = traffic.size() * repeat;
+    std::uint64_t bytes = bytes_once * repeat;
+
+    std::cout << (pcap == "-" ? std::string("synthetic traffic") : pcap) << ": " << traffic.size() << " packets x "
+              << repeat << ", " << handle.snapshot()->rule_count() << " rules, "
+              << std::thread::hardware_concurrency() << " hardware threads\n";
+
+    core::PipelineConfig config;
+    report("fused", run(traffic, repeat, handle, config), packets, bytes);
+    config.mode = core::PipelineConfig::Mode::Staged;
+    for (std::size_t lanes = 1; lanes <= max_lanes; lanes *= 2) {
+        config.detect_threads = lanes;
+        report("staged, " + std::to_string(lanes) + " lane" + (lanes == 1 ? "" : "s"),
+               run(traffic, repeat, handle, config), packets, bytes);
+    }
+    return 0;
+}
@@ -0,0 +1,101 @@
+// Event ring consumer: converts binary alert, flow and TLS records from the
+// memory-mapped ring (eve_output: ring) into EVE JSON lines on stdout.
+//
+//   eve_ring_reader [--follow] [--peek] ring_file
+//
+// Records are consumed (their slots handed back to the IDS) as they are
+// printed; --peek prints pending records without consuming them and
+// --follow keeps reading as new records are published.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <string_view>
+#include <thread>
+
+#include "output/EventRing.hpp"
+#include "output/EveJson.hpp"
+
+static void append_record(std::string& out, const output::RingRecord& r) {
+    flow::FlowKey key{};
+    key.src = r.src;
+    key.dst = r.dst;
+    key.sport = r.sport;
+    key.dport = r.dport;
+    key.proto = r.proto;
+    if (r.type == static_cast<std::uint16_t>(output::RingRecordType::Flow)) {
+        output::append_eve_flow(out, r.timestamp_us, key, r.packets, r.bytes, r.start_us);
+    } else if (r.type == static_cast<std::uint16_t>(output::RingRecordType::Tls)) {
+        // payload: 32 hex digits of JA3/JA3S, then the ALPN protocol
+        std::size_t sni = std::min<std::size_t>(r.signature_length, sizeof(r.signature));
+        std::size_t payload = std::clamp<std::size_t>(r.payload_length, 32, sizeof(r.payload));
+        output::append_eve_tls(out, r.timestamp_us, key, r.tls_client != 0, static_cast<std::uint16_t>(r.signature_id),
+                               std::string_view(r.signature, sni), std::string_view(r.payload + 32, payload - 32),
+                               std::string_view(r.payload, 32));
+    } else {
+        std::size_t sig = std::min<std::size_t>(r.signature_length, sizeof(r.signature));
+        std::size_t payload = std::min<std::size_t>(r.payload_length, sizeof(r.payload));
+        output::append_eve_alert(out, r.timestamp_us, r.signature_id, std::string_view(r.signature, sig), key,
+                                 std::string_view(r.payload, payload));
+    }
+    out.push_back('\n');
+}
+
+int main(int argc, char** argv) {
+    bool follow = false;
+    bool peek = false;
+    std::string path;
+    for (int i = 1; i < argc; ++i) {
+        std::string_view arg = argv[i];
+        if (arg == "--follow") follow = true;
+        else if (arg == "--peek") peek = true;
+        else path = arg;
+    }
+    if (path.empty()) {
+        std::cerr << "usage: eve_ring_reader [--follow] [--peek] ring_file" << std::endl;
+        return 2;
+    }
+
+    output::EventRingReader ring;
+    if (!ring.open(path)) {
+        std::cerr << "Not a valid event ring: " << path << std::endl;
+        return 1;
+    }
+
+    std::string out;
+    std::uint64_t printed = 0;
+    std::uint64_t skipped = 0;
+    std::uint64_t next = ring.read_index();
+    for (;;) {
+        std::uint64_t end = ring.write_index();
+        while (next != end) {
+            const output::RingRecord& r = ring.record(next++);
+            if (r.layout_version == output::kRingRecordVersion) {
+                append_record(out, r);
+                ++printed;
+            } else {
+                ++skipped;
+            }
+            if (!peek) ring.release();
+            if (out.size() >= 64 * 1024) {
+                std::fwrite(out.data(), 1, out.size(), stdout);
+                out.clear();
+            }
+        }
+        if (!out.empty()) {
+            std::fwrite(out.data(), 1, out.size(), stdout);
+            out.clear();
+            std::fflush(stdout);
+        }
+        if (!follow || peek) break;
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    }
+
+    std::cerr << printed << " records";
+    if (skipped != 0) std::cerr << ", " << skipped << " with an unknown layout skipped";
+    std::cerr << ", " << ring.dropped() << " dropped by the producer (ring full), " << ring.pending()
+              << " pending" << std::endl;
+    return 0;
+}
@@ -1,44 +1,111 @@
+#include <algorithm>
 #include <atomic>
 #include <chrono>
+#include <cstdio>
+#include <deque>
 #include <iostream>
 #include <memory>
+#include <memory_resource>
 #include <string>
 #include <string_view>
 #include <thread>
 #include <vector>
 
+#include "core/Affinity.hpp"
+#include "core/Arena.hpp"
+#include "core/HeapCounter.hpp"
+#include "core/Metrics.hpp"
 #include "core/Packet.hpp"
+#include "core/Pipeline.hpp"
+#include "core/ScratchArena.hpp"
+#include "core/ThreadPool.hpp"
+#include "core/dsa/AhoCorasick.hpp"
+#include "core/dsa/ConcurrentCuckooHash.hpp"
+#include "core/dsa/DomainSet.hpp"
+#include "core/dsa/IpLpm.hpp"
 #include "core/dsa/RingBufferSPSC.hpp"
 #include "capture/ISource.hpp"
 #include "capture/SimSource.hpp"
 #include "capture/NpcapSource.hpp"
+#include "capture/PcapFileSource.hpp"
 #include "ips/WinDivertSource.hpp"
 #include "decode/Ethernet.hpp"
 #include "decode/IPv4.hpp"
 #include "decode/TCP.hpp"
 #include "decode/DNS.hpp"
+#include "decode/HTTP.hpp"
+#include "decode/TLS.hpp"
 #include "flow/FlowTable.hpp"
+#include "flow/TlsHelloTracker.hpp"
 #include "detect/Engine.hpp"
+#include "detect/CompiledRuleset.hpp"
+#include "detect/EngineHandle.hpp"
+#include "detect/Threshold.hpp"
+#include "detect/RuleProfiler.hpp"
+#include "config/ConfigLoader.hpp"
 #include "output/EveJson.hpp"
+#include "output/EveWriter.hpp"
+#include "output/MetricsServer.hpp"
 #include "ips/Action.hpp"
+#include "ips/VerdictCache.hpp"
 
-enum class CaptureMode { Simulation, Npcap, WinDivert };
+enum class CaptureMode { Simulation, Npcap, WinDivert, PcapFile };
 
 CaptureMode select_capture_mode() {
     std::cout << "Select capture mode:\n";
     std::cout << "1. Simulation (default)\n";
     std::cout << "2. Npcap (live capture - requires Npcap)\n";
     std::cout << "3. WinDivert (IPS mode - requires admin)\n";
-    std::cout << "Choice (1-3): ";
+    std::cout << "4. PCAP file replay (pcap_file from config)\n";
+    std::cout << "Choice (1-4): ";
     
     std::string input;
     std::getline(std::cin, input);
     
     if (input == "2") return CaptureMode::Npcap;
     if (input == "3") return CaptureMode::WinDivert;
+    if (input == "4") return CaptureMode::PcapFile;
     return CaptureMode::Simulation;
 }
 
+// A packet on its way from the prepare stage (decode, flow state) to
+// detection. The payload left by the inspection budget is kept as an offset
+// into the packet, so the task can move between threads with its packet.
+struct DetectTask {
+    core::Packet packet;
+    flow::DecodedFlow decoded{};      // set by the burst stage
+    flow::FlowEntry* flow{nullptr};   // burst stage: the flow entry, null if the packet didn't decode
+    flow::FlowKey key{};
+    std::size_t payload_offset{0};
+    std::size_t payload_size{0};
+
+    core::ByteSpan payload() const { return {packet.bytes.data() + payload_offset, payload_size}; }
+};
+
+// One detection lane's engine reader, alert thresholds, counters and the
+// scratch arena its match results come from (reset between batches)
+struct DetectLane {
+    detect::ResultCacheStats cache_stats;
+    detect::ThresholdStats threshold_stats;
+    core::MetricShard& metrics;
+    detect::EngineReader reader;
+    detect::ThresholdTable thresholds;
+    core::ScratchArena scratch;
+
+    DetectLane(const detect::EngineHandle& handle, const config::IdsConfig& config, core::MetricShard& shard)
+        : metrics(shard), reader(handle, config.result_cache_size, &cache_stats),
+          thresholds(config.threshold_table_size, &threshold_stats) {}
+};
+
+// Adds the calling thread's heap allocations since its previous call to
+// shard (threads that run several stages count each allocation once)
+static void account_heap_allocations(core::MetricShard& shard) {
+    static thread_local std::uint64_t seen = 0;
+    std::uint64_t now = core::heap_allocations();
+    shard.add(core::Counter::HeapAllocations, now - seen);
+    seen = now;
+}
+
 int main() {
     using namespace std::chrono_literals;
 
@@ -46,27 +113,238 @@ int main() {
     
     CaptureMode mode = select_capture_mode();
     
-    core::dsa::RingBufferSPSC<core::Packet, 1024> ring;
     std::atomic<bool> done{false};
-    std::atomic<std::size_t> packets_processed{0};
-    std::atomic<std::size_t> alerts_generated{0};
-
-    // Enhanced detection engine with multiple rules
-    detect::Engine engine;
-    engine.addRule({1, "Suspicious test pattern", std::string("test")});
-    engine.addRule({2, "Malicious payload detected", std::string("malicious")});
-    engine.addRule({3, "SQL injection attempt", std::string("SELECT * FROM")});
-    engine.addRule({4, "XSS attempt", std::string("<script>")});
-    engine.addRule({5, "Potential backdoor", std::string("backdoor")});
-    engine.build();
+
+    // Per-thread counters and latency histograms, summed when read
+    core::Metrics metrics;
+    core::MetricShard& capture_metrics = metrics.register_thread();
+    core::MetricShard& worker_metrics = metrics.register_thread();
+    core::MetricShard& ips_metrics = metrics.register_thread();
+
+    config::IdsConfig config;
+    config::load_config("configs/example.json", config);
+
+    // Thread placement. Memory a thread works on is allocated from its CPU
+    // (first-touch NUMA placement): the packet ring and flow table by the
+    // worker, each lane's state and batch channel by that lane.
+    core::CpuTopology topology = core::detect_topology();
+    core::PipelineConfig pipeline_config;
+    if (config.pipeline_mode == "staged") {
+        pipeline_config.mode = core::PipelineConfig::Mode::Staged;
+    } else if (config.pipeline_mode != "fused") {
+        std::cerr << "Unknown pipeline_mode '" << config.pipeline_mode << "', using fused" << std::endl;
+    }
+    pipeline_config.detect_threads = config.detect_threads;
+    pipeline_config.batch_size = config.pipeline_batch;
+    // Flow entries of a burst must outlive the burst's own lookups
+    pipeline_config.burst_size = std::min<std::size_t>(config.pipeline_burst, config.flow_table_size);
+    pipeline_config.lane_cpus = config.detect_cpus;
+    auto placement = [&](int cpu) {
+        if (cpu < 0) return std::string("unpinned");
+        if (static_cast<std::size_t>(cpu) >= topology.cpus()) return "CPU " + std::to_string(cpu) + " (not present)";
+        return "CPU " + std::to_string(cpu) + " (node " + std::to_string(topology.node(cpu)) + ")";
+    };
+    std::cout << "Topology: " << topology.describe() << "\n";
+    std::cout << "Threads: capture " << placement(config.capture_cpu) << ", worker " << placement(config.worker_cpu);
+    if (pipeline_config.mode == core::PipelineConfig::Mode::Staged) {
+        for (std::size_t i = 0; i < config.detect_threads; ++i) {
+            std::cout << ", detect lane " << i << " "
+                      << placement(i < config.detect_cpus.size() ? config.detect_cpus[i] : -1);
+        }
+    }
+    std::cout << ", stats " << placement(config.stats_cpu) << "\n";
+    if (config.capture_cpu >= 0 && config.worker_cpu >= 0 &&
+        topology.node(config.capture_cpu) != topology.node(config.worker_cpu)) {
+        std::cout << "Warning: capture and worker are on different NUMA nodes, every packet crosses nodes\n";
+    }
+    std::cout << std::endl;
+
+    auto ring = core::on_cpu(config.worker_cpu, [] {
+        return std::make_unique<core::dsa::RingBufferSPSC<core::Packet, 1024>>();
+    });
+
+    // Huge pages for large DFA transition tables (from here on) and the flow table
+    core::HugePages huge_pages = core::HugePages::Off;
+    if (!core::parse_huge_pages(config.huge_pages, huge_pages)) {
+        std::cerr << "Unknown huge_pages '" << config.huge_pages << "', using off" << std::endl;
+    }
+    core::set_default_huge_pages(huge_pages);
+    core::dsa::AhoCorasick::set_table_placer(core::place_on_huge_pages);
+
+    // Rules come from the configured rule files (via the compiled ruleset
+    // cache) or, without any, from the built-in set
+    // Rule compilation (startup and reload) is spread over all cores
+    core::ThreadPool compile_pool;
+
+    auto initial_engine = std::make_shared<detect::Engine>();
+    detect::Engine& engine = *initial_engine;
+    if (config.rule_files.empty() ||
+        !detect::load_or_compile_ruleset(engine, config.rule_files, config.compiled_ruleset, &compile_pool)) {
+        detect::Rule test_rule{1, "Suspicious test pattern", std::string("test")};
+        detect::parse_threshold("type limit, track by_src, count 10, seconds 60", test_rule.threshold);
+        engine.addRule(std::move(test_rule));
+        engine.addRule({2, "Malicious payload detected", std::string("malicious")});
+        engine.addRule({3, "SQL injection attempt", std::string("SELECT * FROM")});
+        engine.addRule({4, "XSS attempt", std::string("<script>")});
+        engine.addRule({5, "Potential backdoor", std::string("backdoor")});
+    }
+    engine.build(&compile_pool);
     
-    std::cout << "Loaded " << engine.rule_count() << " detection rules\n" << std::endl;
+    std::cout << "Loaded " << engine.rule_count() << " detection rules\n";
+    for (std::size_t g = 0; g < static_cast<std::size_t>(detect::GroupId::Count); ++g) {
+        auto id = static_cast<detect::GroupId>(g);
+        const auto& group = engine.group(id);
+        std::cout << "  group " << detect::Engine::group_name(id) << ": " << group.pattern_ids.size()
+                  << " literals, " << core::dsa::LiteralMatcher::kind_name(group.matcher.kind()) << " matcher\n";
+    }
+    std::cout << std::endl;
 
-    // Flow table with larger capacity
-    flow::FlowTable flows(8192);
+    // Workers match against immutable snapshots; "reload" swaps in a new one
+    detect::EngineHandle engine_handle(std::move(initial_engine));
+    detect::RulesetReloader reloader(engine_handle, &compile_pool);
+
+    // Alerts and flow records go to the EVE log (stdout if none), or to the
+    // binary event ring, through the output thread
+    output::EveWriterConfig eve_config;
+    eve_config.path = config.eve_log;
+    eve_config.queue_size = config.eve_queue_size;
+    eve_config.rotate_bytes = config.eve_rotate_mb << 20;
+    eve_config.rotate_keep = config.eve_rotate_keep;
+    if (config.eve_output == "ring") {
+        eve_config.format = output::EveWriterConfig::Format::Ring;
+        eve_config.path = config.event_ring_path;
+        eve_config.ring_capacity = config.event_ring_records;
+    } else if (config.eve_output != "json") {
+        std::cerr << "Unknown eve_output '" << config.eve_output << "', using json" << std::endl;
+    }
+    output::EveWriter eve(eve_config);
+    if (!eve.start()) return 1;
+
+    // Prometheus text endpoint on loopback, scraped from the per-thread shards
+    output::MetricsServer metrics_server(metrics);
+    if (config.metrics_port != 0 && metrics_server.start(config.metrics_port)) {
+        std::cout << "Serving metrics on http://127.0.0.1:" << config.metrics_port << "/metrics\n";
+    }
+
+    // Flow table, in a huge-page arena when enabled (heap once the arena is full)
+    std::unique_ptr<core::Arena> flow_arena;
+    if (huge_pages != core::HugePages::Off) {
+        flow_arena = core::on_cpu(config.worker_cpu, [&] {
+            return std::make_unique<core::Arena>(flow::FlowTable::arena_bytes(config.flow_table_size), huge_pages);
+        });
+        std::cout << "Flow table arena: " << (flow_arena->capacity() >> 20) << " MiB on "
+                  << core::huge_pages_name(flow_arena->backing()) << "\n";
+    }
+    auto flows = core::on_cpu(config.worker_cpu, [&] {
+        return std::make_unique<flow::FlowTable>(config.flow_table_size, flow_arena.get());
+    });
+    // Decoder temporaries of the worker, reset at every burst
+    auto worker_scratch = core::on_cpu(config.worker_cpu, [] { return std::make_unique<core::ScratchArena>(); });
+
+    // IP reputation block list, checked before detection on every new flow
+    core::dsa::IpLpm blocklist;
+    std::size_t blocklist_prefixes = 0;
+    if (!config.blocklist_file.empty()) blocklist_prefixes = config::load_blocklist(config.blocklist_file, blocklist);
+    auto blocklisted = [&](std::uint32_t src, std::uint32_t dst) {
+        return blocklist_prefixes != 0 && (blocklist.lookup_v4(src) != core::dsa::IpLpm::kNoMatch ||
+                                           blocklist.lookup_v4(dst) != core::dsa::IpLpm::kNoMatch);
+    };
+    std::atomic<std::size_t> blocked_flows{0};
+
+    // Domain block list, matched against DNS questions, HTTP Host and TLS SNI
+    core::dsa::DomainSet blocked_domains;
+    if (!config.domain_blocklist.empty()) {
+        config::load_domain_set(config.domain_blocklist, config.domain_blocklist_image, blocked_domains);
+    }
+    std::atomic<std::size_t> domain_hits{0};
+    // EVE alert signature per category (the list file the entry came from)
+    std::vector<std::string> domain_signatures;
+    for (const auto& file : config.domain_blocklist) domain_signatures.push_back("Blocked domain (" + file + ")");
+
+    // Flows seen naming a blocked domain (value: the entry's category), in
+    // both directions, so the IPS decision thread can drop the rest of
+    // them. The worker is the only writer; entries are dropped oldest first
+    // after flow_timeout_seconds or past flow_table_size, by which time the
+    // decision thread has moved any live flow into its own verdict cache.
+    using DomainBlockedFlows = core::dsa::ConcurrentCuckooHash<flow::FlowKey, std::uint16_t, flow::FlowKeyHash>;
+    DomainBlockedFlows domain_blocked_flows(1024);
+    std::deque<std::pair<flow::FlowKey, std::chrono::steady_clock::time_point>> domain_blocked_order;
+    std::atomic<std::size_t> domain_drops{0};
+
+    // Per-flow inspection budget: stream depth and TLS bypass
+    flow::InspectionPolicy inspection;
+    inspection.stream_depth = config.stream_depth;
+    inspection.tls_bypass = config.tls_bypass;
+    inspection.entropy_threshold = config.entropy_threshold;
+    inspection.entropy_window = config.entropy_window;
+    std::atomic<std::size_t> depth_bypassed_flows{0};
+    std::atomic<std::size_t> tls_bypassed_flows{0};
+    std::atomic<std::size_t> entropy_bypassed_flows{0};
+    detect::RuleProfiler rule_profiler;
+
+    // Packet path: prepare (decode, flow state, reassembly) then detect, run
+    // to completion on the worker or staged over detect_threads lanes
+    core::Pipeline<DetectTask> pipeline(pipeline_config);
+    std::vector<std::unique_ptr<DetectLane>> lanes;
+    for (std::size_t i = 0; i < pipeline.lanes(); ++i) {
+        int cpu = pipeline_config.mode == core::PipelineConfig::Mode::Staged ? pipeline.lane_cpu(i) : config.worker_cpu;
+        core::MetricShard& shard = metrics.register_thread();
+        lanes.push_back(core::on_cpu(cpu, [&] { return std::make_unique<DetectLane>(engine_handle, config, shard); }));
+        if (config.rule_profiling) lanes.back()->reader.set_profile(&rule_profiler.register_thread());
+    }
+    auto lane_total = [&](auto counter) {
+        std::uint64_t sum = 0;
+        for (const auto& lane : lanes) sum += counter(*lane).load(std::memory_order_relaxed);
+        return sum;
+    };
+    auto check_domain = [&](const char* source, std::string_view name, const flow::FlowKey& key) {
+        core::dsa::DomainSet::Match hit;
+        if (name.empty() || !blocked_domains.lookup(name, &hit)) return;
+        domain_hits++;
+        worker_metrics.add(core::Counter::Alerts);
+        // Block-list alerts have no rule: signature id 0, the list in the signature
+        char excerpt[output::EveEvent::kMaxPayload];
+        int written = std::snprintf(excerpt, sizeof(excerpt), "%s %.*s", source, static_cast<int>(name.size()),
+                                    name.data());
+        std::size_t length =
+            written < 0 ? 0 : std::min<std::size_t>(static_cast<std::size_t>(written), sizeof(excerpt) - 1);
+        std::string_view signature = hit.category < domain_signatures.size()
+                                         ? std::string_view(domain_signatures[hit.category])
+                                         : std::string_view("Blocked domain");
+        eve.submit(0, signature, key, std::string_view(excerpt, length));
+
+        auto now = std::chrono::steady_clock::now();
+        while (!domain_blocked_order.empty() &&
+               (domain_blocked_order.size() >= config.flow_table_size ||
+                now - domain_blocked_order.front().second > std::chrono::seconds(config.flow_timeout_seconds))) {
+            domain_blocked_flows.erase(domain_blocked_order.front().first);
+            domain_blocked_order.pop_front();
+        }
+        for (const auto& k : {key, key.reversed()}) {
+            std::uint16_t category;
+            if (domain_blocked_flows.find(k, category)) continue;
+            domain_blocked_flows.insert_or_assign(k, hit.category);
+            domain_blocked_order.emplace_back(k, now);
+        }
+    };
+
+    // IPS decision callback for WinDivert mode. Flows with a cached verdict
+    // (dropped before, or inspected past ips_inspect_depth) skip inspection.
+    ips::VerdictCache::Config verdict_config;
+    verdict_config.capacity = config.flow_table_size;
+    verdict_config.inspect_depth = config.ips_inspect_depth;
+    verdict_config.idle_timeout = std::chrono::seconds(config.flow_timeout_seconds);
+    ips::VerdictCache verdicts(verdict_config);
+    DomainBlockedFlows::Reader domain_blocked_reader(domain_blocked_flows); // decision thread only
+
+    auto inspect = [&](const core::Packet& pkt, const flow::FlowKey* key) -> ips::Decision {
+        // Block-listed endpoints are dropped before any payload inspection
+        if (key && blocklisted(key->src, key->dst)) return ips::Decision::Drop;
+        if (key && domain_blocked_reader.contains(*key)) {
+            domain_drops++;
+            return ips::Decision::Drop;
+        }
 
-    // IPS decision callback for WinDivert mode
-    auto ips_decision = [&](const core::Packet& pkt) -> ips::Decision {
         // Simple policy: drop packets containing "malicious"
         std::string_view payload_str(reinterpret_cast<const char*>(pkt.bytes.data()), pkt.bytes.size());
         if (payload_str.find("malicious") != std::string_view::npos) {
@@ -76,77 +354,227 @@ int main() {
         return ips::Decision::Pass;
     };
 
-    // Enhanced worker thread: decode -> flow -> detect -> alert/action
+    auto ips_decision = [&](const core::Packet& pkt) -> ips::Decision {
+        core::ScopedLatency latency(ips_metrics, pkt.ts);
+        core::ByteSpan bytes{pkt.bytes.data(), pkt.bytes.size()};
+        flow::DecodedFlow f;
+        if (!flow::decode_flow(bytes, f)) {
+            // Not cacheable (non-IPv4 or truncated L4); still honour the block list
+            decode::IPv4Header ip{};
+            core::ByteSpan l4{};
+            flow::FlowKey key{};
+            bool ipv4 = decode::parse_ipv4(bytes, ip, l4);
+            key.src = ip.src;
+            key.dst = ip.dst;
+            return inspect(pkt, ipv4 ? &key : nullptr);
+        }
+
+        ips::Decision decision;
+        auto cached = verdicts.lookup(f.key, pkt.ts);
+        if (cached != ips::VerdictCache::Verdict::None) {
+            decision = cached == ips::VerdictCache::Verdict::Drop ? ips::Decision::Drop : ips::Decision::Pass;
+        } else {
+            decision = inspect(pkt, &f.key);
+            verdicts.record(f.key, decision, f.payload.size(), pkt.ts);
+        }
+        if (f.tcp_closing()) verdicts.end_flow(f.key);
+        return decision;
+    };
+
+    // Worker thread: decode -> flow -> (detection lanes) -> alert/action
     std::thread worker([&]() {
-        while (!done.load() || !ring.empty()) {
-            core::Packet pkt;
-            if (!ring.try_pop(pkt)) {
-                std::this_thread::sleep_for(1ms);
-                continue;
-            }
+        if (config.worker_cpu >= 0) core::pin_current_thread(config.worker_cpu);
+        flow::TlsHelloTracker tls_tracker;
 
-            packets_processed++;
-            core::ByteSpan bytes{pkt.bytes.data(), pkt.bytes.size()};
-            
-            // Handle different link types
-            core::ByteSpan l3_data;
-            bool has_ethernet = (pkt.link == core::LinkType::Ethernet);
-            
-            if (has_ethernet) {
-                decode::EthernetHeader eth{};
-                if (!decode::parse_ethernet(bytes, eth, l3_data)) continue;
-                if (eth.ethertype != 0x0800) continue; // IPv4 only
-            } else {
-                l3_data = bytes; // WinDivert captures at IP layer
+        // Decodes a burst of packets and looks up their flows together, so
+        // the flow table's cache misses overlap. Packets that don't decode
+        // are counted and end here (task.flow stays null).
+        std::vector<flow::FlowKey> burst_keys;
+        std::vector<flow::FlowEntry*> burst_entries;
+        std::vector<DetectTask*> burst_tasks;
+        auto decode_burst = [&](DetectTask* tasks, std::size_t n) {
+            worker_scratch->reset();
+            account_heap_allocations(worker_metrics);
+            burst_keys.clear();
+            burst_tasks.clear();
+            for (std::size_t i = 0; i < n; ++i) {
+                DetectTask& task = tasks[i];
+                const core::Packet& pkt = task.packet;
+                task.flow = nullptr;
+                worker_metrics.add(core::Counter::PacketsProcessed);
+                core::ByteSpan bytes{pkt.bytes.data(), pkt.bytes.size()};
+
+                // Handle different link types
+                core::ByteSpan l3_data;
+                bool has_ethernet = (pkt.link == core::LinkType::Ethernet);
+
+                if (has_ethernet) {
+                    decode::EthernetHeader eth{};
+                    if (!decode::parse_ethernet(bytes, eth, l3_data)) {
+                        worker_metrics.add(core::Counter::DecodeEthernet);
+                        core::record_latency(worker_metrics, pkt.ts);
+                        continue;
+                    }
+                    if (eth.ethertype != 0x0800) { // IPv4 only
+                        worker_metrics.add(core::Counter::DecodeNotIpv4);
+                        core::record_latency(worker_metrics, pkt.ts);
+                        continue;
+                    }
+                } else {
+                    l3_data = bytes; // WinDivert captures at IP layer
+                }
+
+                flow::DecodeError decode_error = flow::DecodeError::None;
+                if (!flow::decode_flow(l3_data, task.decoded, &decode_error)) {
+                    switch (decode_error) {
+                    case flow::DecodeError::Tcp: worker_metrics.add(core::Counter::DecodeTcp); break;
+                    case flow::DecodeError::Udp: worker_metrics.add(core::Counter::DecodeUdp); break;
+                    default: worker_metrics.add(core::Counter::DecodeIpv4); break;
+                    }
+                    core::record_latency(worker_metrics, pkt.ts);
+                    continue;
+                }
+                burst_keys.push_back(task.decoded.key);
+                burst_tasks.push_back(&task);
             }
+            burst_entries.resize(burst_keys.size());
+            flows->lookup_batch(burst_keys.data(), burst_keys.size(), burst_entries.data());
+            for (std::size_t i = 0; i < burst_tasks.size(); ++i) burst_tasks[i]->flow = burst_entries[i];
+        };
 
-            decode::IPv4Header ip{};
-            core::ByteSpan l4_data{};
-            if (!decode::parse_ipv4(l3_data, ip, l4_data)) continue;
-            
-            flow::FlowKey flow_key{ip.src, ip.dst, 0, 0, ip.protocol};
-            
-            core::ByteSpan payload{};
-            if (ip.protocol == 6) { // TCP
-                decode::TCPHeader tcp{};
-                if (!decode::parse_tcp(l4_data, tcp, payload)) continue;
-                flow_key.sport = tcp.srcPort;
-                flow_key.dport = tcp.dstPort;
-            } else if (ip.protocol == 17) { // UDP
-                if (l4_data.size() < 8) continue;
-                flow_key.sport = (l4_data[0] << 8) | l4_data[1];
-                flow_key.dport = (l4_data[2] << 8) | l4_data[3];
-                payload = l4_data.subspan(8);
-                
-                // Check for DNS
-                if (flow_key.dport == 53 || flow_key.sport == 53) {
-                    decode::DNSHeader dns_header{};
-                    std::vector<decode::DNSQuestion> questions;
-                    if (decode::parse_dns(payload, dns_header, questions)) {
-                        for (const auto& q : questions) {
-                            std::cout << "[DNS] Query: " << q.name << " (type " << q.type << ")\n";
-                        }
+        // Stage 1, on this thread: true if the task goes on to detection.
+        // Packets that end here record their latency now.
+        auto prepare = [&](DetectTask& task) {
+            if (!task.flow) return false; // didn't decode; counted by decode_burst
+            const core::Packet& pkt = task.packet;
+            auto skip = [&] {
+                core::record_latency(worker_metrics, pkt.ts);
+                return false;
+            };
+            const flow::DecodedFlow& decoded = task.decoded;
+            const flow::FlowKey& flow_key = decoded.key;
+            core::ByteSpan payload = decoded.payload;
+
+            // Check for DNS
+            if (flow_key.proto == 17 && (flow_key.dport == 53 || flow_key.sport == 53)) {
+                decode::DNSHeader dns_header{};
+                std::pmr::vector<decode::DNSQuestion> questions(worker_scratch.get());
+                if (decode::parse_dns(payload, dns_header, questions)) {
+                    for (const auto& q : questions) {
+                        std::cout << "[DNS] Query: " << q.name << " (type " << q.type << ")\n";
+                        check_domain("DNS query", q.name, flow_key);
                     }
                 }
-            } else {
-                payload = l4_data; // Other protocols
             }
 
             // Update flow table
-            auto &entry = flows.touch(flow_key, std::chrono::steady_clock::now());
+            auto &entry = *task.flow;
+            flow::FlowTable::touch_entry(entry, std::chrono::steady_clock::now());
             entry.bytes += pkt.bytes.size();
+            if (decoded.tcp_closing() && !entry.flow_logged) {
+                entry.flow_logged = true;
+                eve.submit_flow(flow_key, entry.packets, entry.bytes, entry.firstSeen);
+            }
+
+            if (entry.packets == 1) worker_metrics.add(core::Counter::FlowsCreated);
 
-            // Run detection engine
-            if (!payload.empty()) {
-                auto matches = engine.match(payload, &flow_key);
-                for (const auto &match : matches) {
-                    alerts_generated++;
-                    std::string line = output::make_eve_alert_line(match.rule, flow_key);
-                    std::cout << "[ALERT] " << line << std::endl;
-                    std::cout << "[CONTEXT] " << match.context << "\n" << std::endl;
+            // Pre-detection reputation check, once per new flow
+            if (entry.packets == 1 && blocklisted(flow_key.src, flow_key.dst)) {
+                entry.blocked = true;
+                blocked_flows++;
+                std::cout << "[BLOCKLIST] Flow " << output::ipv4_to_string(flow_key.src) << " -> "
+                          << output::ipv4_to_string(flow_key.dst) << " blocked\n";
+            }
+            if (entry.blocked) return skip();
+
+            // Flows past their inspection budget skip all payload inspection
+            worker_metrics.add(core::Counter::PayloadBytes, payload.size());
+            if (entry.bypass != flow::Bypass::None) {
+                worker_metrics.add(core::Counter::BypassedBytes, payload.size());
+                return skip();
+            }
+
+            // TLS hello (possibly spanning segments): SNI, ALPN, version, JA3/JA3S
+            if (flow_key.proto == 6 && !payload.empty() && !entry.tls_hello_done) {
+                decode::TlsHello hello;
+                auto status = tls_tracker.feed(flow_key, decoded.tcp_seq, payload, hello);
+                if (status == flow::TlsHelloTracker::Status::NeedMore) {
+                    worker_metrics.add(core::Counter::ReassemblyBuffered);
+                } else {
+                    entry.tls_hello_done = true;
+                }
+                if (status == flow::TlsHelloTracker::Status::Done) {
+                    bool client = hello.kind == decode::TlsHello::Kind::Client;
+                    entry.tls_handshake = true;
+                    entry.tls_server_hello = !client;
+                    worker_metrics.add(core::Counter::TlsHellos);
+                    char ja3[33];
+                    hello.ja3_hex(ja3);
+                    eve.submit_tls(flow_key, client, hello.version, hello.sni, hello.alpn_first,
+                                   std::string_view(ja3, 32));
+                    if (client) check_domain("TLS SNI", hello.sni, flow_key);
                 }
             }
-        }
+
+            // HTTP Host header
+            if (flow_key.proto == 6 && !payload.empty() && blocked_domains.size() != 0 && !entry.tls_handshake) {
+                check_domain("HTTP Host", decode::find_http_host(payload), flow_key);
+            }
+
+            core::ByteSpan full_payload = payload;
+            const flow::FlowEntry* reverse = entry.tls_handshake ? flows->find(flow_key.reversed()) : nullptr;
+            if (flow::apply_inspection_budget(entry, flow_key, payload, inspection, reverse)) {
+                switch (entry.bypass) {
+                case flow::Bypass::Encrypted: tls_bypassed_flows++; break;
+                case flow::Bypass::HighEntropy: entropy_bypassed_flows++; break;
+                default: depth_bypassed_flows++; break;
+                }
+            }
+            worker_metrics.add(core::Counter::BypassedBytes, full_payload.size() - payload.size());
+
+            if (payload.empty()) return skip();
+            task.key = flow_key;
+            task.payload_offset = static_cast<std::size_t>(payload.data() - pkt.bytes.data());
+            task.payload_size = payload.size();
+            return true;
+        };
+
+        // Stage 2, on the lane's thread (this one when fused)
+        auto detect_task = [&](std::size_t lane_index, DetectTask& task) {
+            DetectLane& lane = *lanes[lane_index];
+            core::ByteSpan payload = task.payload();
+            lane.metrics.add(core::Counter::MatcherPackets);
+            lane.metrics.add(core::Counter::MatcherBytes, payload.size());
+            auto matches = lane.reader.match(payload, &task.key, &lane.scratch);
+            auto now_seconds = static_cast<std::uint64_t>(
+                std::chrono::duration_cast<std::chrono::seconds>(task.packet.ts.time_since_epoch()).count());
+            for (const auto &match : matches) {
+                if (!lane.thresholds.allow(*match.rule, match.rule_index, task.key, now_seconds)) {
+                    lane.metrics.add(core::Counter::AlertsSuppressed);
+                    continue;
+                }
+                lane.metrics.add(core::Counter::Alerts);
+                eve.submit(static_cast<std::uint32_t>(match.rule->id), match.rule->message, task.key, match.context);
+            }
+            core::record_latency(lane.metrics, task.packet.ts);
+        };
+
+        // Lanes by source address, so by_src thresholds see all of a source's
+        // alerts; by_dst and by_rule counts are kept per lane
+        auto lane_of = [](const DetectTask& task) {
+            return static_cast<std::size_t>((task.key.src * 0x9E3779B1u) >> 16);
+        };
+
+        // Batch boundary (engine refresh, scratch reset) every pipeline_batch
+        // packets or whenever the input runs dry. Match results are consumed
+        // within detect_task, so neither outlives its batch.
+        pipeline.run(done, [&](core::Packet& pkt) { return ring->try_pop(pkt); }, decode_burst, prepare, lane_of,
+                     detect_task, [&](std::size_t lane_index) {
+                         DetectLane& lane = *lanes[lane_index];
+                         lane.reader.refresh();
+                         lane.scratch.reset();
+                         account_heap_allocations(lane.metrics);
+                     });
     });
 
     // Create appropriate capture source
@@ -172,6 +600,16 @@ int main() {
             source = std::unique_ptr<capture::ISource>(ips_source.get());
             break;
         }
+        case CaptureMode::PcapFile: {
+            if (config.pcap_file.empty()) {
+                std::cout << "No pcap_file configured, falling back to simulation\n";
+                source = std::make_unique<capture::SimSource>();
+            } else {
+                std::cout << "Replaying " << config.pcap_file << " (" << config.pcap_loops << " loop(s))\n";
+                source = std::make_unique<capture::PcapFileSource>(config.pcap_file, config.pcap_loops);
+            }
+            break;
+        }
         default:
             std::cout << "Using simulation mode\n";
             source = std::make_unique<capture::SimSource>();
@@ -180,36 +618,93 @@ int main() {
 
     // Start packet capture
     source->start([&](core::Packet &&p) {
-        while (!ring.try_push(std::move(p))) {
+        // Sources own their capture thread, so it is pinned on its first packet
+        static thread_local bool pinned = false;
+        if (!pinned && config.capture_cpu >= 0) core::pin_current_thread(config.capture_cpu);
+        pinned = true;
+        capture_metrics.add(core::Counter::PacketsCaptured);
+        capture_metrics.add(core::Counter::CapturedBytes, p.bytes.size());
+        if (ring->try_push(std::move(p))) return;
+        capture_metrics.add(core::Counter::RingFullWaits);
+        while (!ring->try_push(std::move(p))) {
             std::this_thread::sleep_for(100us);
         }
     });
 
-    std::cout << "\nCapture started. Press Enter to stop...\n" << std::endl;
+    std::cout << "\nCapture started. Type 'reload' to reload rules";
+    if (config.rule_profiling) std::cout << ", 'profile' for the rule profile";
+    std::cout << ", press Enter to stop...\n" << std::endl;
     
     // Statistics thread
     std::thread stats_thread([&]() {
-        auto last_packets = packets_processed.load();
-        auto last_alerts = alerts_generated.load();
+        if (config.stats_cpu >= 0) core::pin_current_thread(config.stats_cpu);
+        auto last_packets = metrics.total(core::Counter::PacketsProcessed);
+        auto last_alerts = metrics.total(core::Counter::Alerts);
+        auto last_heap = metrics.total(core::Counter::HeapAllocations);
         
         while (!done.load()) {
             std::this_thread::sleep_for(5s);
-            auto current_packets = packets_processed.load();
-            auto current_alerts = alerts_generated.load();
+            auto current_packets = metrics.total(core::Counter::PacketsProcessed);
+            auto current_alerts = metrics.total(core::Counter::Alerts);
+            auto current_heap = metrics.total(core::Counter::HeapAllocations);
+            auto latency = metrics.latency();
             
             std::cout << "[STATS] Packets: " << current_packets 
                       << " (+" << (current_packets - last_packets) << "/5s), "
                       << "Alerts: " << current_alerts 
-                      << " (+" << (current_alerts - last_alerts) << "/5s)\n";
+                      << " (+" << (current_alerts - last_alerts) << "/5s), "
+                      << "Bypassed flows: "
+                      << depth_bypassed_flows.load() + tls_bypassed_flows.load() + entropy_bypassed_flows.load()
+                      << ", skipped bytes: " << metrics.total(core::Counter::BypassedBytes)
+                      << ", result cache hits: "
+                      << lane_total([](const DetectLane& l) -> const auto& { return l.cache_stats.hits; })
+                      << ", suppressed alerts: " << metrics.total(core::Counter::AlertsSuppressed)
+                      << ", latency p50/p99: " << latency->quantile(0.5) / 1000 << "/"
+                      << latency->quantile(0.99) / 1000 << " us";
+            if (core::heap_counting_enabled()) std::cout << ", heap allocs: +" << current_heap - last_heap << "/5s";
+            if (ips_source) {
+                const auto& v = verdicts.stats();
+                std::cout << ", IPS fast drops: " << v.fast_drops.load(std::memory_order_relaxed)
+                          << ", fast passes: " << v.fast_passes.load(std::memory_order_relaxed)
+                          << ", inspected: " << v.inspected.load(std::memory_order_relaxed);
+            }
+            std::cout << "\n";
             
             last_packets = current_packets;
             last_alerts = current_alerts;
+            last_heap = current_heap;
         }
     });
     
-    // Wait for user input
+    // Wait for user input; "reload" recompiles the rule files in the background
     std::string input;
-    std::getline(std::cin, input);
+    while (std::getline(std::cin, input) && (input == "reload" || input == "profile")) {
+        if (input == "profile") {
+            if (config.rule_profiling) {
+                rule_profiler.report(*engine_handle.snapshot(), std::cout, config.rule_profile_top);
+            } else {
+                std::cout << "[PROFILE] rule_profiling is off\n";
+            }
+            continue;
+        }
+        if (config.rule_files.empty()) {
+            std::cout << "[RELOAD] No rule_files configured\n";
+            continue;
+        }
+        bool started = reloader.start(config.rule_files, config.compiled_ruleset, [](const detect::ReloadStats& s) {
+            constexpr double kMiB = 1024.0 * 1024.0;
+            if (!s.ok) {
+                std::cout << "[RELOAD] Failed, keeping current rules\n";
+                return;
+            }
+            std::cout << "[RELOAD] " << s.rule_count << " rules in " << s.duration_ms << " ms; engines old "
+                      << s.old_engine_bytes / kMiB << " MiB + new " << s.new_engine_bytes / kMiB
+                      << " MiB; RSS " << s.before.resident_bytes / kMiB << " -> " << s.overlap.resident_bytes / kMiB
+                      << " MiB during overlap (process peak " << s.overlap.peak_bytes / kMiB << " MiB)\n";
+        });
+        if (!started) std::cout << "[RELOAD] Already in progress\n";
+    }
+    reloader.join();
     
     std::cout << "\nStopping capture...\n";
     source->stop();
@@ -217,11 +712,83 @@ int main() {
     
     worker.join();
     stats_thread.join();
+    eve.stop();
+    metrics_server.stop();
     
     std::cout << "\nFinal Statistics:";
-    std::cout << "\n- Packets processed: " << packets_processed.load();
-    std::cout << "\n- Alerts generated: " << alerts_generated.load();
-    std::cout << "\n- Detection rules: " << engine.rule_count() << std::endl;
+    auto latency = metrics.latency();
+    std::cout << "\n- Packets processed: " << metrics.total(core::Counter::PacketsProcessed) << " of "
+              << metrics.total(core::Counter::PacketsCaptured) << " captured ("
+              << metrics.total(core::Counter::RingFullWaits) << " waited on a full ring)";
+    std::cout << "\n- Decode failures: " << metrics.total(core::Counter::DecodeEthernet) << " ethernet, "
+              << metrics.total(core::Counter::DecodeNotIpv4) << " not IPv4, " << metrics.total(core::Counter::DecodeIpv4)
+              << " IPv4, " << metrics.total(core::Counter::DecodeTcp) << " TCP, "
+              << metrics.total(core::Counter::DecodeUdp) << " UDP";
+    std::cout << "\n- Capture-to-verdict latency: p50 " << latency->quantile(0.5) / 1000 << " us, p99 "
+              << latency->quantile(0.99) / 1000 << " us, p99.9 " << latency->quantile(0.999) / 1000 << " us";
+    std::cout << "\n- Pipeline: " << (pipeline_config.mode == core::PipelineConfig::Mode::Staged ? "staged, " : "fused, ")
+              << pipeline.lanes() << " detection lane(s), " << pipeline.stats().batches.load() << " batches handed off, "
+              << pipeline.stats().lane_stalls.load() << " stalls on a busy lane";
+    std::cout << "\n- Alerts generated: " << metrics.total(core::Counter::Alerts);
+    if (core::heap_counting_enabled()) {
+        auto packets = metrics.total(core::Counter::PacketsProcessed);
+        auto heap = metrics.total(core::Counter::HeapAllocations);
+        std::cout << "\n- Heap allocations by worker and lanes: " << heap;
+        if (packets != 0) std::cout << " (" << static_cast<double>(heap) / static_cast<double>(packets) << " per packet)";
+    }
+    std::size_t lane_scratch = 0;
+    std::uint64_t scratch_growths = worker_scratch->growths();
+    for (const auto& lane : lanes) {
+        lane_scratch += lane->scratch.capacity();
+        scratch_growths += lane->scratch.growths();
+    }
+    std::cout << "\n- Scratch arenas: worker " << worker_scratch->capacity() / 1024 << " KiB (peak "
+              << worker_scratch->high_water() << " bytes per burst), lanes " << lane_scratch / 1024 << " KiB, "
+              << scratch_growths << " growths";
+    std::cout << "\n- EVE records: " << eve.stats().written.load() << " written in " << eve.stats().writes.load()
+              << " writes, " << eve.stats().dropped.load() << " dropped, "
+              << eve.stats().rotations.load() << " rotations, " << eve.stats().write_errors.load() << " write errors";
+    std::cout << "\n- Blocked flows: " << blocked_flows.load();
+    std::cout << "\n- Blocked domain hits: " << domain_hits.load();
+    std::cout << "\n- TLS hellos parsed: " << metrics.total(core::Counter::TlsHellos);
+    std::cout << "\n- Bypassed flows: " << depth_bypassed_flows.load() << " at stream depth, "
+              << tls_bypassed_flows.load() << " encrypted (TLS), " << entropy_bypassed_flows.load()
+              << " high entropy";
+    auto payload_bytes = metrics.total(core::Counter::PayloadBytes);
+    auto bypassed_bytes = metrics.total(core::Counter::BypassedBytes);
+    std::cout << "\n- Payload bytes skipped: " << bypassed_bytes << " of " << payload_bytes;
+    if (payload_bytes != 0) {
+        std::cout << " (" << 100.0 * static_cast<double>(bypassed_bytes) / static_cast<double>(payload_bytes) << "%)";
+    }
+    if (config.result_cache_size != 0) {
+        auto lookups = lane_total([](const DetectLane& l) -> const auto& { return l.cache_stats.lookups; });
+        auto hits = lane_total([](const DetectLane& l) -> const auto& { return l.cache_stats.hits; });
+        std::cout << "\n- Result cache: " << hits << " hits of " << lookups << " lookups";
+        if (lookups != 0) std::cout << " (" << 100.0 * static_cast<double>(hits) / static_cast<double>(lookups) << "%)";
+        std::cout << ", " << lane_total([](const DetectLane& l) -> const auto& { return l.cache_stats.saved_bytes; })
+                  << " bytes not scanned, "
+                  << lane_total([](const DetectLane& l) -> const auto& { return l.cache_stats.uncacheable; })
+                  << " uncacheable";
+    }
+    std::cout << "\n- Thresholded alerts: "
+              << lane_total([](const DetectLane& l) -> const auto& { return l.threshold_stats.suppressed; })
+              << " suppressed of "
+              << lane_total([](const DetectLane& l) -> const auto& { return l.threshold_stats.checked; })
+              << " matches, "
+              << lane_total([](const DetectLane& l) -> const auto& { return l.threshold_stats.evicted; })
+              << " counters evicted";
+    if (ips_source) {
+        const auto& v = verdicts.stats();
+        std::cout << "\n- IPS verdicts: " << v.fast_drops.load() << " fast drops, " << v.fast_passes.load()
+                  << " fast passes, " << v.inspected.load() << " inspected (" << v.untracked.load()
+                  << " untracked), " << v.expired.load() << " expired, " << domain_drops.load()
+                  << " dropped for a blocked domain";
+    }
+    std::cout << "\n- Detection rules: " << engine_handle.snapshot()->rule_count() << std::endl;
+    if (config.rule_profiling) {
+        std::cout << "\n";
+        rule_profiler.report(*engine_handle.snapshot(), std::cout, config.rule_profile_top);
+    }
 
     return 0;
 }
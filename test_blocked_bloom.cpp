@@ -0,0 +1,98 @@
+// Blocked Bloom filter tests: no inserted key is ever reported absent, the
+// false positive rate at 10 bits per key stays near the expected 1%, batch
+// queries (scalar and, where the CPU has it, AVX2) agree with single ones,
+// and a saved filter mapped back or attached in place answers the same but
+// refuses inserts.
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <system_error>
+#include <vector>
+
+#include "core/dsa/BlockedBloomFilter.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using core::dsa::BlockedBloomFilter;
+
+constexpr std::size_t kKeys = 100000;
+
+static std::vector<std::uint64_t> random_hashes(std::uint64_t seed) {
+    std::mt19937_64 rng(seed);
+    std::vector<std::uint64_t> hashes(kKeys);
+    for (auto& h : hashes) h = rng();
+    return hashes;
+}
+
+static std::size_t missing(const BlockedBloomFilter& filter, const std::vector<std::uint64_t>& hashes) {
+    std::size_t n = 0;
+    for (auto h : hashes) n += filter.contains_hash(h) ? 0 : 1;
+    return n;
+}
+
+static bool batch_agrees(const BlockedBloomFilter& filter, const std::vector<std::uint64_t>& hashes) {
+    std::vector<std::uint8_t> out(hashes.size(), 2);
+    filter.contains_batch(hashes.data(), hashes.size(), out.data());
+    for (std::size_t i = 0; i < hashes.size(); ++i) {
+        if (out[i] != (filter.contains_hash(hashes[i]) ? 1 : 0)) return false;
+    }
+    return true;
+}
+
+static void membership(const std::vector<std::uint64_t>& present, const std::vector<std::uint64_t>& absent) {
+    BlockedBloomFilter filter(kKeys);
+    check(filter.insert_batch(present.data(), present.size()), "membership: insert_batch refused");
+    check(missing(filter, present) == 0, "membership: inserted key reported absent");
+
+    double rate = static_cast<double>(absent.size() - missing(filter, absent)) / static_cast<double>(absent.size());
+    check(rate > 0.001 && rate < 0.02, "membership: false positive rate far from 1% at 10 bits per key");
+
+    check(filter.insert("evil.example") && filter.possibly_contains("evil.example"), "membership: string key");
+
+    check(batch_agrees(filter, absent) && batch_agrees(filter, present), "batch: differs from single queries");
+    filter.limit_simd(core::SimdLevel::None);
+    check(batch_agrees(filter, absent) && batch_agrees(filter, present), "batch: scalar kernel differs");
+
+    BlockedBloomFilter empty;
+    std::uint8_t out[2] = {1, 1};
+    check(!empty.contains_hash(present[0]) && !empty.insert_hash(present[0]), "empty: filter without blocks");
+    empty.contains_batch(present.data(), 2, out);
+    check(out[0] == 0 && out[1] == 0, "empty: batch reported a key");
+}
+
+static void read_only_copies(const std::vector<std::uint64_t>& present, const std::vector<std::uint64_t>& absent) {
+    BlockedBloomFilter filter(kKeys);
+    filter.insert_batch(present.data(), present.size());
+
+    auto path = (std::filesystem::temp_directory_path() / "test_blocked_bloom.idsb").string();
+    check(filter.save(path), "image: save");
+    BlockedBloomFilter loaded;
+    check(loaded.load(path) && !loaded.writable() && loaded.block_count() == filter.block_count(), "image: load");
+    check(missing(loaded, present) == 0 && missing(loaded, absent) == missing(filter, absent),
+          "image: loaded filter answers differently");
+    check(batch_agrees(loaded, absent), "image: batch differs from single queries");
+    check(!loaded.insert_hash(absent[0]) && !loaded.insert("x") && !loaded.insert_batch(absent.data(), 4),
+          "image: insert into a mapped filter accepted");
+
+    BlockedBloomFilter attached;
+    attached.attach(filter.data(), filter.block_count());
+    check(!attached.writable() && missing(attached, present) == 0, "attach: attached filter lost a key");
+    check(!attached.insert_hash(absent[0]) && missing(filter, absent) == missing(attached, absent),
+          "attach: insert into an attached filter accepted");
+
+    std::error_code ec;
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 8, ec);
+    BlockedBloomFilter truncated;
+    check(!ec && !truncated.load(path), "image: truncated image loaded");
+    std::filesystem::remove(path, ec);
+}
+
+int main() {
+    auto present = random_hashes(1);
+    auto absent = random_hashes(2);
+    membership(present, absent);
+    read_only_copies(present, absent);
+    return test::report("test_blocked_bloom");
+}
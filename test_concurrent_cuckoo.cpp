@@ -0,0 +1,122 @@
+// Concurrent cuckoo hash tests: one writer inserting, updating, erasing and
+// growing the table while Reader threads look keys up. Readers must never
+// see a torn value, never miss a key that stays in the table (while its
+// neighbours are displaced or the table is resized), and never see a key's
+// value go back to an older version.
+#include <atomic>
+#include <cstdint>
+#include <random>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "core/dsa/ConcurrentCuckooHash.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+
+// Several words, so a read racing a write shows up as a mismatch
+struct Versioned {
+    std::uint64_t key;
+    std::uint64_t version;
+    std::uint64_t check[6];
+};
+
+static Versioned make_value(std::uint64_t key, std::uint64_t version) {
+    Versioned v{key, version, {}};
+    for (auto& c : v.check) c = key * 0x9E3779B97F4A7C15ull ^ version;
+    return v;
+}
+
+static bool intact(std::uint64_t key, const Versioned& v) {
+    if (v.key != key) return false;
+    for (auto c : v.check) {
+        if (c != (key * 0x9E3779B97F4A7C15ull ^ v.version)) return false;
+    }
+    return true;
+}
+
+using Table = core::dsa::ConcurrentCuckooHash<std::uint64_t, Versioned>;
+
+static void single_thread_basics() {
+    Table table(8);
+    for (std::uint64_t k = 0; k < 5000; ++k) table.insert_or_assign(k, make_value(k, 1));
+    check(table.size() == 5000, "basics: size after inserts");
+    check(table.generation() > 0, "basics: table never grew");
+    Versioned v{};
+    bool all = true;
+    for (std::uint64_t k = 0; k < 5000; ++k) all = all && table.find(k, v) && intact(k, v) && v.version == 1;
+    check(all, "basics: inserted key missing after growth");
+    table.insert_or_assign(7, make_value(7, 2));
+    check(table.size() == 5000 && table.find(7, v) && v.version == 2, "basics: assign did not replace");
+    check(table.erase(7) && !table.find(7, v) && !table.erase(7), "basics: erase");
+    check(table.size() == 4999, "basics: size after erase");
+}
+
+static void readers_during_writes() {
+    constexpr std::uint64_t kStable = 2000;    // always present, updated in place
+    constexpr std::uint64_t kChurn = 200000;   // inserted and erased around them
+    constexpr int kReaders = 3;
+
+    Table table(64);
+    for (std::uint64_t k = 0; k < kStable; ++k) table.insert_or_assign(k, make_value(k, 0));
+
+    std::atomic<bool> done{false};
+    std::atomic<std::uint64_t> torn{0}, missing{0}, backwards{0}, lookups{0};
+    std::vector<std::thread> readers;
+    for (int r = 0; r < kReaders; ++r) {
+        readers.emplace_back([&, r] {
+            Table::Reader reader(table);
+            std::mt19937_64 rng(static_cast<std::uint64_t>(r) + 1);
+            std::vector<std::uint64_t> last_version(kStable, 0);
+            std::uint64_t n = 0;
+            // At least one full pass even if the writer finishes first
+            while (!done.load(std::memory_order_acquire) || n < 4 * kStable) {
+                Versioned v{};
+                std::uint64_t k = rng() % kStable;
+                if (!reader.find(k, v)) {
+                    missing.fetch_add(1);
+                } else if (!intact(k, v)) {
+                    torn.fetch_add(1);
+                } else {
+                    if (v.version < last_version[k]) backwards.fetch_add(1);
+                    last_version[k] = v.version;
+                }
+                std::uint64_t c = kStable + rng() % kChurn;
+                if (reader.find(c, v) && !intact(c, v)) torn.fetch_add(1);
+                ++n;
+            }
+            lookups.fetch_add(n);
+        });
+    }
+
+    std::mt19937_64 rng(1234);
+    std::uint64_t version = 0;
+    for (std::uint64_t c = 0; c < kChurn; ++c) {
+        table.insert_or_assign(kStable + c, make_value(kStable + c, 0));
+        if (c % 3 == 0) table.erase(kStable + rng() % (c + 1));
+        if (c % 2 == 0) {
+            std::uint64_t k = rng() % kStable;
+            table.insert_or_assign(k, make_value(k, ++version));
+        }
+    }
+    done.store(true, std::memory_order_release);
+    for (auto& t : readers) t.join();
+
+    check(table.generation() >= 5, "concurrent: table did not resize under readers");
+    check(torn.load() == 0, "concurrent: reader saw a torn value");
+    check(missing.load() == 0, "concurrent: reader missed a key that was never erased");
+    check(backwards.load() == 0, "concurrent: reader saw a value go back to an older version");
+    check(lookups.load() > 0, "concurrent: readers made no lookups");
+
+    Versioned v{};
+    bool all = true;
+    for (std::uint64_t k = 0; k < kStable; ++k) all = all && table.find(k, v) && intact(k, v);
+    check(all, "concurrent: stable key missing at the end");
+}
+
+int main() {
+    single_thread_basics();
+    readers_during_writes();
+    return test::report("test_concurrent_cuckoo");
+}
@@ -0,0 +1,129 @@
+// Domain set tests: exact ("example.com"), subdomain ("*.example.com") and
+// combined (".example.com") entries against hand-picked names, then random
+// names over a few labels against a brute-force suffix scan, both on the
+// built table and on a saved image mapped back in. Images from another
+// source or cut short must not load.
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include "core/dsa/DomainSet.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using core::dsa::DomainSet;
+
+static void entry_kinds() {
+    DomainSet set;
+    check(set.add("exact.com", 1) && set.add("*.sub.com", 2) && set.add(".both.com", 3), "kinds: add");
+    check(set.add("Merged.ORG.", 4) && set.add("*.merged.org", 4), "kinds: add merged");
+    set.build();
+    check(set.size() == 4, "kinds: duplicate name counted twice");
+
+    DomainSet::Match m;
+    check(set.lookup("exact.com", &m) && m.exact && m.category == 1 && m.entry == "exact.com", "kinds: exact name");
+    check(!set.lookup("www.exact.com"), "kinds: exact entry matched a subdomain");
+    check(!set.lookup("sub.com"), "kinds: subdomain entry matched the name itself");
+    check(set.lookup("a.b.sub.com", &m) && !m.exact && m.category == 2 && m.entry == "sub.com",
+          "kinds: subdomain entry");
+    check(set.lookup("both.com") && set.lookup("x.both.com", &m) && m.category == 3, "kinds: combined entry");
+    check(set.lookup("merged.org") && set.lookup("www.merged.org"), "kinds: exact and subdomain entries merged");
+    check(set.lookup("EXACT.Com.", &m) && m.entry == "exact.com", "kinds: case and trailing dot");
+    check(!set.lookup("notexact.com") && !set.lookup("xsub.com") && !set.lookup("com"), "kinds: label boundaries");
+    check(!set.lookup("") && !set.lookup("."), "kinds: empty name matched");
+}
+
+static void rejects_malformed() {
+    DomainSet set;
+    check(!set.add(""), "malformed: empty entry");
+    check(!set.add("*."), "malformed: bare wildcard");
+    check(!set.add("a..b.com"), "malformed: empty label");
+    check(!set.add("..com"), "malformed: leading dots");
+    check(!set.add("bad name.com"), "malformed: space");
+    check(!set.add(std::string(254, 'a')), "malformed: name over 253 bytes");
+    check(set.add("under_score-1.net"), "malformed: valid characters rejected");
+}
+
+static std::string random_name(std::mt19937& rng) {
+    static const char* const kLabels[] = {"a", "b", "ex", "www", "mail", "com", "net"};
+    std::string name;
+    int labels = 1 + static_cast<int>(rng() % 4);
+    for (int i = 0; i < labels; ++i) {
+        if (i) name += '.';
+        name += kLabels[rng() % std::size(kLabels)];
+    }
+    return name;
+}
+
+// Shortest listed suffix whose flags allow the match, as lookup() walks
+static bool brute_force(const std::map<std::string, std::uint8_t>& entries, const std::string& name,
+                        std::string* entry) {
+    for (std::size_t i = name.size(); i-- > 0;) {
+        bool whole = i == 0;
+        if (!whole && name[i - 1] != '.') continue;
+        auto it = entries.find(name.substr(i));
+        if (it == entries.end() || !(it->second & (whole ? DomainSet::kExact : DomainSet::kSubdomains))) continue;
+        *entry = it->first;
+        return true;
+    }
+    return false;
+}
+
+static int differences(const DomainSet& set, const std::map<std::string, std::uint8_t>& entries,
+                       std::uint32_t seed) {
+    std::mt19937 rng(seed);
+    int wrong = 0;
+    for (int i = 0; i < 20000; ++i) {
+        std::string name = random_name(rng);
+        std::string want;
+        bool expected = brute_force(entries, name, &want);
+        DomainSet::Match m;
+        bool found = set.lookup(name, &m);
+        wrong += found != expected || (found && m.entry != want);
+    }
+    return wrong;
+}
+
+static void matches_brute_force_and_image() {
+    std::mt19937 rng(7);
+    DomainSet set;
+    std::map<std::string, std::uint8_t> entries;
+    for (int i = 0; i < 150; ++i) {
+        std::string name = random_name(rng);
+        switch (rng() % 3) {
+        case 0: set.add(name); entries[name] |= DomainSet::kExact; break;
+        case 1: set.add("*." + name); entries[name] |= DomainSet::kSubdomains; break;
+        default:
+            set.add("." + name);
+            entries[name] |= DomainSet::kExact | DomainSet::kSubdomains;
+            break;
+        }
+    }
+    set.build();
+    check(set.size() == entries.size(), "random: entry count");
+    check(differences(set, entries, 11) == 0, "random: built set differs from brute force");
+
+    auto path = (std::filesystem::temp_directory_path() / "test_domain_set.idsd").string();
+    check(set.save(path, 42), "image: save");
+    DomainSet loaded;
+    check(!loaded.load(path, 43), "image: loaded with another source hash");
+    check(loaded.load(path, 42) && loaded.mapped() && loaded.size() == set.size(), "image: load");
+    check(differences(loaded, entries, 11) == 0, "image: mapped set differs from brute force");
+
+    loaded = DomainSet();
+    std::error_code ec;
+    std::filesystem::resize_file(path, std::filesystem::file_size(path) - 1, ec);
+    check(!ec && !loaded.load(path, 42), "image: truncated image loaded");
+    std::filesystem::remove(path, ec);
+}
+
+int main() {
+    entry_kinds();
+    rejects_malformed();
+    matches_brute_force_and_image();
+    return test::report("test_domain_set");
+}
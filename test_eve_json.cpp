@@ -0,0 +1,125 @@
+// EVE JSON tests: every byte value is escaped as JSON requires (quotes,
+// backslashes and control characters; UTF-8 passes through), payloads are
+// reduced to printable ASCII, RFC 3339 timestamps match known instants
+// (before the epoch, leap days, century years) and gmtime() on random
+// seconds, and whole alert and tls records come out byte for byte.
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <random>
+#include <string>
+#include <string_view>
+
+#include "output/EveJson.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+
+static std::string json(std::string_view s) {
+    std::string out;
+    output::append_json_string(out, s);
+    return out;
+}
+
+static std::string timestamp(std::int64_t us) {
+    std::string out;
+    output::append_rfc3339_us(out, us);
+    return out;
+}
+
+static void string_escaping() {
+    int wrong = 0;
+    for (int c = 0; c < 256; ++c) {
+        char byte = static_cast<char>(c);
+        std::string want;
+        switch (c) {
+        case '"': want = "\\\""; break;
+        case '\\': want = "\\\\"; break;
+        case '\n': want = "\\n"; break;
+        case '\r': want = "\\r"; break;
+        case '\t': want = "\\t"; break;
+        default:
+            if (c < 0x20) {
+                char buf[8];
+                std::snprintf(buf, sizeof(buf), "\\u%04x", c);
+                want = buf;
+            } else {
+                want = std::string(1, byte);
+            }
+            break;
+        }
+        wrong += json(std::string_view(&byte, 1)) != "\"" + want + "\"";
+    }
+    check(wrong == 0, "escape: a single byte is escaped wrongly");
+
+    check(json("") == "\"\"", "escape: empty string");
+    check(json("say \"hi\"\\n") == "\"say \\\"hi\\\"\\\\n\"", "escape: quotes and backslash");
+    check(json(std::string_view("a\0b\x1f\x7f", 5)) == "\"a\\u0000b\\u001f\x7f\"", "escape: NUL, 0x1f and DEL");
+    check(json("caf\xc3\xa9 \xe2\x9c\x93") == "\"caf\xc3\xa9 \xe2\x9c\x93\"", "escape: UTF-8 passes through");
+    check(json("line1\r\nline2\t") == "\"line1\\r\\nline2\\t\"", "escape: CR LF and tab");
+
+    std::string printable;
+    output::append_json_printable(printable, "GET \"/\\\"\r\n\x01\xff");
+    check(printable == "\"GET \\\"/\\\\\\\"....\"", "printable: control and high bytes become '.'");
+}
+
+static void timestamps() {
+    check(timestamp(0) == "1970-01-01T00:00:00.000000Z", "time: epoch");
+    check(timestamp(-1) == "1969-12-31T23:59:59.999999Z", "time: one microsecond before the epoch");
+    check(timestamp(1714566896123456) == "2024-05-01T12:34:56.123456Z", "time: 2024");
+    check(timestamp(951868799999999) == "2000-02-29T23:59:59.999999Z", "time: leap day of 2000");
+    check(timestamp(-2203891199999999) == "1900-03-01T00:00:00.000001Z", "time: 1900 is not a leap year");
+    check(timestamp(4133894400000000) == "2100-12-31T00:00:00.000000Z", "time: 2100");
+
+    std::mt19937_64 rng(41);
+    int wrong = 0;
+    for (int i = 0; i < 20000; ++i) {
+        auto seconds = static_cast<std::time_t>(rng() % 4102444800ull); // up to 2100
+        auto micros = static_cast<std::int64_t>(rng() % 1000000);
+        std::tm* tm = std::gmtime(&seconds);
+        if (!tm) continue;
+        char want[64];
+        std::snprintf(want, sizeof(want), "%04d-%02d-%02dT%02d:%02d:%02d.%06lldZ", tm->tm_year + 1900, tm->tm_mon + 1,
+                      tm->tm_mday, tm->tm_hour, tm->tm_min, tm->tm_sec, static_cast<long long>(micros));
+        wrong += timestamp(static_cast<std::int64_t>(seconds) * 1000000 + micros) != want;
+    }
+    check(wrong == 0, "time: differs from gmtime");
+}
+
+static void records() {
+    flow::FlowKey key{0x0A000001u, 0xC0A80102u, 51234, 443, 6};
+    std::string alert;
+    output::append_eve_alert(alert, 0, 1001, "ET \"bad\"\ttraffic", key, std::string_view("x\ny", 3));
+    check(alert == "{\"timestamp\":\"1970-01-01T00:00:00.000000Z\",\"event_type\":\"alert\","
+                   "\"src_ip\":\"10.0.0.1\",\"src_port\":51234,\"dest_ip\":\"192.168.1.2\",\"dest_port\":443,"
+                   "\"proto\":6,\"alert\":{\"signature_id\":1001,\"signature\":\"ET \\\"bad\\\"\\ttraffic\"},"
+                   "\"payload_printable\":\"x.y\"}",
+          "record: alert");
+
+    std::string tls;
+    output::append_eve_tls(tls, 1000000, key, true, 0x0304, "a\"b.example", "h2",
+                           "ee58977da0f3295e388dbc2fc67e7784");
+    check(tls == "{\"timestamp\":\"1970-01-01T00:00:01.000000Z\",\"event_type\":\"tls\","
+                 "\"src_ip\":\"10.0.0.1\",\"src_port\":51234,\"dest_ip\":\"192.168.1.2\",\"dest_port\":443,"
+                 "\"proto\":6,\"tls\":{\"version\":\"0x0304\",\"sni\":\"a\\\"b.example\",\"alpn\":\"h2\","
+                 "\"ja3\":{\"hash\":\"ee58977da0f3295e388dbc2fc67e7784\"}}}",
+          "record: tls");
+
+    std::string server;
+    output::append_eve_tls(server, 0, key.reversed(), false, 0x0303, {}, {}, "2b83a23dea22815f9c4ffaaeaebdc796");
+    check(server.find("\"version\":\"0x0303\",\"ja3s\":{\"hash\":\"2b83a23dea22815f9c4ffaaeaebdc796\"}}}") !=
+                  std::string::npos &&
+              server.find("sni") == std::string::npos && server.find("\"src_ip\":\"192.168.1.2\"") != std::string::npos,
+          "record: tls server hello without SNI and ALPN");
+
+    check(output::ipv4_to_string(0) == "0.0.0.0" && output::ipv4_to_string(0xFFFFFFFFu) == "255.255.255.255" &&
+              output::ipv4_to_string(0x0A640509u) == "10.100.5.9",
+          "record: IPv4 formatting");
+}
+
+int main() {
+    string_escaping();
+    timestamps();
+    records();
+    return test::report("test_eve_json");
+}
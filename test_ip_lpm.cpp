@@ -0,0 +1,152 @@
+// IP LPM tests: random nested IPv4 and IPv6 prefixes are looked up at
+// addresses in and around them, in DIR-24-8 and DIR-16-8-8 form, and the
+// result must equal a brute-force longest match over the prefix list
+// (later duplicates win). Prefix text parsing is checked separately.
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+#include "core/dsa/IpLpm.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using core::dsa::IpLpm;
+using core::dsa::IpPrefix;
+
+struct Entry {
+    IpPrefix prefix;
+    std::uint32_t value;
+};
+
+static bool covers(const IpPrefix& p, const std::uint8_t* addr) {
+    for (unsigned bit = 0; bit < p.length; ++bit) {
+        unsigned mask = 0x80u >> (bit % 8);
+        if ((p.addr[bit / 8] & mask) != (addr[bit / 8] & mask)) return false;
+    }
+    return true;
+}
+
+static std::uint32_t brute_force(const std::vector<Entry>& entries, bool v6, const std::uint8_t* addr) {
+    std::uint32_t value = IpLpm::kNoMatch;
+    int best = -1;
+    for (const auto& e : entries) {
+        if (e.prefix.v6 != v6 || !covers(e.prefix, addr)) continue;
+        if (static_cast<int>(e.prefix.length) >= best) {
+            best = static_cast<int>(e.prefix.length);
+            value = e.value;
+        }
+    }
+    return value;
+}
+
+// A random prefix drawn around a few bases, so prefixes nest and overlap
+static IpPrefix random_prefix(std::mt19937& rng, bool v6) {
+    static const std::uint8_t kBases[][16] = {
+        {10, 0, 0, 0},
+        {192, 168, 1, 0},
+        {0x20, 0x01, 0x0d, 0xb8},
+        {0xfe, 0x80},
+    };
+    IpPrefix p;
+    p.v6 = v6;
+    const std::uint8_t* base = kBases[(v6 ? 2 : 0) + rng() % 2];
+    unsigned bytes = v6 ? 16 : 4;
+    for (unsigned i = 0; i < bytes; ++i) p.addr[i] = base[i];
+    // Randomize the bytes past the shared head only
+    for (unsigned i = 2; i < bytes; ++i) {
+        if (rng() % 2) p.addr[i] = static_cast<std::uint8_t>(rng() % 4);
+    }
+    p.length = static_cast<unsigned>(rng() % (8 * bytes + 1));
+    for (unsigned bit = p.length; bit < 8 * bytes; ++bit) {
+        p.addr[bit / 8] &= static_cast<std::uint8_t>(~(0x80u >> (bit % 8)));
+    }
+    return p;
+}
+
+// An address inside one of the prefixes, or just outside it
+static std::array<std::uint8_t, 16> probe(std::mt19937& rng, const std::vector<Entry>& entries, bool v6) {
+    std::array<std::uint8_t, 16> a{};
+    const IpPrefix& p = entries[rng() % entries.size()].prefix;
+    a = p.addr;
+    unsigned bytes = v6 ? 16 : 4;
+    for (unsigned bit = p.length; bit < 8 * bytes; ++bit) {
+        if (rng() % 2) a[bit / 8] |= static_cast<std::uint8_t>(0x80u >> (bit % 8));
+    }
+    if (p.length > 0 && rng() % 4 == 0) {
+        unsigned bit = static_cast<unsigned>(rng() % p.length);
+        a[bit / 8] ^= static_cast<std::uint8_t>(0x80u >> (bit % 8));
+    }
+    return a;
+}
+
+static void matches_brute_force(unsigned v4_root_bits) {
+    std::mt19937 rng(v4_root_bits);
+    std::vector<Entry> entries;
+    IpLpm lpm(v4_root_bits);
+    for (std::uint32_t i = 0; i < 600; ++i) {
+        Entry e{random_prefix(rng, i % 3 == 0), i % 7 == 0 ? i / 7 : i};
+        entries.push_back(e);
+        check(lpm.add(e.prefix, e.value), "lpm: add rejected a valid prefix");
+    }
+    lpm.build();
+    check(lpm.v4_prefix_count() + lpm.v6_prefix_count() == entries.size(), "lpm: prefix counts");
+
+    int wrong4 = 0, wrong6 = 0;
+    for (int i = 0; i < 20000; ++i) {
+        bool v6 = i % 2 == 1;
+        auto a = probe(rng, entries, v6);
+        std::uint32_t want = brute_force(entries, v6, a.data());
+        if (v6) {
+            wrong6 += lpm.lookup_v6(a.data()) != want;
+        } else {
+            IpPrefix host;
+            host.addr = a;
+            wrong4 += lpm.lookup_v4(host.v4()) != want;
+        }
+    }
+    check(wrong4 == 0, v4_root_bits == 24 ? "lpm: DIR-24-8 differs from brute force"
+                                          : "lpm: DIR-16-8-8 differs from brute force");
+    check(wrong6 == 0, "lpm: IPv6 trie differs from brute force");
+}
+
+static void empty_and_default() {
+    IpLpm lpm(16);
+    lpm.build();
+    std::uint8_t any6[16] = {0x20, 0x01};
+    check(lpm.lookup_v4(0x0A000001u) == IpLpm::kNoMatch && lpm.lookup_v6(any6) == IpLpm::kNoMatch,
+          "lpm: empty table matched");
+    check(lpm.add("0.0.0.0/0", 1) && lpm.add("10.1.2.3", 2) && lpm.add("::/0", 3), "lpm: add text prefixes");
+    check(!lpm.add("10.0.0.0/8", IpLpm::kNoMatch), "lpm: value kNoMatch accepted");
+    lpm.build();
+    check(lpm.lookup_v4(0x0A010203u) == 2 && lpm.lookup_v4(0x0A010204u) == 1, "lpm: host route over default");
+    check(lpm.lookup_v6(any6) == 3, "lpm: IPv6 default route");
+}
+
+static void parses_prefixes() {
+    IpPrefix p;
+    check(IpLpm::parse_prefix(" 10.1.2.3/8\r", p) && !p.v6 && p.length == 8 && p.v4() == 0x0A000000u,
+          "parse: IPv4 prefix is masked and trimmed");
+    check(IpLpm::parse_prefix("192.168.1.7", p) && p.length == 32 && p.v4() == 0xC0A80107u, "parse: IPv4 host");
+    check(IpLpm::parse_prefix("2001:db8::1/32", p) && p.v6 && p.length == 32 && p.addr[0] == 0x20 &&
+              p.addr[3] == 0xb8 && p.addr[15] == 0,
+          "parse: IPv6 prefix is masked");
+    check(IpLpm::parse_prefix("::1", p) && p.v6 && p.length == 128 && p.addr[15] == 1 && p.addr[0] == 0,
+          "parse: IPv6 loopback");
+    check(IpLpm::parse_prefix("1:2:3:4:5:6:7:8", p) && p.addr[14] == 0 && p.addr[15] == 8, "parse: full IPv6");
+    check(!IpLpm::parse_prefix("1.2.3", p), "parse: three octets accepted");
+    check(!IpLpm::parse_prefix("1.2.3.4/33", p), "parse: IPv4 length 33 accepted");
+    check(!IpLpm::parse_prefix("256.1.1.1", p), "parse: octet 256 accepted");
+    check(!IpLpm::parse_prefix("1::2::3", p), "parse: two '::' accepted");
+    check(!IpLpm::parse_prefix("1:2:3:4:5:6:7:8:9", p), "parse: nine IPv6 groups accepted");
+    check(!IpLpm::parse_prefix("2001:db8::/129", p), "parse: IPv6 length 129 accepted");
+}
+
+int main() {
+    matches_brute_force(24);
+    matches_brute_force(16);
+    empty_and_default();
+    parses_prefixes();
+    return test::report("test_ip_lpm");
+}
@@ -0,0 +1,136 @@
+// Regex tests: random patterns over a small alphabet are compared with
+// std::regex (ECMAScript agrees with the PCRE subset on these) for whether
+// a text matches and where the earliest match ends, through the lazy DFA
+// and through the NFA fallback of an undersized cache. Unsupported
+// constructs must fail to compile.
+#include <cctype>
+#include <cstddef>
+#include <cstdint>
+#include <random>
+#include <regex>
+#include <string>
+#include <string_view>
+
+#include "core/dsa/Regex.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+
+// Atoms, classes and quantifiers only: no anchors, whose meaning inside a
+// substring differs between the two engines. Groups take bounded
+// quantifiers only, since a star over a star makes std::regex backtrack
+// exponentially.
+static std::string random_pattern(std::mt19937& rng, int depth = 0) {
+    static const char* const kAtoms[] = {"a", "b", "c", "A", "1", ".", "[ab]", "[^a]", "[a-c]", "\\d", "\\w", "x"};
+    static const char* const kQuantifiers[] = {"", "", "", "*", "+", "?", "{2}", "{1,3}", "{0,2}", "*?", "+?"};
+    static const char* const kGroupQuantifiers[] = {"", "", "?", "{2}", "??"};
+    std::string p;
+    int atoms = 1 + static_cast<int>(rng() % 4);
+    for (int i = 0; i < atoms; ++i) {
+        if (depth < 2 && rng() % 5 == 0) {
+            p += "(" + random_pattern(rng, depth + 1);
+            if (rng() % 2) p += "|" + random_pattern(rng, depth + 1);
+            p += ")";
+            p += kGroupQuantifiers[rng() % std::size(kGroupQuantifiers)];
+        } else {
+            p += kAtoms[rng() % std::size(kAtoms)];
+            p += kQuantifiers[rng() % std::size(kQuantifiers)];
+        }
+    }
+    return p;
+}
+
+static std::string random_text(std::mt19937& rng) {
+    static const char kBytes[] = "abcA1x -";
+    std::string t(rng() % 16, ' ');
+    for (auto& c : t) c = kBytes[rng() % (sizeof(kBytes) - 1)];
+    return t;
+}
+
+static std::string lower(std::string s) {
+    for (auto& c : s) c = static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+    return s;
+}
+
+// End of the earliest-ending match, or npos: the shortest prefix in which
+// the pattern, pinned by a trailing $, is found
+static std::size_t earliest_end(const std::regex& pinned, const std::string& text) {
+    for (std::size_t end = 0; end <= text.size(); ++end) {
+        if (std::regex_search(text.begin(), text.begin() + static_cast<std::ptrdiff_t>(end), pinned)) return end;
+    }
+    return std::string::npos;
+}
+
+static void matches_std_regex() {
+    std::mt19937 rng(2024);
+    int compared = 0;
+    for (int p = 0; p < 300; ++p) {
+        std::string pattern = random_pattern(rng);
+        bool icase = rng() % 4 == 0;
+        core::dsa::Regex re;
+        if (!re.compile(pattern, icase ? "i" : "")) {
+            check(false, ("regex: rejected a supported pattern: " + pattern).c_str());
+            continue;
+        }
+        std::regex expected("(?:" + pattern + ")$",
+                            icase ? std::regex::ECMAScript | std::regex::icase : std::regex::ECMAScript);
+        core::dsa::RegexCache dfa;
+        core::dsa::RegexCache tiny(64, 0); // overflows at once: NFA simulation
+        for (int t = 0; t < 20; ++t) {
+            std::string text = random_text(rng);
+            std::size_t want = earliest_end(expected, text);
+            for (core::dsa::RegexCache* cache : {&dfa, &tiny}) {
+                std::size_t end = std::string::npos;
+                bool found = re.search(text, *cache, &end);
+                if (found != (want != std::string::npos) || (found && end != want)) {
+                    check(false, ("regex: /" + pattern + "/ on \"" + text + "\" differs from std::regex" +
+                                  (cache == &tiny ? " (NFA)" : " (DFA)")).c_str());
+                }
+            }
+            ++compared;
+
+            // A match must contain one of the prefilter literals
+            if (want == std::string::npos || re.required_literals().empty()) continue;
+            bool has = false;
+            for (const auto& l : re.required_literals()) {
+                has = has || (icase ? lower(text).find(lower(l)) : text.find(l)) != std::string::npos;
+            }
+            check(has, ("regex: match without a required literal: " + pattern).c_str());
+        }
+    }
+    check(compared == 300 * 20, "regex: a supported pattern was rejected");
+}
+
+// A cache belongs to one compiled Regex, so each search gets its own
+static bool matches(const char* pattern, const char* flags, std::string_view text, std::size_t* end = nullptr) {
+    core::dsa::Regex re;
+    core::dsa::RegexCache cache;
+    return re.compile(pattern, flags) && re.search(text, cache, end);
+}
+
+static void anchors() {
+    std::size_t end = 0;
+    check(matches("^GET /", "", "GET /x", &end) && end == 5, "anchors: ^ at the start");
+    check(!matches("^GET /", "", "xGET /"), "anchors: ^ matched mid-text");
+    check(matches("admin$", "", "/admin") && !matches("admin$", "", "/admin/"), "anchors: $");
+    check(matches("\\Aa+\\z", "", "aaa") && !matches("\\Aa+\\z", "", "aab"), "anchors: \\A \\z");
+    check(matches("a.b", "s", "a\nb"), "flags: s lets '.' match a newline");
+    check(!matches("a.b", "", "a\nb"), "flags: '.' matched a newline without s");
+}
+
+static void rejects_unsupported() {
+    core::dsa::Regex re;
+    check(!re.compile("(a)\\1"), "reject: backreference");
+    check(!re.compile("a(?=b)"), "reject: lookahead");
+    check(!re.compile("\\bword"), "reject: word boundary");
+    check(!re.compile("(ab"), "reject: unbalanced group");
+    check(!re.compile("a)"), "reject: unmatched ')'");
+    check(!re.compile("abc", "x"), "reject: unknown flag");
+}
+
+int main() {
+    matches_std_regex();
+    anchors();
+    rejects_unsupported();
+    return test::report("test_regex");
+}
@@ -0,0 +1,99 @@
+// Result cache tests: a payload that hashes like a cached benign one must
+// still be scanned.
+#include <cstdint>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "core/Hash.hpp"
+#include "detect/Engine.hpp"
+#include "detect/ResultCache.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+
+static core::ByteSpan span(const std::string& s) {
+    return {reinterpret_cast<const std::uint8_t*>(s.data()), s.size()};
+}
+
+// 16-byte block whose first word cancels kSecret1, followed by `tail`.
+// The old mixing zeroed the running state on such a block, so everything
+// before it and the seed stopped mattering.
+static std::string zeroing_payload(const std::string& word, const std::string& tail) {
+    std::string p(8, '\0');
+    std::memcpy(p.data(), &core::hash_detail::kSecret1, 8);
+    p += word; // 8 bytes
+    return p + tail;
+}
+
+static void hash_has_no_seed_independent_collisions() {
+    const std::string tail = " the same trailing text on both payloads ";
+    std::string benign = zeroing_payload("harmless", tail);
+    std::string evil = zeroing_payload("xxevilxx", tail);
+    for (std::uint64_t seed : {0ull, 1ull, 0x1234ull, 0xdeadbeefcafef00dull}) {
+        check(core::hash64(benign.data(), benign.size(), seed) != core::hash64(evil.data(), evil.size(), seed),
+              "hash64: zeroing block collides");
+        std::string a = "prefix A........" + benign;
+        std::string b = "prefix B........" + benign;
+        check(core::hash64(a.data(), a.size(), seed) != core::hash64(b.data(), b.size(), seed),
+              "hash64: bytes before a zeroing block are lost");
+    }
+    // Short keys take the tail path only
+    std::string s1(8, '\0'), s2(8, '\0');
+    std::memcpy(s1.data(), &core::hash_detail::kSecret1, 8);
+    std::memcpy(s2.data(), &core::hash_detail::kSecret1, 8);
+    check(core::hash64(s1.data(), 8, 1) != core::hash64(s2.data(), 8, 2), "hash64: seed lost on a zeroing tail");
+}
+
+static void cache_compares_payload_bytes() {
+    detect::ResultCache cache(16);
+    std::string benign = "GET /health HTTP/1.1";
+    std::string evil = "GET /evil?? HTTP/1.1";
+    const std::uint64_t key = 42; // same key for both: a forced collision
+    cache.store(key, {}, span(benign), nullptr, 0);
+    check(cache.find(key, {}, span(benign)) != nullptr, "cache: stored payload not found");
+    check(cache.find(key, {}, span(evil)) == nullptr, "cache: colliding payload of the same length hit");
+    check(cache.find(key, {}, span(benign.substr(1))) == nullptr, "cache: shorter payload hit");
+
+    // Entries are replaced, not merged
+    cache.store(key, {}, span(evil), nullptr, 0);
+    check(cache.find(key, {}, span(benign)) == nullptr, "cache: replaced payload still hits");
+
+    // Same key and payload from another scope: ICMP to class 0 and GRE to
+    // class 46 once folded to the same seed
+    const detect::ResultScope icmp{0, 0, 3, 1}, gre{0, 46, 3, 47};
+    check(icmp.seed() != gre.seed(), "cache: scopes fold to the same seed");
+    cache.store(key, icmp, span(benign), nullptr, 0);
+    check(cache.find(key, icmp, span(benign)) != nullptr, "cache: scoped payload not found");
+    check(cache.find(key, gre, span(benign)) == nullptr, "cache: payload hit from another scope");
+
+    std::string big(detect::ResultCache::kMaxPayload + 1, 'a');
+    cache.store(7, {}, span(big), nullptr, 0);
+    check(cache.find(7, {}, span(big)) == nullptr, "cache: payload over kMaxPayload was cached");
+    check(cache.stats().uncacheable.load() == 1, "cache: long payload not counted as uncacheable");
+}
+
+static void engine_scans_colliding_payload() {
+    detect::Engine engine;
+    engine.addRule({1, "Evil payload", std::string("evil")});
+    engine.build();
+    detect::MatchScratch scratch;
+    detect::ResultCache cache(64);
+
+    const std::string tail = " padding so both payloads span several blocks";
+    std::string benign = zeroing_payload("harmless", tail);
+    std::string evil = zeroing_payload("xxevilxx", tail);
+    for (int round = 0; round < 3; ++round) {
+        check(engine.match(span(benign), nullptr, scratch, cache).empty(), "engine: benign payload alerted");
+        check(engine.match(span(evil), nullptr, scratch, cache).size() == 1, "engine: colliding evil payload missed");
+    }
+    check(cache.stats().hits.load() >= 4, "engine: repeated payloads did not hit the cache");
+}
+
+int main() {
+    hash_has_no_seed_independent_collisions();
+    cache_compares_payload_bytes();
+    engine_scans_colliding_payload();
+    return test::report("test_result_cache");
+}
@@ -0,0 +1,140 @@
+// Swiss table tests: random inserts, assigns, erases and lookups over a
+// small key space are mirrored in std::unordered_map and the two must hold
+// the same entries throughout (across growth and in-place cleanup of
+// tombstones). Move-only values are constructed and destroyed exactly once
+// each, churn at a steady size does not grow the table, and string keys
+// can be looked up by std::string_view.
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <random>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+
+#include "core/Hash.hpp"
+#include "core/dsa/SwissTable.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using core::dsa::SwissTable;
+
+static bool same_contents(const SwissTable<std::uint64_t, std::uint64_t>& table,
+                          const std::unordered_map<std::uint64_t, std::uint64_t>& model) {
+    if (table.size() != model.size()) return false;
+    bool same = true;
+    std::size_t visited = 0;
+    table.for_each([&](std::uint64_t k, std::uint64_t v) {
+        auto it = model.find(k);
+        same = same && it != model.end() && it->second == v;
+        ++visited;
+    });
+    return same && visited == model.size();
+}
+
+static void matches_unordered_map() {
+    std::mt19937_64 rng(34);
+    SwissTable<std::uint64_t, std::uint64_t> table;
+    std::unordered_map<std::uint64_t, std::uint64_t> model;
+    int wrong = 0;
+    for (int op = 0; op < 300000; ++op) {
+        // The key space drifts so the table grows, shrinks in use and churns
+        std::uint64_t key = rng() % 4096 + static_cast<std::uint64_t>(op / 50000) * 1024;
+        switch (rng() % 8) {
+        case 0:
+        case 1: {
+            auto [v, inserted] = table.try_emplace(key, static_cast<std::uint64_t>(op));
+            auto [it, model_inserted] = model.try_emplace(key, static_cast<std::uint64_t>(op));
+            wrong += inserted != model_inserted || *v != it->second;
+            break;
+        }
+        case 2:
+            table.insert_or_assign(key, static_cast<std::uint64_t>(op));
+            model[key] = static_cast<std::uint64_t>(op);
+            break;
+        case 3:
+        case 4:
+        case 5:
+            wrong += table.erase(key) != (model.erase(key) == 1);
+            break;
+        default: {
+            const std::uint64_t* v = table.find(key);
+            auto it = model.find(key);
+            wrong += (v != nullptr) != (it != model.end()) || (v && *v != it->second);
+            wrong += table.contains(key) != (it != model.end());
+            break;
+        }
+        }
+        if (op % 10000 == 0 && !same_contents(table, model)) ++wrong;
+    }
+    check(wrong == 0, "random: differs from std::unordered_map");
+    check(same_contents(table, model), "random: final contents differ");
+
+    table.clear();
+    check(table.empty() && !table.find(1) && !table.contains(2), "random: clear left entries");
+}
+
+// Counts live instances so leaks and double destruction show up
+struct Tracked {
+    static inline int live = 0;
+    std::uint64_t id;
+    explicit Tracked(std::uint64_t i) : id(i) { ++live; }
+    Tracked(Tracked&& other) noexcept : id(other.id) { ++live; }
+    Tracked(const Tracked&) = delete;
+    Tracked& operator=(const Tracked&) = delete;
+    Tracked& operator=(Tracked&& other) noexcept {
+        id = other.id;
+        return *this;
+    }
+    ~Tracked() { --live; }
+};
+
+static void move_only_values() {
+    {
+        SwissTable<std::uint64_t, Tracked> table;
+        for (std::uint64_t k = 0; k < 5000; ++k) table.try_emplace(k, k * 3);
+        for (std::uint64_t k = 0; k < 5000; k += 2) table.erase(k);
+        table.insert_or_assign(1, Tracked(7));
+        check(Tracked::live == 2500, "move-only: live values differ from entries");
+        const Tracked* v = table.find(1);
+        check(v && v->id == 7 && table.find(3) && table.find(3)->id == 9, "move-only: values");
+
+        SwissTable<std::uint64_t, Tracked> moved(std::move(table));
+        check(moved.size() == 2500 && table.empty() && Tracked::live == 2500, "move-only: move construct");
+    }
+    check(Tracked::live == 0, "move-only: values leaked or destroyed twice");
+}
+
+static void churn_keeps_capacity() {
+    SwissTable<std::uint64_t, std::uint64_t> table;
+    constexpr std::uint64_t kLive = 3000;
+    table.reserve(kLive);
+    std::size_t capacity = table.capacity();
+    for (std::uint64_t k = 0; k < kLive; ++k) table.try_emplace(k, k);
+    for (std::uint64_t k = kLive; k < 50 * kLive; ++k) {
+        table.erase(k - kLive);
+        table.try_emplace(k, k);
+    }
+    check(table.capacity() == capacity, "churn: table grew at a steady size");
+    bool all = table.size() == kLive;
+    for (std::uint64_t k = 49 * kLive; k < 50 * kLive; ++k) all = all && table.find(k) && *table.find(k) == k;
+    check(all, "churn: live key lost");
+}
+
+static void heterogeneous_lookup() {
+    SwissTable<std::string, int, core::StringHash, std::equal_to<>> table;
+    table.try_emplace(std::string("example.com"), 1);
+    table.try_emplace(std::string("evil.example"), 2);
+    std::string_view key = "evil.example";
+    const int* v = table.find(key);
+    check(v && *v == 2 && !table.find(std::string_view("evil")), "heterogeneous: string_view lookup");
+    check(table.erase(std::string_view("example.com")) && table.size() == 1, "heterogeneous: string_view erase");
+}
+
+int main() {
+    matches_unordered_map();
+    move_only_values();
+    churn_keeps_capacity();
+    heterogeneous_lookup();
+    return test::report("test_swiss_table");
+}
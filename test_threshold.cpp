@@ -0,0 +1,59 @@
+// Alert threshold tests: counters are per rule, even when rules from
+// different files share an id (ids restart at 1 in every file), and per
+// tracked address.
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <string>
+
+#include "detect/CompiledRuleset.hpp"
+#include "detect/Engine.hpp"
+#include "detect/Threshold.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+
+static core::ByteSpan span(const std::string& s) {
+    return {reinterpret_cast<const std::uint8_t*>(s.data()), s.size()};
+}
+
+static void write_file(const std::string& path, const std::string& text) {
+    std::ofstream(path, std::ios::binary) << text;
+}
+
+// Alerts let through for count matches of payload from src
+static int alerts(const detect::Engine& engine, detect::ThresholdTable& table, const std::string& payload,
+                  std::uint32_t src, int count, std::uint64_t now) {
+    detect::MatchScratch scratch;
+    flow::FlowKey key{src, 0x0A000002, 40000, 80, 6};
+    int allowed = 0;
+    for (int i = 0; i < count; ++i) {
+        for (const auto& match : engine.match(span(payload), &key, scratch)) {
+            allowed += table.allow(*match.rule, match.rule_index, key, now) ? 1 : 0;
+        }
+    }
+    return allowed;
+}
+
+static void rules_from_two_files_keep_separate_counters() {
+    // Both files' first rule gets id 1
+    write_file("test_threshold_a.rules", "Rule A|alpha|threshold=type limit, track by_src, count 2, seconds 60\n");
+    write_file("test_threshold_b.rules", "Rule B|bravo|threshold=type limit, track by_src, count 2, seconds 60\n");
+    detect::Engine engine;
+    bool loaded = detect::load_or_compile_ruleset(engine, {"test_threshold_a.rules", "test_threshold_b.rules"}, "");
+    std::remove("test_threshold_a.rules");
+    std::remove("test_threshold_b.rules");
+    check(loaded && engine.rule_count() == 2, "two files: rules not loaded");
+    check(engine.rule(0).id == engine.rule(1).id, "two files: expected the same rule id in both files");
+
+    detect::ThresholdTable table(64);
+    check(alerts(engine, table, "alpha", 0x0A000001, 5, 100) == 2, "two files: rule A not limited to 2");
+    check(alerts(engine, table, "bravo", 0x0A000001, 5, 100) == 2, "two files: rule B shares rule A's counter");
+    check(alerts(engine, table, "alpha", 0x0A000009, 5, 100) == 2, "two files: by_src counter shared across sources");
+    check(alerts(engine, table, "alpha", 0x0A000001, 1, 200) == 1, "two files: counter not reset in a new window");
+}
+
+int main() {
+    rules_from_two_files_keep_separate_counters();
+    return test::report("test_threshold");
+}
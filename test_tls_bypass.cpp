@@ -0,0 +1,117 @@
+// TLS bypass tests: inspection stops on application data only after a
+// ClientHello and a ServerHello were parsed on the connection. Forged
+// record headers, a one-sided hello or two ClientHellos keep the flow
+// inspected.
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "flow/FlowTable.hpp"
+#include "flow/TlsHelloTracker.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using Bytes = std::vector<std::uint8_t>;
+
+static Bytes record(std::uint8_t type, const Bytes& body) {
+    Bytes r{type, 0x03, 0x03, static_cast<std::uint8_t>(body.size() >> 8), static_cast<std::uint8_t>(body.size())};
+    r.insert(r.end(), body.begin(), body.end());
+    return r;
+}
+
+// Minimal well-formed hello: version, random, empty session id, one suite,
+// null compression, no extensions
+static Bytes hello(bool client) {
+    Bytes body{0x03, 0x03};
+    body.resize(2 + 32, 0x5a);
+    body.push_back(0); // session id
+    if (client) body.insert(body.end(), {0x00, 0x02});
+    body.insert(body.end(), {0x13, 0x01});
+    if (client) body.push_back(1);
+    body.push_back(0); // compression
+    Bytes message{static_cast<std::uint8_t>(client ? 1 : 2), 0, 0, static_cast<std::uint8_t>(body.size())};
+    message.insert(message.end(), body.begin(), body.end());
+    return record(22, message);
+}
+
+static Bytes app_data() {
+    std::string text = "GET /attack HTTP/1.1 hidden behind a TLS header";
+    return record(23, Bytes(text.begin(), text.end()));
+}
+
+// One direction of a connection, fed like the worker does: hello parsing
+// first, then the inspection budget
+struct Direction {
+    flow::FlowKey key;
+    flow::FlowEntry entry;
+    std::uint32_t seq{1000};
+
+    // Payload bytes left for detection
+    std::size_t feed(flow::TlsHelloTracker& tracker, const Bytes& packet, const flow::FlowEntry* reverse) {
+        core::ByteSpan payload(packet.data(), packet.size());
+        if (!entry.tls_hello_done) {
+            decode::TlsHello parsed;
+            auto status = tracker.feed(key, seq, payload, parsed);
+            if (status != flow::TlsHelloTracker::Status::NeedMore) entry.tls_hello_done = true;
+            if (status == flow::TlsHelloTracker::Status::Done) {
+                entry.tls_handshake = true;
+                entry.tls_server_hello = parsed.kind == decode::TlsHello::Kind::Server;
+            }
+        }
+        seq += static_cast<std::uint32_t>(packet.size());
+        flow::InspectionPolicy policy;
+        flow::apply_inspection_budget(entry, key, payload, policy, reverse);
+        return payload.size();
+    }
+};
+
+struct Connection {
+    flow::TlsHelloTracker tracker;
+    Direction client{flow::FlowKey{0x0A000001, 0x0A000002, 40000, 8080, 6}, {}};
+    Direction server{client.key.reversed(), {}};
+};
+
+static void forged_headers_do_not_bypass() {
+    Connection c;
+    Bytes fake_handshake = record(22, Bytes(5, 0x00)); // header plus junk, no hello
+    c.client.feed(c.tracker, fake_handshake, &c.server.entry);
+    c.server.feed(c.tracker, fake_handshake, &c.client.entry);
+    check(!c.client.entry.tls_handshake && !c.server.entry.tls_handshake, "forged: handshake set from a header");
+    check(c.client.feed(c.tracker, app_data(), &c.server.entry) == app_data().size(),
+          "forged: application data after a fake handshake header was bypassed");
+    check(c.client.entry.bypass == flow::Bypass::None, "forged: flow marked bypassed");
+}
+
+static void one_sided_hello_does_not_bypass() {
+    Connection c;
+    c.client.feed(c.tracker, hello(true), nullptr);
+    check(c.client.entry.tls_handshake, "one-sided: ClientHello not parsed");
+    check(c.client.feed(c.tracker, app_data(), nullptr) != 0, "one-sided: bypassed without a reverse direction");
+    check(c.client.feed(c.tracker, app_data(), &c.server.entry) != 0, "one-sided: bypassed without a ServerHello");
+}
+
+static void two_client_hellos_do_not_bypass() {
+    Connection c;
+    c.client.feed(c.tracker, hello(true), &c.server.entry);
+    c.server.feed(c.tracker, hello(true), &c.client.entry);
+    check(c.client.feed(c.tracker, app_data(), &c.server.entry) != 0, "two ClientHellos: client bypassed");
+    check(c.server.feed(c.tracker, app_data(), &c.client.entry) != 0, "two ClientHellos: server bypassed");
+}
+
+static void real_handshake_bypasses() {
+    Connection c;
+    check(c.client.feed(c.tracker, hello(true), &c.server.entry) != 0, "handshake: ClientHello not inspected");
+    check(c.server.feed(c.tracker, hello(false), &c.client.entry) != 0, "handshake: ServerHello not inspected");
+    check(c.client.entry.tls_handshake && c.server.entry.tls_server_hello, "handshake: hellos not parsed");
+    check(c.client.feed(c.tracker, app_data(), &c.server.entry) == 0, "handshake: client application data scanned");
+    check(c.client.entry.bypass == flow::Bypass::Encrypted, "handshake: client not bypassed as encrypted");
+    check(c.server.feed(c.tracker, app_data(), &c.client.entry) == 0, "handshake: server application data scanned");
+}
+
+int main() {
+    forged_headers_do_not_bypass();
+    one_sided_hello_does_not_bypass();
+    two_client_hellos_do_not_bypass();
+    real_handshake_bypasses();
+    return test::report("test_tls_bypass");
+}
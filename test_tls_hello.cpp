@@ -0,0 +1,223 @@
+// TLS hello tests: a ClientHello and a ServerHello with GREASE values,
+// SNI, ALPN and supported_versions are parsed, and their JA3 / JA3S must
+// equal the MD5 of the fingerprint strings written out by hand. MD5 itself
+// is checked against the RFC 1321 test vectors. The same hello split over
+// records and segments gives the same result, and truncated hellos are
+// rejected.
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <initializer_list>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "core/Md5.hpp"
+#include "decode/TLS.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using Bytes = std::vector<std::uint8_t>;
+
+static std::string hex(const core::Md5::Digest& d) {
+    static const char digits[] = "0123456789abcdef";
+    std::string s;
+    for (auto b : d) {
+        s += digits[b >> 4];
+        s += digits[b & 15];
+    }
+    return s;
+}
+
+static std::string md5_hex(std::string_view text) {
+    core::Md5 md5;
+    md5.update(text.data(), text.size());
+    return hex(md5.finish());
+}
+
+static void put16(Bytes& b, std::size_t v) {
+    b.push_back(static_cast<std::uint8_t>(v >> 8));
+    b.push_back(static_cast<std::uint8_t>(v));
+}
+
+static void extension(Bytes& out, std::uint16_t type, const Bytes& body) {
+    put16(out, type);
+    put16(out, body.size());
+    out.insert(out.end(), body.begin(), body.end());
+}
+
+static Bytes u16_list(std::initializer_list<std::uint16_t> values) {
+    Bytes b;
+    put16(b, values.size() * 2);
+    for (auto v : values) put16(b, v);
+    return b;
+}
+
+static Bytes handshake(std::uint8_t type, const Bytes& body) {
+    Bytes m{type, 0, static_cast<std::uint8_t>(body.size() >> 8), static_cast<std::uint8_t>(body.size())};
+    m.insert(m.end(), body.begin(), body.end());
+    return m;
+}
+
+// JA3 string: 771,4865-4866-49195,0-23-10-11-16-43,29-23-24,0
+// (GREASE suites, extensions and groups are skipped)
+static Bytes client_hello() {
+    Bytes body{0x03, 0x03};
+    body.resize(2 + 32, 0x11);
+    body.push_back(0); // session id
+    Bytes suites = u16_list({0x0a0a, 0x1301, 0x1302, 0xc02b});
+    body.insert(body.end(), suites.begin(), suites.end());
+    body.insert(body.end(), {1, 0}); // null compression
+
+    Bytes ext;
+    extension(ext, 0x1a1a, {});
+    std::string host = "www.example.com";
+    Bytes sni;
+    put16(sni, host.size() + 3);
+    sni.push_back(0);
+    put16(sni, host.size());
+    sni.insert(sni.end(), host.begin(), host.end());
+    extension(ext, 0, sni);
+    extension(ext, 23, {});
+    extension(ext, 10, u16_list({0x2a2a, 29, 23, 24}));
+    extension(ext, 11, {1, 0});
+    extension(ext, 16, {0, 12, 2, 'h', '2', 8, 'h', 't', 't', 'p', '/', '1', '.', '1'});
+    extension(ext, 43, {6, 0x3a, 0x3a, 0x03, 0x04, 0x03, 0x03});
+    put16(body, ext.size());
+    body.insert(body.end(), ext.begin(), ext.end());
+    return handshake(1, body);
+}
+
+// JA3S string: 771,4865,43-16
+static Bytes server_hello() {
+    Bytes body{0x03, 0x03};
+    body.resize(2 + 32, 0x22);
+    body.push_back(0);
+    body.insert(body.end(), {0x13, 0x01, 0});
+    Bytes ext;
+    extension(ext, 43, {0x03, 0x04});
+    extension(ext, 16, {0, 3, 2, 'h', '2'});
+    put16(body, ext.size());
+    body.insert(body.end(), ext.begin(), ext.end());
+    return handshake(2, body);
+}
+
+static Bytes record(const Bytes& fragment) {
+    Bytes r{22, 0x03, 0x01};
+    put16(r, fragment.size());
+    r.insert(r.end(), fragment.begin(), fragment.end());
+    return r;
+}
+
+static void md5_vectors() {
+    check(md5_hex("") == "d41d8cd98f00b204e9800998ecf8427e", "md5: empty string");
+    check(md5_hex("abc") == "900150983cd24fb0d6963f7d28e17f72", "md5: abc");
+    std::string digits;
+    for (int i = 0; i < 8; ++i) digits += "1234567890";
+    check(md5_hex(digits) == "57edf4a22be3c955ac49da2e2107b67a", "md5: 80 digits (two blocks)");
+
+    core::Md5 pieces;
+    for (char c : digits) pieces.update(static_cast<std::uint8_t>(c));
+    check(hex(pieces.finish()) == "57edf4a22be3c955ac49da2e2107b67a", "md5: byte-at-a-time updates");
+}
+
+static void fingerprints() {
+    Bytes ch = client_hello();
+    decode::TlsHello hello;
+    check(decode::parse_tls_hello(core::ByteSpan(ch.data(), ch.size()), hello), "client: parse");
+    check(hello.kind == decode::TlsHello::Kind::Client && hello.legacy_version == 0x0303 && hello.version == 0x0304,
+          "client: versions");
+    check(hello.cipher_count() == 4 && hello.cipher(1) == 0x1301, "client: cipher suites");
+    check(hello.sni == "www.example.com", "client: SNI");
+    check(hello.alpn_first == "h2" && hello.alpn.size() == 12, "client: ALPN");
+    char ja3[33];
+    hello.ja3_hex(ja3);
+    check(std::string(ja3) == md5_hex("771,4865-4866-49195,0-23-10-11-16-43,29-23-24,0"), "client: JA3");
+    check(std::string(ja3) == "ee58977da0f3295e388dbc2fc67e7784", "client: JA3 known hash");
+
+    decode::TlsHello unhashed;
+    check(decode::parse_tls_hello(core::ByteSpan(ch.data(), ch.size()), unhashed, false) &&
+              unhashed.ja3 == core::Md5::Digest{} && unhashed.sni == hello.sni,
+          "client: parse without fingerprint");
+
+    Bytes sh = server_hello();
+    decode::TlsHello server;
+    check(decode::parse_tls_hello(core::ByteSpan(sh.data(), sh.size()), server), "server: parse");
+    check(server.kind == decode::TlsHello::Kind::Server && server.version == 0x0304 && server.cipher(0) == 0x1301,
+          "server: selected version and suite");
+    check(server.alpn_first == "h2" && server.sni.empty(), "server: ALPN");
+    server.ja3_hex(ja3);
+    check(std::string(ja3) == "2b83a23dea22815f9c4ffaaeaebdc796", "server: JA3S known hash");
+}
+
+static void records_and_segments() {
+    Bytes ch = client_hello();
+    Bytes whole = record(ch);
+    core::ByteSpan message;
+    std::string_view sni;
+    check(decode::tls_hello_message(core::ByteSpan(whole.data(), whole.size()), message) &&
+              message.size() == ch.size(),
+          "records: single-record hello");
+    check(decode::extract_tls_sni(core::ByteSpan(whole.data(), whole.size()), sni) && sni == "www.example.com",
+          "records: extract_tls_sni");
+
+    // Two records fed in 7-byte segments, each followed by a retransmit of
+    // the one before
+    std::size_t half = ch.size() / 2;
+    Bytes stream = record(Bytes(ch.begin(), ch.begin() + static_cast<std::ptrdiff_t>(half)));
+    Bytes second = record(Bytes(ch.begin() + static_cast<std::ptrdiff_t>(half), ch.end()));
+    stream.insert(stream.end(), second.begin(), second.end());
+    check(!decode::tls_hello_message(core::ByteSpan(stream.data(), stream.size()), message),
+          "records: split hello parsed in place");
+
+    decode::TlsHelloReader reader;
+    reader.reset(5000);
+    auto status = decode::TlsHelloReader::Status::NeedMore;
+    std::size_t pos = 0;
+    while (pos < stream.size() && status == decode::TlsHelloReader::Status::NeedMore) {
+        std::size_t n = std::min<std::size_t>(7, stream.size() - pos);
+        status = reader.feed(static_cast<std::uint32_t>(5000 + pos), core::ByteSpan(stream.data() + pos, n));
+        if (pos >= 7) {
+            reader.feed(static_cast<std::uint32_t>(5000 + pos - 7), core::ByteSpan(stream.data() + pos - 7, 7));
+        }
+        pos += n;
+    }
+    decode::TlsHello hello;
+    check(status == decode::TlsHelloReader::Status::Done && reader.message().size() == ch.size() &&
+              std::memcmp(reader.message().data(), ch.data(), ch.size()) == 0,
+          "segments: reassembled hello");
+    char ja3[33];
+    check(decode::parse_tls_hello(reader.message(), hello), "segments: parse");
+    hello.ja3_hex(ja3);
+    check(std::string(ja3) == "ee58977da0f3295e388dbc2fc67e7784", "segments: JA3 differs");
+}
+
+// A hello cut short, with its header length fixed up, is malformed unless
+// the cut falls exactly before the extension block (extensions are optional)
+static void truncated() {
+    Bytes ch = client_hello();
+    std::size_t no_extensions = 4 + 2 + 32 + 1 + 2 + 8 + 2;
+    int wrong = 0;
+    for (std::size_t n = 4; n < ch.size(); ++n) {
+        Bytes cut(ch.begin(), ch.begin() + static_cast<std::ptrdiff_t>(n));
+        cut[2] = static_cast<std::uint8_t>((n - 4) >> 8);
+        cut[3] = static_cast<std::uint8_t>(n - 4);
+        decode::TlsHello hello;
+        bool ok = decode::parse_tls_hello(core::ByteSpan(cut.data(), cut.size()), hello);
+        if (ok != (n == no_extensions)) ++wrong;
+    }
+    check(wrong == 0, "truncated: cut hello accepted");
+    Bytes bad = ch;
+    bad[3] = static_cast<std::uint8_t>(bad[3] + 1);
+    decode::TlsHello hello;
+    check(!decode::parse_tls_hello(core::ByteSpan(bad.data(), bad.size()), hello), "truncated: length past end");
+}
+
+int main() {
+    md5_vectors();
+    fingerprints();
+    records_and_segments();
+    truncated();
+    return test::report("test_tls_hello");
+}
@@ -0,0 +1,61 @@
+// IPS verdict cache tests: a dropped flow stays dropped across FIN/RST and
+// only expires once idle; passed and pending flows end with FIN/RST.
+#include <chrono>
+#include <cstdint>
+
+#include "ips/VerdictCache.hpp"
+#include "test/TestCheck.hpp"
+
+using test::check;
+using ips::VerdictCache;
+using Clock = std::chrono::steady_clock;
+
+static flow::FlowKey key(std::uint16_t sport) {
+    return flow::FlowKey{0x0A000001, 0x0A000002, sport, 80, 6};
+}
+
+static void drop_survives_fin_and_rst() {
+    VerdictCache::Config config;
+    config.idle_timeout = std::chrono::seconds(60);
+    VerdictCache cache(config);
+    Clock::time_point t0 = Clock::now();
+
+    cache.record(key(1000), ips::Decision::Drop, 100, t0);
+    cache.end_flow(key(1000)); // FIN
+    check(cache.lookup(key(1000), t0 + std::chrono::seconds(1)) == VerdictCache::Verdict::Drop,
+          "drop cleared by FIN");
+    cache.end_flow(key(1000)); // RST
+    cache.end_flow(key(1000));
+    check(cache.lookup(key(1000), t0 + std::chrono::seconds(2)) == VerdictCache::Verdict::Drop,
+          "drop cleared by RST");
+    check(cache.stats().expired.load() == 0, "FIN/RST counted a drop as expired");
+
+    // Packets keep it alive; only idleness ends it
+    check(cache.lookup(key(1000), t0 + std::chrono::seconds(50)) == VerdictCache::Verdict::Drop,
+          "drop expired while the flow was active");
+    check(cache.lookup(key(1000), t0 + std::chrono::seconds(200)) == VerdictCache::Verdict::None,
+          "drop outlived the idle timeout");
+}
+
+static void pass_and_pending_end_with_fin() {
+    VerdictCache::Config config;
+    config.inspect_depth = 100;
+    VerdictCache cache(config);
+    Clock::time_point t0 = Clock::now();
+
+    cache.record(key(2000), ips::Decision::Pass, 150, t0);
+    check(cache.lookup(key(2000), t0) == VerdictCache::Verdict::Pass, "pass not cached past inspect_depth");
+    cache.end_flow(key(2000));
+    check(cache.lookup(key(2000), t0) == VerdictCache::Verdict::None, "pass kept after FIN");
+
+    cache.record(key(3000), ips::Decision::Pass, 10, t0); // still under inspection
+    cache.end_flow(key(3000));
+    check(cache.size() == 0, "pending entry kept after FIN");
+    check(cache.stats().expired.load() == 2, "FIN-ended entries not counted");
+}
+
+int main() {
+    drop_survives_fin_and_rst();
+    pass_and_pending_end_with_fin();
+    return test::report("test_verdict_cache");
+}